@@ -19,9 +19,46 @@ fwupd_client_download_bytes2_async(FwupdClient *self,
 				   GCancellable *cancellable,
 				   GAsyncReadyCallback callback,
 				   gpointer callback_data) G_GNUC_NON_NULL(1, 2);
+void
+fwupd_client_download_bytes_conditional_async(FwupdClient *self,
+					      GPtrArray *urls,
+					      FwupdClientDownloadFlags flags,
+					      const gchar *if_none_match,
+					      const gchar *if_modified_since,
+					      GCancellable *cancellable,
+					      GAsyncReadyCallback callback,
+					      gpointer callback_data) G_GNUC_NON_NULL(1, 2);
+GBytes *
+fwupd_client_download_bytes_conditional_finish(FwupdClient *self,
+					       GAsyncResult *res,
+					       gchar **etag,
+					       gchar **last_modified,
+					       GError **error) G_GNUC_NON_NULL(1, 2);
+void
+fwupd_client_refresh_remote_load_validators(FwupdRemote *remote,
+					    const gchar *filename,
+					    gchar **if_none_match,
+					    gchar **if_modified_since) G_GNUC_NON_NULL(1, 2, 3, 4);
+void
+fwupd_client_refresh_remote_save_validators(const gchar *filename,
+					    GBytes *signature,
+					    const gchar *etag,
+					    const gchar *last_modified) G_GNUC_NON_NULL(1, 2);
 
 #ifdef HAVE_GIO_UNIX
 void
+fwupd_client_download_stream_async(FwupdClient *self,
+				   GPtrArray *urls,
+				   const gchar *filename,
+				   const gchar *checksum,
+				   FwupdClientDownloadFlags flags,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data) G_GNUC_NON_NULL(1, 2, 3);
+GUnixInputStream *
+fwupd_client_download_stream_finish(FwupdClient *self, GAsyncResult *res, GError **error)
+    G_GNUC_NON_NULL(1, 2);
+void
 fwupd_client_get_details_stream_async(FwupdClient *self,
 				      GUnixInputStream *istr,
 				      GCancellable *cancellable,
@@ -17,11 +17,14 @@
 #include <sys/utsname.h>
 #endif
 
+#include <errno.h>
 #include <fcntl.h>
+#include <glib/gstdio.h>
 #include <locale.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "fwupd-bios-setting.h"
 #include "fwupd-client-private.h"
@@ -91,6 +94,10 @@ typedef struct {
 	CURL *curl;
 	curl_mime *mime;
 	struct curl_slist *headers;
+	gchar *if_none_match;	  /* nullable */
+	gchar *if_modified_since; /* nullable */
+	gchar *etag;		  /* nullable */
+	gchar *last_modified;	  /* nullable */
 } FwupdCurlHelper;
 #endif
 
@@ -143,6 +150,10 @@ fwupd_client_curl_helper_free(FwupdCurlHelper *helper)
 		curl_slist_free_all(helper->headers);
 	if (helper->urls != NULL)
 		g_ptr_array_unref(helper->urls);
+	g_free(helper->if_none_match);
+	g_free(helper->if_modified_since);
+	g_free(helper->etag);
+	g_free(helper->last_modified);
 	g_free(helper);
 }
 
@@ -3393,6 +3404,7 @@ typedef struct {
 	FwupdRelease *release;
 	FwupdInstallFlags install_flags;
 	FwupdClientDownloadFlags download_flags;
+	gchar *filename_cache; /* nullable */
 } FwupdClientInstallReleaseData;
 
 static void
@@ -3400,6 +3412,7 @@ fwupd_client_install_release_data_free(FwupdClientInstallReleaseData *data)
 {
 	g_object_unref(data->device);
 	g_object_unref(data->release);
+	g_free(data->filename_cache);
 	g_free(data);
 }
 
@@ -3474,6 +3487,123 @@ fwupd_client_install_release_download_cb(GObject *source, GAsyncResult *res, gpo
 					 g_steal_pointer(&task));
 }
 
+#ifdef HAVE_GIO_UNIX
+static void
+fwupd_client_install_release_stream_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = G_TASK(user_data);
+	FwupdClientInstallReleaseData *data = g_task_get_task_data(task);
+
+	/* on failure keep the verified download, which a retry uses if the checksum matches */
+	if (!fwupd_client_install_finish(FWUPD_CLIENT(source), res, &error)) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	if (g_unlink(data->filename_cache) != 0)
+		g_debug("failed to delete %s", data->filename_cache);
+
+	/* success */
+	g_task_return_boolean(task, TRUE);
+}
+
+static void
+fwupd_client_install_release_download_stream_cb(GObject *source,
+						GAsyncResult *res,
+						gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = G_TASK(user_data);
+	g_autoptr(GUnixInputStream) istr = NULL;
+	g_autofree gchar *basename = NULL;
+	FwupdClientInstallReleaseData *data = g_task_get_task_data(task);
+	GCancellable *cancellable = g_task_get_cancellable(task);
+
+	/* the checksum was already verified as the data was written */
+	istr = fwupd_client_download_stream_finish(FWUPD_CLIENT(source), res, &error);
+	if (istr == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	if (fwupd_release_get_filename(data->release) != NULL)
+		basename = g_path_get_basename(fwupd_release_get_filename(data->release));
+	fwupd_client_install_stream_async(FWUPD_CLIENT(source),
+					  fwupd_device_get_id(data->device),
+					  istr,
+					  basename,
+					  data->install_flags,
+					  cancellable,
+					  fwupd_client_install_release_stream_cb,
+					  g_steal_pointer(&task));
+}
+#endif
+
+#ifdef HAVE_GIO_UNIX
+static gboolean
+fwupd_client_is_url_http(const gchar *perhaps_url);
+
+/* streaming to the cache is only implemented for HTTP */
+static gboolean
+fwupd_client_urls_has_http(GPtrArray *urls)
+{
+	for (guint i = 0; i < urls->len; i++) {
+		const gchar *url = g_ptr_array_index(urls, i);
+		if (fwupd_client_is_url_http(url))
+			return TRUE;
+	}
+	return FALSE;
+}
+#endif
+
+static void
+fwupd_client_install_release_download(FwupdClient *self, GPtrArray *urls, GTask *task)
+{
+	FwupdClientInstallReleaseData *data = g_task_get_task_data(task);
+	GCancellable *cancellable = g_task_get_cancellable(task);
+
+#ifdef HAVE_GIO_UNIX
+	/* write to disk rather than keeping the entire archive in memory */
+	if (data->download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_STREAM_TO_CACHE &&
+	    fwupd_client_urls_has_http(urls)) {
+		const gchar *checksum =
+		    fwupd_checksum_get_best(fwupd_release_get_checksums(data->release));
+
+		/* the download is installed without being loaded into memory first */
+		if (checksum == NULL) {
+			g_task_return_new_error(task,
+						FWUPD_ERROR,
+						FWUPD_ERROR_INVALID_FILE,
+						"no checksum to verify the download");
+			g_object_unref(task);
+			return;
+		}
+
+		/* use the checksum so that different releases never share a download */
+		g_free(data->filename_cache);
+		data->filename_cache = g_build_filename(g_get_user_cache_dir(),
+							"fwupd",
+							"downloads",
+							checksum,
+							NULL);
+		fwupd_client_download_stream_async(self,
+						   urls,
+						   data->filename_cache,
+						   checksum,
+						   data->download_flags,
+						   cancellable,
+						   fwupd_client_install_release_download_stream_cb,
+						   task);
+		return;
+	}
+#endif
+	fwupd_client_download_bytes2_async(self,
+					   urls,
+					   data->download_flags,
+					   cancellable,
+					   fwupd_client_install_release_download_cb,
+					   task);
+}
+
 static gboolean
 fwupd_client_is_url_http(const gchar *perhaps_url)
 {
@@ -3618,12 +3748,9 @@ fwupd_client_install_release_remote_cb(GObject *source, GAsyncResult *res, gpoin
 	}
 
 	/* download file */
-	fwupd_client_download_bytes2_async(FWUPD_CLIENT(source),
-					   uris_built,
-					   data->download_flags,
-					   cancellable,
-					   fwupd_client_install_release_download_cb,
-					   g_steal_pointer(&task));
+	fwupd_client_install_release_download(FWUPD_CLIENT(source),
+					      uris_built,
+					      g_steal_pointer(&task));
 }
 
 #ifdef HAVE_LIBCURL
@@ -3707,12 +3834,9 @@ fwupd_client_install_release_async(FwupdClient *self,
 	/* work out what remote-specific URI fields this should use */
 	remote_id = fwupd_release_get_remote_id(release);
 	if (remote_id == NULL) {
-		fwupd_client_download_bytes2_async(self,
-						   fwupd_release_get_locations(release),
-						   download_flags,
-						   cancellable,
-						   fwupd_client_install_release_download_cb,
-						   g_steal_pointer(&task));
+		fwupd_client_install_release_download(self,
+						      fwupd_release_get_locations(release),
+						      g_steal_pointer(&task));
 		return;
 	}
 
@@ -4356,6 +4480,8 @@ typedef struct {
 	FwupdClientDownloadFlags download_flags;
 	GBytes *signature;
 	GBytes *metadata;
+	gchar *etag;	      /* nullable */
+	gchar *last_modified; /* nullable */
 } FwupdClientRefreshRemoteData;
 
 static void
@@ -4366,20 +4492,109 @@ fwupd_client_refresh_remote_data_free(FwupdClientRefreshRemoteData *data)
 	if (data->metadata != NULL)
 		g_bytes_unref(data->metadata);
 	g_object_unref(data->remote);
+	g_free(data->etag);
+	g_free(data->last_modified);
 	g_free(data);
 }
 
+static gchar *
+fwupd_client_refresh_remote_get_validators_fn(FwupdRemote *remote)
+{
+	return g_build_filename(g_get_user_cache_dir(),
+				"fwupd",
+				"remotes.d",
+				fwupd_remote_get_id(remote),
+				"metadata.validators",
+				NULL);
+}
+
+/* private */
+void
+fwupd_client_refresh_remote_load_validators(FwupdRemote *remote,
+					    const gchar *filename,
+					    gchar **if_none_match,
+					    gchar **if_modified_since)
+{
+	g_autofree gchar *checksum = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new();
+	g_autoptr(GError) error_local = NULL;
+
+	/* the cache validators are only useful if the daemon still has the signature */
+	if (fwupd_remote_get_checksum(remote) == NULL)
+		return;
+	if (!g_key_file_load_from_file(kf, filename, G_KEY_FILE_NONE, &error_local)) {
+		g_debug("no cache validators for %s: %s",
+			fwupd_remote_get_id(remote),
+			error_local->message);
+		return;
+	}
+	checksum = g_key_file_get_string(kf, "fwupd Validators", "Checksum", NULL);
+	if (g_strcmp0(checksum, fwupd_remote_get_checksum(remote)) != 0) {
+		g_debug("ignoring cache validators for %s as signature changed",
+			fwupd_remote_get_id(remote));
+		return;
+	}
+	*if_none_match = g_key_file_get_string(kf, "fwupd Validators", "ETag", NULL);
+	*if_modified_since = g_key_file_get_string(kf, "fwupd Validators", "LastModified", NULL);
+}
+
+/* private */
+void
+fwupd_client_refresh_remote_save_validators(const gchar *filename,
+					    GBytes *signature,
+					    const gchar *etag,
+					    const gchar *last_modified)
+{
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *dirname = NULL;
+	g_autoptr(GKeyFile) kf = g_key_file_new();
+	g_autoptr(GError) error_local = NULL;
+
+	/* nothing to use next time */
+	if (etag == NULL && last_modified == NULL) {
+		(void)g_unlink(filename);
+		return;
+	}
+
+	/* this has to match what the daemon uses in fwupd_remote_get_checksum() */
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, signature);
+	g_key_file_set_string(kf, "fwupd Validators", "Checksum", checksum);
+	if (etag != NULL)
+		g_key_file_set_string(kf, "fwupd Validators", "ETag", etag);
+	if (last_modified != NULL)
+		g_key_file_set_string(kf, "fwupd Validators", "LastModified", last_modified);
+	dirname = g_path_get_dirname(filename);
+	if (g_mkdir_with_parents(dirname, 0700) < 0) {
+		g_debug("failed to create %s: %s", dirname, g_strerror(errno));
+		return;
+	}
+	if (!g_key_file_save_to_file(kf, filename, &error_local))
+		g_debug("failed to save cache validators: %s", error_local->message);
+}
+
+static void
+fwupd_client_refresh_remote_data_save_validators(FwupdClientRefreshRemoteData *data)
+{
+	g_autofree gchar *fn = fwupd_client_refresh_remote_get_validators_fn(data->remote);
+	fwupd_client_refresh_remote_save_validators(fn,
+						    data->signature,
+						    data->etag,
+						    data->last_modified);
+}
+
 static void
 fwupd_client_refresh_remote_update_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 {
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GTask) task = G_TASK(user_data);
+	FwupdClientRefreshRemoteData *data = g_task_get_task_data(task);
 
 	/* save metadata */
 	if (!fwupd_client_update_metadata_bytes_finish(FWUPD_CLIENT(source), res, &error)) {
 		g_task_return_error(task, g_steal_pointer(&error));
 		return;
 	}
+	fwupd_client_refresh_remote_data_save_validators(data);
 
 	/* success */
 	g_task_return_boolean(task, TRUE);
@@ -4445,8 +4660,18 @@ fwupd_client_refresh_remote_signature_cb(GObject *source, GAsyncResult *res, gpo
 	g_autoptr(GPtrArray) urls = g_ptr_array_new_with_free_func(g_free);
 
 	/* save signature */
-	bytes = fwupd_client_download_bytes_finish(FWUPD_CLIENT(source), res, &error);
+	bytes = fwupd_client_download_bytes_conditional_finish(FWUPD_CLIENT(source),
+							       res,
+							       &data->etag,
+							       &data->last_modified,
+							       &error);
 	if (bytes == NULL) {
+		if (g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO)) {
+			g_info("metadata signature of %s is not modified, skipping",
+			       fwupd_remote_get_id(data->remote));
+			g_task_return_boolean(task, TRUE);
+			return;
+		}
 		g_prefix_error(&error,
 			       "Failed to download metadata for %s: ",
 			       fwupd_remote_get_id(data->remote));
@@ -4471,6 +4696,7 @@ fwupd_client_refresh_remote_signature_cb(GObject *source, GAsyncResult *res, gpo
 		if (g_strcmp0(checksum, fwupd_remote_get_checksum(data->remote)) == 0) {
 			g_info("metadata signature of %s is unchanged, skipping",
 			       fwupd_remote_get_id(data->remote));
+			fwupd_client_refresh_remote_data_save_validators(data);
 			g_task_return_boolean(task, TRUE);
 			return;
 		}
@@ -4530,9 +4756,13 @@ fwupd_client_refresh_remote_async(FwupdClient *self,
 				  gpointer callback_data)
 {
 	FwupdClientRefreshRemoteData *data;
+	g_autofree gchar *fn_validators = NULL;
+	g_autofree gchar *if_modified_since = NULL;
+	g_autofree gchar *if_none_match = NULL;
 	g_autofree gchar *uri = NULL;
 	g_autoptr(GTask) task = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) urls = g_ptr_array_new_with_free_func(g_free);
 
 	g_return_if_fail(FWUPD_IS_CLIENT(self));
 	g_return_if_fail(FWUPD_IS_REMOTE(remote));
@@ -4572,12 +4802,23 @@ fwupd_client_refresh_remote_async(FwupdClient *self,
 		g_task_return_error(task, g_steal_pointer(&error));
 		return;
 	}
-	fwupd_client_download_bytes_async(self,
-					  uri,
-					  download_flags & ~FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_P2P,
-					  cancellable,
-					  fwupd_client_refresh_remote_signature_cb,
-					  g_steal_pointer(&task));
+	g_ptr_array_add(urls, g_steal_pointer(&uri));
+
+	/* only if it has changed since the daemon last loaded it */
+	fn_validators = fwupd_client_refresh_remote_get_validators_fn(remote);
+	fwupd_client_refresh_remote_load_validators(remote,
+						    fn_validators,
+						    &if_none_match,
+						    &if_modified_since);
+	fwupd_client_download_bytes_conditional_async(
+	    self,
+	    urls,
+	    download_flags & ~FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_P2P,
+	    if_none_match,
+	    if_modified_since,
+	    cancellable,
+	    fwupd_client_refresh_remote_signature_cb,
+	    g_steal_pointer(&task));
 }
 
 /**
@@ -5598,14 +5839,59 @@ fwupd_client_download_ipfs(FwupdClient *self,
 	return g_steal_pointer(&bstdout);
 }
 
-static GBytes *
-fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GError **error)
+static gboolean
+fwupd_client_download_check_status_code(glong status_code, GByteArray *buf, GError **error)
 {
-	CURLcode res;
-	gchar errbuf[CURL_ERROR_SIZE] = {'\0'};
-	glong status_code = 0;
-	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_info("status-code was %ld", status_code);
+	if (status_code == 429) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_FILE,
+				    "Failed to download due to server limit");
+		return FALSE;
+	}
+	if (status_code == 502 || status_code == 503 || status_code == 504) {
+		g_autofree gchar *str = g_strndup((const gchar *)buf->data, MIN(buf->len, 4000));
+		if (g_str_is_ascii(str)) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_TIMED_OUT,
+				    "Transient failure to download, server response was %u: %s",
+				    (guint)status_code,
+				    str);
+			return FALSE;
+		}
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_TIMED_OUT,
+			    "Transient failure to download, server response was %u",
+			    (guint)status_code);
+		return FALSE;
+	}
+	if (status_code >= 400) {
+		g_autofree gchar *str = g_strndup((const gchar *)buf->data, MIN(buf->len, 4000));
+		if (g_str_is_ascii(str)) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_FILE,
+				    "Failed to download, server response was %u: %s",
+				    (guint)status_code,
+				    str);
+			return FALSE;
+		}
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_FILE,
+			    "Failed to download, server response was %u",
+			    (guint)status_code);
+		return FALSE;
+	}
+	return TRUE;
+}
 
+static void
+fwupd_client_download_set_ssl_verify(CURL *curl, const gchar *url)
+{
 	/* relax the SSL checks on localhost URLs and broken corporate proxies */
 	if (fwupd_client_is_localhost(url) || g_getenv("DISABLE_SSL_STRICT") != NULL) {
 		(void)curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
@@ -5614,15 +5900,71 @@ fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GErr
 		(void)curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
 		(void)curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 1L);
 	}
+}
+
+static size_t
+fwupd_client_download_header_callback_cb(char *ptr, size_t size, size_t nitems, void *userdata)
+{
+	FwupdCurlHelper *helper = (FwupdCurlHelper *)userdata;
+	gsize realsize = size * nitems;
+	g_autofree gchar *line = g_strstrip(g_strndup(ptr, realsize));
 
+	/* a new response after a redirect */
+	if (g_str_has_prefix(line, "HTTP/")) {
+		g_clear_pointer(&helper->etag, g_free);
+		g_clear_pointer(&helper->last_modified, g_free);
+		return realsize;
+	}
+	if (g_ascii_strncasecmp(line, "ETag:", 5) == 0) {
+		g_free(helper->etag);
+		helper->etag = g_strstrip(g_strdup(line + 5));
+	} else if (g_ascii_strncasecmp(line, "Last-Modified:", 14) == 0) {
+		g_free(helper->last_modified);
+		helper->last_modified = g_strstrip(g_strdup(line + 14));
+	}
+	return realsize;
+}
+
+static GBytes *
+fwupd_client_download_http(FwupdClient *self,
+			   FwupdCurlHelper *helper,
+			   const gchar *url,
+			   GError **error)
+{
+	CURL *curl = helper->curl;
+	CURLcode res;
+	gchar errbuf[CURL_ERROR_SIZE] = {'\0'};
+	glong status_code = 0;
+	struct curl_slist *headers = NULL;
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+
+	/* only download if changed since last time */
+	if (helper->if_none_match != NULL) {
+		g_autofree gchar *hdr = g_strdup_printf("If-None-Match: %s", helper->if_none_match);
+		headers = curl_slist_append(headers, hdr);
+	}
+	if (helper->if_modified_since != NULL) {
+		g_autofree gchar *hdr =
+		    g_strdup_printf("If-Modified-Since: %s", helper->if_modified_since);
+		headers = curl_slist_append(headers, hdr);
+	}
+
+	fwupd_client_download_set_ssl_verify(curl, url);
 	fwupd_client_set_status(self, FWUPD_STATUS_DOWNLOADING);
 	(void)curl_easy_setopt(curl, CURLOPT_URL, url);
 	(void)curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errbuf);
+	(void)curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+	(void)curl_easy_setopt(curl,
+			       CURLOPT_HEADERFUNCTION,
+			       fwupd_client_download_header_callback_cb);
+	(void)curl_easy_setopt(curl, CURLOPT_HEADERDATA, helper);
 	(void)curl_easy_setopt(curl,
 			       CURLOPT_WRITEFUNCTION,
 			       fwupd_client_download_write_callback_cb);
 	(void)curl_easy_setopt(curl, CURLOPT_WRITEDATA, buf);
 	res = curl_easy_perform(curl);
+	(void)curl_easy_setopt(curl, CURLOPT_HTTPHEADER, NULL);
+	curl_slist_free_all(headers);
 	fwupd_client_set_status(self, FWUPD_STATUS_IDLE);
 	fwupd_client_set_percentage(self, 100);
 	if (res != CURLE_OK) {
@@ -5644,51 +5986,15 @@ fwupd_client_download_http(FwupdClient *self, CURL *curl, const gchar *url, GErr
 
 	/* check for server limit */
 	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
-	g_info("status-code was %ld", status_code);
-	if (status_code == 429) {
+	if (status_code == 304) {
 		g_set_error_literal(error,
 				    FWUPD_ERROR,
-				    FWUPD_ERROR_INVALID_FILE,
-				    "Failed to download due to server limit");
-		return NULL;
-	}
-	if (status_code == 502 || status_code == 503 || status_code == 504) {
-		g_autofree gchar *str = g_strndup((const gchar *)buf->data, MIN(buf->len, 4000));
-		if (g_str_is_ascii(str)) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_TIMED_OUT,
-				    "Transient failure to download, server response was %u: %s",
-				    (guint)status_code,
-				    str);
-			return NULL;
-		}
-		g_set_error(error,
-			    FWUPD_ERROR,
-			    FWUPD_ERROR_TIMED_OUT,
-			    "Transient failure to download, server response was %u",
-			    (guint)status_code);
+				    FWUPD_ERROR_NOTHING_TO_DO,
+				    "not modified since last download");
 		return NULL;
 	}
-	if (status_code >= 400) {
-		g_autofree gchar *str = g_strndup((const gchar *)buf->data, MIN(buf->len, 4000));
-		if (g_str_is_ascii(str)) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_INVALID_FILE,
-				    "Failed to download, server response was %u: %s",
-				    (guint)status_code,
-				    str);
-			return NULL;
-		}
-		g_set_error(error,
-			    FWUPD_ERROR,
-			    FWUPD_ERROR_INVALID_FILE,
-			    "Failed to download, server response was %u",
-			    (guint)status_code);
+	if (!fwupd_client_download_check_status_code(status_code, buf, error))
 		return NULL;
-	}
-
 	return g_bytes_new(buf->data, buf->len);
 }
 
@@ -5700,37 +6006,49 @@ fwupd_client_download_error_is_fatal(const GError *error)
 	return TRUE;
 }
 
-static GBytes *
-fwupd_client_download_http_retry(FwupdClient *self, CURL *curl, const gchar *url, GError **error)
+static gboolean
+fwupd_client_download_check_reachable(const gchar *url, GError **error)
 {
-	FwupdClientPrivate *priv = GET_PRIVATE(self);
 	GNetworkMonitor *monitor = g_network_monitor_get_default();
-	gulong delay_ms = 2500;
 	g_autoptr(GError) error_monitor = NULL;
 	g_autoptr(GSocketConnectable) address = NULL;
 	g_autoptr(GUri) uri = NULL;
 
-	/* test if we can reach this network */
 	uri = g_uri_parse(url, G_URI_FLAGS_NONE, error);
 	if (uri == NULL)
-		return NULL;
+		return FALSE;
 	address = g_network_address_parse(g_uri_get_host(uri), g_uri_get_port(uri), error);
 	if (address == NULL)
-		return NULL;
+		return FALSE;
 	if (!g_network_monitor_can_reach(monitor, address, NULL, &error_monitor)) {
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_NOT_REACHABLE,
 			    "network is unreachable: %s",
 			    error_monitor->message);
-		return NULL;
+		return FALSE;
 	}
+	return TRUE;
+}
+
+static GBytes *
+fwupd_client_download_http_retry(FwupdClient *self,
+				 FwupdCurlHelper *helper,
+				 const gchar *url,
+				 GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	gulong delay_ms = 2500;
+
+	/* test if we can reach this network */
+	if (!fwupd_client_download_check_reachable(url, error))
+		return NULL;
 
 	for (guint i = 0;; i++, delay_ms *= 2) {
 		g_autoptr(GBytes) blob = NULL;
 		g_autoptr(GError) error_local = NULL;
 
-		blob = fwupd_client_download_http(self, curl, url, &error_local);
+		blob = fwupd_client_download_http(self, helper, url, &error_local);
 		if (blob != NULL)
 			return g_steal_pointer(&blob);
 		if (i >= priv->download_retries ||
@@ -5762,7 +6080,7 @@ fwupd_client_download_bytes_thread_cb(GTask *task,
 			return;
 		}
 		if (fwupd_client_is_url_http(url)) {
-			blob = fwupd_client_download_http_retry(self, helper->curl, url, &error);
+			blob = fwupd_client_download_http_retry(self, helper, url, &error);
 			if (blob != NULL)
 				break;
 		} else if (fwupd_client_is_url_ipfs(url)) {
@@ -5790,12 +6108,14 @@ fwupd_client_download_bytes_thread_cb(GTask *task,
 
 /* private */
 void
-fwupd_client_download_bytes2_async(FwupdClient *self,
-				   GPtrArray *urls,
-				   FwupdClientDownloadFlags flags,
-				   GCancellable *cancellable,
-				   GAsyncReadyCallback callback,
-				   gpointer callback_data)
+fwupd_client_download_bytes_conditional_async(FwupdClient *self,
+					      GPtrArray *urls,
+					      FwupdClientDownloadFlags flags,
+					      const gchar *if_none_match,
+					      const gchar *if_modified_since,
+					      GCancellable *cancellable,
+					      GAsyncReadyCallback callback,
+					      gpointer callback_data)
 {
 	g_autoptr(GTask) task = NULL;
 #ifdef HAVE_LIBCURL
@@ -5820,6 +6140,8 @@ fwupd_client_download_bytes2_async(FwupdClient *self,
 		g_task_return_error(task, g_steal_pointer(&error));
 		return;
 	}
+	helper->if_none_match = g_strdup(if_none_match);
+	helper->if_modified_since = g_strdup(if_modified_since);
 	g_task_set_task_data(task,
 			     g_steal_pointer(&helper),
 			     (GDestroyNotify)fwupd_client_curl_helper_free);
@@ -5831,6 +6153,52 @@ fwupd_client_download_bytes2_async(FwupdClient *self,
 #endif
 }
 
+/* private */
+GBytes *
+fwupd_client_download_bytes_conditional_finish(FwupdClient *self,
+					       GAsyncResult *res,
+					       gchar **etag,
+					       gchar **last_modified,
+					       GError **error)
+{
+	GBytes *blob;
+
+	g_return_val_if_fail(FWUPD_IS_CLIENT(self), NULL);
+	g_return_val_if_fail(g_task_is_valid(res, self), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	blob = g_task_propagate_pointer(G_TASK(res), error);
+#ifdef HAVE_LIBCURL
+	if (blob != NULL) {
+		FwupdCurlHelper *helper = g_task_get_task_data(G_TASK(res));
+		if (etag != NULL)
+			*etag = g_strdup(helper->etag);
+		if (last_modified != NULL)
+			*last_modified = g_strdup(helper->last_modified);
+	}
+#endif
+	return blob;
+}
+
+/* private */
+void
+fwupd_client_download_bytes2_async(FwupdClient *self,
+				   GPtrArray *urls,
+				   FwupdClientDownloadFlags flags,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data)
+{
+	fwupd_client_download_bytes_conditional_async(self,
+						      urls,
+						      flags,
+						      NULL,
+						      NULL,
+						      cancellable,
+						      callback,
+						      callback_data);
+}
+
 /**
  * fwupd_client_download_bytes_async:
  * @self: a #FwupdClient
@@ -5892,6 +6260,429 @@ fwupd_client_download_bytes_finish(FwupdClient *self, GAsyncResult *res, GError
 	return g_task_propagate_pointer(G_TASK(res), error);
 }
 
+#if defined(HAVE_LIBCURL) && defined(HAVE_GIO_UNIX)
+typedef struct {
+	FwupdCurlHelper *curl_helper;
+	gchar *filename;
+	gchar *checksum; /* nullable */
+} FwupdClientDownloadStreamHelper;
+
+static void
+fwupd_client_download_stream_helper_free(FwupdClientDownloadStreamHelper *helper)
+{
+	if (helper->curl_helper != NULL)
+		fwupd_client_curl_helper_free(helper->curl_helper);
+	g_free(helper->filename);
+	g_free(helper->checksum);
+	g_free(helper);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FwupdClientDownloadStreamHelper,
+			      fwupd_client_download_stream_helper_free)
+
+typedef struct {
+	CURL *curl;
+	gint fd;
+	goffset offset; /* bytes written to @fd, all of which are included in @checksum */
+	GChecksum *checksum;
+	GByteArray *buf;  /* body of any error response */
+	glong status_code;
+	GError *error;
+} FwupdClientDownloadFileHelper;
+
+static size_t
+fwupd_client_download_file_write_cb(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+	FwupdClientDownloadFileHelper *helper = (FwupdClientDownloadFileHelper *)userdata;
+	gsize realsize = size * nmemb;
+
+	/* first chunk of this transfer */
+	if (helper->status_code == 0) {
+		curl_easy_getinfo(helper->curl, CURLINFO_RESPONSE_CODE, &helper->status_code);
+
+		/* server ignored the Range header, so start again */
+		if (helper->status_code == 200 && helper->offset > 0) {
+			g_debug("server does not support resume, restarting download");
+			if (ftruncate(helper->fd, 0) < 0 || lseek(helper->fd, 0, SEEK_SET) < 0) {
+				g_set_error(&helper->error,
+					    FWUPD_ERROR,
+					    FWUPD_ERROR_WRITE,
+					    "failed to truncate: %s",
+					    g_strerror(errno));
+				return 0;
+			}
+			if (helper->checksum != NULL)
+				g_checksum_reset(helper->checksum);
+			helper->offset = 0;
+		}
+	}
+
+	/* keep any error page for the message */
+	if (helper->status_code >= 300) {
+		g_byte_array_append(helper->buf, (const guint8 *)ptr, realsize);
+		return realsize;
+	}
+
+	/* append to the file and checksum */
+	for (gsize done = 0; done < realsize;) {
+		gssize wrote = write(helper->fd, ptr + done, realsize - done);
+		if (wrote < 0) {
+			if (errno == EINTR)
+				continue;
+			g_set_error(&helper->error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_WRITE,
+				    "failed to write: %s",
+				    g_strerror(errno));
+			return 0;
+		}
+		done += wrote;
+	}
+	if (helper->checksum != NULL)
+		g_checksum_update(helper->checksum, (const guchar *)ptr, realsize);
+	helper->offset += realsize;
+	return realsize;
+}
+
+static gboolean
+fwupd_client_download_file_http(FwupdClient *self,
+				FwupdClientDownloadFileHelper *helper,
+				const gchar *url,
+				GError **error)
+{
+	CURLcode res;
+	gchar errbuf[CURL_ERROR_SIZE] = {'\0'};
+
+	/* ask for just the part we do not already have */
+	helper->status_code = 0;
+	g_byte_array_set_size(helper->buf, 0);
+	if (helper->offset > 0)
+		g_info("resuming download from offset 0x%x", (guint)helper->offset);
+
+	fwupd_client_download_set_ssl_verify(helper->curl, url);
+	fwupd_client_set_status(self, FWUPD_STATUS_DOWNLOADING);
+	(void)curl_easy_setopt(helper->curl, CURLOPT_URL, url);
+	(void)curl_easy_setopt(helper->curl, CURLOPT_ERRORBUFFER, errbuf);
+	(void)curl_easy_setopt(helper->curl,
+			       CURLOPT_WRITEFUNCTION,
+			       fwupd_client_download_file_write_cb);
+	(void)curl_easy_setopt(helper->curl, CURLOPT_WRITEDATA, helper);
+	(void)curl_easy_setopt(helper->curl,
+			       CURLOPT_RESUME_FROM_LARGE,
+			       (curl_off_t)helper->offset);
+	res = curl_easy_perform(helper->curl);
+	(void)curl_easy_setopt(helper->curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)0);
+	fwupd_client_set_status(self, FWUPD_STATUS_IDLE);
+	if (helper->error != NULL) {
+		g_propagate_error(error, g_steal_pointer(&helper->error));
+		return FALSE;
+	}
+	if (res != CURLE_OK) {
+		/* the data we already have is still valid, so these can be resumed */
+		FwupdError error_code = FWUPD_ERROR_INVALID_FILE;
+		if (res == CURLE_PARTIAL_FILE || res == CURLE_RECV_ERROR ||
+		    res == CURLE_OPERATION_TIMEDOUT || res == CURLE_GOT_NOTHING)
+			error_code = FWUPD_ERROR_TIMED_OUT;
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    error_code,
+			    "failed to download file: %s",
+			    errbuf[0] != '\0' ? errbuf : curl_easy_strerror(res));
+		return FALSE;
+	}
+
+	/* the requested range was past the end, which means we already have it all */
+	if (helper->status_code == 0)
+		curl_easy_getinfo(helper->curl, CURLINFO_RESPONSE_CODE, &helper->status_code);
+	if (helper->status_code == 416 && helper->offset > 0)
+		return TRUE;
+	return fwupd_client_download_check_status_code(helper->status_code, helper->buf, error);
+}
+
+static gboolean
+fwupd_client_download_file_http_retry(FwupdClient *self,
+				      FwupdClientDownloadFileHelper *helper,
+				      const gchar *url,
+				      GError **error)
+{
+	FwupdClientPrivate *priv = GET_PRIVATE(self);
+	gulong delay_ms = 2500;
+
+	/* test if we can reach this network */
+	if (!fwupd_client_download_check_reachable(url, error))
+		return FALSE;
+
+	for (guint i = 0;; i++, delay_ms *= 2) {
+		g_autoptr(GError) error_local = NULL;
+
+		if (fwupd_client_download_file_http(self, helper, url, &error_local))
+			return TRUE;
+		if (i >= priv->download_retries ||
+		    fwupd_client_download_error_is_fatal(error_local)) {
+			g_propagate_error(error, g_steal_pointer(&error_local));
+			break;
+		}
+		g_debug("ignoring and trying again: %s", error_local->message);
+		g_usleep(delay_ms * 1000);
+	}
+	return FALSE;
+}
+
+static gboolean
+fwupd_client_download_file_load_partial(FwupdClientDownloadFileHelper *helper, GError **error)
+{
+	guint8 buf[0x8000];
+
+	/* include anything downloaded by an earlier attempt in the running checksum */
+	for (;;) {
+		gssize rc = read(helper->fd, buf, sizeof(buf));
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_READ,
+				    "failed to read: %s",
+				    g_strerror(errno));
+			return FALSE;
+		}
+		if (rc == 0)
+			break;
+		if (helper->checksum != NULL)
+			g_checksum_update(helper->checksum, buf, rc);
+		helper->offset += rc;
+	}
+	return TRUE;
+}
+
+/* a complete download from an earlier attempt can be used if the checksum still matches */
+static GUnixInputStream *
+fwupd_client_download_stream_load_cached(FwupdClientDownloadStreamHelper *stream_helper)
+{
+	FwupdClientDownloadFileHelper helper = {
+	    .fd = -1,
+	};
+	g_autoptr(GChecksum) checksum = NULL;
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GUnixInputStream) istr = NULL;
+
+	helper.fd = g_open(stream_helper->filename, O_RDONLY | O_CLOEXEC, 0);
+	if (helper.fd < 0)
+		return NULL;
+	checksum = g_checksum_new(fwupd_checksum_guess_kind(stream_helper->checksum));
+	helper.checksum = checksum;
+	if (!fwupd_client_download_file_load_partial(&helper, &error_local)) {
+		g_debug("ignoring %s: %s", stream_helper->filename, error_local->message);
+		g_close(helper.fd, NULL);
+		return NULL;
+	}
+	g_close(helper.fd, NULL);
+	if (g_strcmp0(stream_helper->checksum, g_checksum_get_string(checksum)) != 0) {
+		g_debug("ignoring %s as checksum invalid", stream_helper->filename);
+		(void)g_unlink(stream_helper->filename);
+		return NULL;
+	}
+	istr = fwupd_unix_input_stream_from_fn(stream_helper->filename, &error_local);
+	if (istr == NULL) {
+		g_debug("ignoring %s: %s", stream_helper->filename, error_local->message);
+		return NULL;
+	}
+	g_info("using previously downloaded %s", stream_helper->filename);
+	return g_steal_pointer(&istr);
+}
+
+static void
+fwupd_client_download_stream_thread_cb(GTask *task,
+				       gpointer source_object,
+				       gpointer task_data,
+				       GCancellable *cancellable)
+{
+	FwupdClient *self = FWUPD_CLIENT(source_object);
+	FwupdClientDownloadStreamHelper *stream_helper = g_task_get_task_data(task);
+	FwupdCurlHelper *curl_helper = stream_helper->curl_helper;
+	FwupdClientDownloadFileHelper helper = {
+	    .curl = curl_helper->curl,
+	    .fd = -1,
+	};
+	g_autofree gchar *basename = NULL;
+	g_autofree gchar *dirname = NULL;
+	g_autofree gchar *fn_partial = NULL;
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_autoptr(GChecksum) checksum = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GUnixInputStream) istr = NULL;
+
+	/* already downloaded */
+	istr = fwupd_client_download_stream_load_cached(stream_helper);
+	if (istr != NULL) {
+		g_task_return_pointer(task, g_steal_pointer(&istr), (GDestroyNotify)g_object_unref);
+		return;
+	}
+
+	/* any previous attempt is kept in a partial file only used for the same payload */
+	dirname = g_path_get_dirname(stream_helper->filename);
+	basename = g_strdup_printf("%s.partial", stream_helper->checksum);
+	fn_partial = g_build_filename(dirname, basename, NULL);
+	if (g_mkdir_with_parents(dirname, 0700) < 0) {
+		g_task_return_new_error(task,
+					FWUPD_ERROR,
+					FWUPD_ERROR_WRITE,
+					"failed to create %s: %s",
+					dirname,
+					g_strerror(errno));
+		return;
+	}
+	helper.fd = g_open(fn_partial, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (helper.fd < 0) {
+		g_task_return_new_error(task,
+					FWUPD_ERROR,
+					FWUPD_ERROR_WRITE,
+					"failed to open %s: %s",
+					fn_partial,
+					g_strerror(errno));
+		return;
+	}
+	helper.buf = buf;
+	checksum = g_checksum_new(fwupd_checksum_guess_kind(stream_helper->checksum));
+	helper.checksum = checksum;
+	if (!fwupd_client_download_file_load_partial(&helper, &error)) {
+		g_close(helper.fd, NULL);
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+
+	for (guint i = 0; i < curl_helper->urls->len; i++) {
+		const gchar *url = g_ptr_array_index(curl_helper->urls, i);
+		g_clear_error(&error);
+		g_info("downloading %s to %s", url, fn_partial);
+		if (!fwupd_client_curl_helper_set_proxy(self, curl_helper, url, &error))
+			break;
+		if (fwupd_client_is_url_http(url)) {
+			if (fwupd_client_download_file_http_retry(self, &helper, url, &error))
+				break;
+		} else {
+			g_set_error(&error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_FILE,
+				    "not sure how to handle: %s",
+				    url);
+		}
+		if (i == curl_helper->urls->len - 1)
+			break;
+		fwupd_client_set_percentage(self, 0);
+		fwupd_client_set_status(self, FWUPD_STATUS_IDLE);
+		g_info("failed to download %s: %s, trying next URI…", url, error->message);
+	}
+	fwupd_client_set_percentage(self, 100);
+	if (error != NULL) {
+		g_close(helper.fd, NULL);
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	if (!g_close(helper.fd, &error)) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+
+	/* verify checksum */
+	if (g_strcmp0(stream_helper->checksum, g_checksum_get_string(checksum)) != 0) {
+		g_task_return_new_error(task,
+					FWUPD_ERROR,
+					FWUPD_ERROR_INVALID_FILE,
+					"checksum invalid, expected %s got %s",
+					stream_helper->checksum,
+					g_checksum_get_string(checksum));
+		(void)g_unlink(fn_partial);
+		return;
+	}
+	if (g_rename(fn_partial, stream_helper->filename) < 0) {
+		g_task_return_new_error(task,
+					FWUPD_ERROR,
+					FWUPD_ERROR_WRITE,
+					"failed to rename %s: %s",
+					fn_partial,
+					g_strerror(errno));
+		return;
+	}
+
+	/* success */
+	istr = fwupd_unix_input_stream_from_fn(stream_helper->filename, &error);
+	if (istr == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	g_task_return_pointer(task, g_steal_pointer(&istr), (GDestroyNotify)g_object_unref);
+}
+#endif
+
+#ifdef HAVE_GIO_UNIX
+/* private */
+void
+fwupd_client_download_stream_async(FwupdClient *self,
+				   GPtrArray *urls,
+				   const gchar *filename,
+				   const gchar *checksum,
+				   FwupdClientDownloadFlags flags,
+				   GCancellable *cancellable,
+				   GAsyncReadyCallback callback,
+				   gpointer callback_data)
+{
+	g_autoptr(GTask) task = NULL;
+#ifdef HAVE_LIBCURL
+	g_autoptr(GError) error = NULL;
+	g_autoptr(FwupdClientDownloadStreamHelper) helper = NULL;
+#endif
+
+	g_return_if_fail(FWUPD_IS_CLIENT(self));
+	g_return_if_fail(urls != NULL);
+	g_return_if_fail(filename != NULL);
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	/* ensure networking set up */
+	task = g_task_new(self, cancellable, callback, callback_data);
+#ifdef HAVE_LIBCURL
+	if (checksum == NULL) {
+		g_task_return_new_error(task,
+					FWUPD_ERROR,
+					FWUPD_ERROR_INVALID_FILE,
+					"no checksum to verify the download");
+		return;
+	}
+	helper = g_new0(FwupdClientDownloadStreamHelper, 1);
+	helper->filename = g_strdup(filename);
+	helper->checksum = g_strdup(checksum);
+	helper->curl_helper = fwupd_client_curl_new(self, &error);
+	if (helper->curl_helper == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	helper->curl_helper->urls = fwupd_client_filter_locations(urls, flags, &error);
+	if (helper->curl_helper->urls == NULL) {
+		g_task_return_error(task, g_steal_pointer(&error));
+		return;
+	}
+	g_task_set_task_data(task,
+			     g_steal_pointer(&helper),
+			     (GDestroyNotify)fwupd_client_download_stream_helper_free);
+
+	/* download data */
+	g_task_run_in_thread(task, fwupd_client_download_stream_thread_cb);
+#else
+	g_task_return_new_error(task, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "no libcurl support");
+#endif
+}
+
+/* private */
+GUnixInputStream *
+fwupd_client_download_stream_finish(FwupdClient *self, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail(FWUPD_IS_CLIENT(self), NULL);
+	g_return_val_if_fail(g_task_is_valid(res, self), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+	return g_task_propagate_pointer(G_TASK(res), error);
+}
+#endif
+
 #ifdef HAVE_LIBCURL
 static void
 fwupd_client_upload_bytes_thread_cb(GTask *task,
@@ -59,6 +59,15 @@ typedef enum {
 	 * Since: 1.9.4
 	 */
 	FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_P2P = 1 << 0,
+	/**
+	 * FWUPD_CLIENT_DOWNLOAD_FLAG_STREAM_TO_CACHE:
+	 *
+	 * Stream firmware to a file in the user cache directory rather than into memory,
+	 * verifying the checksum while downloading and resuming interrupted transfers.
+	 *
+	 * Since: 2.0.7
+	 */
+	FWUPD_CLIENT_DOWNLOAD_FLAG_STREAM_TO_CACHE = 1 << 1,
 	/*< private >*/
 	FWUPD_CLIENT_DOWNLOAD_FLAG_LAST
 } FwupdClientDownloadFlags;
@@ -6,6 +6,7 @@
 
 #include "config.h"
 
+#include <glib/gstdio.h>
 #include <locale.h>
 #include <string.h>
 
@@ -1031,6 +1032,356 @@ fwupd_client_remotes_func(void)
 	g_assert_null(remote3);
 }
 
+#if defined(HAVE_LIBCURL) && defined(HAVE_GIO_UNIX)
+typedef struct {
+	GSocketListener *listener;
+	GCancellable *cancellable;
+	GBytes *payload;
+	gsize truncate_first; /* only send this many bytes for the first request */
+	const gchar *etag;    /* nullable */
+	guint requests;
+	guint requests_range;
+	guint requests_not_modified;
+} FwupdTestHttpServer;
+
+static gpointer
+fwupd_test_http_server_thread_cb(gpointer user_data)
+{
+	FwupdTestHttpServer *self = (FwupdTestHttpServer *)user_data;
+
+	for (;;) {
+		const guint8 *buf = g_bytes_get_data(self->payload, NULL);
+		gsize bufsz = g_bytes_get_size(self->payload);
+		gsize offset = 0;
+		gsize length;
+		gboolean not_modified = FALSE;
+		GOutputStream *ostr;
+		g_autoptr(GDataInputStream) dstr = NULL;
+		g_autoptr(GSocketConnection) conn = NULL;
+		g_autoptr(GString) hdr = g_string_new(NULL);
+
+		conn = g_socket_listener_accept(self->listener, NULL, self->cancellable, NULL);
+		if (conn == NULL)
+			break;
+
+		/* only the Range and If-None-Match headers are interesting */
+		dstr = g_data_input_stream_new(g_io_stream_get_input_stream(G_IO_STREAM(conn)));
+		g_data_input_stream_set_newline_type(dstr, G_DATA_STREAM_NEWLINE_TYPE_CR_LF);
+		for (;;) {
+			g_autofree gchar *line =
+			    g_data_input_stream_read_line(dstr, NULL, NULL, NULL);
+			if (line == NULL || line[0] == '\0')
+				break;
+			if (g_ascii_strncasecmp(line, "Range: bytes=", 13) == 0)
+				offset = g_ascii_strtoull(line + 13, NULL, 10);
+			if (g_ascii_strncasecmp(line, "If-None-Match: ", 15) == 0)
+				not_modified = g_strcmp0(line + 15, self->etag) == 0;
+		}
+		if (not_modified) {
+			g_string_append(hdr, "HTTP/1.1 304 Not Modified\r\n");
+			self->requests_not_modified++;
+		} else if (offset > 0) {
+			g_string_append_printf(hdr,
+					       "HTTP/1.1 206 Partial Content\r\n"
+					       "Content-Range: bytes %" G_GSIZE_FORMAT
+					       "-%" G_GSIZE_FORMAT "/%" G_GSIZE_FORMAT "\r\n",
+					       offset,
+					       bufsz - 1,
+					       bufsz);
+			self->requests_range++;
+		} else {
+			g_string_append(hdr, "HTTP/1.1 200 OK\r\n");
+		}
+		if (self->etag != NULL)
+			g_string_append_printf(hdr, "ETag: %s\r\n", self->etag);
+		length = not_modified ? 0 : bufsz - offset;
+		g_string_append_printf(hdr,
+				       "Content-Length: %" G_GSIZE_FORMAT "\r\n"
+				       "Connection: close\r\n\r\n",
+				       length);
+		if (self->requests++ == 0 && self->truncate_first > 0)
+			length = self->truncate_first;
+
+		/* a truncated write just closes the connection early */
+		ostr = g_io_stream_get_output_stream(G_IO_STREAM(conn));
+		(void)g_output_stream_write_all(ostr, hdr->str, hdr->len, NULL, NULL, NULL);
+		(void)g_output_stream_write_all(ostr, buf + offset, length, NULL, NULL, NULL);
+		(void)g_io_stream_close(G_IO_STREAM(conn), NULL, NULL);
+	}
+	return NULL;
+}
+
+static void
+fwupd_client_download_stream_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	GUnixInputStream **istr = (GUnixInputStream **)user_data;
+	g_autoptr(GError) error = NULL;
+	*istr = fwupd_client_download_stream_finish(FWUPD_CLIENT(source), res, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(*istr);
+}
+
+static void
+fwupd_client_download_stream_error_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	GError **error = (GError **)user_data;
+	g_autoptr(GUnixInputStream) istr = NULL;
+	istr = fwupd_client_download_stream_finish(FWUPD_CLIENT(source), res, error);
+	g_assert_null(istr);
+	g_assert_nonnull(*error);
+}
+
+static void
+fwupd_client_download_stream_func(void)
+{
+	guint16 port;
+	gsize bufsz = 0;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *data = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autoptr(FwupdClient) client = fwupd_client_new();
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) urls = g_ptr_array_new_with_free_func(g_free);
+	g_autoptr(GThread) thread = NULL;
+	g_autoptr(GUnixInputStream) istr = NULL;
+	FwupdTestHttpServer server = {
+	    .listener = g_socket_listener_new(),
+	    .cancellable = g_cancellable_new(),
+	    .truncate_first = 0x1000,
+	};
+
+	/* local HTTP server that drops the first connection part way through */
+	for (guint i = 0; i < 0x40000; i++) {
+		guint8 tmp = (guint8)(i * 7);
+		g_byte_array_append(buf, &tmp, 1);
+	}
+	server.payload = g_bytes_new(buf->data, buf->len);
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, server.payload);
+	port = g_socket_listener_add_any_inet_port(server.listener, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_cmpint(port, !=, 0);
+	thread = g_thread_new("http-server", fwupd_test_http_server_thread_cb, &server);
+	g_ptr_array_add(urls, g_strdup_printf("http://127.0.0.1:%u/firmware.cab", port));
+
+	/* download to a file, resuming after the first failure */
+	tmpdir = g_dir_make_tmp("fwupd-self-test-XXXXXX", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(tmpdir);
+	fn = g_build_filename(tmpdir, "firmware.cab", NULL);
+	fwupd_client_set_user_agent_for_package(client, "fwupd", PACKAGE_VERSION);
+	fwupd_client_download_set_retries(client, 1);
+	fwupd_client_download_stream_async(client,
+					   urls,
+					   fn,
+					   checksum,
+					   FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					   NULL,
+					   fwupd_client_download_stream_cb,
+					   &istr);
+	while (istr == NULL)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_cmpint(server.requests, ==, 2);
+	g_assert_cmpint(server.requests_range, ==, 1);
+
+	/* the stream is backed by the complete file */
+	g_assert_cmpint(g_unix_input_stream_get_fd(istr), >=, 0);
+	g_assert_true(g_file_get_contents(fn, &data, &bufsz, &error));
+	g_assert_no_error(error);
+	g_assert_cmpint(bufsz, ==, buf->len);
+	g_assert_cmpint(memcmp(data, buf->data, bufsz), ==, 0);
+
+	/* the complete file is reused without another request */
+	g_clear_object(&istr);
+	fwupd_client_download_stream_async(client,
+					   urls,
+					   fn,
+					   checksum,
+					   FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					   NULL,
+					   fwupd_client_download_stream_cb,
+					   &istr);
+	while (istr == NULL)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_cmpint(server.requests, ==, 2);
+
+	/* the download cannot be verified without a checksum */
+	fwupd_client_download_stream_async(client,
+					   urls,
+					   fn,
+					   NULL,
+					   FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+					   NULL,
+					   fwupd_client_download_stream_error_cb,
+					   &error);
+	while (error == NULL)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
+	g_assert_cmpint(server.requests, ==, 2);
+
+	/* shut down server */
+	g_cancellable_cancel(server.cancellable);
+	g_thread_join(g_steal_pointer(&thread));
+	(void)g_unlink(fn);
+	(void)g_rmdir(tmpdir);
+	g_object_unref(server.listener);
+	g_object_unref(server.cancellable);
+	g_bytes_unref(server.payload);
+}
+#endif
+
+#if defined(HAVE_LIBCURL) && defined(HAVE_GIO_UNIX)
+typedef struct {
+	GBytes *blob;
+	GError *error;
+	gchar *etag;
+	gboolean done;
+} FwupdTestDownloadHelper;
+
+static void
+fwupd_client_download_conditional_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	FwupdTestDownloadHelper *helper = (FwupdTestDownloadHelper *)user_data;
+	helper->blob = fwupd_client_download_bytes_conditional_finish(FWUPD_CLIENT(source),
+								      res,
+								      &helper->etag,
+								      NULL,
+								      &helper->error);
+	helper->done = TRUE;
+}
+
+static void
+fwupd_client_download_not_modified_func(void)
+{
+	guint16 port;
+	g_autoptr(FwupdClient) client = fwupd_client_new();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) urls = g_ptr_array_new_with_free_func(g_free);
+	g_autoptr(GThread) thread = NULL;
+	FwupdTestDownloadHelper helper = {NULL};
+	FwupdTestHttpServer server = {
+	    .listener = g_socket_listener_new(),
+	    .cancellable = g_cancellable_new(),
+	    .payload = g_bytes_new_static("signature", 9),
+	    .etag = "\"abcdef\"",
+	};
+
+	port = g_socket_listener_add_any_inet_port(server.listener, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_cmpint(port, !=, 0);
+	thread = g_thread_new("http-server", fwupd_test_http_server_thread_cb, &server);
+	g_ptr_array_add(urls, g_strdup_printf("http://127.0.0.1:%u/firmware.xml.zst.jcat", port));
+	fwupd_client_set_user_agent_for_package(client, "fwupd", PACKAGE_VERSION);
+
+	/* the first download returns the ETag */
+	fwupd_client_download_bytes_conditional_async(client,
+						      urls,
+						      FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+						      NULL,
+						      NULL,
+						      NULL,
+						      fwupd_client_download_conditional_cb,
+						      &helper);
+	while (!helper.done)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_no_error(helper.error);
+	g_assert_nonnull(helper.blob);
+	g_assert_cmpint(g_bytes_get_size(helper.blob), ==, 9);
+	g_assert_cmpstr(helper.etag, ==, "\"abcdef\"");
+	g_clear_pointer(&helper.blob, g_bytes_unref);
+
+	/* a 304 response is not an error the caller has to report */
+	helper.done = FALSE;
+	fwupd_client_download_bytes_conditional_async(client,
+						      urls,
+						      FWUPD_CLIENT_DOWNLOAD_FLAG_NONE,
+						      helper.etag,
+						      NULL,
+						      NULL,
+						      fwupd_client_download_conditional_cb,
+						      &helper);
+	while (!helper.done)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_error(helper.error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO);
+	g_assert_null(helper.blob);
+	g_assert_cmpint(server.requests, ==, 2);
+	g_assert_cmpint(server.requests_not_modified, ==, 1);
+
+	/* shut down server */
+	g_cancellable_cancel(server.cancellable);
+	g_thread_join(g_steal_pointer(&thread));
+	g_clear_error(&helper.error);
+	g_free(helper.etag);
+	g_object_unref(server.listener);
+	g_object_unref(server.cancellable);
+	g_bytes_unref(server.payload);
+}
+#endif
+
+static void
+fwupd_client_validators_func(void)
+{
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *fn = NULL;
+	g_autofree gchar *if_modified_since = NULL;
+	g_autofree gchar *if_none_match = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autoptr(FwupdRemote) remote = fwupd_remote_new();
+	g_autoptr(GBytes) signature = g_bytes_new_static("signature", 9);
+	g_autoptr(GError) error = NULL;
+
+	tmpdir = g_dir_make_tmp("fwupd-self-test-XXXXXX", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(tmpdir);
+	fn = g_build_filename(tmpdir, "lvfs", "metadata.validators", NULL);
+	checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, signature);
+	fwupd_remote_set_id(remote, "lvfs");
+	fwupd_remote_set_checksum_sig(remote, checksum);
+
+	/* saved and reloaded when the daemon has the same signature */
+	fwupd_client_refresh_remote_save_validators(fn,
+						    signature,
+						    "\"abcdef\"",
+						    "Wed, 21 Oct 2015 07:28:00 GMT");
+	g_assert_true(g_file_test(fn, G_FILE_TEST_EXISTS));
+	fwupd_client_refresh_remote_load_validators(remote,
+						    fn,
+						    &if_none_match,
+						    &if_modified_since);
+	g_assert_cmpstr(if_none_match, ==, "\"abcdef\"");
+	g_assert_cmpstr(if_modified_since, ==, "Wed, 21 Oct 2015 07:28:00 GMT");
+	g_clear_pointer(&if_none_match, g_free);
+	g_clear_pointer(&if_modified_since, g_free);
+
+	/* ignored when the daemon has a different signature */
+	fwupd_remote_set_checksum_sig(remote, "deadbeef");
+	fwupd_client_refresh_remote_load_validators(remote,
+						    fn,
+						    &if_none_match,
+						    &if_modified_since);
+	g_assert_null(if_none_match);
+	g_assert_null(if_modified_since);
+
+	/* ignored when the daemon has no signature at all */
+	fwupd_remote_set_checksum_sig(remote, NULL);
+	fwupd_client_refresh_remote_load_validators(remote,
+						    fn,
+						    &if_none_match,
+						    &if_modified_since);
+	g_assert_null(if_none_match);
+
+	/* deleted when the server sends no validators */
+	fwupd_client_refresh_remote_save_validators(fn, signature, NULL, NULL);
+	g_assert_false(g_file_test(fn, G_FILE_TEST_EXISTS));
+
+	/* cleanup */
+	g_clear_pointer(&fn, g_free);
+	fn = g_build_filename(tmpdir, "lvfs", NULL);
+	(void)g_rmdir(fn);
+	(void)g_rmdir(tmpdir);
+}
+
 static gboolean
 fwupd_has_system_bus(void)
 {
@@ -1138,6 +1489,7 @@ fwupd_security_attr_func(void)
 	g_autoptr(FwupdSecurityAttr) attr1 = fwupd_security_attr_new("org.fwupd.hsi.bar");
 	g_autoptr(FwupdSecurityAttr) attr2 = fwupd_security_attr_new(NULL);
 	g_autoptr(FwupdSecurityAttr) attr3 = fwupd_security_attr_new(NULL);
+	g_autoptr(FwupdSecurityAttr) attr4 = NULL;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GVariant) data = NULL;
 
@@ -1249,6 +1601,21 @@ fwupd_security_attr_func(void)
 	g_assert_no_error(error);
 	g_assert_true(ret);
 
+	/* deep copy */
+	fwupd_security_attr_set_result_fallback(attr1, FWUPD_SECURITY_ATTR_RESULT_VALID);
+	fwupd_security_attr_set_kernel_current_value(attr1, "foo");
+	fwupd_security_attr_set_kernel_target_value(attr1, "bar");
+	attr4 = fwupd_security_attr_copy(attr1);
+	g_assert_cmpint(fwupd_security_attr_get_result_fallback(attr4),
+			==,
+			FWUPD_SECURITY_ATTR_RESULT_VALID);
+	g_assert_cmpstr(fwupd_security_attr_get_kernel_current_value(attr4), ==, "foo");
+	g_assert_cmpstr(fwupd_security_attr_get_kernel_target_value(attr4), ==, "bar");
+	g_assert_true(fwupd_security_attr_has_guid(attr4, "af3fc12c-d090-5783-8a67-845b90d3cfec"));
+	fwupd_security_attr_set_result_fallback(attr1, FWUPD_SECURITY_ATTR_RESULT_UNKNOWN);
+	fwupd_security_attr_set_kernel_current_value(attr1, NULL);
+	fwupd_security_attr_set_kernel_target_value(attr1, NULL);
+
 	/* from JSON */
 	ret = fwupd_codec_from_json_string(FWUPD_CODEC(attr2), json, &error);
 	if (g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
@@ -1447,6 +1814,12 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/security-attr", fwupd_security_attr_func);
 	g_test_add_func("/fwupd/bios-attrs", fwupd_bios_settings_func);
 	g_test_add_func("/fwupd/client_api", fwupd_client_api);
+#if defined(HAVE_LIBCURL) && defined(HAVE_GIO_UNIX)
+	g_test_add_func("/fwupd/client{download-stream}", fwupd_client_download_stream_func);
+	g_test_add_func("/fwupd/client{download-not-modified}",
+			fwupd_client_download_not_modified_func);
+#endif
+	g_test_add_func("/fwupd/client{validators}", fwupd_client_validators_func);
 	if (g_test_undefined()) {
 		g_test_add_func("/fwupd/client_api{undefined_setter}",
 				fwupd_client_api_undefined_setter);
@@ -31,15 +31,38 @@
 struct _FuArchive {
 	GObject parent_instance;
 	GHashTable *entries; /* str:GBytes */
+	FuArchiveFlags flags;
+	GBytes *data;		  /* nullable, only for FU_ARCHIVE_FLAG_LAZY */
+	GInputStream *stream;	  /* nullable, only for FU_ARCHIVE_FLAG_LAZY */
+	GHashTable *lazy_entries; /* nullable, str:guint (archive index + 1) */
+	GQueue *cache;		  /* str, most recently used first */
+	gsize cache_size;
+	gsize cache_size_max;
 };
 
 G_DEFINE_TYPE(FuArchive, fu_archive, G_TYPE_OBJECT)
 
+#define FU_ARCHIVE_CACHE_SIZE_MAX_DEFAULT (64 * 1024 * 1024)
+
+static gboolean
+fu_archive_lazy_read(FuArchive *self,
+		     guint idx,
+		     FuArchiveIterateFunc callback,
+		     gpointer user_data,
+		     GError **error);
+
 static void
 fu_archive_finalize(GObject *obj)
 {
 	FuArchive *self = FU_ARCHIVE(obj);
 
+	if (self->data != NULL)
+		g_bytes_unref(self->data);
+	if (self->stream != NULL)
+		g_object_unref(self->stream);
+	if (self->lazy_entries != NULL)
+		g_hash_table_unref(self->lazy_entries);
+	g_queue_free_full(self->cache, g_free);
 	g_hash_table_unref(self->entries);
 	G_OBJECT_CLASS(fu_archive_parent_class)->finalize(obj);
 }
@@ -56,6 +79,64 @@ fu_archive_init(FuArchive *self)
 {
 	self->entries =
 	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_bytes_unref);
+	self->cache = g_queue_new();
+	self->cache_size_max = FU_ARCHIVE_CACHE_SIZE_MAX_DEFAULT;
+}
+
+static void
+fu_archive_cache_remove(FuArchive *self, const gchar *fn)
+{
+	GBytes *bytes;
+	GList *l = g_queue_find_custom(self->cache, fn, (GCompareFunc)g_strcmp0);
+
+	if (l == NULL)
+		return;
+	bytes = g_hash_table_lookup(self->entries, fn);
+	if (bytes != NULL)
+		self->cache_size -= g_bytes_get_size(bytes);
+	g_free(l->data);
+	g_queue_delete_link(self->cache, l);
+}
+
+/* drop the least recently used lazy entries, but always keep the newest */
+static void
+fu_archive_cache_evict(FuArchive *self)
+{
+	while (self->cache_size > self->cache_size_max && g_queue_get_length(self->cache) > 1) {
+		g_autofree gchar *fn = g_queue_pop_tail(self->cache);
+		GBytes *bytes = g_hash_table_lookup(self->entries, fn);
+		if (bytes != NULL)
+			self->cache_size -= g_bytes_get_size(bytes);
+		g_debug("evicting %s from cache", fn);
+		g_hash_table_remove(self->entries, fn);
+	}
+}
+
+static void
+fu_archive_cache_add(FuArchive *self, const gchar *fn, GBytes *blob)
+{
+	g_hash_table_insert(self->entries, g_strdup(fn), g_bytes_ref(blob));
+	g_queue_push_head(self->cache, g_strdup(fn));
+	self->cache_size += g_bytes_get_size(blob);
+	fu_archive_cache_evict(self);
+}
+
+/**
+ * fu_archive_set_cache_size_max:
+ * @self: a #FuArchive
+ * @cache_size_max: size in bytes
+ *
+ * Sets the maximum size of the decompressed files that are kept in memory when using
+ * %FU_ARCHIVE_FLAG_LAZY. The most recently looked up file is always kept.
+ *
+ * Since: 2.0.7
+ **/
+void
+fu_archive_set_cache_size_max(FuArchive *self, gsize cache_size_max)
+{
+	g_return_if_fail(FU_IS_ARCHIVE(self));
+	self->cache_size_max = cache_size_max;
+	fu_archive_cache_evict(self);
 }
 
 /**
@@ -74,9 +155,27 @@ fu_archive_add_entry(FuArchive *self, const gchar *fn, GBytes *blob)
 	g_return_if_fail(FU_IS_ARCHIVE(self));
 	g_return_if_fail(fn != NULL);
 	g_return_if_fail(blob != NULL);
+
+	/* this replaces any lazy entry, and is never evicted */
+	if (self->lazy_entries != NULL) {
+		fu_archive_cache_remove(self, fn);
+		g_hash_table_remove(self->lazy_entries, fn);
+	}
 	g_hash_table_insert(self->entries, g_strdup(fn), g_bytes_ref(blob));
 }
 
+static gboolean
+fu_archive_lookup_by_fn_cb(FuArchive *self,
+			   const gchar *fn,
+			   GBytes *bytes,
+			   gpointer user_data,
+			   GError **error)
+{
+	GBytes **bytes_out = (GBytes **)user_data;
+	*bytes_out = g_bytes_ref(bytes);
+	return TRUE;
+}
+
 /**
  * fu_archive_lookup_by_fn:
  * @self: a #FuArchive
@@ -85,6 +184,8 @@ fu_archive_add_entry(FuArchive *self, const gchar *fn, GBytes *blob)
  *
  * Finds the blob referenced by filename
  *
+ * If the archive was created with %FU_ARCHIVE_FLAG_LAZY then the file is decompressed now.
+ *
  * Returns: (transfer full): a #GBytes, or %NULL if the filename was not found
  *
  * Since: 1.2.2
@@ -93,17 +194,41 @@ GBytes *
 fu_archive_lookup_by_fn(FuArchive *self, const gchar *fn, GError **error)
 {
 	GBytes *bytes;
+	guint idx = 0;
+	g_autoptr(GBytes) bytes_lazy = NULL;
 
 	g_return_val_if_fail(FU_IS_ARCHIVE(self), NULL);
 	g_return_val_if_fail(fn != NULL, NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
+	if (self->lazy_entries != NULL)
+		idx = GPOINTER_TO_UINT(g_hash_table_lookup(self->lazy_entries, fn));
 	bytes = g_hash_table_lookup(self->entries, fn);
-	if (bytes == NULL) {
+	if (bytes != NULL) {
+		/* mark as most recently used */
+		if (idx != 0) {
+			GList *l = g_queue_find_custom(self->cache, fn, (GCompareFunc)g_strcmp0);
+			if (l != NULL) {
+				g_queue_unlink(self->cache, l);
+				g_queue_push_head_link(self->cache, l);
+			}
+		}
+		return g_bytes_ref(bytes);
+	}
+	if (idx == 0) {
+		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND, "no blob for %s", fn);
+		return NULL;
+	}
+
+	/* decompress just this file */
+	if (!fu_archive_lazy_read(self, idx, fu_archive_lookup_by_fn_cb, &bytes_lazy, error))
+		return NULL;
+	if (bytes_lazy == NULL) {
 		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND, "no blob for %s", fn);
 		return NULL;
 	}
-	return g_bytes_ref(bytes);
+	fu_archive_cache_add(self, fn, bytes_lazy);
+	return g_steal_pointer(&bytes_lazy);
 }
 
 /**
@@ -116,6 +241,9 @@ fu_archive_lookup_by_fn(FuArchive *self, const gchar *fn, GError **error)
  * Iterates over the archive contents, calling the given function for each
  * of the files found. If any @callback returns %FALSE scanning is aborted.
  *
+ * If the archive was created with %FU_ARCHIVE_FLAG_LAZY then each file is decompressed in turn,
+ * and is not kept in memory.
+ *
  * Returns: True if no @callback returned FALSE
  *
  * Since: 1.3.4
@@ -135,9 +263,14 @@ fu_archive_iterate(FuArchive *self,
 
 	g_hash_table_iter_init(&iter, self->entries);
 	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		/* cached copy of a lazy entry */
+		if (self->lazy_entries != NULL && g_hash_table_contains(self->lazy_entries, key))
+			continue;
 		if (!callback(self, (const gchar *)key, (GBytes *)value, user_data, error))
 			return FALSE;
 	}
+	if (self->lazy_entries != NULL)
+		return fu_archive_lazy_read(self, 0, callback, user_data, error);
 	return TRUE;
 }
 
@@ -259,17 +392,181 @@ fu_archive_read_new(GError **error)
 	return g_steal_pointer(&arch);
 }
 
+typedef struct {
+	GInputStream *stream;
+	guint8 buf[0x8000];
+} FuArchiveStreamHelper;
+
+static gint64
+fu_archive_skip_cb(struct archive *arch, void *client_data, off_t request)
+{
+	FuArchiveStreamHelper *helper = (FuArchiveStreamHelper *)client_data;
+	gssize cnt;
+	g_autoptr(GError) error_local = NULL;
+
+	cnt = g_input_stream_skip(helper->stream, request, NULL, &error_local);
+	if (cnt < 0) {
+		archive_set_error(arch,
+				  ARCHIVE_FAILED,
+				  "failed to read from stream: %s",
+				  error_local->message);
+		return -1;
+	}
+	return cnt;
+}
+
+static gssize
+fu_archive_read_cb(struct archive *arch, void *client_data, const void **buffer)
+{
+	FuArchiveStreamHelper *helper = (FuArchiveStreamHelper *)client_data;
+	gssize cnt;
+	g_autoptr(GError) error_local = NULL;
+
+	cnt = g_input_stream_read(helper->stream,
+				  helper->buf,
+				  sizeof(helper->buf),
+				  NULL,
+				  &error_local);
+	if (cnt < 0) {
+		archive_set_error(arch,
+				  ARCHIVE_FAILED,
+				  "failed to read from stream: %s",
+				  error_local->message);
+		return -1;
+	}
+	if (cnt > 0)
+		*buffer = helper->buf;
+	return cnt;
+}
+
+static GSeekType
+fu_archive_whence_to_seek_type(gint whence)
+{
+	if (whence == SEEK_SET)
+		return G_SEEK_SET;
+	if (whence == SEEK_END)
+		return G_SEEK_END;
+	return G_SEEK_CUR;
+}
+
+static gint64
+fu_archive_seek_cb(struct archive *arch, void *client_data, gint64 offset, gint whence)
+{
+	FuArchiveStreamHelper *helper = (FuArchiveStreamHelper *)client_data;
+	g_autoptr(GError) error_local = NULL;
+	if (!g_seekable_seek(G_SEEKABLE(helper->stream),
+			     offset,
+			     fu_archive_whence_to_seek_type(whence),
+			     NULL,
+			     &error_local)) {
+		archive_set_error(arch,
+				  ARCHIVE_FAILED,
+				  "failed to read from stream: %s",
+				  error_local->message);
+		return -1;
+	}
+	return g_seekable_tell(G_SEEKABLE(helper->stream));
+}
+
+/* @helper has to outlive the returned context */
+static _archive_read_ctx *
+fu_archive_read_open(FuArchive *self, FuArchiveStreamHelper *helper, GError **error)
+{
+	int r;
+	g_autoptr(_archive_read_ctx) arch = NULL;
+
+	arch = fu_archive_read_new(error);
+	if (arch == NULL)
+		return NULL;
+	if (self->stream != NULL) {
+		if (!g_seekable_seek(G_SEEKABLE(self->stream), 0x0, G_SEEK_SET, NULL, error))
+			return NULL;
+		helper->stream = self->stream;
+		archive_read_set_seek_callback(arch, fu_archive_seek_cb);
+		archive_read_set_read_callback(arch, fu_archive_read_cb);
+		archive_read_set_skip_callback(arch, fu_archive_skip_cb);
+		archive_read_set_callback_data(arch, helper);
+		r = archive_read_open1(arch);
+	} else {
+		r = archive_read_open_memory(arch,
+					     (void *)g_bytes_get_data(self->data, NULL),
+					     (size_t)g_bytes_get_size(self->data));
+	}
+	if (r != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "cannot open: %s",
+			    archive_error_string(arch));
+		return NULL;
+	}
+	return g_steal_pointer(&arch);
+}
+
+static GBytes *
+fu_archive_read_data(_archive_read_ctx *arch,
+		     struct archive_entry *entry,
+		     const gchar *fn,
+		     GError **error)
+{
+	gint64 bufsz;
+	gssize rc;
+	g_autofree guint8 *buf = NULL;
+
+	if (!archive_entry_size_is_set(entry)) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "%s entry does not have size set",
+			    fn);
+		return NULL;
+	}
+	bufsz = archive_entry_size(entry);
+	if (bufsz > 1024 * 1024 * 1024) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "cannot read huge files");
+		return NULL;
+	}
+	buf = g_malloc(bufsz);
+	rc = archive_read_data(arch, buf, (gsize)bufsz);
+	if (rc < 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_READ,
+			    "cannot read data: %s",
+			    archive_error_string(arch));
+		return NULL;
+	}
+	if (rc != bufsz) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_READ,
+			    "read %" G_GSSIZE_FORMAT " of %" G_GINT64_FORMAT,
+			    rc,
+			    bufsz);
+		return NULL;
+	}
+	return g_bytes_new_take(g_steal_pointer(&buf), bufsz);
+}
+
+static gchar *
+fu_archive_entry_get_key(FuArchive *self, const gchar *fn)
+{
+	if (self->flags & FU_ARCHIVE_FLAG_IGNORE_PATH)
+		return g_path_get_basename(fn);
+	return g_strdup(fn);
+}
+
 static gboolean
-fu_archive_read(FuArchive *self, _archive_read_ctx *arch, FuArchiveFlags flags, GError **error)
+fu_archive_read(FuArchive *self, _archive_read_ctx *arch, GError **error)
 {
 	int r;
-	while (TRUE) {
+	for (guint idx = 1;; idx++) {
 		const gchar *fn;
-		gint64 bufsz;
-		gssize rc;
 		struct archive_entry *entry;
 		g_autofree gchar *fn_key = NULL;
-		g_autofree guint8 *buf = NULL;
 		g_autoptr(GBytes) bytes = NULL;
 
 		r = archive_read_next_header(arch, &entry);
@@ -284,58 +581,118 @@ fu_archive_read(FuArchive *self, _archive_read_ctx *arch, FuArchiveFlags flags,
 			return FALSE;
 		}
 
+		/* a compression filter has to decompress everything to skip over the data, so
+		 * keep each entry now rather than decompressing it all again for each lookup */
+		if (idx == 1 && self->lazy_entries != NULL && archive_filter_count(arch) > 1) {
+			g_debug("archive uses %s compression, so not lazy",
+				archive_filter_name(arch, 0));
+			g_clear_pointer(&self->lazy_entries, g_hash_table_unref);
+		}
+
 		/* only extract if valid */
 		fn = archive_entry_pathname(entry);
 		if (fn == NULL)
 			continue;
-		if (!archive_entry_size_is_set(entry)) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_INVALID_DATA,
-				    "%s entry does not have size set",
-				    fn);
-			return FALSE;
-		}
-		bufsz = archive_entry_size(entry);
-		if (bufsz > 1024 * 1024 * 1024) {
-			g_set_error_literal(error,
+		fn_key = fu_archive_entry_get_key(self, fn);
+
+		/* just record the position, any later entry with the same name wins */
+		if (self->lazy_entries != NULL) {
+			if (!archive_entry_size_is_set(entry)) {
+				g_set_error(error,
 					    FWUPD_ERROR,
-					    FWUPD_ERROR_NOT_SUPPORTED,
-					    "cannot read huge files");
-			return FALSE;
+					    FWUPD_ERROR_INVALID_DATA,
+					    "%s entry does not have size set",
+					    fn);
+				return FALSE;
+			}
+			g_debug("indexing %s [%" G_GINT64_FORMAT "]",
+				fn_key,
+				(gint64)archive_entry_size(entry));
+			g_hash_table_insert(self->lazy_entries,
+					    g_steal_pointer(&fn_key),
+					    GUINT_TO_POINTER(idx));
+			continue;
 		}
-		buf = g_malloc(bufsz);
-		rc = archive_read_data(arch, buf, (gsize)bufsz);
-		if (rc < 0) {
+
+		bytes = fu_archive_read_data(arch, entry, fn, error);
+		if (bytes == NULL)
+			return FALSE;
+		g_debug("adding %s [%" G_GSIZE_FORMAT "]", fn_key, g_bytes_get_size(bytes));
+		fu_archive_add_entry(self, fn_key, bytes);
+	}
+
+	/* success */
+	return TRUE;
+}
+
+/* decompress the entry at @idx, or every lazy entry if @idx is zero */
+static gboolean
+fu_archive_lazy_read(FuArchive *self,
+		     guint idx,
+		     FuArchiveIterateFunc callback,
+		     gpointer user_data,
+		     GError **error)
+{
+	g_autofree FuArchiveStreamHelper *helper = g_new0(FuArchiveStreamHelper, 1);
+	g_autoptr(_archive_read_ctx) arch = NULL;
+
+	arch = fu_archive_read_open(self, helper, error);
+	if (arch == NULL)
+		return FALSE;
+	for (guint idx_tmp = 1;; idx_tmp++) {
+		const gchar *fn;
+		int r;
+		struct archive_entry *entry;
+		g_autofree gchar *fn_key = NULL;
+		g_autoptr(GBytes) bytes = NULL;
+
+		r = archive_read_next_header(arch, &entry);
+		if (r == ARCHIVE_EOF)
+			break;
+		if (r != ARCHIVE_OK) {
 			g_set_error(error,
 				    FWUPD_ERROR,
-				    FWUPD_ERROR_READ,
-				    "cannot read data: %s",
+				    FWUPD_ERROR_INVALID_DATA,
+				    "cannot read header: %s",
 				    archive_error_string(arch));
 			return FALSE;
 		}
-		if (rc != bufsz) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_READ,
-				    "read %" G_GSSIZE_FORMAT " of %" G_GINT64_FORMAT,
-				    rc,
-				    bufsz);
+		if (idx != 0 && idx_tmp != idx)
+			continue;
+		fn = archive_entry_pathname(entry);
+		if (fn == NULL)
+			continue;
+
+		/* replaced by a later entry, or by fu_archive_add_entry() */
+		fn_key = fu_archive_entry_get_key(self, fn);
+		if (GPOINTER_TO_UINT(g_hash_table_lookup(self->lazy_entries, fn_key)) != idx_tmp)
+			continue;
+		bytes = fu_archive_read_data(arch, entry, fn, error);
+		if (bytes == NULL)
 			return FALSE;
-		}
-		if (flags & FU_ARCHIVE_FLAG_IGNORE_PATH) {
-			fn_key = g_path_get_basename(fn);
-		} else {
-			fn_key = g_strdup(fn);
-		}
-		g_debug("adding %s [%" G_GINT64_FORMAT "]", fn_key, bufsz);
-		bytes = g_bytes_new_take(g_steal_pointer(&buf), bufsz);
-		fu_archive_add_entry(self, fn_key, bytes);
+		if (!callback(self, fn_key, bytes, user_data, error))
+			return FALSE;
+		if (idx != 0)
+			break;
 	}
 
 	/* success */
 	return TRUE;
 }
+#else
+static gboolean
+fu_archive_lazy_read(FuArchive *self,
+		     guint idx,
+		     FuArchiveIterateFunc callback,
+		     gpointer user_data,
+		     GError **error)
+{
+	g_set_error_literal(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "missing libarchive support");
+	return FALSE;
+}
 #endif
 
 /**
@@ -348,6 +705,10 @@ fu_archive_read(FuArchive *self, _archive_read_ctx *arch, FuArchiveFlags flags,
  *
  * If @data is unspecified then a new empty archive is created.
  *
+ * If %FU_ARCHIVE_FLAG_LAZY is set then only the filenames are read, and a reference to @data
+ * is kept so that files can be decompressed when required. This is ignored if the entire archive
+ * is compressed, e.g. `.tar.xz`, as reading the filenames decompresses all the data anyway.
+ *
  * Returns: a #FuArchive, or %NULL if the archive was invalid in any way.
  *
  * Since: 1.2.2
@@ -360,26 +721,23 @@ fu_archive_new(GBytes *data, FuArchiveFlags flags, GError **error)
 
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
+	self->flags = flags;
 	if (data != NULL) {
-		int r;
+		g_autofree FuArchiveStreamHelper *helper = g_new0(FuArchiveStreamHelper, 1);
 		g_autoptr(_archive_read_ctx) arch = NULL;
 
-		arch = fu_archive_read_new(error);
+		self->data = g_bytes_ref(data);
+		if (flags & FU_ARCHIVE_FLAG_LAZY) {
+			self->lazy_entries =
+			    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+		}
+		arch = fu_archive_read_open(self, helper, error);
 		if (arch == NULL)
 			return NULL;
-		r = archive_read_open_memory(arch,
-					     (void *)g_bytes_get_data(data, NULL),
-					     (size_t)g_bytes_get_size(data));
-		if (r != 0) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "cannot open: %s",
-				    archive_error_string(arch));
-			return NULL;
-		}
-		if (!fu_archive_read(self, arch, flags, error))
+		if (!fu_archive_read(self, arch, error))
 			return NULL;
+		if (self->lazy_entries == NULL)
+			g_clear_pointer(&self->data, g_bytes_unref);
 	}
 	return g_steal_pointer(&self);
 #else
@@ -391,84 +749,6 @@ fu_archive_new(GBytes *data, FuArchiveFlags flags, GError **error)
 #endif
 }
 
-#ifdef HAVE_LIBARCHIVE
-typedef struct {
-	GInputStream *stream;
-	guint8 buf[0x8000];
-} FuArchiveStreamHelper;
-
-static gint64
-fu_archive_skip_cb(struct archive *arch, void *client_data, off_t request)
-{
-	FuArchiveStreamHelper *helper = (FuArchiveStreamHelper *)client_data;
-	gssize cnt;
-	g_autoptr(GError) error_local = NULL;
-
-	cnt = g_input_stream_skip(helper->stream, request, NULL, &error_local);
-	if (cnt < 0) {
-		archive_set_error(arch,
-				  ARCHIVE_FAILED,
-				  "failed to read from stream: %s",
-				  error_local->message);
-		return -1;
-	}
-	return cnt;
-}
-
-static gssize
-fu_archive_read_cb(struct archive *arch, void *client_data, const void **buffer)
-{
-	FuArchiveStreamHelper *helper = (FuArchiveStreamHelper *)client_data;
-	gssize cnt;
-	g_autoptr(GError) error_local = NULL;
-
-	cnt = g_input_stream_read(helper->stream,
-				  helper->buf,
-				  sizeof(helper->buf),
-				  NULL,
-				  &error_local);
-	if (cnt < 0) {
-		archive_set_error(arch,
-				  ARCHIVE_FAILED,
-				  "failed to read from stream: %s",
-				  error_local->message);
-		return -1;
-	}
-	if (cnt > 0)
-		*buffer = helper->buf;
-	return cnt;
-}
-
-static GSeekType
-fu_archive_whence_to_seek_type(gint whence)
-{
-	if (whence == SEEK_SET)
-		return G_SEEK_SET;
-	if (whence == SEEK_END)
-		return G_SEEK_END;
-	return G_SEEK_CUR;
-}
-
-static gint64
-fu_archive_seek_cb(struct archive *arch, void *client_data, gint64 offset, gint whence)
-{
-	FuArchiveStreamHelper *helper = (FuArchiveStreamHelper *)client_data;
-	g_autoptr(GError) error_local = NULL;
-	if (!g_seekable_seek(G_SEEKABLE(helper->stream),
-			     offset,
-			     fu_archive_whence_to_seek_type(whence),
-			     NULL,
-			     &error_local)) {
-		archive_set_error(arch,
-				  ARCHIVE_FAILED,
-				  "failed to read from stream: %s",
-				  error_local->message);
-		return -1;
-	}
-	return g_seekable_tell(G_SEEKABLE(helper->stream));
-}
-#endif
-
 /**
  * fu_archive_new_stream:
  * @stream: a #GInputStream
@@ -477,6 +757,10 @@ fu_archive_seek_cb(struct archive *arch, void *client_data, gint64 offset, gint
  *
  * Parses @stream as an archive and decompresses all files to memory blobs.
  *
+ * If %FU_ARCHIVE_FLAG_LAZY is set then only the filenames are read, and a reference to @stream
+ * is kept so that files can be decompressed when required. This is ignored if the entire archive
+ * is compressed, e.g. `.tar.xz`, as reading the filenames decompresses all the data anyway.
+ *
  * Returns: a #FuArchive, or %NULL if the archive was invalid in any way.
  *
  * Since: 2.0.0
@@ -486,34 +770,23 @@ fu_archive_new_stream(GInputStream *stream, FuArchiveFlags flags, GError **error
 {
 #ifdef HAVE_LIBARCHIVE
 	g_autoptr(FuArchive) self = g_object_new(FU_TYPE_ARCHIVE, NULL);
+	g_autofree FuArchiveStreamHelper *helper = g_new0(FuArchiveStreamHelper, 1);
 	g_autoptr(_archive_read_ctx) arch = NULL;
-	FuArchiveStreamHelper helper = {.stream = stream};
-	int r;
 
 	g_return_val_if_fail(G_INPUT_STREAM(stream), NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
-	if (!g_seekable_seek(G_SEEKABLE(stream), 0x0, G_SEEK_SET, NULL, error))
-		return NULL;
-
-	arch = fu_archive_read_new(error);
+	self->flags = flags;
+	self->stream = g_object_ref(stream);
+	if (flags & FU_ARCHIVE_FLAG_LAZY)
+		self->lazy_entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	arch = fu_archive_read_open(self, helper, error);
 	if (arch == NULL)
 		return NULL;
-	archive_read_set_seek_callback(arch, fu_archive_seek_cb);
-	archive_read_set_read_callback(arch, fu_archive_read_cb);
-	archive_read_set_skip_callback(arch, fu_archive_skip_cb);
-	archive_read_set_callback_data(arch, &helper);
-	r = archive_read_open1(arch);
-	if (r != 0) {
-		g_set_error(error,
-			    FWUPD_ERROR,
-			    FWUPD_ERROR_NOT_SUPPORTED,
-			    "cannot open: %s",
-			    archive_error_string(arch));
-		return NULL;
-	}
-	if (!fu_archive_read(self, arch, flags, error))
+	if (!fu_archive_read(self, arch, error))
 		return NULL;
+	if (self->lazy_entries == NULL)
+		g_clear_object(&self->stream);
 	return g_steal_pointer(&self);
 #else
 	g_set_error_literal(error,
@@ -532,6 +805,45 @@ fu_archive_write_cb(struct archive *arch, void *user_data, const void *buf, gsiz
 	g_byte_array_append(blob, buf, bufsz);
 	return (gssize)bufsz;
 }
+
+static gboolean
+fu_archive_write_entry_cb(FuArchive *self,
+			  const gchar *fn,
+			  GBytes *bytes,
+			  gpointer user_data,
+			  GError **error)
+{
+	_archive_write_ctx *arch = (_archive_write_ctx *)user_data;
+	int r;
+	gssize rc;
+	g_autoptr(_archive_entry_ctx) entry = NULL;
+
+	entry = archive_entry_new();
+	archive_entry_set_pathname(entry, fn);
+	archive_entry_set_filetype(entry, AE_IFREG);
+	archive_entry_set_perm(entry, 0644);
+	archive_entry_set_size(entry, g_bytes_get_size(bytes));
+
+	r = archive_write_header(arch, entry);
+	if (r != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "cannot write header: %s",
+			    archive_error_string(arch));
+		return FALSE;
+	}
+	rc = archive_write_data(arch, g_bytes_get_data(bytes, NULL), g_bytes_get_size(bytes));
+	if (rc < 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_WRITE,
+			    "cannot write data: %s",
+			    archive_error_string(arch));
+		return FALSE;
+	}
+	return TRUE;
+}
 #endif
 
 /**
@@ -557,7 +869,6 @@ fu_archive_write(FuArchive *self,
 	int r;
 	g_autoptr(_archive_write_ctx) arch = NULL;
 	g_autoptr(GByteArray) blob = g_byte_array_new();
-	g_autoptr(GList) keys = NULL;
 
 	g_return_val_if_fail(FU_IS_ARCHIVE(self), NULL);
 	g_return_val_if_fail(format != FU_ARCHIVE_FORMAT_UNKNOWN, NULL);
@@ -601,40 +912,8 @@ fu_archive_write(FuArchive *self,
 		return NULL;
 	}
 
-	keys = g_hash_table_get_keys(self->entries);
-	for (GList *l = keys; l != NULL; l = l->next) {
-		const gchar *fn = l->data;
-		GBytes *bytes = g_hash_table_lookup(self->entries, fn);
-		gssize rc;
-		g_autoptr(_archive_entry_ctx) entry = NULL;
-
-		entry = archive_entry_new();
-		archive_entry_set_pathname(entry, fn);
-		archive_entry_set_filetype(entry, AE_IFREG);
-		archive_entry_set_perm(entry, 0644);
-		archive_entry_set_size(entry, g_bytes_get_size(bytes));
-
-		r = archive_write_header(arch, entry);
-		if (r != 0) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "cannot write header: %s",
-				    archive_error_string(arch));
-			return NULL;
-		}
-		rc = archive_write_data(arch,
-					g_bytes_get_data(bytes, NULL),
-					g_bytes_get_size(bytes));
-		if (rc < 0) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_WRITE,
-				    "cannot write data: %s",
-				    archive_error_string(arch));
-			return NULL;
-		}
-	}
+	if (!fu_archive_iterate(self, fu_archive_write_entry_cb, arch, error))
+		return NULL;
 
 	r = archive_write_close(arch);
 	if (r != 0) {
@@ -0,0 +1,16 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include "fu-bluez-device.h"
+
+gboolean
+fu_bluez_device_write_chunks_io(FuIOChannel *io,
+				gsize mtu,
+				FuChunkArray *chunks,
+				FuProgress *progress,
+				GError **error) G_GNUC_NON_NULL(1, 3, 4);
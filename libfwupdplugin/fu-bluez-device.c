@@ -12,13 +12,16 @@
 #include <gio/gunixfdlist.h>
 #include <string.h>
 
-#include "fu-bluez-device.h"
+#include "fu-bluez-device-private.h"
 #include "fu-dump.h"
 #include "fu-firmware-common.h"
 #include "fu-string.h"
 
 #define DEFAULT_PROXY_TIMEOUT 5000
 
+/* opcode and attribute handle of the ATT write command */
+#define FU_BLUEZ_DEVICE_ATT_HEADER_SIZE 3
+
 /**
  * FuBluezDevice:
  *
@@ -984,6 +987,134 @@ fu_bluez_device_write_acquire(FuBluezDevice *self, const gchar *uuid, gint32 *mt
 	return fu_bluez_device_method_acquire(self, "AcquireWrite", uuid, mtu, error);
 }
 
+/* each write on the SOCK_SEQPACKET socket is sent as one ATT write command */
+gboolean
+fu_bluez_device_write_chunks_io(FuIOChannel *io,
+				gsize mtu,
+				FuChunkArray *chunks,
+				FuProgress *progress,
+				GError **error)
+{
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_set_steps(progress, fu_chunk_array_length(chunks));
+	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
+		g_autoptr(FuChunk) chk = NULL;
+
+		chk = fu_chunk_array_index(chunks, i, error);
+		if (chk == NULL)
+			return FALSE;
+		if (fu_chunk_get_data_sz(chk) + FU_BLUEZ_DEVICE_ATT_HEADER_SIZE > mtu) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_DATA,
+				    "chunk of 0x%x bytes too large for MTU of 0x%x",
+				    (guint)fu_chunk_get_data_sz(chk),
+				    (guint)mtu);
+			return FALSE;
+		}
+		if (!fu_io_channel_write_raw(io,
+					     fu_chunk_get_data(chk),
+					     fu_chunk_get_data_sz(chk),
+					     DEFAULT_PROXY_TIMEOUT,
+					     FU_IO_CHANNEL_FLAG_NONE,
+					     error)) {
+			g_prefix_error(error, "failed to write chunk 0x%x: ", i);
+			return FALSE;
+		}
+		fu_progress_step_done(progress);
+	}
+
+	/* success */
+	return TRUE;
+}
+
+static gboolean
+fu_bluez_device_write_chunks_fallback(FuBluezDevice *self,
+				      const gchar *uuid,
+				      FuChunkArray *chunks,
+				      FuProgress *progress,
+				      GError **error)
+{
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_set_steps(progress, fu_chunk_array_length(chunks));
+	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
+		g_autoptr(FuChunk) chk = NULL;
+		g_autoptr(GByteArray) buf = g_byte_array_new();
+
+		chk = fu_chunk_array_index(chunks, i, error);
+		if (chk == NULL)
+			return FALSE;
+		g_byte_array_append(buf, fu_chunk_get_data(chk), fu_chunk_get_data_sz(chk));
+		if (!fu_bluez_device_write(self, uuid, buf, error)) {
+			g_prefix_error(error, "failed to write chunk 0x%x: ", i);
+			return FALSE;
+		}
+		fu_progress_step_done(progress);
+	}
+
+	/* success */
+	return TRUE;
+}
+
+/**
+ * fu_bluez_device_write_chunks:
+ * @self: a #FuBluezDevice
+ * @uuid: the UUID, e.g. `00cde35c-7062-11eb-9439-0242ac130002`
+ * @chunks: a #FuChunkArray, where each chunk is sent as one packet
+ * @progress: a #FuProgress
+ * @error: (nullable): optional return location for an error
+ *
+ * Writes a sequence of packets to a UUID on the device.
+ *
+ * If the characteristic supports write-without-response then the packets are streamed to the
+ * socket returned by `AcquireWrite`, which avoids a D-Bus round-trip for every packet.
+ * Otherwise, or if any chunk is too large for the negotiated MTU, each packet is written using
+ * fu_bluez_device_write().
+ *
+ * Returns: %TRUE if all the data was written
+ *
+ * Since: 2.0.7
+ **/
+gboolean
+fu_bluez_device_write_chunks(FuBluezDevice *self,
+			     const gchar *uuid,
+			     FuChunkArray *chunks,
+			     FuProgress *progress,
+			     GError **error)
+{
+	gint32 mtu = 0;
+	g_autoptr(FuIOChannel) io = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	g_return_val_if_fail(FU_IS_BLUEZ_DEVICE(self), FALSE);
+	g_return_val_if_fail(uuid != NULL, FALSE);
+	g_return_val_if_fail(chunks != NULL, FALSE);
+	g_return_val_if_fail(FU_IS_PROGRESS(progress), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* the characteristic is locked until the socket is closed */
+	io = fu_bluez_device_method_acquire(self, "AcquireWrite", uuid, &mtu, &error_local);
+	if (io == NULL) {
+		g_debug("falling back to WriteValue: %s", error_local->message);
+		return fu_bluez_device_write_chunks_fallback(self, uuid, chunks, progress, error);
+	}
+	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
+		g_autoptr(FuChunk) chk = fu_chunk_array_index(chunks, i, error);
+		if (chk == NULL)
+			return FALSE;
+		if (fu_chunk_get_data_sz(chk) + FU_BLUEZ_DEVICE_ATT_HEADER_SIZE > (gsize)mtu) {
+			g_debug("falling back to WriteValue as MTU is only 0x%x", (guint)mtu);
+			g_clear_object(&io);
+			return fu_bluez_device_write_chunks_fallback(self,
+								     uuid,
+								     chunks,
+								     progress,
+								     error);
+		}
+	}
+	return fu_bluez_device_write_chunks_io(io, mtu, chunks, progress, error);
+}
+
 static void
 fu_bluez_device_incorporate(FuDevice *self, FuDevice *donor)
 {
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "fu-chunk-array.h"
 #include "fu-device.h"
 #include "fu-io-channel.h"
 
@@ -46,3 +47,9 @@ fu_bluez_device_notify_acquire(FuBluezDevice *self, const gchar *uuid, gint32 *m
 FuIOChannel *
 fu_bluez_device_write_acquire(FuBluezDevice *self, const gchar *uuid, gint32 *mtu, GError **error)
     G_GNUC_NON_NULL(1, 2, 3);
+gboolean
+fu_bluez_device_write_chunks(FuBluezDevice *self,
+			     const gchar *uuid,
+			     FuChunkArray *chunks,
+			     FuProgress *progress,
+			     GError **error) G_GNUC_NON_NULL(1, 2, 3, 4);
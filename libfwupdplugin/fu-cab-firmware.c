@@ -14,6 +14,7 @@
 #include "fu-bytes.h"
 #include "fu-cab-firmware-private.h"
 #include "fu-cab-image.h"
+#include "fu-cab-mszip-input-stream.h"
 #include "fu-cab-struct.h"
 #include "fu-chunk-array.h"
 #include "fu-common.h"
@@ -26,6 +27,7 @@
 typedef struct {
 	gboolean compressed;
 	gboolean only_basename;
+	guint max_threads;
 } FuCabFirmwarePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(FuCabFirmware, fu_cab_firmware, FU_TYPE_FIRMWARE)
@@ -34,8 +36,6 @@ G_DEFINE_TYPE_WITH_PRIVATE(FuCabFirmware, fu_cab_firmware, FU_TYPE_FIRMWARE)
 #define FU_CAB_FIRMWARE_MAX_FILES   1024
 #define FU_CAB_FIRMWARE_MAX_FOLDERS 64
 
-#define FU_CAB_FIRMWARE_DECOMPRESS_BUFSZ 0x4000 /* bytes */
-
 /**
  * fu_cab_firmware_get_compressed:
  * @self: a #FuCabFirmware
@@ -106,6 +106,24 @@ fu_cab_firmware_set_only_basename(FuCabFirmware *self, gboolean only_basename)
 	priv->only_basename = only_basename;
 }
 
+/**
+ * fu_cab_firmware_set_max_threads:
+ * @self: a #FuCabFirmware
+ * @max_threads: number of threads, or 0 for the number of processors
+ *
+ * Sets the maximum number of threads used to compress the CFDATA blocks when writing.
+ * The output does not depend on the number of threads.
+ *
+ * Since: 2.0.7
+ **/
+void
+fu_cab_firmware_set_max_threads(FuCabFirmware *self, guint max_threads)
+{
+	FuCabFirmwarePrivate *priv = GET_PRIVATE(self);
+	g_return_if_fail(FU_IS_CAB_FIRMWARE(self));
+	priv->max_threads = max_threads;
+}
+
 typedef struct {
 	GInputStream *stream;
 	FwupdInstallFlags install_flags;
@@ -113,21 +131,16 @@ typedef struct {
 	gsize rsvd_block;
 	gsize size_total;
 	FuCabCompression compression;
-	GPtrArray *folder_data; /* of FuCompositeInputStream */
-	z_stream zstrm;
-	guint8 *decompress_buf;
-	gsize decompress_bufsz;
+	GPtrArray *folder_data; /* of FuCompositeInputStream or FuCabMszipInputStream */
 } FuCabFirmwareParseHelper;
 
 static void
 fu_cab_firmware_parse_helper_free(FuCabFirmwareParseHelper *helper)
 {
-	inflateEnd(&helper->zstrm);
 	if (helper->stream != NULL)
 		g_object_unref(helper->stream);
 	if (helper->folder_data != NULL)
 		g_ptr_array_unref(helper->folder_data);
-	g_free(helper->decompress_buf);
 	g_free(helper);
 }
 
@@ -272,27 +285,21 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 		}
 	}
 
-	/* decompress Zlib data after removing *another *header... */
+	/* the Zlib data is only inflated when read, after removing *another* header... */
 	if (helper->compression == FU_CAB_COMPRESSION_MSZIP) {
-		int zret;
+		guint8 buf[2] = {0x0};
 		g_autofree gchar *kind = NULL;
-		g_autoptr(GByteArray) buf = g_byte_array_new();
-		g_autoptr(GBytes) bytes_comp = NULL;
-		g_autoptr(GBytes) bytes_uncomp = NULL;
 
 		/* check compressed header */
-		bytes_comp = fu_input_stream_read_bytes(helper->stream,
-							*offset + hdr_sz,
-							blob_comp,
-							NULL,
-							error);
-		if (bytes_comp == NULL)
+		if (!fu_input_stream_read_safe(helper->stream,
+					       buf,
+					       sizeof(buf),
+					       0x0,
+					       *offset + hdr_sz,
+					       MIN(blob_comp, sizeof(buf)),
+					       error))
 			return FALSE;
-		kind = fu_memstrsafe(g_bytes_get_data(bytes_comp, NULL),
-				     g_bytes_get_size(bytes_comp),
-				     0x0,
-				     2,
-				     error);
+		kind = fu_memstrsafe(buf, MIN(blob_comp, sizeof(buf)), 0x0, sizeof(buf), error);
 		if (kind == NULL)
 			return FALSE;
 		if (g_strcmp0(kind, "CK") != 0) {
@@ -303,51 +310,12 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 				    kind);
 			return FALSE;
 		}
-		if (helper->decompress_buf == NULL)
-			helper->decompress_buf = g_malloc0(helper->decompress_bufsz);
-		helper->zstrm.avail_in = g_bytes_get_size(bytes_comp) - 2;
-		helper->zstrm.next_in = (z_const Bytef *)g_bytes_get_data(bytes_comp, NULL) + 2;
-		while (1) {
-			helper->zstrm.avail_out = helper->decompress_bufsz;
-			helper->zstrm.next_out = helper->decompress_buf;
-			zret = inflate(&helper->zstrm, Z_BLOCK);
-			if (zret == Z_STREAM_END)
-				break;
-			g_byte_array_append(buf,
-					    helper->decompress_buf,
-					    helper->decompress_bufsz - helper->zstrm.avail_out);
-			if (zret != Z_OK) {
-				g_set_error(error,
-					    FWUPD_ERROR,
-					    FWUPD_ERROR_NOT_SUPPORTED,
-					    "inflate error @0x%x: %s",
-					    (guint)*offset,
-					    zError(zret));
-				return FALSE;
-			}
-		}
-		zret = inflateReset(&helper->zstrm);
-		if (zret != Z_OK) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "failed to reset inflate: %s",
-				    zError(zret));
+		if (!fu_cab_mszip_input_stream_add_block(FU_CAB_MSZIP_INPUT_STREAM(folder_data),
+							 *offset + hdr_sz + sizeof(buf),
+							 blob_comp - sizeof(buf),
+							 blob_uncomp,
+							 error))
 			return FALSE;
-		}
-		zret = inflateSetDictionary(&helper->zstrm, buf->data, buf->len);
-		if (zret != Z_OK) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_NOT_SUPPORTED,
-				    "failed to set inflate dictionary: %s",
-				    zError(zret));
-			return FALSE;
-		}
-		bytes_uncomp =
-		    g_byte_array_free_to_bytes(g_steal_pointer(&buf)); /* nocheck:blocked */
-		fu_composite_input_stream_add_bytes(FU_COMPOSITE_INPUT_STREAM(folder_data),
-						    bytes_uncomp);
 	} else {
 		fu_composite_input_stream_add_partial_stream(
 		    FU_COMPOSITE_INPUT_STREAM(folder_data),
@@ -359,22 +327,22 @@ fu_cab_firmware_parse_data(FuCabFirmware *self,
 	return TRUE;
 }
 
-static gboolean
+static GInputStream *
 fu_cab_firmware_parse_folder(FuCabFirmware *self,
 			     FuCabFirmwareParseHelper *helper,
 			     guint idx,
 			     gsize offset,
-			     GInputStream *folder_data,
 			     GError **error)
 {
 	FuCabFirmwarePrivate *priv = GET_PRIVATE(self);
 	gsize offset_folder;
 	g_autoptr(GByteArray) st = NULL;
+	g_autoptr(GInputStream) folder_data = NULL;
 
 	/* parse header */
 	st = fu_struct_cab_folder_parse_stream(helper->stream, offset, error);
 	if (st == NULL)
-		return FALSE;
+		return NULL;
 
 	/* sanity check */
 	if (fu_struct_cab_folder_get_ndatab(st) == 0) {
@@ -382,7 +350,7 @@ fu_cab_firmware_parse_folder(FuCabFirmware *self,
 				    FWUPD_ERROR,
 				    FWUPD_ERROR_NOT_SUPPORTED,
 				    "no CFDATA blocks");
-		return FALSE;
+		return NULL;
 	}
 	helper->compression = fu_struct_cab_folder_get_compression(st);
 	if (helper->compression != FU_CAB_COMPRESSION_NONE)
@@ -394,18 +362,25 @@ fu_cab_firmware_parse_folder(FuCabFirmware *self,
 			    FWUPD_ERROR_NOT_SUPPORTED,
 			    "compression %s not supported",
 			    fu_cab_compression_to_string(helper->compression));
-		return FALSE;
+		return NULL;
+	}
+	if (helper->compression == FU_CAB_COMPRESSION_MSZIP) {
+		folder_data = fu_cab_mszip_input_stream_new(helper->stream, error);
+		if (folder_data == NULL)
+			return NULL;
+	} else {
+		folder_data = fu_composite_input_stream_new();
 	}
 
 	/* parse CDATA */
 	offset_folder = fu_struct_cab_folder_get_offset(st);
 	for (guint i = 0; i < fu_struct_cab_folder_get_ndatab(st); i++) {
 		if (!fu_cab_firmware_parse_data(self, helper, &offset_folder, folder_data, error))
-			return FALSE;
+			return NULL;
 	}
 
 	/* success */
-	return TRUE;
+	return g_steal_pointer(&folder_data);
 }
 
 static gboolean
@@ -508,30 +483,20 @@ fu_cab_firmware_validate(FuFirmware *firmware, GInputStream *stream, gsize offse
 	return fu_struct_cab_header_validate_stream(stream, offset, error);
 }
 
-static FuCabFirmwareParseHelper *
-fu_cab_firmware_parse_helper_new(GInputStream *stream, FwupdInstallFlags flags, GError **error)
+static gboolean
+fu_cab_firmware_sniff(FuFirmware *firmware, const guint8 *buf, gsize bufsz, GError **error)
 {
-	int zret;
-	g_autoptr(FuCabFirmwareParseHelper) helper = g_new0(FuCabFirmwareParseHelper, 1);
-
-	/* zlib */
-	helper->zstrm.zalloc = fu_cab_firmware_zalloc;
-	helper->zstrm.zfree = fu_cab_firmware_zfree;
-	zret = inflateInit2(&helper->zstrm, -MAX_WBITS);
-	if (zret != Z_OK) {
-		g_set_error(error,
-			    FWUPD_ERROR,
-			    FWUPD_ERROR_NOT_SUPPORTED,
-			    "failed to initialize inflate: %s",
-			    zError(zret));
-		return NULL;
-	}
+	return fu_struct_cab_header_validate(buf, bufsz, 0x0, error);
+}
 
+static FuCabFirmwareParseHelper *
+fu_cab_firmware_parse_helper_new(GInputStream *stream, FwupdInstallFlags flags)
+{
+	FuCabFirmwareParseHelper *helper = g_new0(FuCabFirmwareParseHelper, 1);
 	helper->stream = g_object_ref(stream);
 	helper->install_flags = flags;
 	helper->folder_data = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
-	helper->decompress_bufsz = FU_CAB_FIRMWARE_DECOMPRESS_BUFSZ;
-	return g_steal_pointer(&helper);
+	return helper;
 }
 
 static gboolean
@@ -609,9 +574,7 @@ fu_cab_firmware_parse(FuFirmware *firmware,
 	}
 
 	/* create helper */
-	helper = fu_cab_firmware_parse_helper_new(stream, flags, error);
-	if (helper == NULL)
-		return FALSE;
+	helper = fu_cab_firmware_parse_helper_new(stream, flags);
 
 	/* reserved sizes */
 	offset += st->len;
@@ -628,8 +591,9 @@ fu_cab_firmware_parse(FuFirmware *firmware,
 
 	/* parse CFFOLDER */
 	for (guint i = 0; i < fu_struct_cab_header_get_nr_folders(st); i++) {
-		g_autoptr(GInputStream) folder_data = fu_composite_input_stream_new();
-		if (!fu_cab_firmware_parse_folder(self, helper, i, offset, folder_data, error))
+		g_autoptr(GInputStream) folder_data = NULL;
+		folder_data = fu_cab_firmware_parse_folder(self, helper, i, offset, error);
+		if (folder_data == NULL)
 			return FALSE;
 		if (!fu_input_stream_size(folder_data, &streamsz, error))
 			return FALSE;
@@ -654,6 +618,86 @@ fu_cab_firmware_parse(FuFirmware *firmware,
 	return TRUE;
 }
 
+typedef struct {
+	FuCabFirmware *self; /* noref */
+	FuChunk *chk;
+	GByteArray *buf;
+	GError *error;
+} FuCabFirmwareWriteHelper;
+
+static void
+fu_cab_firmware_write_helper_free(FuCabFirmwareWriteHelper *helper)
+{
+	if (helper->chk != NULL)
+		g_object_unref(helper->chk);
+	if (helper->buf != NULL)
+		g_byte_array_unref(helper->buf);
+	if (helper->error != NULL)
+		g_error_free(helper->error);
+	g_free(helper);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuCabFirmwareWriteHelper, fu_cab_firmware_write_helper_free)
+
+static GByteArray *
+fu_cab_firmware_write_chunk(FuCabFirmware *self, FuChunk *chk, GError **error)
+{
+	FuCabFirmwarePrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GByteArray) chunk_zlib = g_byte_array_new();
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+
+	fu_byte_array_set_size(chunk_zlib, fu_chunk_get_data_sz(chk) * 2, 0x0);
+	if (priv->compressed) {
+		int zret;
+		z_stream zstrm = {
+		    .zalloc = fu_cab_firmware_zalloc,
+		    .zfree = fu_cab_firmware_zfree,
+		    .opaque = Z_NULL,
+		    .next_in = (guint8 *)fu_chunk_get_data(chk),
+		    .avail_in = fu_chunk_get_data_sz(chk),
+		    .next_out = chunk_zlib->data,
+		    .avail_out = chunk_zlib->len,
+		};
+		g_autoptr(z_stream_deflater) zstrm_deflater = &zstrm;
+		zret = deflateInit2(zstrm_deflater,
+				    Z_DEFAULT_COMPRESSION,
+				    Z_DEFLATED,
+				    -15,
+				    8,
+				    Z_DEFAULT_STRATEGY);
+		if (zret != Z_OK) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "failed to initialize deflate: %s",
+				    zError(zret));
+			return NULL;
+		}
+		zret = deflate(zstrm_deflater, Z_FINISH);
+		if (zret != Z_OK && zret != Z_STREAM_END) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "zlib deflate failed: %s",
+				    zError(zret));
+			return NULL;
+		}
+		fu_byte_array_append_uint8(buf, (guint8)'C');
+		fu_byte_array_append_uint8(buf, (guint8)'K');
+		g_byte_array_append(buf, chunk_zlib->data, zstrm.total_out);
+	} else {
+		g_byte_array_append(buf, fu_chunk_get_data(chk), fu_chunk_get_data_sz(chk));
+	}
+	return g_steal_pointer(&buf);
+}
+
+static void
+fu_cab_firmware_write_chunk_cb(gpointer data, gpointer user_data)
+{
+	FuCabFirmwareWriteHelper *helper = (FuCabFirmwareWriteHelper *)data;
+	helper->buf = fu_cab_firmware_write_chunk(helper->self, helper->chk, &helper->error);
+}
+
 static GByteArray *
 fu_cab_firmware_write(FuFirmware *firmware, GError **error)
 {
@@ -661,6 +705,7 @@ fu_cab_firmware_write(FuFirmware *firmware, GError **error)
 	FuCabFirmwarePrivate *priv = GET_PRIVATE(self);
 	gsize archive_size;
 	gsize offset;
+	guint max_threads;
 	guint32 index_into = 0;
 	g_autoptr(GByteArray) st_hdr = fu_struct_cab_header_new();
 	g_autoptr(GByteArray) st_folder = fu_struct_cab_folder_new();
@@ -668,6 +713,7 @@ fu_cab_firmware_write(FuFirmware *firmware, GError **error)
 	g_autoptr(GByteArray) cfdata_linear = g_byte_array_new();
 	g_autoptr(GBytes) cfdata_linear_blob = NULL;
 	g_autoptr(FuChunkArray) chunks = NULL;
+	g_autoptr(GPtrArray) helpers = NULL;
 	g_autoptr(GPtrArray) chunks_zlib =
 	    g_ptr_array_new_with_free_func((GDestroyNotify)g_byte_array_unref);
 
@@ -704,57 +750,45 @@ fu_cab_firmware_write(FuFirmware *firmware, GError **error)
 					       FU_CHUNK_ADDR_OFFSET_NONE,
 					       FU_CHUNK_PAGESZ_NONE,
 					       0x8000);
+	helpers = g_ptr_array_new_with_free_func((GDestroyNotify)fu_cab_firmware_write_helper_free);
 	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
-		g_autoptr(FuChunk) chk = NULL;
-		g_autoptr(GByteArray) chunk_zlib = g_byte_array_new();
-		g_autoptr(GByteArray) buf = g_byte_array_new();
+		g_autoptr(FuCabFirmwareWriteHelper) helper = g_new0(FuCabFirmwareWriteHelper, 1);
+		helper->self = self;
+		helper->chk = fu_chunk_array_index(chunks, i, error);
+		if (helper->chk == NULL)
+			return NULL;
+		g_ptr_array_add(helpers, g_steal_pointer(&helper));
+	}
 
-		chk = fu_chunk_array_index(chunks, i, error);
-		if (chk == NULL)
+	/* there is no preset dictionary, so each block can be compressed in any order */
+	max_threads = priv->max_threads > 0 ? priv->max_threads : g_get_num_processors();
+	max_threads = MIN(max_threads, helpers->len);
+	if (priv->compressed && max_threads > 1) {
+		GThreadPool *pool = g_thread_pool_new(fu_cab_firmware_write_chunk_cb,
+						      NULL,
+						      max_threads,
+						      TRUE,
+						      error);
+		if (pool == NULL)
 			return NULL;
-		fu_byte_array_set_size(chunk_zlib, fu_chunk_get_data_sz(chk) * 2, 0x0);
-		if (priv->compressed) {
-			int zret;
-			z_stream zstrm = {
-			    .zalloc = fu_cab_firmware_zalloc,
-			    .zfree = fu_cab_firmware_zfree,
-			    .opaque = Z_NULL,
-			    .next_in = (guint8 *)fu_chunk_get_data(chk),
-			    .avail_in = fu_chunk_get_data_sz(chk),
-			    .next_out = chunk_zlib->data,
-			    .avail_out = chunk_zlib->len,
-			};
-			g_autoptr(z_stream_deflater) zstrm_deflater = &zstrm;
-			zret = deflateInit2(zstrm_deflater,
-					    Z_DEFAULT_COMPRESSION,
-					    Z_DEFLATED,
-					    -15,
-					    8,
-					    Z_DEFAULT_STRATEGY);
-			if (zret != Z_OK) {
-				g_set_error(error,
-					    FWUPD_ERROR,
-					    FWUPD_ERROR_NOT_SUPPORTED,
-					    "failed to initialize deflate: %s",
-					    zError(zret));
+		for (guint i = 0; i < helpers->len; i++) {
+			if (!g_thread_pool_push(pool, g_ptr_array_index(helpers, i), error)) {
+				g_thread_pool_free(pool, TRUE, TRUE);
 				return NULL;
 			}
-			zret = deflate(zstrm_deflater, Z_FINISH);
-			if (zret != Z_OK && zret != Z_STREAM_END) {
-				g_set_error(error,
-					    FWUPD_ERROR,
-					    FWUPD_ERROR_NOT_SUPPORTED,
-					    "zlib deflate failed: %s",
-					    zError(zret));
-				return NULL;
-			}
-			fu_byte_array_append_uint8(buf, (guint8)'C');
-			fu_byte_array_append_uint8(buf, (guint8)'K');
-			g_byte_array_append(buf, chunk_zlib->data, zstrm.total_out);
-		} else {
-			g_byte_array_append(buf, fu_chunk_get_data(chk), fu_chunk_get_data_sz(chk));
 		}
-		g_ptr_array_add(chunks_zlib, g_steal_pointer(&buf));
+		g_thread_pool_free(pool, FALSE, TRUE);
+	} else {
+		for (guint i = 0; i < helpers->len; i++)
+			fu_cab_firmware_write_chunk_cb(g_ptr_array_index(helpers, i), NULL);
+	}
+	for (guint i = 0; i < helpers->len; i++) {
+		FuCabFirmwareWriteHelper *helper = g_ptr_array_index(helpers, i);
+		if (helper->error != NULL) {
+			g_propagate_error(error, g_steal_pointer(&helper->error));
+			return NULL;
+		}
+		g_ptr_array_add(chunks_zlib, g_steal_pointer(&helper->buf));
 	}
 
 	/* create header */
@@ -892,6 +926,7 @@ fu_cab_firmware_class_init(FuCabFirmwareClass *klass)
 {
 	FuFirmwareClass *firmware_class = FU_FIRMWARE_CLASS(klass);
 	firmware_class->validate = fu_cab_firmware_validate;
+	firmware_class->sniff = fu_cab_firmware_sniff;
 	firmware_class->parse = fu_cab_firmware_parse;
 	firmware_class->write = fu_cab_firmware_write;
 	firmware_class->build = fu_cab_firmware_build;
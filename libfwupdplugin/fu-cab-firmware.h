@@ -24,6 +24,8 @@ gboolean
 fu_cab_firmware_get_only_basename(FuCabFirmware *self) G_GNUC_NON_NULL(1);
 void
 fu_cab_firmware_set_only_basename(FuCabFirmware *self, gboolean only_basename) G_GNUC_NON_NULL(1);
+void
+fu_cab_firmware_set_max_threads(FuCabFirmware *self, guint max_threads) G_GNUC_NON_NULL(1);
 
 FuCabFirmware *
 fu_cab_firmware_new(void) G_GNUC_WARN_UNUSED_RESULT;
@@ -0,0 +1,513 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuCabMszipInputStream"
+
+#include "config.h"
+
+#include <zlib.h>
+
+#include "fwupd-codec.h"
+#include "fwupd-error.h"
+
+#include "fu-cab-mszip-input-stream.h"
+#include "fu-input-stream.h"
+#include "fu-mem.h"
+
+/**
+ * FuCabMszipInputStream:
+ *
+ * An input stream for one MSZIP-compressed cabinet CFFOLDER.
+ *
+ * Each CFDATA block is only inflated when it is read, and only a few of the most recently used
+ * blocks are kept in memory. Blocks use the previous uncompressed block as the preset dictionary,
+ * so reading backwards requires inflating again from the nearest cached block.
+ */
+
+#define FU_CAB_MSZIP_INPUT_STREAM_CACHE_MAX	   4
+#define FU_CAB_MSZIP_INPUT_STREAM_DECOMPRESS_BUFSZ 0x4000
+
+typedef struct {
+	gsize offset; /* of the deflate data, after the CK signature */
+	gsize size_comp;
+	gsize offset_uncomp;
+	gsize size_uncomp;
+} FuCabMszipInputStreamBlock;
+
+typedef struct {
+	guint idx;
+	GBytes *blob;
+} FuCabMszipInputStreamCacheItem;
+
+struct _FuCabMszipInputStream {
+	GInputStream parent_instance;
+	GInputStream *stream;
+	GArray *blocks;   /* of FuCabMszipInputStreamBlock */
+	GPtrArray *cache; /* of FuCabMszipInputStreamCacheItem, most recent first */
+	z_stream zstrm;
+	guint8 *decompress_buf;
+	goffset pos;
+	gsize total_size;
+};
+
+static void
+fu_cab_mszip_input_stream_seekable_iface_init(GSeekableIface *iface);
+static void
+fu_cab_mszip_input_stream_codec_iface_init(FwupdCodecInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(FuCabMszipInputStream,
+			fu_cab_mszip_input_stream,
+			G_TYPE_INPUT_STREAM,
+			G_IMPLEMENT_INTERFACE(G_TYPE_SEEKABLE,
+					      fu_cab_mszip_input_stream_seekable_iface_init)
+			    G_IMPLEMENT_INTERFACE(FWUPD_TYPE_CODEC,
+						  fu_cab_mszip_input_stream_codec_iface_init))
+
+static void
+fu_cab_mszip_input_stream_add_string(FwupdCodec *codec, guint idt, GString *str)
+{
+	FuCabMszipInputStream *self = FU_CAB_MSZIP_INPUT_STREAM(codec);
+	fwupd_codec_string_append_hex(str, idt, "Pos", self->pos);
+	fwupd_codec_string_append_hex(str, idt, "TotalSize", self->total_size);
+	fwupd_codec_string_append_int(str, idt, "Blocks", self->blocks->len);
+	fwupd_codec_string_append_int(str, idt, "Cached", self->cache->len);
+}
+
+static void
+fu_cab_mszip_input_stream_codec_iface_init(FwupdCodecInterface *iface)
+{
+	iface->add_string = fu_cab_mszip_input_stream_add_string;
+}
+
+static void
+fu_cab_mszip_input_stream_cache_item_free(FuCabMszipInputStreamCacheItem *item)
+{
+	g_bytes_unref(item->blob);
+	g_free(item);
+}
+
+static voidpf
+fu_cab_mszip_input_stream_zalloc(voidpf opaque, uInt items, uInt size)
+{
+	return g_malloc0_n(items, size);
+}
+
+static void
+fu_cab_mszip_input_stream_zfree(voidpf opaque, voidpf address)
+{
+	g_free(address);
+}
+
+/* decode just the first deflate block header, which does not need the preset dictionary */
+static gboolean
+fu_cab_mszip_input_stream_check_block_header(FuCabMszipInputStream *self,
+					     const FuCabMszipInputStreamBlock *blk,
+					     GError **error)
+{
+	int zret;
+	guint8 dummy = 0x0;
+	g_autoptr(GBytes) bytes_comp = NULL;
+
+	bytes_comp = fu_input_stream_read_bytes(self->stream,
+						blk->offset,
+						blk->size_comp,
+						NULL,
+						error);
+	if (bytes_comp == NULL)
+		return FALSE;
+	zret = inflateReset(&self->zstrm);
+	if (zret != Z_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "failed to reset inflate: %s",
+			    zError(zret));
+		return FALSE;
+	}
+	self->zstrm.avail_in = g_bytes_get_size(bytes_comp);
+	self->zstrm.next_in = (z_const Bytef *)g_bytes_get_data(bytes_comp, NULL);
+	self->zstrm.avail_out = 0;
+	self->zstrm.next_out = &dummy;
+	zret = inflate(&self->zstrm, Z_TREES);
+	if (zret != Z_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "inflate error @0x%x: %s",
+			    (guint)blk->offset,
+			    self->zstrm.msg != NULL ? self->zstrm.msg : zError(zret));
+		return FALSE;
+	}
+
+	/* stopped just before the first literal, or the stored data */
+	if ((self->zstrm.data_type & 256) == 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "truncated deflate block header @0x%x",
+			    (guint)blk->offset);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * fu_cab_mszip_input_stream_add_block:
+ * @self: a #FuCabMszipInputStream
+ * @offset: offset of the deflate data in the cabinet stream, i.e. after the `CK` signature
+ * @size_comp: size of the deflate data
+ * @size_uncomp: expected size of the inflated data
+ * @error: (nullable): optional return location for an error
+ *
+ * Adds a CFDATA block to the end of the folder. Only the deflate block header is decoded, so that
+ * a corrupt cabinet is rejected when parsed; the data is not inflated until it is read.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 2.0.7
+ **/
+gboolean
+fu_cab_mszip_input_stream_add_block(FuCabMszipInputStream *self,
+				    gsize offset,
+				    gsize size_comp,
+				    gsize size_uncomp,
+				    GError **error)
+{
+	FuCabMszipInputStreamBlock blk = {
+	    .offset = offset,
+	    .size_comp = size_comp,
+	    .size_uncomp = size_uncomp,
+	};
+	g_return_val_if_fail(FU_IS_CAB_MSZIP_INPUT_STREAM(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (!fu_cab_mszip_input_stream_check_block_header(self, &blk, error))
+		return FALSE;
+	blk.offset_uncomp = self->total_size;
+	g_array_append_val(self->blocks, blk);
+	self->total_size += size_uncomp;
+	return TRUE;
+}
+
+static GBytes *
+fu_cab_mszip_input_stream_inflate_block(FuCabMszipInputStream *self,
+					guint idx,
+					GBytes *dict,
+					GError **error)
+{
+	FuCabMszipInputStreamBlock *blk =
+	    &g_array_index(self->blocks, FuCabMszipInputStreamBlock, idx);
+	int zret;
+	g_autoptr(GByteArray) buf = g_byte_array_sized_new(blk->size_uncomp);
+	g_autoptr(GBytes) bytes_comp = NULL;
+
+	bytes_comp = fu_input_stream_read_bytes(self->stream,
+						blk->offset,
+						blk->size_comp,
+						NULL,
+						error);
+	if (bytes_comp == NULL)
+		return NULL;
+
+	/* each block is a new deflate stream, primed with the previous uncompressed block */
+	zret = inflateReset(&self->zstrm);
+	if (zret != Z_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "failed to reset inflate: %s",
+			    zError(zret));
+		return NULL;
+	}
+	if (dict != NULL && g_bytes_get_size(dict) > 0) {
+		zret = inflateSetDictionary(&self->zstrm,
+					    g_bytes_get_data(dict, NULL),
+					    g_bytes_get_size(dict));
+		if (zret != Z_OK) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "failed to set inflate dictionary: %s",
+				    zError(zret));
+			return NULL;
+		}
+	}
+	if (self->decompress_buf == NULL)
+		self->decompress_buf = g_malloc0(FU_CAB_MSZIP_INPUT_STREAM_DECOMPRESS_BUFSZ);
+	self->zstrm.avail_in = g_bytes_get_size(bytes_comp);
+	self->zstrm.next_in = (z_const Bytef *)g_bytes_get_data(bytes_comp, NULL);
+	while (1) {
+		self->zstrm.avail_out = FU_CAB_MSZIP_INPUT_STREAM_DECOMPRESS_BUFSZ;
+		self->zstrm.next_out = self->decompress_buf;
+		zret = inflate(&self->zstrm, Z_BLOCK);
+		if (zret == Z_STREAM_END)
+			break;
+		g_byte_array_append(buf,
+				    self->decompress_buf,
+				    FU_CAB_MSZIP_INPUT_STREAM_DECOMPRESS_BUFSZ -
+					self->zstrm.avail_out);
+		if (zret != Z_OK) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "inflate error @0x%x: %s",
+				    (guint)blk->offset,
+				    zError(zret));
+			return NULL;
+		}
+	}
+
+	/* the folder offsets are computed from the CFDATA header */
+	if (buf->len != blk->size_uncomp) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "inflated size @0x%x was 0x%x, expected 0x%x",
+			    (guint)blk->offset,
+			    buf->len,
+			    (guint)blk->size_uncomp);
+		return NULL;
+	}
+	return g_byte_array_free_to_bytes(g_steal_pointer(&buf)); /* nocheck:blocked */
+}
+
+static void
+fu_cab_mszip_input_stream_cache_add(FuCabMszipInputStream *self, guint idx, GBytes *blob)
+{
+	FuCabMszipInputStreamCacheItem *item = g_new0(FuCabMszipInputStreamCacheItem, 1);
+	item->idx = idx;
+	item->blob = g_bytes_ref(blob);
+	g_ptr_array_insert(self->cache, 0, item);
+	if (self->cache->len > FU_CAB_MSZIP_INPUT_STREAM_CACHE_MAX)
+		g_ptr_array_remove_index(self->cache, self->cache->len - 1);
+}
+
+static GBytes *
+fu_cab_mszip_input_stream_get_block(FuCabMszipInputStream *self, guint idx, GError **error)
+{
+	FuCabMszipInputStreamCacheItem *item_start = NULL;
+	guint idx_start = 0;
+	g_autoptr(GBytes) dict = NULL;
+
+	/* already cached, so mark as the most recently used */
+	for (guint i = 0; i < self->cache->len; i++) {
+		FuCabMszipInputStreamCacheItem *item = g_ptr_array_index(self->cache, i);
+		if (item->idx == idx) {
+			if (i > 0) {
+				g_ptr_array_steal_index(self->cache, i);
+				g_ptr_array_insert(self->cache, 0, item);
+			}
+			return g_bytes_ref(item->blob);
+		}
+		if (item->idx < idx && (item_start == NULL || item->idx > item_start->idx))
+			item_start = item;
+	}
+
+	/* inflate forwards from the nearest earlier block we still have */
+	if (item_start != NULL) {
+		dict = g_bytes_ref(item_start->blob);
+		idx_start = item_start->idx + 1;
+	}
+	for (guint i = idx_start; i <= idx; i++) {
+		g_autoptr(GBytes) blob = fu_cab_mszip_input_stream_inflate_block(self, i, dict, error);
+		if (blob == NULL)
+			return NULL;
+		g_bytes_unref(dict);
+		dict = g_steal_pointer(&blob);
+	}
+	fu_cab_mszip_input_stream_cache_add(self, idx, dict);
+	return g_steal_pointer(&dict);
+}
+
+static guint
+fu_cab_mszip_input_stream_get_block_for_offset(FuCabMszipInputStream *self, gsize offset)
+{
+	guint lo = 0;
+	guint hi = self->blocks->len;
+
+	/* the first block that ends after the offset */
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		FuCabMszipInputStreamBlock *blk =
+		    &g_array_index(self->blocks, FuCabMszipInputStreamBlock, mid);
+		if (blk->offset_uncomp + blk->size_uncomp <= offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static goffset
+fu_cab_mszip_input_stream_tell(GSeekable *seekable)
+{
+	FuCabMszipInputStream *self = FU_CAB_MSZIP_INPUT_STREAM(seekable);
+	g_return_val_if_fail(FU_IS_CAB_MSZIP_INPUT_STREAM(self), -1);
+	return self->pos;
+}
+
+static gboolean
+fu_cab_mszip_input_stream_can_seek(GSeekable *seekable)
+{
+	return TRUE;
+}
+
+static gboolean
+fu_cab_mszip_input_stream_seek(GSeekable *seekable,
+			       goffset offset,
+			       GSeekType type,
+			       GCancellable *cancellable,
+			       GError **error)
+{
+	FuCabMszipInputStream *self = FU_CAB_MSZIP_INPUT_STREAM(seekable);
+
+	g_return_val_if_fail(FU_IS_CAB_MSZIP_INPUT_STREAM(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (type == G_SEEK_CUR) {
+		self->pos += offset;
+	} else if (type == G_SEEK_END) {
+		self->pos = self->total_size + offset;
+	} else {
+		self->pos = offset;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_cab_mszip_input_stream_can_truncate(GSeekable *seekable)
+{
+	return FALSE;
+}
+
+static gboolean
+fu_cab_mszip_input_stream_truncate(GSeekable *seekable,
+				   goffset offset,
+				   GCancellable *cancellable,
+				   GError **error)
+{
+	g_set_error_literal(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "cannot truncate FuCabMszipInputStream");
+	return FALSE;
+}
+
+static void
+fu_cab_mszip_input_stream_seekable_iface_init(GSeekableIface *iface)
+{
+	iface->tell = fu_cab_mszip_input_stream_tell;
+	iface->can_seek = fu_cab_mszip_input_stream_can_seek;
+	iface->seek = fu_cab_mszip_input_stream_seek;
+	iface->can_truncate = fu_cab_mszip_input_stream_can_truncate;
+	iface->truncate_fn = fu_cab_mszip_input_stream_truncate;
+}
+
+/**
+ * fu_cab_mszip_input_stream_new:
+ * @stream: the cabinet #GInputStream
+ * @error: (nullable): optional return location for an error
+ *
+ * Creates an input stream for an MSZIP-compressed folder; use
+ * fu_cab_mszip_input_stream_add_block() to add each CFDATA block.
+ *
+ * Returns: (transfer full): a #FuCabMszipInputStream, or %NULL on error
+ *
+ * Since: 2.0.7
+ **/
+GInputStream *
+fu_cab_mszip_input_stream_new(GInputStream *stream, GError **error)
+{
+	int zret;
+	g_autoptr(FuCabMszipInputStream) self = g_object_new(FU_TYPE_CAB_MSZIP_INPUT_STREAM, NULL);
+
+	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	self->stream = g_object_ref(stream);
+	zret = inflateInit2(&self->zstrm, -MAX_WBITS);
+	if (zret != Z_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "failed to initialize inflate: %s",
+			    zError(zret));
+		return NULL;
+	}
+	return G_INPUT_STREAM(g_steal_pointer(&self));
+}
+
+static gssize
+fu_cab_mszip_input_stream_read(GInputStream *stream,
+			       void *buffer,
+			       gsize count,
+			       GCancellable *cancellable,
+			       GError **error)
+{
+	FuCabMszipInputStream *self = FU_CAB_MSZIP_INPUT_STREAM(stream);
+	FuCabMszipInputStreamBlock *blk;
+	gsize offset;
+	guint idx;
+	g_autoptr(GBytes) blob = NULL;
+
+	g_return_val_if_fail(FU_IS_CAB_MSZIP_INPUT_STREAM(self), -1);
+	g_return_val_if_fail(error == NULL || *error == NULL, -1);
+
+	if (self->pos < 0 || (gsize)self->pos >= self->total_size)
+		return 0;
+	idx = fu_cab_mszip_input_stream_get_block_for_offset(self, self->pos);
+	blob = fu_cab_mszip_input_stream_get_block(self, idx, error);
+	if (blob == NULL)
+		return -1;
+
+	/* only ever return data from one block */
+	blk = &g_array_index(self->blocks, FuCabMszipInputStreamBlock, idx);
+	offset = self->pos - blk->offset_uncomp;
+	count = MIN(count, blk->size_uncomp - offset);
+	if (!fu_memcpy_safe(buffer,
+			    count,
+			    0x0,
+			    g_bytes_get_data(blob, NULL),
+			    g_bytes_get_size(blob),
+			    offset,
+			    count,
+			    error))
+		return -1;
+	self->pos += count;
+	return count;
+}
+
+static void
+fu_cab_mszip_input_stream_finalize(GObject *object)
+{
+	FuCabMszipInputStream *self = FU_CAB_MSZIP_INPUT_STREAM(object);
+	inflateEnd(&self->zstrm);
+	if (self->stream != NULL)
+		g_object_unref(self->stream);
+	g_array_unref(self->blocks);
+	g_ptr_array_unref(self->cache);
+	g_free(self->decompress_buf);
+	G_OBJECT_CLASS(fu_cab_mszip_input_stream_parent_class)->finalize(object);
+}
+
+static void
+fu_cab_mszip_input_stream_class_init(FuCabMszipInputStreamClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	GInputStreamClass *istream_class = G_INPUT_STREAM_CLASS(klass);
+	istream_class->read_fn = fu_cab_mszip_input_stream_read;
+	object_class->finalize = fu_cab_mszip_input_stream_finalize;
+}
+
+static void
+fu_cab_mszip_input_stream_init(FuCabMszipInputStream *self)
+{
+	self->blocks = g_array_new(FALSE, FALSE, sizeof(FuCabMszipInputStreamBlock));
+	self->cache = g_ptr_array_new_with_free_func(
+	    (GDestroyNotify)fu_cab_mszip_input_stream_cache_item_free);
+	self->zstrm.zalloc = fu_cab_mszip_input_stream_zalloc;
+	self->zstrm.zfree = fu_cab_mszip_input_stream_zfree;
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#define FU_TYPE_CAB_MSZIP_INPUT_STREAM (fu_cab_mszip_input_stream_get_type())
+
+G_DECLARE_FINAL_TYPE(FuCabMszipInputStream,
+		     fu_cab_mszip_input_stream,
+		     FU,
+		     CAB_MSZIP_INPUT_STREAM,
+		     GInputStream)
+
+GInputStream *
+fu_cab_mszip_input_stream_new(GInputStream *stream, GError **error) G_GNUC_NON_NULL(1);
+gboolean
+fu_cab_mszip_input_stream_add_block(FuCabMszipInputStream *self,
+				    gsize offset,
+				    gsize size_comp,
+				    gsize size_uncomp,
+				    GError **error) G_GNUC_NON_NULL(1);
@@ -48,7 +48,7 @@ struct FuStructCabFolder {
     compression: FuCabCompression,
 }
 
-#[derive(ParseStream, ValidateStream, New, Default)]
+#[derive(ParseStream, Validate, ValidateStream, New, Default)]
 #[repr(C, packed)]
 struct FuStructCabHeader {
     signature: [char; 4] == "MSCF",
@@ -42,6 +42,13 @@ fu_context_get_runtime_versions(FuContext *self) G_GNUC_NON_NULL(1);
 GHashTable *
 fu_context_get_compile_versions(FuContext *self) G_GNUC_NON_NULL(1);
 void
+fu_context_add_setup_cache(FuContext *self, const gchar *cache_id, GHashTable *values)
+    G_GNUC_NON_NULL(1, 2, 3);
+GHashTable *
+fu_context_get_setup_cache(FuContext *self, const gchar *cache_id) G_GNUC_NON_NULL(1, 2);
+void
+fu_context_remove_setup_cache(FuContext *self, const gchar *cache_id) G_GNUC_NON_NULL(1, 2);
+void
 fu_context_add_firmware_gtype(FuContext *self, const gchar *id, GType gtype) G_GNUC_NON_NULL(1, 2);
 GPtrArray *
 fu_context_get_firmware_gtype_ids(FuContext *self) G_GNUC_NON_NULL(1);
@@ -8,6 +8,8 @@
 
 #include "config.h"
 
+#include <glib/gstdio.h>
+
 #include "fu-bios-settings-private.h"
 #include "fu-common-private.h"
 #include "fu-config-private.h"
@@ -44,8 +46,10 @@ typedef struct {
 	GHashTable *compile_versions;
 	GHashTable *udev_subsystems; /* utf8:GPtrArray */
 	GPtrArray *esp_volumes;
+	GHashTable *esp_files_cache; /* utf8:FuContextEspFileCacheItem */
 	GHashTable *firmware_gtypes; /* utf8:GType */
 	GHashTable *hwid_flags;	     /* str: */
+	GHashTable *setup_caches;    /* utf8:GHashTable */
 	FuPowerState power_state;
 	FuLidState lid_state;
 	FuDisplayState display_state;
@@ -576,6 +580,72 @@ fu_context_get_runtime_versions(FuContext *self)
 	return priv->runtime_versions;
 }
 
+/**
+ * fu_context_add_setup_cache:
+ * @self: a #FuContext
+ * @cache_id: a device setup cache ID, from fu_device_get_setup_cache_id()
+ * @values: (element-type utf8 utf8): the values saved by the device
+ *
+ * Adds the cached results of a previous `FuDevice->setup()`, typically loaded from the history
+ * database when the daemon starts.
+ *
+ * Since: 2.0.7
+ **/
+void
+fu_context_add_setup_cache(FuContext *self, const gchar *cache_id, GHashTable *values)
+{
+	FuContextPrivate *priv = GET_PRIVATE(self);
+
+	g_return_if_fail(FU_IS_CONTEXT(self));
+	g_return_if_fail(cache_id != NULL);
+	g_return_if_fail(values != NULL);
+
+	g_hash_table_insert(priv->setup_caches, g_strdup(cache_id), g_hash_table_ref(values));
+}
+
+/**
+ * fu_context_get_setup_cache:
+ * @self: a #FuContext
+ * @cache_id: a device setup cache ID, from fu_device_get_setup_cache_id()
+ *
+ * Gets the cached results of a previous `FuDevice->setup()`.
+ *
+ * Returns: (transfer none) (element-type utf8 utf8) (nullable): values, or %NULL if not found
+ *
+ * Since: 2.0.7
+ **/
+GHashTable *
+fu_context_get_setup_cache(FuContext *self, const gchar *cache_id)
+{
+	FuContextPrivate *priv = GET_PRIVATE(self);
+
+	g_return_val_if_fail(FU_IS_CONTEXT(self), NULL);
+	g_return_val_if_fail(cache_id != NULL, NULL);
+
+	return g_hash_table_lookup(priv->setup_caches, cache_id);
+}
+
+/**
+ * fu_context_remove_setup_cache:
+ * @self: a #FuContext
+ * @cache_id: a device setup cache ID, from fu_device_get_setup_cache_id()
+ *
+ * Removes the cached results of a previous `FuDevice->setup()`, for instance because the
+ * firmware has been written.
+ *
+ * Since: 2.0.7
+ **/
+void
+fu_context_remove_setup_cache(FuContext *self, const gchar *cache_id)
+{
+	FuContextPrivate *priv = GET_PRIVATE(self);
+
+	g_return_if_fail(FU_IS_CONTEXT(self));
+	g_return_if_fail(cache_id != NULL);
+
+	g_hash_table_remove(priv->setup_caches, cache_id);
+}
+
 /**
  * fu_context_add_compile_version:
  * @self: a #FuContext
@@ -1836,6 +1906,39 @@ fu_context_get_esp_volume_by_hard_drive_device_path(FuContext *self,
 	return NULL;
 }
 
+typedef struct {
+	FuFirmware *firmware;
+	guint64 size;
+	gint64 mtime_nsec;
+} FuContextEspFileCacheItem;
+
+static void
+fu_context_esp_file_cache_item_free(FuContextEspFileCacheItem *item)
+{
+	g_object_unref(item->firmware);
+	g_free(item);
+}
+
+typedef struct {
+	gchar *filename;
+	guint64 idx;
+	guint64 size;
+	gint64 mtime_nsec;
+	FuFirmware *firmware; /* nullable */
+	GError *error;	      /* nullable */
+} FuContextEspFileHelper;
+
+static void
+fu_context_esp_file_helper_free(FuContextEspFileHelper *helper)
+{
+	if (helper->firmware != NULL)
+		g_object_unref(helper->firmware);
+	if (helper->error != NULL)
+		g_error_free(helper->error);
+	g_free(helper->filename);
+	g_free(helper);
+}
+
 static FuFirmware *
 fu_context_esp_load_pe_file(const gchar *filename, GError **error)
 {
@@ -1849,6 +1952,33 @@ fu_context_esp_load_pe_file(const gchar *filename, GError **error)
 	return g_steal_pointer(&firmware);
 }
 
+/* runs in a worker thread, so must not touch the context */
+static void
+fu_context_esp_load_pe_file_cb(gpointer data, gpointer user_data)
+{
+	FuContextEspFileHelper *helper = (FuContextEspFileHelper *)data;
+	helper->firmware = fu_context_esp_load_pe_file(helper->filename, &helper->error);
+	if (helper->firmware != NULL)
+		fu_firmware_set_idx(helper->firmware, helper->idx);
+}
+
+static void
+fu_context_esp_file_helper_add(GPtrArray *helpers, const gchar *filename, FuEfiLoadOption *entry)
+{
+	FuContextEspFileHelper *helper;
+
+	/* more than one entry can point at the same file, and the first in BootOrder wins */
+	for (guint i = 0; i < helpers->len; i++) {
+		FuContextEspFileHelper *helper_tmp = g_ptr_array_index(helpers, i);
+		if (g_strcmp0(helper_tmp->filename, filename) == 0)
+			return;
+	}
+	helper = g_new0(FuContextEspFileHelper, 1);
+	helper->filename = g_strdup(filename);
+	helper->idx = fu_firmware_get_idx(FU_FIRMWARE(entry));
+	g_ptr_array_add(helpers, helper);
+}
+
 static gchar *
 fu_context_build_uefi_basename_for_arch(const gchar *app_name)
 {
@@ -1876,7 +2006,8 @@ fu_context_build_uefi_basename_for_arch(const gchar *app_name)
 static gboolean
 fu_context_get_esp_files_for_entry(FuContext *self,
 				   FuEfiLoadOption *entry,
-				   GPtrArray *files,
+				   GPtrArray *lockers,
+				   GPtrArray *helpers,
 				   FuContextEspFileFlags flags,
 				   GError **error)
 {
@@ -1935,31 +2066,12 @@ fu_context_get_esp_files_for_entry(FuContext *self,
 	mount_point = fu_volume_get_mount_point(volume);
 	filename = g_build_filename(mount_point, dp_filename, NULL);
 	g_debug("check for 1st stage bootloader: %s", filename);
-	if (flags & FU_CONTEXT_ESP_FILE_FLAG_INCLUDE_FIRST_STAGE) {
-		g_autoptr(FuFirmware) firmware = NULL;
-		g_autoptr(GError) error_local = NULL;
-
-		/* ignore if the file cannot be loaded as a PE file */
-		firmware = fu_context_esp_load_pe_file(filename, &error_local);
-		if (firmware == NULL) {
-			if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED) ||
-			    g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE)) {
-				g_debug("ignoring: %s", error_local->message);
-			} else {
-				g_propagate_error(error, g_steal_pointer(&error_local));
-				return FALSE;
-			}
-		} else {
-			fu_firmware_set_idx(firmware, fu_firmware_get_idx(FU_FIRMWARE(entry)));
-			g_ptr_array_add(files, g_steal_pointer(&firmware));
-		}
-	}
+	if (flags & FU_CONTEXT_ESP_FILE_FLAG_INCLUDE_FIRST_STAGE)
+		fu_context_esp_file_helper_add(helpers, filename, entry);
 
 	/* the 2nd stage bootloader, typically grub */
 	if (flags & FU_CONTEXT_ESP_FILE_FLAG_INCLUDE_SECOND_STAGE &&
 	    g_str_has_suffix(filename, shim_name)) {
-		g_autoptr(FuFirmware) firmware = NULL;
-		g_autoptr(GError) error_local = NULL;
 		g_autoptr(GString) filename2 = g_string_new(filename);
 		const gchar *path;
 
@@ -1973,48 +2085,129 @@ fu_context_get_esp_files_for_entry(FuContext *self,
 			g_string_replace(filename2, shim_name, grub_name, 1);
 		}
 		g_debug("check for 2nd stage bootloader: %s", filename2->str);
-
-		/* ignore if the file cannot be loaded as a PE file */
-		firmware = fu_context_esp_load_pe_file(filename2->str, &error_local);
-		if (firmware == NULL) {
-			if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED) ||
-			    g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE)) {
-				g_debug("ignoring: %s", error_local->message);
-			} else {
-				g_propagate_error(error, g_steal_pointer(&error_local));
-				return FALSE;
-			}
-		} else {
-			fu_firmware_set_idx(firmware, fu_firmware_get_idx(FU_FIRMWARE(entry)));
-			g_ptr_array_add(files, g_steal_pointer(&firmware));
-		}
+		fu_context_esp_file_helper_add(helpers, filename2->str, entry);
 	}
 
 	/* revocations, typically for SBAT */
 	if (flags & FU_CONTEXT_ESP_FILE_FLAG_INCLUDE_REVOCATIONS &&
 	    g_str_has_suffix(filename, shim_name)) {
 		g_autoptr(GString) filename2 = g_string_new(filename);
-		g_autoptr(FuFirmware) firmware = NULL;
-		g_autoptr(GError) error_local = NULL;
-
 		g_string_replace(filename2, shim_name, "revocations.efi", 1);
 		g_debug("check for revocation: %s", filename2->str);
+		fu_context_esp_file_helper_add(helpers, filename2->str, entry);
+	}
 
-		/* ignore if the file cannot be loaded as a PE file */
-		firmware = fu_context_esp_load_pe_file(filename2->str, &error_local);
-		if (firmware == NULL) {
-			if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED) ||
-			    g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE)) {
-				g_debug("ignoring: %s", error_local->message);
-			} else {
-				g_propagate_error(error, g_steal_pointer(&error_local));
+	/* keep the volume mounted until the files have been loaded */
+	g_ptr_array_add(lockers, g_steal_pointer(&volume_locker));
+
+	/* success */
+	return TRUE;
+}
+
+/*
+ * Use the already-parsed file if the size and modification time are unchanged.
+ *
+ * The cached object may already have been returned to another caller, so it is never modified;
+ * if the boot entry index is different then the file is parsed again.
+ */
+static gboolean
+fu_context_esp_file_helper_check_cache(FuContext *self, FuContextEspFileHelper *helper)
+{
+	FuContextPrivate *priv = GET_PRIVATE(self);
+	FuContextEspFileCacheItem *item;
+	GStatBuf statbuf = {0};
+
+	if (g_stat(helper->filename, &statbuf) != 0)
+		return FALSE;
+	helper->size = statbuf.st_size;
+#ifdef _WIN32
+	helper->mtime_nsec = (gint64)statbuf.st_mtime * 1000000000;
+#else
+	helper->mtime_nsec = (gint64)statbuf.st_mtim.tv_sec * 1000000000 + statbuf.st_mtim.tv_nsec;
+#endif
+	item = g_hash_table_lookup(priv->esp_files_cache, helper->filename);
+	if (item == NULL || item->size != helper->size || item->mtime_nsec != helper->mtime_nsec ||
+	    fu_firmware_get_idx(item->firmware) != helper->idx)
+		return FALSE;
+	helper->firmware = g_object_ref(item->firmware);
+	return TRUE;
+}
+
+/* drop files that were not used this time and that no longer exist, e.g. a temporary mount */
+static void
+fu_context_esp_files_cache_prune(FuContext *self, GPtrArray *helpers)
+{
+	FuContextPrivate *priv = GET_PRIVATE(self);
+	GHashTableIter iter;
+	const gchar *filename;
+	g_autoptr(GHashTable) seen = g_hash_table_new(g_str_hash, g_str_equal);
+
+	for (guint i = 0; i < helpers->len; i++) {
+		FuContextEspFileHelper *helper = g_ptr_array_index(helpers, i);
+		g_hash_table_add(seen, helper->filename);
+	}
+	g_hash_table_iter_init(&iter, priv->esp_files_cache);
+	while (g_hash_table_iter_next(&iter, (gpointer *)&filename, NULL)) {
+		if (g_hash_table_contains(seen, filename))
+			continue;
+		if (g_file_test(filename, G_FILE_TEST_EXISTS))
+			continue;
+		g_debug("removing %s from ESP cache", filename);
+		g_hash_table_iter_remove(&iter);
+	}
+}
+
+static gboolean
+fu_context_esp_file_helpers_load(FuContext *self, GPtrArray *helpers, GError **error)
+{
+	FuContextPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GPtrArray) helpers_load = g_ptr_array_new();
+
+	for (guint i = 0; i < helpers->len; i++) {
+		FuContextEspFileHelper *helper = g_ptr_array_index(helpers, i);
+		if (!fu_context_esp_file_helper_check_cache(self, helper))
+			g_ptr_array_add(helpers_load, helper);
+	}
+	g_debug("ESP files: %u cached, %u to load",
+		helpers->len - helpers_load->len,
+		helpers_load->len);
+
+	/* computing the Authenticode hash reads every byte, so spread out across CPUs */
+	if (helpers_load->len > 1) {
+		guint max_threads = MIN(g_get_num_processors(), helpers_load->len);
+		GThreadPool *pool = g_thread_pool_new(fu_context_esp_load_pe_file_cb,
+						      NULL,
+						      max_threads,
+						      TRUE,
+						      error);
+		if (pool == NULL)
+			return FALSE;
+		for (guint i = 0; i < helpers_load->len; i++) {
+			if (!g_thread_pool_push(pool, g_ptr_array_index(helpers_load, i), error)) {
+				g_thread_pool_free(pool, TRUE, TRUE);
 				return FALSE;
 			}
-		} else {
-			fu_firmware_set_idx(firmware, fu_firmware_get_idx(FU_FIRMWARE(entry)));
-			g_ptr_array_add(files, g_steal_pointer(&firmware));
 		}
+		g_thread_pool_free(pool, FALSE, TRUE);
+	} else if (helpers_load->len == 1) {
+		fu_context_esp_load_pe_file_cb(g_ptr_array_index(helpers_load, 0), NULL);
+	}
+
+	/* save for next time */
+	for (guint i = 0; i < helpers_load->len; i++) {
+		FuContextEspFileHelper *helper = g_ptr_array_index(helpers_load, i);
+		FuContextEspFileCacheItem *item;
+		if (helper->firmware == NULL || helper->size == 0) {
+			g_hash_table_remove(priv->esp_files_cache, helper->filename);
+			continue;
+		}
+		item = g_new0(FuContextEspFileCacheItem, 1);
+		item->firmware = g_object_ref(helper->firmware);
+		item->size = helper->size;
+		item->mtime_nsec = helper->mtime_nsec;
+		g_hash_table_insert(priv->esp_files_cache, g_strdup(helper->filename), item);
 	}
+	fu_context_esp_files_cache_prune(self, helpers);
 
 	/* success */
 	return TRUE;
@@ -2028,6 +2221,12 @@ fu_context_get_esp_files_for_entry(FuContext *self,
  *
  * Gets the PE files for all the entries listed in `BootOrder`.
  *
+ * Files that have not changed since the last call are not parsed again, and the same
+ * #FuPefileFirmware is returned. Callers must not modify the returned objects.
+ *
+ * If more than one entry points at the same file it is only returned once, with the index of
+ * the first entry in `BootOrder`.
+ *
  * Returns: (transfer full) (element-type FuPefileFirmware): PE firmware data
  *
  * Since: 2.0.0
@@ -2038,6 +2237,10 @@ fu_context_get_esp_files(FuContext *self, FuContextEspFileFlags flags, GError **
 	FuContextPrivate *priv = GET_PRIVATE(self);
 	g_autoptr(GPtrArray) entries = NULL;
 	g_autoptr(GPtrArray) files = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	g_autoptr(GPtrArray) helpers =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_context_esp_file_helper_free);
+	g_autoptr(GPtrArray) lockers =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 
 	g_return_val_if_fail(FU_IS_CONTEXT(self), NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
@@ -2048,7 +2251,12 @@ fu_context_get_esp_files(FuContext *self, FuContextEspFileFlags flags, GError **
 	for (guint i = 0; i < entries->len; i++) {
 		FuEfiLoadOption *entry = g_ptr_array_index(entries, i);
 		g_autoptr(GError) error_local = NULL;
-		if (!fu_context_get_esp_files_for_entry(self, entry, files, flags, &error_local)) {
+		if (!fu_context_get_esp_files_for_entry(self,
+							entry,
+							lockers,
+							helpers,
+							flags,
+							&error_local)) {
 			if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND) ||
 			    g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE)) {
 				g_debug("ignoring %s: %s",
@@ -2061,6 +2269,27 @@ fu_context_get_esp_files(FuContext *self, FuContextEspFileFlags flags, GError **
 		}
 	}
 
+	/* load all the files while the volumes are mounted */
+	if (!fu_context_esp_file_helpers_load(self, helpers, error))
+		return NULL;
+	for (guint i = 0; i < helpers->len; i++) {
+		FuContextEspFileHelper *helper = g_ptr_array_index(helpers, i);
+
+		/* ignore if the file cannot be loaded as a PE file */
+		if (helper->firmware == NULL) {
+			GError *error_local = helper->error;
+			if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED) ||
+			    g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE) ||
+			    g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND)) {
+				g_debug("ignoring: %s", error_local->message);
+				continue;
+			}
+			g_propagate_error(error, g_steal_pointer(&helper->error));
+			return NULL;
+		}
+		g_ptr_array_add(files, g_object_ref(helper->firmware));
+	}
+
 	/* success */
 	return g_steal_pointer(&files);
 }
@@ -2253,12 +2482,14 @@ fu_context_finalize(GObject *object)
 	g_object_unref(priv->hwids);
 	g_object_unref(priv->config);
 	g_hash_table_unref(priv->hwid_flags);
+	g_hash_table_unref(priv->setup_caches);
 	g_object_unref(priv->quirks);
 	g_object_unref(priv->smbios);
 	g_object_unref(priv->host_bios_settings);
 	g_hash_table_unref(priv->firmware_gtypes);
 	g_hash_table_unref(priv->udev_subsystems);
 	g_ptr_array_unref(priv->esp_volumes);
+	g_hash_table_unref(priv->esp_files_cache);
 	g_ptr_array_unref(priv->backends);
 
 	G_OBJECT_CLASS(fu_context_parent_class)->finalize(object);
@@ -2429,9 +2660,18 @@ fu_context_init(FuContext *self)
 						      g_free,
 						      (GDestroyNotify)g_ptr_array_unref);
 	priv->firmware_gtypes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	priv->setup_caches = g_hash_table_new_full(g_str_hash,
+						   g_str_equal,
+						   g_free,
+						   (GDestroyNotify)g_hash_table_unref);
 	priv->quirks = fu_quirks_new(self);
 	priv->host_bios_settings = fu_bios_settings_new();
 	priv->esp_volumes = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	priv->esp_files_cache =
+	    g_hash_table_new_full(g_str_hash,
+				  g_str_equal,
+				  g_free,
+				  (GDestroyNotify)fu_context_esp_file_cache_item_free);
 	priv->runtime_versions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 	priv->compile_versions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 	priv->backends = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
@@ -31,6 +31,24 @@ void
 fu_device_set_parent(FuDevice *self, FuDevice *parent) G_GNUC_NON_NULL(1);
 gint
 fu_device_get_order(FuDevice *self) G_GNUC_NON_NULL(1);
+const FuVersionKey *
+fu_device_get_version_key(FuDevice *self) G_GNUC_NON_NULL(1);
+guint
+fu_device_get_retry_latency(FuDevice *self) G_GNUC_NON_NULL(1);
+void
+fu_device_set_retry_latency(FuDevice *self, guint retry_latency) G_GNUC_NON_NULL(1);
+guint
+fu_device_get_retry_count(FuDevice *self) G_GNUC_NON_NULL(1);
+const gchar *
+fu_device_get_setup_cache_id(FuDevice *self) G_GNUC_NON_NULL(1);
+GHashTable *
+fu_device_get_setup_cache(FuDevice *self) G_GNUC_NON_NULL(1);
+void
+fu_device_invalidate_setup_cache(FuDevice *self) G_GNUC_NON_NULL(1);
+guint
+fu_device_get_sleep_count(FuDevice *self) G_GNUC_NON_NULL(1);
+guint64
+fu_device_get_sleep_duration(FuDevice *self) G_GNUC_NON_NULL(1);
 void
 fu_device_set_order(FuDevice *self, gint order) G_GNUC_NON_NULL(1);
 const gchar *
@@ -19,6 +19,7 @@
 #include "fu-bytes.h"
 #include "fu-chunk-array.h"
 #include "fu-common.h"
+#include "fu-context-private.h"
 #include "fu-device-event-private.h"
 #include "fu-device-private.h"
 #include "fu-input-stream.h"
@@ -90,6 +91,10 @@ typedef struct {
 	GPtrArray *instance_ids;     /* (nullable) (element-type FuDeviceInstanceIdItem) */
 	GPtrArray *retry_recs;	     /* (nullable) (element-type FuDeviceRetryRecovery) */
 	guint retry_delay;
+	guint retry_cnt;
+	guint retry_latency; /* ms */
+	guint sleep_cnt;
+	guint64 sleep_total; /* ms */
 	GPtrArray *private_flags_registered; /* (nullable) (element-type GRefString) */
 	GPtrArray *private_flags;	     /* (nullable) (no-ref) (element-type GRefString) */
 	gchar *custom_flags;
@@ -97,6 +102,10 @@ typedef struct {
 	gulong notify_flags_proxy_id;
 	GHashTable *instance_hash; /* (nullable) */
 	FuProgress *progress;	   /* provided for FuDevice notify callbacks */
+	FuVersionKey *version_key; /* (nullable) */
+	GHashTable *setup_cache_identity; /* (nullable) */
+	GHashTable *setup_cache;	  /* (nullable) */
+	gchar *setup_cache_id;		  /* (nullable) */
 } FuDevicePrivate;
 
 typedef struct {
@@ -261,6 +270,8 @@ fu_device_register_flags(FuDevice *self)
 	fu_device_register_private_flag_safe(self, FU_DEVICE_PRIVATE_FLAG_NO_AUTO_INSTANCE_IDS);
 	fu_device_register_private_flag_safe(self, FU_DEVICE_PRIVATE_FLAG_ENSURE_SEMVER);
 	fu_device_register_private_flag_safe(self, FU_DEVICE_PRIVATE_FLAG_RETRY_OPEN);
+	fu_device_register_private_flag_safe(self, FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE);
+	fu_device_register_private_flag_safe(self, FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP);
 	fu_device_register_private_flag_safe(self, FU_DEVICE_PRIVATE_FLAG_REPLUG_MATCH_GUID);
 	fu_device_register_private_flag_safe(self, FU_DEVICE_PRIVATE_FLAG_INHERIT_ACTIVATION);
 	fu_device_register_private_flag_safe(self, FU_DEVICE_PRIVATE_FLAG_IS_OPEN);
@@ -585,6 +596,111 @@ fu_device_retry_set_delay(FuDevice *self, guint delay)
 	priv->retry_delay = delay;
 }
 
+/* exponentially weighted so that one slow success does not undo the learning */
+static void
+fu_device_retry_learn_latency(FuDevice *self, guint64 delay_total)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	guint latency = (guint)MIN(delay_total, G_MAXUINT);
+	if (priv->retry_latency == 0)
+		priv->retry_latency = latency;
+	else
+		priv->retry_latency = (guint)(((guint64)priv->retry_latency * 3 + latency) / 4);
+	g_debug("retry succeeded after %ums, latency now %ums", latency, priv->retry_latency);
+}
+
+/**
+ * fu_device_get_retry_latency:
+ * @self: a #FuDevice
+ *
+ * Gets the delay learned from previous successful retries, used when the device has
+ * %FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE set.
+ *
+ * Returns: delay in ms, or 0 for unknown
+ *
+ * Since: 2.0.7
+ **/
+guint
+fu_device_get_retry_latency(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_DEVICE(self), 0);
+	return priv->retry_latency;
+}
+
+/**
+ * fu_device_set_retry_latency:
+ * @self: a #FuDevice
+ * @retry_latency: delay in ms, or 0 for unknown
+ *
+ * Sets the delay learned from previous successful retries, typically loaded from the history
+ * database.
+ *
+ * Since: 2.0.7
+ **/
+void
+fu_device_set_retry_latency(FuDevice *self, guint retry_latency)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_if_fail(FU_IS_DEVICE(self));
+	priv->retry_latency = retry_latency;
+}
+
+/**
+ * fu_device_get_retry_count:
+ * @self: a #FuDevice
+ *
+ * Gets how many times a function has been retried using fu_device_retry_full().
+ *
+ * Returns: integer
+ *
+ * Since: 2.0.7
+ **/
+guint
+fu_device_get_retry_count(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_DEVICE(self), 0);
+	return priv->retry_cnt;
+}
+
+/**
+ * fu_device_get_sleep_count:
+ * @self: a #FuDevice
+ *
+ * Gets how many times fu_device_sleep() or fu_device_sleep_full() actually delayed.
+ *
+ * Returns: integer
+ *
+ * Since: 2.0.7
+ **/
+guint
+fu_device_get_sleep_count(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_DEVICE(self), 0);
+	return priv->sleep_cnt;
+}
+
+/**
+ * fu_device_get_sleep_duration:
+ * @self: a #FuDevice
+ *
+ * Gets the total time spent in fu_device_sleep() and fu_device_sleep_full(), including the
+ * delays between retries.
+ *
+ * Returns: delay in ms
+ *
+ * Since: 2.0.7
+ **/
+guint64
+fu_device_get_sleep_duration(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_DEVICE(self), 0);
+	return priv->sleep_total;
+}
+
 /**
  * fu_device_retry_full:
  * @self: a #FuDevice
@@ -603,6 +719,10 @@ fu_device_retry_set_delay(FuDevice *self, guint delay)
  * If the reset function returns %FALSE, then the function returns straight away
  * without processing any pending retries.
  *
+ * If the device has the %FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE flag then the first delay is
+ * either the latency learned from previous calls or @delay/8, doubling on each failure up to
+ * @delay. Retries continue until the delays add up to what @count tries of @delay would be.
+ *
  * Since: 1.5.5
  **/
 gboolean
@@ -614,22 +734,45 @@ fu_device_retry_full(FuDevice *self,
 		     GError **error)
 {
 	FuDevicePrivate *priv = GET_PRIVATE(self);
+	gboolean adaptive = FALSE;
+	guint delay_next = delay;
+	guint64 delay_budget = 0;
+	guint64 delay_total = 0;
 
 	g_return_val_if_fail(FU_IS_DEVICE(self), FALSE);
 	g_return_val_if_fail(func != NULL, FALSE);
 	g_return_val_if_fail(count >= 1, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
+	/* the total delay is the same as the non-adaptive mode, but starts off much shorter */
+	if (fu_device_has_private_flag(self, FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE) && delay > 0) {
+		adaptive = TRUE;
+		delay_budget = (guint64)delay * (count - 1);
+		delay_next = priv->retry_latency > 0 ? MIN(priv->retry_latency, delay)
+						     : MAX(delay / 8, 1);
+	}
+
 	for (guint i = 0;; i++) {
 		g_autoptr(GError) error_local = NULL;
 
 		/* delay */
-		if (i > 0)
-			fu_device_sleep(self, delay);
+		if (i > 0) {
+			priv->retry_cnt++;
+			if (adaptive) {
+				fu_device_sleep(self, delay_next);
+				delay_total += delay_next;
+				delay_next = MIN(delay_next * 2, delay);
+			} else {
+				fu_device_sleep(self, delay);
+			}
+		}
 
 		/* run function, if success return success */
-		if (func(self, user_data, &error_local))
+		if (func(self, user_data, &error_local)) {
+			if (adaptive && i > 0)
+				fu_device_retry_learn_latency(self, delay_total);
 			break;
+		}
 
 		/* sanity check */
 		if (error_local == NULL) {
@@ -641,17 +784,24 @@ fu_device_retry_full(FuDevice *self,
 		}
 
 		/* too many retries */
-		if (i >= count - 1) {
+		if ((!adaptive && i >= count - 1) || (adaptive && delay_total >= delay_budget)) {
 			g_propagate_prefixed_error(error,
 						   g_steal_pointer(&error_local),
 						   "failed after %u retries: ",
-						   count);
+						   i + 1);
 			return FALSE;
 		}
 
 		/* show recoverable error on the console */
 		if (priv->retry_recs == NULL || priv->retry_recs->len == 0) {
-			g_info("failed on try %u of %u: %s", i + 1, count, error_local->message);
+			if (adaptive) {
+				g_info("failed on try %u: %s", i + 1, error_local->message);
+			} else {
+				g_info("failed on try %u of %u: %s",
+				       i + 1,
+				       count,
+				       error_local->message);
+			}
 			continue;
 		}
 
@@ -694,6 +844,10 @@ fu_device_retry_full(FuDevice *self,
  * If the reset function returns %FALSE, then the function returns straight away
  * without processing any pending retries.
  *
+ * If the device has the %FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE flag then the first delay is
+ * either the latency learned from previous calls or @delay/8, doubling on each failure up to
+ * @delay. Retries continue until the delays add up to what @count tries of @delay would be.
+ *
  * Since: 1.4.0
  **/
 gboolean
@@ -732,8 +886,11 @@ fu_device_sleep(FuDevice *self, guint delay_ms)
 		return;
 	if (priv->proxy != NULL && fu_device_has_flag(priv->proxy, FWUPD_DEVICE_FLAG_EMULATED))
 		return;
-	if (delay_ms > 0)
+	if (delay_ms > 0) {
+		priv->sleep_cnt++;
+		priv->sleep_total += delay_ms;
 		g_usleep(delay_ms * 1000);
+	}
 }
 
 /**
@@ -760,8 +917,11 @@ fu_device_sleep_full(FuDevice *self, guint delay_ms, FuProgress *progress)
 		return;
 	if (priv->proxy != NULL && fu_device_has_flag(priv->proxy, FWUPD_DEVICE_FLAG_EMULATED))
 		return;
-	if (delay_ms > 0)
+	if (delay_ms > 0) {
+		priv->sleep_cnt++;
+		priv->sleep_total += delay_ms;
 		fu_progress_sleep(progress, delay_ms);
+	}
 }
 
 /**
@@ -2827,6 +2987,202 @@ fu_device_set_metadata(FuDevice *self, const gchar *key, const gchar *value)
 	g_hash_table_insert(priv->metadata, g_strdup(key), g_strdup(value));
 }
 
+/* recording or replaying events needs the hardware to be actually queried */
+static gboolean
+fu_device_setup_cache_is_enabled(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	if (!fu_device_has_private_flag(self, FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP))
+		return FALSE;
+	if (fu_device_has_flag(self, FWUPD_DEVICE_FLAG_EMULATED))
+		return FALSE;
+	if (priv->ctx == NULL || fu_context_has_flag(priv->ctx, FU_CONTEXT_FLAG_SAVE_EVENTS))
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * fu_device_add_setup_cache_identity:
+ * @self: a #FuDevice
+ * @key: the key, e.g. `DpcdOui`
+ * @value: the value, e.g. `90CC24`
+ *
+ * Adds a value that identifies the exact hardware, and that is cheap to query. If any of the
+ * values change then any results saved using fu_device_set_setup_cache_value() are not used.
+ *
+ * The device type, physical ID, logical ID, vendor ID, product ID and serial number are always
+ * included, and so do not need to be added.
+ *
+ * This should be called before fu_device_get_setup_cache_value() or
+ * fu_device_set_setup_cache_value().
+ *
+ * Since: 2.0.7
+ **/
+void
+fu_device_add_setup_cache_identity(FuDevice *self, const gchar *key, const gchar *value)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_if_fail(FU_IS_DEVICE(self));
+	g_return_if_fail(key != NULL);
+	g_return_if_fail(value != NULL);
+	if (priv->setup_cache_identity == NULL) {
+		priv->setup_cache_identity =
+		    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	}
+	g_hash_table_insert(priv->setup_cache_identity, g_strdup(key), g_strdup(value));
+
+	/* the identity changed, so anything saved was for different hardware */
+	g_clear_pointer(&priv->setup_cache_id, g_free);
+	g_clear_pointer(&priv->setup_cache, g_hash_table_unref);
+}
+
+static void
+fu_device_ensure_setup_cache_id(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	const gchar *serial = fu_device_get_serial(self);
+	g_autoptr(GString) str = g_string_new(G_OBJECT_TYPE_NAME(self));
+
+	if (priv->setup_cache_id != NULL)
+		return;
+	if (priv->physical_id != NULL)
+		g_string_append_printf(str, ";PhysicalId=%s", priv->physical_id);
+	if (priv->logical_id != NULL)
+		g_string_append_printf(str, ";LogicalId=%s", priv->logical_id);
+	g_string_append_printf(str, ";Vid=%04x;Pid=%04x", priv->vid, priv->pid);
+	if (serial != NULL)
+		g_string_append_printf(str, ";Serial=%s", serial);
+	if (priv->setup_cache_identity != NULL) {
+		g_autoptr(GList) keys = g_hash_table_get_keys(priv->setup_cache_identity);
+		keys = g_list_sort(keys, (GCompareFunc)g_strcmp0);
+		for (GList *l = keys; l != NULL; l = l->next) {
+			const gchar *key = l->data;
+			const gchar *value = g_hash_table_lookup(priv->setup_cache_identity, key);
+			g_string_append_printf(str, ";%s=%s", key, value);
+		}
+	}
+	priv->setup_cache_id = g_compute_checksum_for_string(G_CHECKSUM_SHA1, str->str, -1);
+}
+
+/**
+ * fu_device_get_setup_cache_id:
+ * @self: a #FuDevice
+ *
+ * Gets the ID used to save the setup results, which is derived from the hardware identity.
+ *
+ * Returns: a SHA-1 hash, or %NULL if the setup cache has not been used
+ *
+ * Since: 2.0.7
+ **/
+const gchar *
+fu_device_get_setup_cache_id(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_DEVICE(self), NULL);
+	return priv->setup_cache_id;
+}
+
+/**
+ * fu_device_get_setup_cache:
+ * @self: a #FuDevice
+ *
+ * Gets the setup results saved by the device that should be persisted.
+ *
+ * Returns: (transfer none) (element-type utf8 utf8) (nullable): values, or %NULL if none saved
+ *
+ * Since: 2.0.7
+ **/
+GHashTable *
+fu_device_get_setup_cache(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_DEVICE(self), NULL);
+	return priv->setup_cache;
+}
+
+/**
+ * fu_device_invalidate_setup_cache:
+ * @self: a #FuDevice
+ *
+ * Forgets the setup results saved for this hardware, typically because the firmware is about
+ * to be written.
+ *
+ * Since: 2.0.7
+ **/
+void
+fu_device_invalidate_setup_cache(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_if_fail(FU_IS_DEVICE(self));
+	if (priv->setup_cache_id != NULL && priv->ctx != NULL)
+		fu_context_remove_setup_cache(priv->ctx, priv->setup_cache_id);
+	g_clear_pointer(&priv->setup_cache, g_hash_table_unref);
+}
+
+/**
+ * fu_device_get_setup_cache_value:
+ * @self: a #FuDevice
+ * @key: the key, e.g. `BoardId`
+ *
+ * Gets a value saved from a previous `->setup()` of the same hardware, which is cleared when
+ * firmware is written to the device.
+ *
+ * The device must have the %FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP flag set.
+ *
+ * Returns: a string value, or %NULL if not cached
+ *
+ * Since: 2.0.7
+ **/
+const gchar *
+fu_device_get_setup_cache_value(FuDevice *self, const gchar *key)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	GHashTable *values;
+
+	g_return_val_if_fail(FU_IS_DEVICE(self), NULL);
+	g_return_val_if_fail(key != NULL, NULL);
+
+	if (!fu_device_setup_cache_is_enabled(self))
+		return NULL;
+	if (priv->setup_cache != NULL)
+		return g_hash_table_lookup(priv->setup_cache, key);
+	fu_device_ensure_setup_cache_id(self);
+	values = fu_context_get_setup_cache(priv->ctx, priv->setup_cache_id);
+	if (values == NULL)
+		return NULL;
+	return g_hash_table_lookup(values, key);
+}
+
+/**
+ * fu_device_set_setup_cache_value:
+ * @self: a #FuDevice
+ * @key: the key, e.g. `BoardId`
+ * @value: the string value, which must not contain `;` or `=`
+ *
+ * Saves a value that was slow to read from the hardware in `->setup()` so that it can be used
+ * the next time the same hardware is set up, including after the daemon is restarted.
+ *
+ * The device must have the %FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP flag set.
+ *
+ * Since: 2.0.7
+ **/
+void
+fu_device_set_setup_cache_value(FuDevice *self, const gchar *key, const gchar *value)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+
+	g_return_if_fail(FU_IS_DEVICE(self));
+	g_return_if_fail(key != NULL);
+	g_return_if_fail(value != NULL);
+
+	if (!fu_device_setup_cache_is_enabled(self))
+		return;
+	fu_device_ensure_setup_cache_id(self);
+	if (priv->setup_cache == NULL)
+		priv->setup_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	g_hash_table_insert(priv->setup_cache, g_strdup(key), g_strdup(value));
+}
+
 /**
  * fu_device_set_metadata_boolean:
  * @self: a #FuDevice
@@ -3123,6 +3479,35 @@ fu_device_set_version(FuDevice *self, const gchar *version)
 	}
 }
 
+/**
+ * fu_device_get_version_key:
+ * @self: a #FuDevice
+ *
+ * Gets the device version as a pre-parsed key, which is much faster to compare than the
+ * version string when sorting or checking many releases.
+ *
+ * The key is cached, and is only rebuilt if the version or the version format changes.
+ *
+ * Returns: a #FuVersionKey
+ *
+ * Since: 2.0.7
+ **/
+const FuVersionKey *
+fu_device_get_version_key(FuDevice *self)
+{
+	FuDevicePrivate *priv = GET_PRIVATE(self);
+	const gchar *version = fu_device_get_version(self);
+	FwupdVersionFormat fmt = fu_device_get_version_format(self);
+
+	g_return_val_if_fail(FU_IS_DEVICE(self), NULL);
+
+	if (priv->version_key == NULL || !fu_version_key_matches(priv->version_key, version, fmt)) {
+		fu_version_key_free(priv->version_key);
+		priv->version_key = fu_version_key_new(version, fmt);
+	}
+	return priv->version_key;
+}
+
 /**
  * fu_device_set_version_lowest:
  * @self: a #FuDevice
@@ -4748,6 +5133,11 @@ fu_device_to_string_impl(FuDevice *self, guint idt, GString *str)
 	fwupd_codec_string_append(str, idt, "ProxyGuid", priv->proxy_guid);
 	fwupd_codec_string_append_int(str, idt, "RemoveDelay", priv->remove_delay);
 	fwupd_codec_string_append_int(str, idt, "AcquiesceDelay", priv->acquiesce_delay);
+	fwupd_codec_string_append_int(str, idt, "SleepCount", priv->sleep_cnt);
+	fwupd_codec_string_append_int(str, idt, "SleepDuration", priv->sleep_total);
+	fwupd_codec_string_append_int(str, idt, "RetryCount", priv->retry_cnt);
+	fwupd_codec_string_append_int(str, idt, "RetryLatency", priv->retry_latency);
+	fwupd_codec_string_append(str, idt, "SetupCacheId", priv->setup_cache_id);
 	fwupd_codec_string_append(str, idt, "CustomFlags", priv->custom_flags);
 	if (priv->specialized_gtype != G_TYPE_INVALID)
 		fwupd_codec_string_append(str, idt, "GType", g_type_name(priv->specialized_gtype));
@@ -5950,6 +6340,10 @@ fu_device_probe_invalidate(FuDevice *self)
 	g_return_if_fail(FU_IS_DEVICE(self));
 	priv->done_probe = FALSE;
 	priv->done_setup = FALSE;
+	if (priv->setup_cache_identity != NULL)
+		g_hash_table_remove_all(priv->setup_cache_identity);
+	g_clear_pointer(&priv->setup_cache_id, g_free);
+	g_clear_pointer(&priv->setup_cache, g_hash_table_unref);
 	if (device_class->invalidate != NULL)
 		device_class->invalidate(self);
 }
@@ -7815,6 +8209,7 @@ fu_device_finalize(GObject *object)
 
 	if (priv->progress != NULL)
 		g_object_unref(priv->progress);
+	fu_version_key_free(priv->version_key);
 	if (priv->proxy != NULL) {
 		if (priv->notify_flags_proxy_id != 0)
 			g_signal_handler_disconnect(priv->proxy, priv->notify_flags_proxy_id);
@@ -7831,6 +8226,11 @@ fu_device_finalize(GObject *object)
 		g_source_remove(priv->poll_id);
 	if (priv->metadata != NULL)
 		g_hash_table_unref(priv->metadata);
+	if (priv->setup_cache_identity != NULL)
+		g_hash_table_unref(priv->setup_cache_identity);
+	if (priv->setup_cache != NULL)
+		g_hash_table_unref(priv->setup_cache);
+	g_free(priv->setup_cache_id);
 	if (priv->inhibits != NULL)
 		g_hash_table_unref(priv->inhibits);
 	if (priv->instance_hash != NULL)
@@ -429,6 +429,24 @@ fu_device_new(FuContext *ctx);
  * Since: 1.5.5
  */
 #define FU_DEVICE_PRIVATE_FLAG_RETRY_OPEN "retry-open"
+/**
+ * FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE:
+ *
+ * Start fu_device_retry_full() with a short delay and back off, learning how long the device
+ * usually takes to succeed.
+ *
+ * Since: 2.0.7
+ */
+#define FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE "retry-adaptive"
+/**
+ * FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP:
+ *
+ * Allow values saved with fu_device_set_setup_cache_value() to be reused the next time the same
+ * hardware is set up.
+ *
+ * Since: 2.0.7
+ */
+#define FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP "cache-setup"
 /**
  * FU_DEVICE_PRIVATE_FLAG_REPLUG_MATCH_GUID:
  *
@@ -867,6 +885,14 @@ fu_device_remove_metadata(FuDevice *self, const gchar *key) G_GNUC_NON_NULL(1, 2
 void
 fu_device_set_metadata(FuDevice *self, const gchar *key, const gchar *value) G_GNUC_NON_NULL(1, 2);
 void
+fu_device_add_setup_cache_identity(FuDevice *self, const gchar *key, const gchar *value)
+    G_GNUC_NON_NULL(1, 2);
+const gchar *
+fu_device_get_setup_cache_value(FuDevice *self, const gchar *key) G_GNUC_NON_NULL(1, 2);
+void
+fu_device_set_setup_cache_value(FuDevice *self, const gchar *key, const gchar *value)
+    G_GNUC_NON_NULL(1, 2);
+void
 fu_device_set_metadata_boolean(FuDevice *self, const gchar *key, gboolean value)
     G_GNUC_NON_NULL(1, 2);
 void
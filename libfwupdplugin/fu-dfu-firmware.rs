@@ -13,7 +13,7 @@ struct FuStructDfuFtr {
     crc: u32le,
 }
 
-#[derive(New, ValidateStream, ParseStream, Default)]
+#[derive(New, Validate, ValidateStream, ParseStream, Default)]
 #[repr(C, packed)]
 struct FuStructDfuseHdr {
     sig: [char; 5] == "DfuSe",
@@ -111,6 +111,12 @@ fu_dfuse_firmware_validate(FuFirmware *firmware, GInputStream *stream, gsize off
 	return fu_struct_dfuse_hdr_validate_stream(stream, offset, error);
 }
 
+static gboolean
+fu_dfuse_firmware_sniff(FuFirmware *firmware, const guint8 *buf, gsize bufsz, GError **error)
+{
+	return fu_struct_dfuse_hdr_validate(buf, bufsz, 0x0, error);
+}
+
 static gboolean
 fu_dfuse_firmware_parse(FuFirmware *firmware,
 			GInputStream *stream,
@@ -273,6 +279,7 @@ fu_dfuse_firmware_class_init(FuDfuseFirmwareClass *klass)
 {
 	FuFirmwareClass *firmware_class = FU_FIRMWARE_CLASS(klass);
 	firmware_class->validate = fu_dfuse_firmware_validate;
+	firmware_class->sniff = fu_dfuse_firmware_sniff;
 	firmware_class->parse = fu_dfuse_firmware_parse;
 	firmware_class->write = fu_dfuse_firmware_write;
 }
@@ -14,6 +14,7 @@
 #include "fu-byte-array.h"
 #include "fu-efi-lz77-decompressor.h"
 #include "fu-input-stream.h"
+#include "fu-mem.h"
 #include "fu-string.h"
 
 struct _FuEfiLz77Decompressor {
@@ -52,12 +53,12 @@ G_DEFINE_TYPE(FuEfiLz77Decompressor, fu_efi_lz77_decompressor, FU_TYPE_FIRMWARE)
 #endif
 
 typedef struct {
-	GInputStream *stream; /* no-ref */
-	GByteArray *dst;      /* no-ref */
+	const guint8 *src; /* no-ref */
+	gsize src_bufsz;
+	GByteArray *dst; /* no-ref */
 
-	guint16 bit_count;
+	gsize bit_pos;
 	guint32 bit_buf;
-	guint32 sub_bit_buf;
 	guint16 block_size;
 
 	guint16 left[2 * NC - 1];
@@ -79,58 +80,40 @@ fu_efi_lz77_decompressor_memset16(guint16 *buf, gsize length, guint16 value)
 		buf[i] = value;
 }
 
-static gboolean
-fu_efi_lz77_decompressor_read_source_bits(FuEfiLz77DecompressHelper *helper,
-					  guint16 number_of_bits,
-					  GError **error)
+/* load the next BITBUFSIZ bits of the source into bit_buf, padding with zeros at the end */
+static void
+fu_efi_lz77_decompressor_fill_bit_buf(FuEfiLz77DecompressHelper *helper)
 {
-	/* left shift number_of_bits of bits in advance */
-	helper->bit_buf = (guint32)(((guint64)helper->bit_buf) << number_of_bits);
-
-	/* copy data needed in bytes into sub_bit_buf */
-	while (number_of_bits > helper->bit_count) {
-		gssize rc;
-		guint8 sub_bit_buf = 0;
-
-		number_of_bits = (guint16)(number_of_bits - helper->bit_count);
-		helper->bit_buf |= (guint32)(((guint64)helper->sub_bit_buf) << number_of_bits);
-
-		/* get 1 byte into sub_bit_buf */
-		rc = g_input_stream_read(helper->stream,
-					 &sub_bit_buf,
-					 sizeof(sub_bit_buf),
-					 NULL,
-					 error);
-		if (rc < 0)
-			return FALSE;
-		if (rc == 0) {
-			/* no more bits from the source, just pad zero bit */
-			helper->sub_bit_buf = 0;
-		} else {
-			helper->sub_bit_buf = sub_bit_buf;
+	gsize offset = helper->bit_pos / 8;
+	guint64 tmp = 0;
+
+	if (offset + sizeof(tmp) <= helper->src_bufsz) {
+		tmp = fu_memread_uint64(helper->src + offset, G_BIG_ENDIAN);
+	} else {
+		for (gsize i = 0; i < sizeof(tmp); i++) {
+			tmp <<= 8;
+			if (offset + i < helper->src_bufsz)
+				tmp |= helper->src[offset + i];
 		}
-		helper->bit_count = 8;
 	}
+	helper->bit_buf = (guint32)((tmp << (helper->bit_pos % 8)) >> (64 - BITBUFSIZ));
+}
 
-	/* calculate additional bit count read to update bit_count */
-	helper->bit_count = (guint16)(helper->bit_count - number_of_bits);
-
-	/* copy number_of_bits of bits from sub_bit_buf into bit_buf */
-	helper->bit_buf |= helper->sub_bit_buf >> helper->bit_count;
-	return TRUE;
+static void
+fu_efi_lz77_decompressor_read_source_bits(FuEfiLz77DecompressHelper *helper,
+					  guint16 number_of_bits)
+{
+	helper->bit_pos += number_of_bits;
+	fu_efi_lz77_decompressor_fill_bit_buf(helper);
 }
 
-static gboolean
-fu_efi_lz77_decompressor_get_bits(FuEfiLz77DecompressHelper *helper,
-				  guint16 number_of_bits,
-				  guint16 *value,
-				  GError **error)
+static guint16
+fu_efi_lz77_decompressor_get_bits(FuEfiLz77DecompressHelper *helper, guint16 number_of_bits)
 {
 	/* pop number_of_bits of bits from left */
-	*value = (guint16)(helper->bit_buf >> (BITBUFSIZ - number_of_bits));
-
-	/* fill up bit_buf from source */
-	return fu_efi_lz77_decompressor_read_source_bits(helper, number_of_bits, error);
+	guint16 value = (guint16)(helper->bit_buf >> (BITBUFSIZ - number_of_bits));
+	fu_efi_lz77_decompressor_read_source_bits(helper, number_of_bits);
+	return value;
 }
 
 /* creates huffman code mapping table for extra set, char&len set and position set according to
@@ -257,8 +240,8 @@ fu_efi_lz77_decompressor_make_huffman_table(FuEfiLz77DecompressHelper *helper,
 }
 
 /* get a position value according to Position Huffman table */
-static gboolean
-fu_efi_lz77_decompressor_decode_p(FuEfiLz77DecompressHelper *helper, guint32 *value, GError **error)
+static guint32
+fu_efi_lz77_decompressor_decode_p(FuEfiLz77DecompressHelper *helper)
 {
 	guint16 val;
 
@@ -276,18 +259,13 @@ fu_efi_lz77_decompressor_decode_p(FuEfiLz77DecompressHelper *helper, guint32 *va
 	}
 
 	/* advance what we have read */
-	if (!fu_efi_lz77_decompressor_read_source_bits(helper, helper->pt_len[val], error))
-		return FALSE;
+	fu_efi_lz77_decompressor_read_source_bits(helper, helper->pt_len[val]);
 
 	if (val > 1) {
-		guint16 char_c = 0;
-		if (!fu_efi_lz77_decompressor_get_bits(helper, (guint16)(val - 1), &char_c, error))
-			return FALSE;
-		*value = (guint32)((1U << (val - 1)) + char_c);
-		return TRUE;
+		guint16 char_c = fu_efi_lz77_decompressor_get_bits(helper, (guint16)(val - 1));
+		return (guint32)((1U << (val - 1)) + char_c);
 	}
-	*value = val;
-	return TRUE;
+	return val;
 }
 
 /* read in the extra set or position set length array, then generate the code mapping for them */
@@ -298,12 +276,11 @@ fu_efi_lz77_decompressor_read_pt_len(FuEfiLz77DecompressHelper *helper,
 				     guint16 special_symbol,
 				     GError **error)
 {
-	guint16 number = 0;
+	guint16 number;
 	guint16 index = 0;
 
 	/* read Extra Set Code Length Array size */
-	if (!fu_efi_lz77_decompressor_get_bits(helper, number_of_bits, &number, error))
-		return FALSE;
+	number = fu_efi_lz77_decompressor_get_bits(helper, number_of_bits);
 
 	/* fail if number or number_of_symbols is greater than size of pt_len */
 	if ((number > sizeof(helper->pt_len)) || (number_of_symbols > sizeof(helper->pt_len))) {
@@ -312,9 +289,7 @@ fu_efi_lz77_decompressor_read_pt_len(FuEfiLz77DecompressHelper *helper,
 	}
 	if (number == 0) {
 		/* this represents only Huffman code used */
-		guint16 char_c = 0;
-		if (!fu_efi_lz77_decompressor_get_bits(helper, number_of_bits, &char_c, error))
-			return FALSE;
+		guint16 char_c = fu_efi_lz77_decompressor_get_bits(helper, number_of_bits);
 		fu_efi_lz77_decompressor_memset16(&helper->pt_table[0],
 						  sizeof(helper->pt_table),
 						  (guint16)char_c);
@@ -336,11 +311,8 @@ fu_efi_lz77_decompressor_read_pt_len(FuEfiLz77DecompressHelper *helper,
 			}
 		}
 
-		if (!fu_efi_lz77_decompressor_read_source_bits(
-			helper,
-			(guint16)((char_c < 7) ? 3 : char_c - 3),
-			error))
-			return FALSE;
+		fu_efi_lz77_decompressor_read_source_bits(helper,
+							  (guint16)((char_c < 7) ? 3 : char_c - 3));
 
 		helper->pt_len[index++] = (guint8)char_c;
 
@@ -348,8 +320,7 @@ fu_efi_lz77_decompressor_read_pt_len(FuEfiLz77DecompressHelper *helper,
 		 * a 2-bit value is used to indicated the number of consecutive zero lengths after
 		 * the third length */
 		if (index == special_symbol) {
-			if (!fu_efi_lz77_decompressor_get_bits(helper, 2, &char_c, error))
-				return FALSE;
+			char_c = fu_efi_lz77_decompressor_get_bits(helper, 2);
 			while ((gint16)(--char_c) >= 0 && index < NPT) {
 				helper->pt_len[index++] = 0;
 			}
@@ -370,16 +341,13 @@ fu_efi_lz77_decompressor_read_pt_len(FuEfiLz77DecompressHelper *helper,
 static gboolean
 fu_efi_lz77_decompressor_read_c_len(FuEfiLz77DecompressHelper *helper, GError **error)
 {
-	guint16 number = 0;
+	guint16 number;
 	guint16 index = 0;
 
-	if (!fu_efi_lz77_decompressor_get_bits(helper, CBIT, &number, error))
-		return FALSE;
+	number = fu_efi_lz77_decompressor_get_bits(helper, CBIT);
 	if (number == 0) {
 		/* this represents only Huffman code used */
-		guint16 char_c = 0;
-		if (!fu_efi_lz77_decompressor_get_bits(helper, CBIT, &char_c, error))
-			return FALSE;
+		guint16 char_c = fu_efi_lz77_decompressor_get_bits(helper, CBIT);
 		memset(helper->c_len, 0, sizeof(helper->c_len));
 		fu_efi_lz77_decompressor_memset16(&helper->c_table[0],
 						  sizeof(helper->c_table),
@@ -403,25 +371,15 @@ fu_efi_lz77_decompressor_read_c_len(FuEfiLz77DecompressHelper *helper, GError **
 		}
 
 		/* advance what we have read */
-		if (!fu_efi_lz77_decompressor_read_source_bits(helper,
-							       helper->pt_len[char_c],
-							       error))
-			return FALSE;
+		fu_efi_lz77_decompressor_read_source_bits(helper, helper->pt_len[char_c]);
 
 		if (char_c <= 2) {
 			if (char_c == 0) {
 				char_c = 1;
 			} else if (char_c == 1) {
-				if (!fu_efi_lz77_decompressor_get_bits(helper, 4, &char_c, error))
-					return FALSE;
-				char_c += 3;
+				char_c = fu_efi_lz77_decompressor_get_bits(helper, 4) + 3;
 			} else if (char_c == 2) {
-				if (!fu_efi_lz77_decompressor_get_bits(helper,
-								       CBIT,
-								       &char_c,
-								       error))
-					return FALSE;
-				char_c += 20;
+				char_c = fu_efi_lz77_decompressor_get_bits(helper, CBIT) + 20;
 			}
 			while ((gint16)(--char_c) >= 0 && index < NC)
 				helper->c_len[index++] = 0;
@@ -448,8 +406,7 @@ fu_efi_lz77_decompressor_decode_c(FuEfiLz77DecompressHelper *helper, guint16 *va
 
 	if (helper->block_size == 0) {
 		/* starting a new block, so read blocksize from block header */
-		if (!fu_efi_lz77_decompressor_get_bits(helper, 16, &helper->block_size, error))
-			return FALSE;
+		helper->block_size = fu_efi_lz77_decompressor_get_bits(helper, 16);
 
 		/* read in the extra set code length array */
 		if (!fu_efi_lz77_decompressor_read_pt_len(helper, NT, TBIT, 3, error)) {
@@ -502,8 +459,7 @@ fu_efi_lz77_decompressor_decode_c(FuEfiLz77DecompressHelper *helper, guint16 *va
 	}
 
 	/* advance what we have read */
-	if (!fu_efi_lz77_decompressor_read_source_bits(helper, helper->c_len[index2], error))
-		return FALSE;
+	fu_efi_lz77_decompressor_read_source_bits(helper, helper->c_len[index2]);
 	*value = index2;
 	return TRUE;
 }
@@ -533,8 +489,7 @@ fu_efi_lz77_decompressor_internal(FuEfiLz77DecompressHelper *helper,
 	}
 
 	/* fill the first BITBUFSIZ bits */
-	if (!fu_efi_lz77_decompressor_read_source_bits(helper, BITBUFSIZ, error))
-		return FALSE;
+	fu_efi_lz77_decompressor_fill_bit_buf(helper);
 
 	/* decode each char */
 	while (dst_offset < helper->dst->len) {
@@ -549,13 +504,10 @@ fu_efi_lz77_decompressor_internal(FuEfiLz77DecompressHelper *helper,
 		} else {
 			guint16 bytes_remaining;
 			guint32 data_offset;
-			guint32 tmp = 0;
 
 			/* process a pointer, so get string length */
 			bytes_remaining = (guint16)(char_c - (0x00000100U - THRESHOLD));
-			if (!fu_efi_lz77_decompressor_decode_p(helper, &tmp, error))
-				return FALSE;
-			data_offset = dst_offset - tmp - 1;
+			data_offset = dst_offset - fu_efi_lz77_decompressor_decode_p(helper) - 1;
 
 			/* write bytes_remaining of bytes into dst_buf */
 			bytes_remaining--;
@@ -594,6 +546,7 @@ fu_efi_lz77_decompressor_parse(FuFirmware *firmware,
 	guint32 dst_bufsz;
 	guint32 src_bufsz;
 	g_autoptr(GByteArray) st = NULL;
+	g_autoptr(GBytes) src = NULL;
 	g_autoptr(GError) error_all = NULL;
 	g_autoptr(GByteArray) dst = g_byte_array_new();
 	FuEfiLz77DecompressorVersion decompressor_versions[] = {
@@ -636,16 +589,24 @@ fu_efi_lz77_decompressor_parse(FuFirmware *firmware,
 	}
 	fu_byte_array_set_size(dst, dst_bufsz, 0x0);
 
+	/* read the source once rather than a byte at a time, as this is shared by both versions */
+	if (streamsz > st->len) {
+		src = fu_input_stream_read_bytes(stream, st->len, streamsz - st->len, NULL, error);
+		if (src == NULL)
+			return FALSE;
+	} else {
+		src = g_bytes_new(NULL, 0);
+	}
+
 	/* try both position */
 	for (guint i = 0; i < G_N_ELEMENTS(decompressor_versions); i++) {
 		FuEfiLz77DecompressHelper helper = {
 		    .dst = dst,
-		    .stream = stream,
+		    .src = g_bytes_get_data(src, NULL),
+		    .src_bufsz = g_bytes_get_size(src),
 		};
 		g_autoptr(GError) error_local = NULL;
 
-		if (!g_seekable_seek(G_SEEKABLE(stream), st->len, G_SEEK_SET, NULL, error))
-			return FALSE;
 		if (fu_efi_lz77_decompressor_internal(&helper,
 						      decompressor_versions[i],
 						      &error_local)) {
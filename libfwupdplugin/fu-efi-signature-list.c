@@ -230,6 +230,7 @@ static void
 fu_efi_signature_list_init(FuEfiSignatureList *self)
 {
 	fu_firmware_add_flag(FU_FIRMWARE(self), FU_FIRMWARE_FLAG_ALWAYS_SEARCH);
+	fu_firmware_add_flag(FU_FIRMWARE(self), FU_FIRMWARE_FLAG_INDEX_IMAGES);
 	fu_firmware_set_images_max(FU_FIRMWARE(self), 2000);
 	g_type_ensure(FU_TYPE_EFI_SIGNATURE);
 }
@@ -53,6 +53,12 @@ fu_efi_volume_validate(FuFirmware *firmware, GInputStream *stream, gsize offset,
 	return fu_struct_efi_volume_validate_stream(stream, offset, error);
 }
 
+static gboolean
+fu_efi_volume_sniff(FuFirmware *firmware, const guint8 *buf, gsize bufsz, GError **error)
+{
+	return fu_struct_efi_volume_validate(buf, bufsz, 0x0, error);
+}
+
 static gboolean
 fu_efi_volume_parse(FuFirmware *firmware,
 		    GInputStream *stream,
@@ -321,6 +327,7 @@ fu_efi_volume_class_init(FuEfiVolumeClass *klass)
 {
 	FuFirmwareClass *firmware_class = FU_FIRMWARE_CLASS(klass);
 	firmware_class->validate = fu_efi_volume_validate;
+	firmware_class->sniff = fu_efi_volume_sniff;
 	firmware_class->parse = fu_efi_volume_parse;
 	firmware_class->write = fu_efi_volume_write;
 	firmware_class->export = fu_efi_volume_export;
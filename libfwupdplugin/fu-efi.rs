@@ -139,7 +139,7 @@ struct FuStructEfiSectionGuidDefined {
     attr: u16le,
 }
 
-#[derive(New, ValidateStream, ParseStream, Default)]
+#[derive(New, Validate, ValidateStream, ParseStream, Default)]
 #[repr(C, packed)]
 struct FuStructEfiVolume {
     zero_vector: Guid,
@@ -34,6 +34,12 @@ fu_elf_firmware_validate(FuFirmware *firmware, GInputStream *stream, gsize offse
 	return fu_struct_elf_file_header64le_validate_stream(stream, offset, error);
 }
 
+static gboolean
+fu_elf_firmware_sniff(FuFirmware *firmware, const guint8 *buf, gsize bufsz, GError **error)
+{
+	return fu_struct_elf_file_header64le_validate(buf, bufsz, 0x0, error);
+}
+
 static gboolean
 fu_elf_firmware_parse(FuFirmware *firmware,
 		      GInputStream *stream,
@@ -377,6 +383,7 @@ fu_elf_firmware_class_init(FuElfFirmwareClass *klass)
 {
 	FuFirmwareClass *firmware_class = FU_FIRMWARE_CLASS(klass);
 	firmware_class->validate = fu_elf_firmware_validate;
+	firmware_class->sniff = fu_elf_firmware_sniff;
 	firmware_class->parse = fu_elf_firmware_parse;
 	firmware_class->write = fu_elf_firmware_write;
 }
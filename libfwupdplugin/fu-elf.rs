@@ -10,7 +10,7 @@ enum FuElfFileHeaderType {
     Core = 0x04,
 }
 
-#[derive(ParseStream, ValidateStream, New, Default)]
+#[derive(ParseStream, Validate, ValidateStream, New, Default)]
 #[repr(C, packed)]
 struct FuStructElfFileHeader64le {
     ei_magic: [char; 4] == "\x7F\x45\x4C\x46",
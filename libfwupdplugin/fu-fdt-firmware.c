@@ -319,6 +319,12 @@ fu_fdt_firmware_validate(FuFirmware *firmware, GInputStream *stream, gsize offse
 	return fu_struct_fdt_validate_stream(stream, offset, error);
 }
 
+static gboolean
+fu_fdt_firmware_sniff(FuFirmware *firmware, const guint8 *buf, gsize bufsz, GError **error)
+{
+	return fu_struct_fdt_validate(buf, bufsz, 0x0, error);
+}
+
 static gboolean
 fu_fdt_firmware_parse(FuFirmware *firmware,
 		      GInputStream *stream,
@@ -585,6 +591,7 @@ fu_fdt_firmware_class_init(FuFdtFirmwareClass *klass)
 {
 	FuFirmwareClass *firmware_class = FU_FIRMWARE_CLASS(klass);
 	firmware_class->validate = fu_fdt_firmware_validate;
+	firmware_class->sniff = fu_fdt_firmware_sniff;
 	firmware_class->export = fu_fdt_firmware_export;
 	firmware_class->parse = fu_fdt_firmware_parse;
 	firmware_class->write = fu_fdt_firmware_write;
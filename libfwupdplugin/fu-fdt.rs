@@ -9,7 +9,7 @@ enum FuFdtToken {
     End         = 0x00000009,
 }
 
-#[derive(New, ValidateStream, ParseStream, Default)]
+#[derive(New, Validate, ValidateStream, ParseStream, Default)]
 #[repr(C, packed)]
 struct FuStructFdt {
     magic: u32be == 0xD00DFEED,
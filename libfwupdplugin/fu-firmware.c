@@ -48,6 +48,8 @@ typedef struct {
 	guint depth;
 	GPtrArray *chunks;  /* nullable, element-type FuChunk */
 	GPtrArray *patches; /* nullable, element-type FuFirmwarePatch */
+	GHashTable *images_by_id;	/* nullable, utf8:FuFirmware (noref) */
+	GHashTable *images_by_checksum; /* nullable, GChecksumType:GHashTable */
 } FuFirmwarePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(FuFirmware, fu_firmware, G_TYPE_OBJECT)
@@ -90,6 +92,8 @@ fu_firmware_flag_to_string(FuFirmwareFlags flag)
 		return "no-auto-detection";
 	if (flag == FU_FIRMWARE_FLAG_HAS_CHECK_COMPATIBLE)
 		return "has-check-compatible";
+	if (flag == FU_FIRMWARE_FLAG_INDEX_IMAGES)
+		return "index-images";
 	return NULL;
 }
 
@@ -124,6 +128,8 @@ fu_firmware_flag_from_string(const gchar *flag)
 		return FU_FIRMWARE_FLAG_NO_AUTO_DETECTION;
 	if (g_strcmp0(flag, "has-check-compatible") == 0)
 		return FU_FIRMWARE_FLAG_HAS_CHECK_COMPATIBLE;
+	if (g_strcmp0(flag, "index-images") == 0)
+		return FU_FIRMWARE_FLAG_INDEX_IMAGES;
 	return FU_FIRMWARE_FLAG_NONE;
 }
 
@@ -139,6 +145,23 @@ fu_firmware_patch_free(FuFirmwarePatch *ptch)
 	g_free(ptch);
 }
 
+static void
+fu_firmware_invalidate_image_index(FuFirmware *self)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+	g_clear_pointer(&priv->images_by_id, g_hash_table_unref);
+	g_clear_pointer(&priv->images_by_checksum, g_hash_table_unref);
+}
+
+/* the parent index includes the ID and checksum of this image */
+static void
+fu_firmware_invalidate_parent_image_index(FuFirmware *self)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+	if (priv->parent != NULL)
+		fu_firmware_invalidate_image_index(priv->parent);
+}
+
 /**
  * fu_firmware_add_flag:
  * @firmware: a #FuFirmware
@@ -372,6 +395,7 @@ fu_firmware_set_id(FuFirmware *self, const gchar *id)
 
 	g_free(priv->id);
 	priv->id = g_strdup(id);
+	fu_firmware_invalidate_parent_image_index(self);
 }
 
 /**
@@ -643,6 +667,10 @@ fu_firmware_set_bytes(FuFirmware *self, GBytes *bytes)
 
 	/* the input stream is no longer valid */
 	g_clear_object(&priv->stream);
+
+	/* any cached checksums are no longer valid */
+	fu_firmware_invalidate_image_index(self);
+	fu_firmware_invalidate_parent_image_index(self);
 }
 
 /**
@@ -800,6 +828,8 @@ fu_firmware_set_stream(FuFirmware *self, GInputStream *stream, GError **error)
 		priv->streamsz = 0;
 	}
 	g_set_object(&priv->stream, stream);
+	fu_firmware_invalidate_image_index(self);
+	fu_firmware_invalidate_parent_image_index(self);
 	return TRUE;
 }
 
@@ -1050,6 +1080,60 @@ fu_firmware_validate_for_offset(FuFirmware *self,
 	return FALSE;
 }
 
+/**
+ * fu_firmware_sniff:
+ * @self: a #FuFirmware
+ * @buf: the start of the firmware, typically %FU_FIRMWARE_SNIFF_BUFSZ bytes
+ * @bufsz: size of @buf
+ * @streamsz: size of the entire firmware, which may be larger than @bufsz
+ * @flags: install flags, e.g. %FWUPD_INSTALL_FLAG_NO_SEARCH
+ * @error: (nullable): optional return location for an error
+ *
+ * Quickly checks if the firmware could be parsed by this type, without doing a full parse.
+ * This is only a hint, and a full parse using fu_firmware_parse_stream() may still fail.
+ *
+ * Returns: %FALSE if the firmware is definitely not of this type
+ *
+ * Since: 2.0.7
+ **/
+gboolean
+fu_firmware_sniff(FuFirmware *self,
+		  const guint8 *buf,
+		  gsize bufsz,
+		  gsize streamsz,
+		  FwupdInstallFlags flags,
+		  GError **error)
+{
+	FuFirmwareClass *klass = FU_FIRMWARE_GET_CLASS(self);
+
+	g_return_val_if_fail(FU_IS_FIRMWARE(self), FALSE);
+	g_return_val_if_fail(buf != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* not implemented */
+	if (klass->sniff == NULL)
+		return TRUE;
+
+	/* the parser will search for the magic */
+	if ((fu_firmware_has_flag(self, FU_FIRMWARE_FLAG_ALWAYS_SEARCH) ||
+	     (flags & FWUPD_INSTALL_FLAG_NO_SEARCH) == 0) &&
+	    streamsz <= FU_FIRMWARE_SEARCH_MAGIC_BUFSZ_MAX) {
+		/* the magic might be after the data we have */
+		if (bufsz < streamsz)
+			return TRUE;
+		for (gsize offset = 0; offset < bufsz; offset++) {
+			if (klass->sniff(self, buf + offset, bufsz - offset, NULL))
+				return TRUE;
+		}
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_FILE,
+				    "did not find magic");
+		return FALSE;
+	}
+	return klass->sniff(self, buf, bufsz, error);
+}
+
 /**
  * fu_firmware_parse_stream:
  * @self: a #FuFirmware
@@ -1587,6 +1671,10 @@ fu_firmware_add_patch(FuFirmware *self, gsize offset, GBytes *blob)
 	g_return_if_fail(FU_IS_FIRMWARE(self));
 	g_return_if_fail(blob != NULL);
 
+	/* any cached checksums are no longer valid */
+	fu_firmware_invalidate_image_index(self);
+	fu_firmware_invalidate_parent_image_index(self);
+
 	/* ensure exists */
 	if (priv->patches == NULL) {
 		priv->patches =
@@ -1773,6 +1861,9 @@ fu_firmware_add_image_full(FuFirmware *self, FuFirmware *img, GError **error)
 		return FALSE;
 	}
 
+	/* any dedupe will also change the images */
+	fu_firmware_invalidate_image_index(self);
+
 	/* dedupe */
 	for (guint i = 0; i < priv->images->len; i++) {
 		FuFirmware *img_tmp = g_ptr_array_index(priv->images, i);
@@ -1893,8 +1984,10 @@ fu_firmware_remove_image(FuFirmware *self, FuFirmware *img, GError **error)
 	g_return_val_if_fail(FU_IS_FIRMWARE(img), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	if (g_ptr_array_remove(priv->images, img))
+	if (g_ptr_array_remove(priv->images, img)) {
+		fu_firmware_invalidate_image_index(self);
 		return TRUE;
+	}
 
 	/* did not exist */
 	g_set_error(error,
@@ -1930,6 +2023,7 @@ fu_firmware_remove_image_by_idx(FuFirmware *self, guint64 idx, GError **error)
 	if (img == NULL)
 		return FALSE;
 	g_ptr_array_remove(priv->images, img);
+	fu_firmware_invalidate_image_index(self);
 	return TRUE;
 }
 
@@ -1958,6 +2052,7 @@ fu_firmware_remove_image_by_id(FuFirmware *self, const gchar *id, GError **error
 	if (img == NULL)
 		return FALSE;
 	g_ptr_array_remove(priv->images, img);
+	fu_firmware_invalidate_image_index(self);
 	return TRUE;
 }
 
@@ -1987,6 +2082,23 @@ fu_firmware_get_images(FuFirmware *self)
 	return g_steal_pointer(&imgs);
 }
 
+static void
+fu_firmware_build_image_index_id(FuFirmware *self)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+
+	priv->images_by_id = g_hash_table_new(g_str_hash, g_str_equal);
+	for (guint i = 0; i < priv->images->len; i++) {
+		FuFirmware *img = g_ptr_array_index(priv->images, i);
+		const gchar *id = fu_firmware_get_id(img);
+
+		/* the first image wins, just like the linear search */
+		if (id == NULL || g_hash_table_contains(priv->images_by_id, id))
+			continue;
+		g_hash_table_insert(priv->images_by_id, (gpointer)id, img);
+	}
+}
+
 /**
  * fu_firmware_get_image_by_id:
  * @self: a #FuPlugin
@@ -2007,6 +2119,22 @@ fu_firmware_get_image_by_id(FuFirmware *self, const gchar *id, GError **error)
 	g_return_val_if_fail(FU_IS_FIRMWARE(self), NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
+	/* exact match can use the index, a glob has to be matched against each image */
+	if (id != NULL && (priv->flags & FU_FIRMWARE_FLAG_INDEX_IMAGES) > 0 &&
+	    strpbrk(id, "*?") == NULL) {
+		FuFirmware *img;
+		if (priv->images_by_id == NULL)
+			fu_firmware_build_image_index_id(self);
+		img = g_hash_table_lookup(priv->images_by_id, id);
+		if (img != NULL)
+			return g_object_ref(img);
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_FOUND,
+			    "no image id %s found in firmware",
+			    id);
+		return NULL;
+	}
 	for (guint i = 0; i < priv->images->len; i++) {
 		FuFirmware *img = g_ptr_array_index(priv->images, i);
 		if (id == NULL && fu_firmware_get_id(img) == NULL)
@@ -2097,6 +2225,47 @@ fu_firmware_get_image_by_idx(FuFirmware *self, guint64 idx, GError **error)
 	return NULL;
 }
 
+/* returns the existing index for the checksum kind, building it if required */
+static GHashTable *
+fu_firmware_build_image_index_checksum(FuFirmware *self, GChecksumType csum_kind, GError **error)
+{
+	FuFirmwarePrivate *priv = GET_PRIVATE(self);
+	GHashTable *images_by_checksum;
+	g_autoptr(GHashTable) images_by_checksum_new = NULL;
+
+	if (priv->images_by_checksum == NULL) {
+		priv->images_by_checksum =
+		    g_hash_table_new_full(g_direct_hash,
+					  g_direct_equal,
+					  NULL,
+					  (GDestroyNotify)g_hash_table_unref);
+	}
+	images_by_checksum =
+	    g_hash_table_lookup(priv->images_by_checksum, GINT_TO_POINTER(csum_kind));
+	if (images_by_checksum != NULL)
+		return images_by_checksum;
+
+	images_by_checksum_new = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	for (guint i = 0; i < priv->images->len; i++) {
+		FuFirmware *img = g_ptr_array_index(priv->images, i);
+		g_autofree gchar *checksum_tmp = NULL;
+
+		checksum_tmp = fu_firmware_get_checksum(img, csum_kind, error);
+		if (checksum_tmp == NULL)
+			return NULL;
+
+		/* the first image wins, just like the linear search */
+		if (g_hash_table_contains(images_by_checksum_new, checksum_tmp))
+			continue;
+		g_hash_table_insert(images_by_checksum_new, g_steal_pointer(&checksum_tmp), img);
+	}
+	images_by_checksum = images_by_checksum_new;
+	g_hash_table_insert(priv->images_by_checksum,
+			    GINT_TO_POINTER(csum_kind),
+			    g_steal_pointer(&images_by_checksum_new));
+	return images_by_checksum;
+}
+
 /**
  * fu_firmware_get_image_by_checksum:
  * @self: a #FuPlugin
@@ -2106,6 +2275,8 @@ fu_firmware_get_image_by_idx(FuFirmware *self, guint64 idx, GError **error)
  * Gets the firmware image using the image checksum. The checksum type is guessed
  * based on the length of the input string.
  *
+ * If %FU_FIRMWARE_FLAG_INDEX_IMAGES is set then the image checksums are only computed once.
+ *
  * Returns: (transfer full): a #FuFirmware, or %NULL if the image is not found
  *
  * Since: 1.5.5
@@ -2121,6 +2292,23 @@ fu_firmware_get_image_by_checksum(FuFirmware *self, const gchar *checksum, GErro
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
 	csum_kind = fwupd_checksum_guess_kind(checksum);
+	if (priv->flags & FU_FIRMWARE_FLAG_INDEX_IMAGES) {
+		GHashTable *images_by_checksum;
+		FuFirmware *img;
+
+		images_by_checksum = fu_firmware_build_image_index_checksum(self, csum_kind, error);
+		if (images_by_checksum == NULL)
+			return NULL;
+		img = g_hash_table_lookup(images_by_checksum, checksum);
+		if (img != NULL)
+			return g_object_ref(img);
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_FOUND,
+			    "no image with checksum %s found in firmware",
+			    checksum);
+		return NULL;
+	}
 	for (guint i = 0; i < priv->images->len; i++) {
 		FuFirmware *img = g_ptr_array_index(priv->images, i);
 		g_autofree gchar *checksum_tmp = NULL;
@@ -2456,6 +2644,10 @@ fu_firmware_finalize(GObject *object)
 		g_ptr_array_unref(priv->patches);
 	if (priv->parent != NULL)
 		g_object_remove_weak_pointer(G_OBJECT(priv->parent), (gpointer *)&priv->parent);
+	if (priv->images_by_id != NULL)
+		g_hash_table_unref(priv->images_by_id);
+	if (priv->images_by_checksum != NULL)
+		g_hash_table_unref(priv->images_by_checksum);
 	g_ptr_array_unref(priv->images);
 	G_OBJECT_CLASS(fu_firmware_parent_class)->finalize(object);
 }
@@ -2519,6 +2711,17 @@ fu_firmware_new_from_bytes(GBytes *fw)
 	return self;
 }
 
+static void
+fu_firmware_new_from_gtypes_add_error(GError **error_all, GError **error_local)
+{
+	g_debug("%s", (*error_local)->message);
+	if (*error_all == NULL) {
+		g_propagate_error(error_all, g_steal_pointer(error_local));
+		return;
+	}
+	g_prefix_error(error_all, "%s: ", (*error_local)->message);
+}
+
 /**
  * fu_firmware_new_from_gtypes:
  * @stream: a #GInputStream
@@ -2529,6 +2732,9 @@ fu_firmware_new_from_bytes(GBytes *fw)
  *
  * Tries to parse the firmware with each #GType in order.
  *
+ * The start of the firmware is read once and types that implement the `sniff` vfunc are
+ * skipped without a full parse if the magic does not match.
+ *
  * Returns: (transfer full) (nullable): a #FuFirmware, or %NULL
  *
  * Since: 1.5.6
@@ -2541,7 +2747,9 @@ fu_firmware_new_from_gtypes(GInputStream *stream,
 			    ...)
 {
 	va_list args;
+	gsize streamsz = 0;
 	g_autoptr(GArray) gtypes = g_array_new(FALSE, FALSE, sizeof(GType));
+	g_autoptr(GBytes) blob_sniff = NULL;
 	g_autoptr(GError) error_all = NULL;
 
 	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
@@ -2571,13 +2779,36 @@ fu_firmware_new_from_gtypes(GInputStream *stream,
 		GType gtype = g_array_index(gtypes, GType, i);
 		g_autoptr(FuFirmware) firmware = g_object_new(gtype, NULL);
 		g_autoptr(GError) error_local = NULL;
-		if (!fu_firmware_parse_stream(firmware, stream, offset, flags, &error_local)) {
-			g_debug("%s", error_local->message);
-			if (error_all == NULL) {
-				g_propagate_error(&error_all, g_steal_pointer(&error_local));
-			} else {
-				g_prefix_error(&error_all, "%s: ", error_local->message);
+
+		/* only read the start of the firmware once */
+		if (FU_FIRMWARE_GET_CLASS(firmware)->sniff != NULL && blob_sniff == NULL) {
+			if (!fu_input_stream_size(stream, &streamsz, error))
+				return NULL;
+			if (streamsz > offset) {
+				blob_sniff =
+				    fu_input_stream_read_bytes(stream,
+							       offset,
+							       MIN(streamsz - offset,
+								   FU_FIRMWARE_SNIFF_BUFSZ),
+							       NULL,
+							       error);
+				if (blob_sniff == NULL)
+					return NULL;
+			}
+		}
+		if (blob_sniff != NULL) {
+			if (!fu_firmware_sniff(firmware,
+					       g_bytes_get_data(blob_sniff, NULL),
+					       g_bytes_get_size(blob_sniff),
+					       streamsz - offset,
+					       flags,
+					       &error_local)) {
+				fu_firmware_new_from_gtypes_add_error(&error_all, &error_local);
+				continue;
 			}
+		}
+		if (!fu_firmware_parse_stream(firmware, stream, offset, flags, &error_local)) {
+			fu_firmware_new_from_gtypes_add_error(&error_all, &error_local);
 			continue;
 		}
 		return g_steal_pointer(&firmware);
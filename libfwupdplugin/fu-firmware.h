@@ -77,6 +77,7 @@ struct _FuFirmwareClass {
 				     FwupdInstallFlags flags,
 				     GError **error);
 	gchar *(*convert_version)(FuFirmware *self, guint64 version_raw);
+	gboolean (*sniff)(FuFirmware *self, const guint8 *buf, gsize bufsz, GError **error);
 };
 
 /**
@@ -169,6 +170,15 @@ typedef enum {
 	 * Since: 1.9.20
 	 **/
 	FU_FIRMWARE_FLAG_HAS_CHECK_COMPATIBLE = 1u << 8,
+	/**
+	 * FU_FIRMWARE_FLAG_INDEX_IMAGES:
+	 *
+	 * Index the child images by ID and checksum when they are first looked up.
+	 * This should be used for containers with many images that are searched repeatedly.
+	 *
+	 * Since: 2.0.7
+	 **/
+	FU_FIRMWARE_FLAG_INDEX_IMAGES = 1u << 9,
 	/**
 	 * FU_FIRMWARE_FLAG_UNKNOWN:
 	 *
@@ -248,6 +258,15 @@ typedef enum {
 
 #define FU_FIRMWARE_SEARCH_MAGIC_BUFSZ_MAX (32 * 1024 * 1024)
 
+/**
+ * FU_FIRMWARE_SNIFF_BUFSZ:
+ *
+ * The amount of data read from the start of the firmware when checking the magic.
+ *
+ * Since: 2.0.7
+ **/
+#define FU_FIRMWARE_SNIFF_BUFSZ 0x1000
+
 const gchar *
 fu_firmware_flag_to_string(FuFirmwareFlags flag);
 FuFirmwareFlags
@@ -263,6 +282,13 @@ fu_firmware_new_from_gtypes(GInputStream *stream,
 			    FwupdInstallFlags flags,
 			    GError **error,
 			    ...) G_GNUC_NON_NULL(1);
+gboolean
+fu_firmware_sniff(FuFirmware *self,
+		  const guint8 *buf,
+		  gsize bufsz,
+		  gsize streamsz,
+		  FwupdInstallFlags flags,
+		  GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
 gchar *
 fu_firmware_to_string(FuFirmware *self) G_GNUC_NON_NULL(1);
 void
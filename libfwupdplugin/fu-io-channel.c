@@ -127,6 +127,86 @@ fu_io_channel_seek(FuIOChannel *self, gsize offset, GError **error)
 	return TRUE;
 }
 
+/**
+ * fu_io_channel_wait:
+ * @self: a #FuIOChannel
+ * @condition: a #GIOCondition, typically %G_IO_IN or %G_IO_OUT
+ * @timeout_ms: timeout in ms
+ * @error: (nullable): optional return location for an error
+ *
+ * Waits for the device to signal @condition, for instance when a status byte is ready to be read.
+ * This should be used rather than polling the device with a fixed delay, as the caller
+ * continues as soon as the device is ready.
+ *
+ * Returns: %TRUE if the device is ready, or %FALSE with %FWUPD_ERROR_TIMED_OUT
+ *
+ * Since: 2.0.7
+ **/
+gboolean
+fu_io_channel_wait(FuIOChannel *self, GIOCondition condition, guint timeout_ms, GError **error)
+{
+	gint64 deadline;
+	GPollFD fds = {
+	    .fd = self->fd,
+	    .events = condition | G_IO_ERR,
+	};
+
+	g_return_val_if_fail(FU_IS_IO_CHANNEL(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (self->fd == -1) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_SUPPORTED,
+				    "channel is not open");
+		return FALSE;
+	}
+
+	/* restart with the time remaining if interrupted */
+	deadline = g_get_monotonic_time() + ((gint64)timeout_ms * 1000);
+	while (TRUE) {
+		gint64 remaining = (deadline - g_get_monotonic_time()) / 1000;
+		gint rc = g_poll(&fds, 1, (gint)MAX(remaining, 0));
+		if (rc == 0) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_TIMED_OUT,
+				    "timed out waiting for 0x%x after %ums",
+				    (guint)condition,
+				    timeout_ms);
+			return FALSE;
+		}
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_READ,
+				    "failed to poll %i",
+				    self->fd);
+			return FALSE;
+		}
+		if (fds.revents & G_IO_NVAL) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOT_FOUND,
+				    "invalid fd %i",
+				    self->fd);
+			return FALSE;
+		}
+		if (fds.revents & (G_IO_ERR | G_IO_HUP) && (fds.revents & condition) == 0) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_READ,
+				    "device signalled error 0x%x",
+				    (guint)fds.revents);
+			return FALSE;
+		}
+		if (fds.revents & condition)
+			return TRUE;
+	}
+}
+
 static gboolean
 fu_io_channel_flush_input(FuIOChannel *self, GError **error)
 {
@@ -113,6 +113,12 @@ fu_oprom_firmware_validate(FuFirmware *firmware, GInputStream *stream, gsize off
 	return fu_struct_oprom_validate_stream(stream, offset, error);
 }
 
+static gboolean
+fu_oprom_firmware_sniff(FuFirmware *firmware, const guint8 *buf, gsize bufsz, GError **error)
+{
+	return fu_struct_oprom_validate(buf, bufsz, 0x0, error);
+}
+
 static gboolean
 fu_oprom_firmware_parse(FuFirmware *firmware,
 			GInputStream *stream,
@@ -294,6 +300,7 @@ fu_oprom_firmware_class_init(FuOpromFirmwareClass *klass)
 {
 	FuFirmwareClass *firmware_class = FU_FIRMWARE_CLASS(klass);
 	firmware_class->validate = fu_oprom_firmware_validate;
+	firmware_class->sniff = fu_oprom_firmware_sniff;
 	firmware_class->export = fu_oprom_firmware_export;
 	firmware_class->parse = fu_oprom_firmware_parse;
 	firmware_class->write = fu_oprom_firmware_write;
@@ -1,7 +1,7 @@
 // Copyright 2023 Richard Hughes <richard@hughsie.com>
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
-#[derive(New, ValidateStream, ParseStream, Default)]
+#[derive(New, Validate, ValidateStream, ParseStream, Default)]
 #[repr(C, packed)]
 struct FuStructOprom {
     signature: u16le == 0xAA55,
@@ -60,6 +60,12 @@ fu_pefile_firmware_validate(FuFirmware *firmware,
 	return fu_struct_pe_dos_header_validate_stream(stream, offset, error);
 }
 
+static gboolean
+fu_pefile_firmware_sniff(FuFirmware *firmware, const guint8 *buf, gsize bufsz, GError **error)
+{
+	return fu_struct_pe_dos_header_validate(buf, bufsz, 0x0, error);
+}
+
 typedef struct {
 	gsize offset;
 	gsize size;
@@ -521,6 +527,7 @@ fu_pefile_firmware_class_init(FuPefileFirmwareClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS(klass);
 	object_class->finalize = fu_pefile_firmware_finalize;
 	firmware_class->validate = fu_pefile_firmware_validate;
+	firmware_class->sniff = fu_pefile_firmware_sniff;
 	firmware_class->parse = fu_pefile_firmware_parse;
 	firmware_class->write = fu_pefile_firmware_write;
 	firmware_class->export = fu_pefile_firmware_export;
@@ -1,7 +1,7 @@
 // Copyright 2023 Richard Hughes <richard@hughsie.com>
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
-#[derive(ParseStream, ValidateStream, New, Default)]
+#[derive(ParseStream, Validate, ValidateStream, New, Default)]
 #[repr(C, packed)]
 struct FuStructPeDosHeader {
     magic: u16le == 0x5A4D,
@@ -24,6 +24,7 @@
 #include "fu-plugin-private.h"
 #include "fu-security-attr.h"
 #include "fu-string.h"
+#include "fu-trace-private.h"
 
 /**
  * FuPlugin:
@@ -847,6 +848,7 @@ gboolean
 fu_plugin_runner_startup(FuPlugin *self, FuProgress *progress, GError **error)
 {
 	FuPluginVfuncs *vfuncs = fu_plugin_get_vfuncs(self);
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail(FU_IS_PLUGIN(self), FALSE);
@@ -864,6 +866,7 @@ fu_plugin_runner_startup(FuPlugin *self, FuProgress *progress, GError **error)
 	/* optional */
 	if (vfuncs->startup != NULL) {
 		g_debug("startup(%s)", fu_plugin_get_name(self));
+		span = fu_trace_span_begin("plugin", "startup", fu_plugin_get_name(self));
 		if (!vfuncs->startup(self, progress, &error_local)) {
 			if (error_local == NULL) {
 				g_critical("unset plugin error in startup(%s)",
@@ -900,6 +903,7 @@ gboolean
 fu_plugin_runner_ready(FuPlugin *self, FuProgress *progress, GError **error)
 {
 	FuPluginVfuncs *vfuncs = fu_plugin_get_vfuncs(self);
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail(FU_IS_PLUGIN(self), FALSE);
@@ -914,6 +918,7 @@ fu_plugin_runner_ready(FuPlugin *self, FuProgress *progress, GError **error)
 
 	/* optional */
 	g_debug("ready(%s)", fu_plugin_get_name(self));
+	span = fu_trace_span_begin("plugin", "ready", fu_plugin_get_name(self));
 	if (!vfuncs->ready(self, progress, &error_local)) {
 		if (error_local == NULL) {
 			g_critical("unset plugin error in ready(%s)", fu_plugin_get_name(self));
@@ -972,6 +977,7 @@ fu_plugin_runner_device_generic(FuPlugin *self,
 				FuPluginDeviceFunc device_func,
 				GError **error)
 {
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -982,6 +988,7 @@ fu_plugin_runner_device_generic(FuPlugin *self,
 	if (device_func == NULL)
 		return TRUE;
 	g_debug("%s(%s)", symbol_name + 10, fu_plugin_get_name(self));
+	span = fu_trace_span_begin("plugin", symbol_name + 10, fu_plugin_get_name(self));
 	if (!device_func(self, device, &error_local)) {
 		if (error_local == NULL) {
 			g_critical("unset plugin error in %s(%s)",
@@ -1010,6 +1017,7 @@ fu_plugin_runner_device_generic_progress(FuPlugin *self,
 					 FuPluginDeviceProgressFunc device_func,
 					 GError **error)
 {
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1020,6 +1028,7 @@ fu_plugin_runner_device_generic_progress(FuPlugin *self,
 	if (device_func == NULL)
 		return TRUE;
 	g_debug("%s(%s)", symbol_name + 10, fu_plugin_get_name(self));
+	span = fu_trace_span_begin("plugin", symbol_name + 10, fu_plugin_get_name(self));
 	if (!device_func(self, device, progress, &error_local)) {
 		if (error_local == NULL) {
 			g_critical("unset plugin error in %s(%s)",
@@ -1049,6 +1058,7 @@ fu_plugin_runner_flagged_device_generic(FuPlugin *self,
 					FuPluginFlaggedDeviceFunc func,
 					GError **error)
 {
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1059,6 +1069,7 @@ fu_plugin_runner_flagged_device_generic(FuPlugin *self,
 	if (func == NULL)
 		return TRUE;
 	g_debug("%s(%s)", symbol_name + 10, fu_plugin_get_name(self));
+	span = fu_trace_span_begin("plugin", symbol_name + 10, fu_plugin_get_name(self));
 	if (!func(self, device, progress, flags, &error_local)) {
 		if (error_local == NULL) {
 			g_critical("unset plugin error in %s(%s)",
@@ -1086,6 +1097,7 @@ fu_plugin_runner_device_array_generic(FuPlugin *self,
 				      FuPluginDeviceArrayFunc func,
 				      GError **error)
 {
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	/* not enabled */
@@ -1096,6 +1108,7 @@ fu_plugin_runner_device_array_generic(FuPlugin *self,
 	if (func == NULL)
 		return TRUE;
 	g_debug("%s(%s)", symbol_name + 10, fu_plugin_get_name(self));
+	span = fu_trace_span_begin("plugin", symbol_name + 10, fu_plugin_get_name(self));
 	if (!func(self, devices, &error_local)) {
 		if (error_local == NULL) {
 			g_critical("unset plugin error in for %s(%s)",
@@ -1133,6 +1146,7 @@ fu_plugin_runner_coldplug(FuPlugin *self, FuProgress *progress, GError **error)
 {
 	FuPluginPrivate *priv = GET_PRIVATE(self);
 	FuPluginVfuncs *vfuncs = fu_plugin_get_vfuncs(self);
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail(FU_IS_PLUGIN(self), FALSE);
@@ -1152,6 +1166,7 @@ fu_plugin_runner_coldplug(FuPlugin *self, FuProgress *progress, GError **error)
 	if (vfuncs->coldplug == NULL)
 		return TRUE;
 	g_debug("coldplug(%s)", fu_plugin_get_name(self));
+	span = fu_trace_span_begin("plugin", "coldplug", fu_plugin_get_name(self));
 	if (!vfuncs->coldplug(self, progress, &error_local)) {
 		if (error_local == NULL) {
 			g_critical("unset plugin error in coldplug(%s)", fu_plugin_get_name(self));
@@ -1784,6 +1799,7 @@ fu_plugin_runner_backend_device_added(FuPlugin *self,
 {
 	FuPluginPrivate *priv = GET_PRIVATE(self);
 	FuPluginVfuncs *vfuncs = fu_plugin_get_vfuncs(self);
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail(FU_IS_PLUGIN(self), FALSE);
@@ -1794,6 +1810,7 @@ fu_plugin_runner_backend_device_added(FuPlugin *self,
 	/* not enabled */
 	if (fu_plugin_has_flag(self, FWUPD_PLUGIN_FLAG_DISABLED))
 		return TRUE;
+	span = fu_trace_span_begin("plugin", "backend_device_added", fu_plugin_get_name(self));
 
 	/* optional */
 	if (vfuncs->backend_device_added == NULL) {
@@ -2002,6 +2019,7 @@ fu_plugin_runner_verify(FuPlugin *self,
 {
 	FuPluginVfuncs *vfuncs = fu_plugin_get_vfuncs(self);
 	GPtrArray *checksums;
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail(FU_IS_PLUGIN(self), FALSE);
@@ -2012,6 +2030,7 @@ fu_plugin_runner_verify(FuPlugin *self,
 	/* not enabled */
 	if (fu_plugin_has_flag(self, FWUPD_PLUGIN_FLAG_DISABLED))
 		return TRUE;
+	span = fu_trace_span_begin("plugin", "verify", fu_plugin_get_name(self));
 
 	/* optional */
 	if (vfuncs->verify == NULL) {
@@ -2205,6 +2224,7 @@ fu_plugin_runner_write_firmware(FuPlugin *self,
 				GError **error)
 {
 	FuPluginVfuncs *vfuncs = fu_plugin_get_vfuncs(self);
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 	g_autoptr(GError) error_local = NULL;
 
 	g_return_val_if_fail(FU_IS_PLUGIN(self), FALSE);
@@ -2218,6 +2238,7 @@ fu_plugin_runner_write_firmware(FuPlugin *self,
 		g_debug("plugin not enabled, skipping");
 		return TRUE;
 	}
+	span = fu_trace_span_begin("plugin", "write_firmware", fu_plugin_get_name(self));
 
 	/* optional */
 	if (vfuncs->write_firmware != NULL) {
@@ -10,7 +10,12 @@
 
 #include <fwupdplugin.h>
 
+#include <fcntl.h>
 #include <glib/gstdio.h>
+#ifndef _WIN32
+#include <glib-unix.h>
+#include <sys/socket.h>
+#endif
 #include <string.h>
 
 #include "fwupd-enums-private.h"
@@ -18,6 +23,7 @@
 
 #include "fu-backend-private.h"
 #include "fu-bios-settings-private.h"
+#include "fu-bluez-device-private.h"
 #include "fu-cab-firmware-private.h"
 #include "fu-common-private.h"
 #include "fu-config-private.h"
@@ -37,6 +43,7 @@
 #include "fu-self-test-struct.h"
 #include "fu-smbios-private.h"
 #include "fu-test-device.h"
+#include "fu-trace-private.h"
 #include "fu-volume-private.h"
 
 static GMainLoop *_test_loop = NULL;
@@ -323,6 +330,110 @@ fu_archive_cab_func(void)
 	g_assert_null(data_tmp3);
 }
 
+static void
+fu_archive_cab_lazy_func(void)
+{
+	g_autofree gchar *checksum1 = NULL;
+	g_autofree gchar *checksum2 = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuArchive) archive = NULL;
+	g_autoptr(GBytes) data = NULL;
+	g_autoptr(GBytes) data_tmp1 = NULL;
+	g_autoptr(GBytes) data_tmp2 = NULL;
+	g_autoptr(GBytes) data_tmp3 = NULL;
+	g_autoptr(GError) error = NULL;
+
+#ifndef HAVE_LIBARCHIVE
+	g_test_skip("no libarchive support");
+	return;
+#endif
+
+	filename = g_test_build_filename(G_TEST_BUILT,
+					 "tests",
+					 "colorhug",
+					 "colorhug-als-3.0.2.cab",
+					 NULL);
+	data = fu_bytes_get_contents(filename, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(data);
+
+	archive = fu_archive_new(data, FU_ARCHIVE_FLAG_LAZY, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(archive);
+
+	/* only keep the most recently used file */
+	fu_archive_set_cache_size_max(archive, 1);
+	data_tmp1 = fu_archive_lookup_by_fn(archive, "firmware.txt", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(data_tmp1);
+	checksum1 = g_compute_checksum_for_bytes(G_CHECKSUM_SHA1, data_tmp1);
+	g_assert_cmpstr(checksum1, ==, "22596363b3de40b06f981fb85d82312e8c0ed511");
+
+	data_tmp2 = fu_archive_lookup_by_fn(archive, "firmware.metainfo.xml", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(data_tmp2);
+	g_clear_pointer(&data_tmp2, g_bytes_unref);
+
+	/* decompressed again after being evicted */
+	data_tmp2 = fu_archive_lookup_by_fn(archive, "firmware.txt", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(data_tmp2);
+	checksum2 = g_compute_checksum_for_bytes(G_CHECKSUM_SHA1, data_tmp2);
+	g_assert_cmpstr(checksum2, ==, checksum1);
+	g_assert_true(data_tmp1 != data_tmp2);
+
+	data_tmp3 = fu_archive_lookup_by_fn(archive, "NOTGOINGTOEXIST.xml", &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null(data_tmp3);
+}
+
+static void
+fu_archive_lazy_compressed_func(void)
+{
+	g_autoptr(FuArchive) archive = NULL;
+	g_autoptr(FuArchive) archive_src = fu_archive_new(NULL, FU_ARCHIVE_FLAG_NONE, NULL);
+	g_autoptr(GByteArray) buf = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob1 = g_bytes_new_static("hello", 5);
+	g_autoptr(GBytes) blob2 = g_bytes_new_static("world", 5);
+	g_autoptr(GBytes) data_tmp1 = NULL;
+	g_autoptr(GBytes) data_tmp2 = NULL;
+	g_autoptr(GBytes) data_tmp3 = NULL;
+	g_autoptr(GError) error = NULL;
+
+#ifndef HAVE_LIBARCHIVE
+	g_test_skip("no libarchive support");
+	return;
+#endif
+
+	/* a compressed tarball */
+	fu_archive_add_entry(archive_src, "hello.txt", blob1);
+	fu_archive_add_entry(archive_src, "world.txt", blob2);
+	buf = fu_archive_write(archive_src,
+			       FU_ARCHIVE_FORMAT_PAX,
+			       FU_ARCHIVE_COMPRESSION_GZIP,
+			       &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(buf);
+	blob = g_bytes_new(buf->data, buf->len);
+
+	/* the files are kept when the filenames are read, so are never evicted */
+	archive = fu_archive_new(blob, FU_ARCHIVE_FLAG_LAZY, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(archive);
+	fu_archive_set_cache_size_max(archive, 1);
+	data_tmp1 = fu_archive_lookup_by_fn(archive, "hello.txt", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(data_tmp1);
+	g_assert_cmpint(g_bytes_compare(data_tmp1, blob1), ==, 0);
+	data_tmp2 = fu_archive_lookup_by_fn(archive, "world.txt", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(data_tmp2);
+	data_tmp3 = fu_archive_lookup_by_fn(archive, "hello.txt", &error);
+	g_assert_no_error(error);
+	g_assert_true(data_tmp1 == data_tmp3);
+}
+
 static void
 fu_volume_gpt_type_func(void)
 {
@@ -3317,6 +3428,92 @@ fu_common_vercmp_func(void)
 	g_assert_cmpint(fu_version_compare(NULL, NULL, FWUPD_VERSION_FORMAT_UNKNOWN), ==, G_MAXINT);
 }
 
+static gint
+fu_common_vercmp_key_sort_cb(gconstpointer a, gconstpointer b)
+{
+	const FuVersionKey *key_a = *((const FuVersionKey **)a);
+	const FuVersionKey *key_b = *((const FuVersionKey **)b);
+	return fu_version_key_compare(key_a, key_b);
+}
+
+static gint
+fu_common_vercmp_str_sort_cb(gconstpointer a, gconstpointer b)
+{
+	const gchar *str_a = *((const gchar **)a);
+	const gchar *str_b = *((const gchar **)b);
+	return fu_version_compare(str_a, str_b, FWUPD_VERSION_FORMAT_TRIPLET);
+}
+
+static void
+fu_common_vercmp_key_func(void)
+{
+	const gchar *versions[] = {"1.2.3",
+				   "001.002.003",
+				   "1.2.4",
+				   "1.2.3.1",
+				   "1.2",
+				   "1.2.3a",
+				   "1.2.3b",
+				   "1.2a.3",
+				   "1.2.3~rc1",
+				   "1.2.3~rc2",
+				   "alpha",
+				   "beta",
+				   "0x00000002",
+				   "0x2",
+				   "4294967296.1",
+				   "1..2",
+				   "",
+				   NULL};
+	FwupdVersionFormat fmts[] = {FWUPD_VERSION_FORMAT_UNKNOWN,
+				     FWUPD_VERSION_FORMAT_PLAIN,
+				     FWUPD_VERSION_FORMAT_TRIPLET,
+				     FWUPD_VERSION_FORMAT_HEX};
+	guint n_versions = G_N_ELEMENTS(versions);
+	g_autoptr(GPtrArray) keys = NULL;
+	g_autoptr(GPtrArray) strs = g_ptr_array_new_with_free_func(g_free);
+
+	/* same result as the string compare */
+	for (guint f = 0; f < G_N_ELEMENTS(fmts); f++) {
+		for (guint i = 0; i < n_versions; i++) {
+			g_autoptr(FuVersionKey) key_a = fu_version_key_new(versions[i], fmts[f]);
+			for (guint j = 0; j < n_versions; j++) {
+				g_autoptr(FuVersionKey) key_b =
+				    fu_version_key_new(versions[j], fmts[f]);
+				gint rc = fu_version_compare(versions[i], versions[j], fmts[f]);
+				gint rc_key = fu_version_key_compare(key_a, key_b);
+				if (rc != G_MAXINT) {
+					rc = CLAMP(rc, -1, 1);
+					rc_key = CLAMP(rc_key, -1, 1);
+				}
+				g_assert_cmpint(rc_key, ==, rc);
+			}
+		}
+	}
+
+	/* sort a release history */
+	keys = g_ptr_array_new_with_free_func((GDestroyNotify)fu_version_key_free);
+	for (guint i = 0; i < 1000; i++) {
+		g_autofree gchar *str = g_strdup_printf("%u.%u.%u",
+							(guint)g_test_rand_int_range(0, 10),
+							(guint)g_test_rand_int_range(0, 100),
+							(guint)g_test_rand_int_range(0, 1000));
+		g_ptr_array_add(keys, fu_version_key_new(str, FWUPD_VERSION_FORMAT_TRIPLET));
+		g_ptr_array_add(strs, g_steal_pointer(&str));
+	}
+	g_ptr_array_sort(strs, fu_common_vercmp_str_sort_cb);
+	g_ptr_array_sort(keys, fu_common_vercmp_key_sort_cb);
+	for (guint i = 0; i < keys->len; i++) {
+		FuVersionKey *key = g_ptr_array_index(keys, i);
+		const gchar *str = g_ptr_array_index(strs, i);
+		g_assert_cmpint(fu_version_compare(fu_version_key_get_version(key),
+						   str,
+						   FWUPD_VERSION_FORMAT_TRIPLET),
+				==,
+				0);
+	}
+}
+
 static void
 fu_firmware_raw_aligned_func(void)
 {
@@ -3765,6 +3962,8 @@ fu_firmware_new_from_gtypes_func(void)
 	g_autoptr(FuFirmware) firmware1 = NULL;
 	g_autoptr(FuFirmware) firmware2 = NULL;
 	g_autoptr(FuFirmware) firmware3 = NULL;
+	g_autoptr(FuFirmware) firmware4 = NULL;
+	g_autoptr(FuFirmware) firmware_fdt = fu_fdt_firmware_new();
 	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(GInputStream) stream = NULL;
 	g_autoptr(GError) error = NULL;
@@ -3814,6 +4013,28 @@ fu_firmware_new_from_gtypes_func(void)
 						G_TYPE_INVALID);
 	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_FILE);
 	g_assert_null(firmware3);
+	g_clear_error(&error);
+
+	/* dfu -> FuDfuFirmware, skipping FuFdtFirmware without parsing */
+	ret = fu_firmware_sniff(firmware_fdt,
+				g_bytes_get_data(fw, NULL),
+				g_bytes_get_size(fw),
+				g_bytes_get_size(fw),
+				FWUPD_INSTALL_FLAG_NO_SEARCH,
+				&error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_READ);
+	g_assert_false(ret);
+	g_clear_error(&error);
+	firmware4 = fu_firmware_new_from_gtypes(stream,
+						0x0,
+						FWUPD_INSTALL_FLAG_NONE,
+						&error,
+						FU_TYPE_FDT_FIRMWARE,
+						FU_TYPE_DFU_FIRMWARE,
+						G_TYPE_INVALID);
+	g_assert_no_error(error);
+	g_assert_nonnull(firmware4);
+	g_assert_cmpstr(G_OBJECT_TYPE_NAME(firmware4), ==, "FuDfuFirmware");
 }
 
 static void
@@ -4363,6 +4584,76 @@ fu_firmware_dedupe_func(void)
 	g_assert_false(ret);
 }
 
+static void
+fu_firmware_index_func(void)
+{
+	gboolean ret;
+	g_autofree gchar *checksum = NULL;
+	g_autoptr(FuFirmware) firmware_idx = fu_firmware_new();
+	g_autoptr(FuFirmware) firmware_scan = fu_firmware_new();
+	g_autoptr(FuFirmware) img_id = NULL;
+	g_autoptr(FuFirmware) img_csum = NULL;
+	g_autoptr(FuFirmware) img_glob = NULL;
+	g_autoptr(FuFirmware) img_scan = NULL;
+	g_autoptr(GBytes) blob = g_bytes_new_static("changed", 7);
+	g_autoptr(GError) error = NULL;
+
+	/* add the same images to both */
+	fu_firmware_add_flag(firmware_idx, FU_FIRMWARE_FLAG_INDEX_IMAGES);
+	for (guint i = 0; i < 50; i++) {
+		g_autofree gchar *id = g_strdup_printf("img%04u", i);
+		g_autoptr(FuFirmware) img1 = fu_firmware_new();
+		g_autoptr(FuFirmware) img2 = fu_firmware_new();
+		g_autoptr(GBytes) data = g_bytes_new(id, strlen(id));
+		fu_firmware_set_id(img1, id);
+		fu_firmware_set_bytes(img1, data);
+		fu_firmware_add_image(firmware_idx, img1);
+		fu_firmware_set_id(img2, id);
+		fu_firmware_set_bytes(img2, data);
+		fu_firmware_add_image(firmware_scan, img2);
+	}
+	checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA256, "img0049", -1);
+
+	/* the index finds the same image as the linear scan */
+	img_scan = fu_firmware_get_image_by_checksum(firmware_scan, checksum, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img_scan);
+	img_csum = fu_firmware_get_image_by_checksum(firmware_idx, checksum, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img_csum);
+	g_assert_cmpstr(fu_firmware_get_id(img_csum), ==, fu_firmware_get_id(img_scan));
+	g_clear_object(&img_csum);
+
+	/* exact and glob ID */
+	img_id = fu_firmware_get_image_by_id(firmware_idx, "img0049", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img_id);
+	img_glob = fu_firmware_get_image_by_id(firmware_idx, "img004*", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img_glob);
+	g_assert_cmpstr(fu_firmware_get_id(img_glob), ==, "img0040");
+
+	/* changing the child invalidates the parent index */
+	fu_firmware_set_id(img_id, "renamed");
+	img_csum = fu_firmware_get_image_by_id(firmware_idx, "renamed", &error);
+	g_assert_no_error(error);
+	g_assert_true(img_csum == img_id);
+	g_clear_object(&img_csum);
+	fu_firmware_set_bytes(img_id, blob);
+	img_csum = fu_firmware_get_image_by_checksum(firmware_idx, checksum, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null(img_csum);
+	g_clear_error(&error);
+
+	/* removing the image invalidates the index */
+	ret = fu_firmware_remove_image(firmware_idx, img_id, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	img_csum = fu_firmware_get_image_by_id(firmware_idx, "renamed", &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
+	g_assert_null(img_csum);
+}
+
 static void
 fu_efivar_func(void)
 {
@@ -4477,6 +4768,8 @@ fu_efivar_boot_func(void)
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GPtrArray) entries = NULL;
 	g_autoptr(GPtrArray) esp_files = NULL;
+	g_autoptr(GPtrArray) esp_files2 = NULL;
+	g_autoptr(GPtrArray) esp_files3 = NULL;
 	FuEfivars *efivars = fu_context_get_efivars(ctx);
 
 	/* set and get BootCurrent */
@@ -4550,6 +4843,35 @@ fu_efivar_boot_func(void)
 	g_assert_cmpint(esp_files->len, ==, 2);
 	firmware_tmp = g_ptr_array_index(esp_files, 0);
 	g_assert_cmpstr(fu_firmware_get_filename(firmware_tmp), ==, pefile_fn);
+
+	/* unchanged files are not parsed again */
+	esp_files2 =
+	    fu_context_get_esp_files(ctx, FU_CONTEXT_ESP_FILE_FLAG_INCLUDE_FIRST_STAGE, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(esp_files2);
+	g_assert_cmpint(esp_files2->len, ==, 2);
+	g_assert_true(g_ptr_array_index(esp_files2, 0) == firmware_tmp);
+
+	/* a file used by two entries is returned once, without changing earlier results */
+	ret = fu_efivars_create_boot_entry_for_volume(efivars,
+						      0x0003,
+						      volume,
+						      "Fedora Again",
+						      "grubx64.efi",
+						      &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_efivars_build_boot_order(efivars, &error, 0x0003, 0x0001, 0x0002, G_MAXUINT16);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	esp_files3 =
+	    fu_context_get_esp_files(ctx, FU_CONTEXT_ESP_FILE_FLAG_INCLUDE_FIRST_STAGE, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(esp_files3);
+	g_assert_cmpint(esp_files3->len, ==, 2);
+	g_assert_cmpstr(fu_firmware_get_filename(g_ptr_array_index(esp_files3, 0)), ==, pefile_fn);
+	g_assert_cmpint(fu_firmware_get_idx(g_ptr_array_index(esp_files3, 0)), ==, 0x0003);
+	g_assert_cmpint(fu_firmware_get_idx(firmware_tmp), ==, 0x0001);
 }
 
 typedef struct {
@@ -4646,6 +4968,258 @@ fu_device_retry_hardware_func(void)
 	g_assert_cmpint(helper.cnt_failed, ==, 2);
 }
 
+static void
+fu_device_retry_adaptive_func(void)
+{
+	gboolean ret;
+	g_autoptr(FuDevice) device = fu_device_new(NULL);
+	g_autoptr(GError) error = NULL;
+	FuDeviceRetryHelper helper = {
+	    .cnt_success = 0,
+	    .cnt_failed = 0,
+	};
+
+	/* starts at 80/8 ms and doubles */
+	fu_device_add_private_flag(device, FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE);
+	ret = fu_device_retry_full(device,
+				   fu_device_retry_success_3rd_try,
+				   3,
+				   80,
+				   &helper,
+				   &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(helper.cnt_failed, ==, 2);
+	g_assert_cmpint(fu_device_get_retry_count(device), ==, 2);
+	g_assert_cmpint(fu_device_get_sleep_count(device), ==, 2);
+	g_assert_cmpint(fu_device_get_sleep_duration(device), ==, 10 + 20);
+	g_assert_cmpint(fu_device_get_retry_latency(device), ==, 30);
+
+	/* starts at the learned latency */
+	helper.cnt_failed = 0;
+	ret = fu_device_retry_full(device,
+				   fu_device_retry_success_3rd_try,
+				   3,
+				   80,
+				   &helper,
+				   &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(fu_device_get_sleep_duration(device), ==, 30 + 30 + 60);
+	g_assert_cmpint(fu_device_get_retry_latency(device), ==, (30 * 3 + 90) / 4);
+
+	/* gives up after the same total delay as the non-adaptive mode */
+	helper.cnt_failed = 0;
+	fu_device_set_retry_latency(device, 0);
+	ret = fu_device_retry_full(device, fu_device_retry_failed, 3, 80, &helper, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL);
+	g_assert_false(ret);
+	g_assert_cmpint(helper.cnt_failed, ==, 6);
+}
+
+static void
+fu_device_setup_cache_func(void)
+{
+	const gchar *cache_id;
+	g_autoptr(FuContext) ctx = fu_context_new();
+	g_autoptr(FuDevice) device1 = fu_device_new(ctx);
+	g_autoptr(FuDevice) device2 = fu_device_new(ctx);
+	g_autoptr(FuDevice) device3 = fu_device_new(ctx);
+
+	/* not opted in */
+	fu_device_set_physical_id(device1, "usb:01:00");
+	fu_device_set_setup_cache_value(device1, "BoardId", "1234");
+	g_assert_null(fu_device_get_setup_cache(device1));
+	g_assert_null(fu_device_get_setup_cache_value(device1, "BoardId"));
+
+	/* first setup is a cache miss */
+	fu_device_add_private_flag(device1, FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP);
+	fu_device_add_setup_cache_identity(device1, "HwRev", "2");
+	g_assert_null(fu_device_get_setup_cache_value(device1, "BoardId"));
+	fu_device_set_setup_cache_value(device1, "BoardId", "1234");
+	g_assert_cmpstr(fu_device_get_setup_cache_value(device1, "BoardId"), ==, "1234");
+	cache_id = fu_device_get_setup_cache_id(device1);
+	g_assert_nonnull(cache_id);
+	g_assert_nonnull(fu_device_get_setup_cache(device1));
+
+	/* the engine would save this to the history database */
+	fu_context_add_setup_cache(ctx, cache_id, fu_device_get_setup_cache(device1));
+
+	/* same hardware is a cache hit */
+	fu_device_set_physical_id(device2, "usb:01:00");
+	fu_device_add_private_flag(device2, FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP);
+	fu_device_add_setup_cache_identity(device2, "HwRev", "2");
+	g_assert_cmpstr(fu_device_get_setup_cache_value(device2, "BoardId"), ==, "1234");
+	g_assert_cmpstr(fu_device_get_setup_cache_id(device2), ==, cache_id);
+	g_assert_null(fu_device_get_setup_cache(device2));
+
+	/* different hardware revision */
+	fu_device_set_physical_id(device3, "usb:01:00");
+	fu_device_add_private_flag(device3, FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP);
+	fu_device_add_setup_cache_identity(device3, "HwRev", "3");
+	g_assert_null(fu_device_get_setup_cache_value(device3, "BoardId"));
+
+	/* firmware was written */
+	fu_device_invalidate_setup_cache(device1);
+	g_assert_null(fu_device_get_setup_cache(device1));
+	g_assert_null(fu_context_get_setup_cache(ctx, cache_id));
+	g_assert_null(fu_device_get_setup_cache_value(device1, "BoardId"));
+}
+
+static void
+fu_trace_func(void)
+{
+	gboolean ret;
+	g_autofree gchar *data = NULL;
+	g_autofree gchar *fn = g_build_filename("/tmp", "fwupd-self-test", "trace.json", NULL);
+	g_autoptr(GError) error = NULL;
+
+	/* span before recording is started is not saved */
+	{
+		g_auto(FuTraceSpan) span = fu_trace_span_begin("test", "ignored", NULL);
+	}
+
+	fu_trace_start();
+	g_assert_true(fu_trace_is_recording());
+	{
+		g_auto(FuTraceSpan) span = fu_trace_span_begin("test", "outer", "detail");
+		g_auto(FuTraceSpan) span_early = fu_trace_span_begin("test", "inner", NULL);
+		fu_trace_span_end(&span_early);
+	}
+
+	/* Chrome trace event format */
+	ret = fu_trace_save(fn, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = g_file_get_contents(fn, &data, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_nonnull(g_strstr_len(data, -1, "\"traceEvents\""));
+	g_assert_nonnull(g_strstr_len(data, -1, "\"outer\""));
+	g_assert_nonnull(g_strstr_len(data, -1, "\"inner\""));
+	g_assert_nonnull(g_strstr_len(data, -1, "\"detail\""));
+	g_assert_null(g_strstr_len(data, -1, "\"ignored\""));
+
+	/* a span that ends after recording is stopped is discarded */
+	{
+		g_auto(FuTraceSpan) span = fu_trace_span_begin("test", "stopped", NULL);
+		fu_trace_stop();
+	}
+	g_assert_false(fu_trace_is_recording());
+	ret = fu_trace_save(fn, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO);
+	g_assert_false(ret);
+}
+
+static void
+fu_io_channel_wait_func(void)
+{
+#ifndef _WIN32
+	gboolean ret;
+	gint fds[2] = {-1, -1};
+	guint8 buf[1] = {0x0};
+	g_autoptr(FuIOChannel) io_read = NULL;
+	g_autoptr(FuIOChannel) io_write = NULL;
+	g_autoptr(GError) error = NULL;
+
+	ret = g_unix_open_pipe(fds, FD_CLOEXEC, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	io_read = fu_io_channel_unix_new(fds[0]);
+	io_write = fu_io_channel_unix_new(fds[1]);
+
+	/* nothing to read yet */
+	ret = fu_io_channel_wait(io_read, G_IO_IN, 10, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_TIMED_OUT);
+	g_assert_false(ret);
+	g_clear_error(&error);
+
+	/* ready as soon as the other end writes */
+	ret = fu_io_channel_write_raw(io_write,
+				      (const guint8 *)"x",
+				      1,
+				      100,
+				      FU_IO_CHANNEL_FLAG_NONE,
+				      &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_io_channel_wait(io_read, G_IO_IN, 1000, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* the other end has gone away */
+	ret = fu_io_channel_read_raw(io_read,
+				     buf,
+				     sizeof(buf),
+				     NULL,
+				     100,
+				     FU_IO_CHANNEL_FLAG_SINGLE_SHOT,
+				     &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_io_channel_shutdown(io_write, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_io_channel_wait(io_read, G_IO_IN, 1000, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_READ);
+	g_assert_false(ret);
+#else
+	g_test_skip("pipes not supported on Windows");
+#endif
+}
+
+static void
+fu_bluez_device_write_chunks_func(void)
+{
+#ifndef _WIN32
+	gboolean ret;
+	gint fds[2] = {-1, -1};
+	g_autoptr(FuChunkArray) chunks = NULL;
+	g_autoptr(FuIOChannel) io_bluez = NULL;
+	g_autoptr(FuIOChannel) io_device = NULL;
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GBytes) blob = g_bytes_new_static("hello world!", 12);
+	g_autoptr(GError) error = NULL;
+
+	/* stand-in for the socket returned by AcquireWrite */
+	g_assert_cmpint(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds), ==, 0);
+	io_bluez = fu_io_channel_unix_new(fds[0]);
+	io_device = fu_io_channel_unix_new(fds[1]);
+
+	/* each chunk arrives as one packet */
+	chunks = fu_chunk_array_new_from_bytes(blob, 0x0, 0x0, 5);
+	ret = fu_bluez_device_write_chunks_io(io_bluez, 8, chunks, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
+		gsize bufsz = 0;
+		guint8 buf[0x20] = {0x0};
+		g_autoptr(FuChunk) chk = fu_chunk_array_index(chunks, i, &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(chk);
+		ret = fu_io_channel_read_raw(io_device,
+					     buf,
+					     sizeof(buf),
+					     &bufsz,
+					     100,
+					     FU_IO_CHANNEL_FLAG_SINGLE_SHOT,
+					     &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+		g_assert_cmpint(bufsz, ==, fu_chunk_get_data_sz(chk));
+		g_assert_cmpint(memcmp(buf, fu_chunk_get_data(chk), bufsz), ==, 0);
+	}
+
+	/* too large for the MTU once the ATT header is added */
+	fu_progress_reset(progress);
+	ret = fu_bluez_device_write_chunks_io(io_bluez, 7, chunks, progress, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA);
+	g_assert_false(ret);
+#else
+	g_test_skip("sockets not supported on Windows");
+#endif
+}
+
 static void
 fu_bios_settings_load_func(void)
 {
@@ -6184,6 +6758,132 @@ fu_cab_checksum_func(void)
 	}
 }
 
+static void
+fu_cab_firmware_mszip_func(void)
+{
+	gboolean ret;
+	gsize offset_ck = 0;
+	gsize streamsz = 0;
+	g_autofree gchar *csum1 = NULL;
+	g_autofree gchar *csum2 = NULL;
+	g_autoptr(FuCabFirmware) cab1 = fu_cab_firmware_new();
+	g_autoptr(FuCabImage) img1 = fu_cab_image_new();
+	g_autoptr(FuFirmware) cab2 = fu_cab_firmware_new();
+	g_autoptr(FuFirmware) cab3 = fu_cab_firmware_new();
+	g_autoptr(FuFirmware) img2 = NULL;
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_autoptr(GByteArray) buf_corrupt = NULL;
+	g_autoptr(GBytes) blob1 = NULL;
+	g_autoptr(GBytes) blob2 = NULL;
+	g_autoptr(GBytes) blob3 = NULL;
+	g_autoptr(GBytes) blob4 = NULL;
+	g_autoptr(GBytes) blob5 = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+
+	/* several CFDATA blocks, each using the previous as the dictionary */
+	for (guint i = 0; i < 0x28000; i++)
+		fu_byte_array_append_uint8(buf, (guint8)((i * 7) ^ (i >> 9)));
+	blob1 = g_bytes_new(buf->data, buf->len);
+	fu_firmware_set_id(FU_FIRMWARE(img1), "firmware.bin");
+	fu_firmware_set_bytes(FU_FIRMWARE(img1), blob1);
+	ret = fu_firmware_add_image_full(FU_FIRMWARE(cab1), FU_FIRMWARE(img1), &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_cab_firmware_set_compressed(cab1, TRUE);
+	blob2 = fu_firmware_write(FU_FIRMWARE(cab1), &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob2);
+	g_assert_cmpint(g_bytes_get_size(blob2), <, g_bytes_get_size(blob1));
+
+	/* parse, which only decodes the deflate block headers */
+	ret = fu_firmware_parse_bytes(cab2, blob2, 0x0, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	img2 = fu_firmware_get_image_by_id(cab2, "firmware.bin", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(img2);
+	stream = fu_firmware_get_stream(img2, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream);
+	ret = fu_input_stream_size(stream, &streamsz, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(streamsz, ==, g_bytes_get_size(blob1));
+
+	/* read the last block first, then seek backwards over a block boundary */
+	blob3 = fu_input_stream_read_bytes(stream, 0x27f00, 0x100, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob3);
+	g_assert_cmpint(memcmp(g_bytes_get_data(blob3, NULL), buf->data + 0x27f00, 0x100), ==, 0);
+	blob4 = fu_input_stream_read_bytes(stream, 0x7f80, 0x100, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob4);
+	g_assert_cmpint(memcmp(g_bytes_get_data(blob4, NULL), buf->data + 0x7f80, 0x100), ==, 0);
+
+	/* and everything */
+	csum1 = g_compute_checksum_for_bytes(G_CHECKSUM_SHA1, blob1);
+	csum2 = fu_input_stream_compute_checksum(stream, G_CHECKSUM_SHA1, &error);
+	g_assert_no_error(error);
+	g_assert_cmpstr(csum2, ==, csum1);
+
+	/* an invalid deflate block type is rejected when parsing */
+	buf_corrupt = g_byte_array_new();
+	g_byte_array_append(buf_corrupt, g_bytes_get_data(blob2, NULL), g_bytes_get_size(blob2));
+	ret = fu_memmem_safe(buf_corrupt->data,
+			     buf_corrupt->len,
+			     (const guint8 *)"CK",
+			     2,
+			     &offset_ck,
+			     &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	buf_corrupt->data[offset_ck + 2] |= 0x06;
+	blob5 = g_bytes_new(buf_corrupt->data, buf_corrupt->len);
+	ret = fu_firmware_parse_bytes(cab3, blob5, 0x0, FWUPD_INSTALL_FLAG_IGNORE_CHECKSUM, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED);
+	g_assert_false(ret);
+}
+
+static void
+fu_cab_firmware_write_parallel_func(void)
+{
+	gboolean ret;
+	gsize bufsz = 1024 * 1024;
+	g_autoptr(FuCabFirmware) cab = fu_cab_firmware_new();
+	g_autoptr(FuCabImage) img = fu_cab_image_new();
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) blob_serial = NULL;
+	g_autoptr(GBytes) blob_parallel = NULL;
+	g_autoptr(GError) error = NULL;
+
+	/* something that compresses, but not to nothing */
+	fu_byte_array_set_size(buf, bufsz, 0x0);
+	for (gsize i = 0; i < bufsz; i++)
+		buf->data[i] = (guint8)((i * 31) ^ (i >> 11) ^ (i >> 19));
+	blob = g_bytes_new(buf->data, buf->len);
+	fu_firmware_set_id(FU_FIRMWARE(img), "firmware.bin");
+	fu_firmware_set_bytes(FU_FIRMWARE(img), blob);
+	ret = fu_firmware_add_image_full(FU_FIRMWARE(cab), FU_FIRMWARE(img), &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_cab_firmware_set_compressed(cab, TRUE);
+
+	/* one thread */
+	fu_cab_firmware_set_max_threads(cab, 1);
+	blob_serial = fu_firmware_write(FU_FIRMWARE(cab), &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob_serial);
+
+	/* one thread per CPU, which has to be byte-identical */
+	fu_cab_firmware_set_max_threads(cab, 0);
+	blob_parallel = fu_firmware_write(FU_FIRMWARE(cab), &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(blob_parallel);
+	g_assert_cmpint(g_bytes_compare(blob_serial, blob_parallel), ==, 0);
+}
+
 static void
 fu_efi_lz77_decompressor_func(void)
 {
@@ -6583,6 +7283,8 @@ main(int argc, char **argv)
 	(void)g_setenv("CACHE_DIRECTORY", "/tmp/fwupd-self-test/cache", TRUE);
 
 	g_test_add_func("/fwupd/cab{checksum}", fu_cab_checksum_func);
+	g_test_add_func("/fwupd/cab{mszip}", fu_cab_firmware_mszip_func);
+	g_test_add_func("/fwupd/cab{write-parallel}", fu_cab_firmware_write_parallel_func);
 	g_test_add_func("/fwupd/efi-lz77{decompressor}", fu_efi_lz77_decompressor_func);
 	g_test_add_func("/fwupd/input-stream", fu_input_stream_func);
 	g_test_add_func("/fwupd/input-stream{sum-overflow}", fu_input_stream_sum_overflow_func);
@@ -6649,6 +7351,7 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/common{version}", fu_common_version_func);
 	g_test_add_func("/fwupd/common{version-semver}", fu_version_semver_func);
 	g_test_add_func("/fwupd/common{vercmp}", fu_common_vercmp_func);
+	g_test_add_func("/fwupd/common{vercmp-key}", fu_common_vercmp_key_func);
 	g_test_add_func("/fwupd/common{strstrip}", fu_strstrip_func);
 	g_test_add_func("/fwupd/common{endian}", fu_common_endian_func);
 	g_test_add_func("/fwupd/common{bytes-get-data}", fu_common_bytes_get_data_func);
@@ -6684,6 +7387,7 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/firmware{archive}", fu_firmware_archive_func);
 	g_test_add_func("/fwupd/firmware{linear}", fu_firmware_linear_func);
 	g_test_add_func("/fwupd/firmware{dedupe}", fu_firmware_dedupe_func);
+	g_test_add_func("/fwupd/firmware{index}", fu_firmware_index_func);
 	g_test_add_func("/fwupd/firmware{build}", fu_firmware_build_func);
 	g_test_add_func("/fwupd/firmware{raw-aligned}", fu_firmware_raw_aligned_func);
 	g_test_add_func("/fwupd/firmware{ihex}", fu_firmware_ihex_func);
@@ -6704,6 +7408,8 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/firmware{gtypes}", fu_firmware_new_from_gtypes_func);
 	g_test_add_func("/fwupd/archive{invalid}", fu_archive_invalid_func);
 	g_test_add_func("/fwupd/archive{cab}", fu_archive_cab_func);
+	g_test_add_func("/fwupd/archive{cab-lazy}", fu_archive_cab_lazy_func);
+	g_test_add_func("/fwupd/archive{lazy-compressed}", fu_archive_lazy_compressed_func);
 	g_test_add_func("/fwupd/device", fu_device_func);
 	g_test_add_func("/fwupd/device{event}", fu_device_event_func);
 	g_test_add_func("/fwupd/device{event-donor}", fu_device_event_donor_func);
@@ -6733,6 +7439,11 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/device{retry-success}", fu_device_retry_success_func);
 	g_test_add_func("/fwupd/device{retry-failed}", fu_device_retry_failed_func);
 	g_test_add_func("/fwupd/device{retry-hardware}", fu_device_retry_hardware_func);
+	g_test_add_func("/fwupd/device{retry-adaptive}", fu_device_retry_adaptive_func);
+	g_test_add_func("/fwupd/device{setup-cache}", fu_device_setup_cache_func);
+	g_test_add_func("/fwupd/trace", fu_trace_func);
+	g_test_add_func("/fwupd/io-channel{wait}", fu_io_channel_wait_func);
+	g_test_add_func("/fwupd/bluez-device{write-chunks}", fu_bluez_device_write_chunks_func);
 	g_test_add_func("/fwupd/device{cfi-device}", fu_device_cfi_device_func);
 	g_test_add_func("/fwupd/device{progress}", fu_plugin_device_progress_func);
 	return g_test_run();
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+/**
+ * FuTraceSpan:
+ * @category: a static string, e.g. `udev`
+ * @name: a static string, e.g. `pread`
+ * @detail: (nullable): a string that must outlive the span, e.g. a device ID
+ * @begin_usec: the monotonic start time, or 0 if not recording
+ *
+ * A span of time, normally declared using `g_auto(FuTraceSpan)` so that it ends automatically.
+ * Use FU_TRACE_SPAN_INIT() when the span has to be declared before it begins.
+ **/
+typedef struct {
+	const gchar *category;
+	const gchar *name;
+	const gchar *detail;
+	gint64 begin_usec;
+} FuTraceSpan;
+
+#define FU_TRACE_SPAN_INIT() {.category = NULL}
+
+FuTraceSpan
+fu_trace_span_begin(const gchar *category, const gchar *name, const gchar *detail)
+    G_GNUC_NON_NULL(1, 2);
+void
+fu_trace_span_end(FuTraceSpan *span) G_GNUC_NON_NULL(1);
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(FuTraceSpan, fu_trace_span_end)
+
+void
+fu_trace_start(void);
+void
+fu_trace_stop(void);
+gboolean
+fu_trace_is_recording(void);
+gboolean
+fu_trace_save(const gchar *filename, GError **error) G_GNUC_NON_NULL(1);
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuTrace"
+
+#include "config.h"
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#endif
+
+#include "fwupd-codec.h"
+#include "fwupd-error.h"
+
+#include "fu-bytes.h"
+#include "fu-trace-private.h"
+
+/* about 100MB of JSON, which is more than enough for a single update */
+#define FU_TRACE_EVENTS_MAX 1000000
+
+typedef struct {
+	const gchar *category; /* static */
+	const gchar *name;     /* static */
+	gchar *detail;
+	gint64 ts;  /* µs since the recording started */
+	gint64 dur; /* µs */
+	guint tid;
+} FuTraceEvent;
+
+static GMutex fu_trace_mutex;
+static GPtrArray *fu_trace_events = NULL; /* (mutex fu_trace_mutex) of FuTraceEvent */
+static guint fu_trace_events_dropped = 0; /* (mutex fu_trace_mutex) */
+static gint64 fu_trace_epoch_usec = 0;
+static gint fu_trace_recording = 0; /* atomic */
+static gint fu_trace_tid_last = 0;  /* atomic */
+static GPrivate fu_trace_tid;
+
+static void
+fu_trace_event_free(FuTraceEvent *event)
+{
+	g_free(event->detail);
+	g_free(event);
+}
+
+/* small, stable thread IDs are easier to read than pointers in the trace viewer */
+static guint
+fu_trace_get_tid(void)
+{
+	guint tid = GPOINTER_TO_UINT(g_private_get(&fu_trace_tid));
+	if (tid == 0) {
+		tid = (guint)g_atomic_int_add(&fu_trace_tid_last, 1) + 1;
+		g_private_set(&fu_trace_tid, GUINT_TO_POINTER(tid));
+	}
+	return tid;
+}
+
+/**
+ * fu_trace_start:
+ *
+ * Starts recording spans in memory so that they can be written with fu_trace_save().
+ *
+ * The static probes are always available when built with `<sys/sdt.h>`, even when not recording.
+ **/
+void
+fu_trace_start(void)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&fu_trace_mutex);
+	if (fu_trace_events != NULL)
+		return;
+	fu_trace_events = g_ptr_array_new_with_free_func((GDestroyNotify)fu_trace_event_free);
+	fu_trace_epoch_usec = g_get_monotonic_time();
+	g_atomic_int_set(&fu_trace_recording, TRUE);
+}
+
+/**
+ * fu_trace_stop:
+ *
+ * Stops recording spans and discards any that have been recorded, so that fu_trace_start() can
+ * be used again.
+ **/
+void
+fu_trace_stop(void)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&fu_trace_mutex);
+	g_atomic_int_set(&fu_trace_recording, FALSE);
+	g_clear_pointer(&fu_trace_events, g_ptr_array_unref);
+	fu_trace_events_dropped = 0;
+	fu_trace_epoch_usec = 0;
+}
+
+/**
+ * fu_trace_is_recording:
+ *
+ * Gets if spans are being recorded.
+ *
+ * Returns: %TRUE if fu_trace_start() has been called
+ **/
+gboolean
+fu_trace_is_recording(void)
+{
+	return g_atomic_int_get(&fu_trace_recording);
+}
+
+/**
+ * fu_trace_span_begin:
+ * @category: a static string, e.g. `udev`
+ * @name: a static string, e.g. `pread`
+ * @detail: (nullable): a string that must outlive the span, e.g. a device ID
+ *
+ * Begins a span, firing the `fwupd:span_begin` static probe.
+ *
+ * Returns: a #FuTraceSpan, which must be ended with fu_trace_span_end()
+ **/
+FuTraceSpan
+fu_trace_span_begin(const gchar *category, const gchar *name, const gchar *detail)
+{
+	FuTraceSpan span = {
+	    .category = category,
+	    .name = name,
+	    .detail = detail,
+	    .begin_usec = 0,
+	};
+#ifdef HAVE_SYS_SDT_H
+	DTRACE_PROBE3(fwupd, span_begin, category, name, detail);
+#endif
+	if (fu_trace_is_recording())
+		span.begin_usec = g_get_monotonic_time();
+	return span;
+}
+
+/**
+ * fu_trace_span_end:
+ * @span: a #FuTraceSpan
+ *
+ * Ends a span, firing the `fwupd:span_end` static probe. Ending a span more than once is allowed.
+ **/
+void
+fu_trace_span_end(FuTraceSpan *span)
+{
+	FuTraceEvent *event;
+	gint64 end_usec;
+	g_autoptr(GMutexLocker) locker = NULL;
+
+	/* already ended */
+	if (span->category == NULL)
+		return;
+#ifdef HAVE_SYS_SDT_H
+	DTRACE_PROBE3(fwupd, span_end, span->category, span->name, span->detail);
+#endif
+
+	/* recording was not enabled when the span began */
+	if (span->begin_usec == 0) {
+		span->category = NULL;
+		return;
+	}
+	end_usec = g_get_monotonic_time();
+
+	locker = g_mutex_locker_new(&fu_trace_mutex);
+	if (fu_trace_events == NULL) {
+		span->category = NULL;
+		return;
+	}
+	if (fu_trace_events->len >= FU_TRACE_EVENTS_MAX) {
+		fu_trace_events_dropped++;
+		span->category = NULL;
+		return;
+	}
+	event = g_new0(FuTraceEvent, 1);
+	event->category = span->category;
+	event->name = span->name;
+	event->detail = g_strdup(span->detail);
+	event->ts = span->begin_usec - fu_trace_epoch_usec;
+	event->dur = end_usec - span->begin_usec;
+	event->tid = fu_trace_get_tid();
+	g_ptr_array_add(fu_trace_events, event);
+	span->category = NULL;
+}
+
+/**
+ * fu_trace_save:
+ * @filename: a filename
+ * @error: (nullable): optional return location for an error
+ *
+ * Writes all the recorded spans in the Chrome trace event JSON format, which can be loaded
+ * into Perfetto or `chrome://tracing`.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_trace_save(const gchar *filename, GError **error)
+{
+	gsize datasz;
+	g_autofree gchar *data = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new();
+	g_autoptr(JsonGenerator) json_generator = json_generator_new();
+	g_autoptr(JsonNode) json_root = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&fu_trace_mutex);
+
+	g_return_val_if_fail(filename != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (fu_trace_events == NULL) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOTHING_TO_DO,
+				    "tracing was not started");
+		return FALSE;
+	}
+
+	json_builder_begin_object(builder);
+	fwupd_codec_json_append(builder, "displayTimeUnit", "ms");
+	json_builder_set_member_name(builder, "otherData");
+	json_builder_begin_object(builder);
+	fwupd_codec_json_append(builder, "version", PACKAGE_VERSION);
+	fwupd_codec_json_append_int(builder, "droppedEvents", fu_trace_events_dropped);
+	json_builder_end_object(builder);
+	json_builder_set_member_name(builder, "traceEvents");
+	json_builder_begin_array(builder);
+
+	/* so the viewer shows the binary name rather than a PID */
+	json_builder_begin_object(builder);
+	fwupd_codec_json_append(builder, "name", "process_name");
+	fwupd_codec_json_append(builder, "ph", "M");
+	fwupd_codec_json_append_int(builder, "pid", 1);
+	json_builder_set_member_name(builder, "args");
+	json_builder_begin_object(builder);
+	fwupd_codec_json_append(builder, "name", g_get_prgname());
+	json_builder_end_object(builder);
+	json_builder_end_object(builder);
+
+	/* complete events have both the start time and duration */
+	for (guint i = 0; i < fu_trace_events->len; i++) {
+		FuTraceEvent *event = g_ptr_array_index(fu_trace_events, i);
+		json_builder_begin_object(builder);
+		fwupd_codec_json_append(builder, "name", event->name);
+		fwupd_codec_json_append(builder, "cat", event->category);
+		fwupd_codec_json_append(builder, "ph", "X");
+		fwupd_codec_json_append_int(builder, "ts", event->ts);
+		fwupd_codec_json_append_int(builder, "dur", event->dur);
+		fwupd_codec_json_append_int(builder, "pid", 1);
+		fwupd_codec_json_append_int(builder, "tid", event->tid);
+		if (event->detail != NULL) {
+			json_builder_set_member_name(builder, "args");
+			json_builder_begin_object(builder);
+			fwupd_codec_json_append(builder, "detail", event->detail);
+			json_builder_end_object(builder);
+		}
+		json_builder_end_object(builder);
+	}
+	json_builder_end_array(builder);
+	json_builder_end_object(builder);
+
+	/* export */
+	json_root = json_builder_get_root(builder);
+	json_generator_set_root(json_generator, json_root);
+	data = json_generator_to_data(json_generator, &datasz);
+	if (data == NULL) {
+		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_INTERNAL, "failed to convert to json");
+		return FALSE;
+	}
+	blob = g_bytes_new_take(g_steal_pointer(&data), datasz);
+	return fu_bytes_set_contents(filename, blob, error);
+}
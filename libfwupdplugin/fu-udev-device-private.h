@@ -37,3 +37,9 @@ fu_udev_device_ioctl(FuUdevDevice *self,
 		     guint timeout,
 		     FuIoctlFlags flags,
 		     GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1);
+void
+fu_udev_device_invalidate_sysfs_cache(FuUdevDevice *self) G_GNUC_NON_NULL(1);
+guint
+fu_udev_device_get_sysfs_cache_hits(FuUdevDevice *self) G_GNUC_NON_NULL(1);
+guint
+fu_udev_device_get_sysfs_cache_misses(FuUdevDevice *self) G_GNUC_NON_NULL(1);
@@ -27,6 +27,7 @@
 #include "fu-ioctl-private.h"
 #include "fu-path.h"
 #include "fu-string.h"
+#include "fu-trace-private.h"
 #include "fu-udev-device-private.h"
 
 /**
@@ -48,6 +49,9 @@ typedef struct {
 	FuIoChannelOpenFlag open_flags;
 	GHashTable *properties;
 	gboolean properties_valid;
+	GHashTable *sysfs_cache; /* (element-type utf8 utf8) */
+	guint sysfs_cache_hits;
+	guint sysfs_cache_misses;
 } FuUdevDevicePrivate;
 
 static void
@@ -562,12 +566,17 @@ fu_udev_device_unbind_driver(FuDevice *device, GError **error)
 	    G_OUTPUT_STREAM(g_file_replace(file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error));
 	if (stream == NULL)
 		return FALSE;
-	return g_output_stream_write_all(stream,
-					 priv->bind_id,
-					 strlen(priv->bind_id),
-					 NULL,
-					 NULL,
-					 error);
+	if (!g_output_stream_write_all(stream,
+				       priv->bind_id,
+				       strlen(priv->bind_id),
+				       NULL,
+				       NULL,
+				       error))
+		return FALSE;
+
+	/* DRIVER= in uevent is now different */
+	g_hash_table_remove(priv->sysfs_cache, "uevent");
+	return TRUE;
 }
 
 static gboolean
@@ -621,12 +630,17 @@ fu_udev_device_bind_driver(FuDevice *device,
 	    G_OUTPUT_STREAM(g_file_replace(file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error));
 	if (stream == NULL)
 		return FALSE;
-	return g_output_stream_write_all(stream,
-					 priv->bind_id,
-					 strlen(priv->bind_id),
-					 NULL,
-					 NULL,
-					 error);
+	if (!g_output_stream_write_all(stream,
+				       priv->bind_id,
+				       strlen(priv->bind_id),
+				       NULL,
+				       NULL,
+				       error))
+		return FALSE;
+
+	/* DRIVER= in uevent is now different */
+	g_hash_table_remove(priv->sysfs_cache, "uevent");
+	return TRUE;
 }
 
 static FuIoChannelOpenFlag
@@ -637,6 +651,75 @@ fu_udev_device_get_open_flags(FuUdevDevice *self)
 	return priv->open_flags;
 }
 
+/**
+ * fu_udev_device_invalidate_sysfs_cache:
+ * @self: a #FuUdevDevice
+ *
+ * Forgets all the cached sysfs attribute values, typically because the kernel sent a `change`
+ * uevent for the device.
+ *
+ * Since: 2.0.7
+ **/
+void
+fu_udev_device_invalidate_sysfs_cache(FuUdevDevice *self)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_if_fail(FU_IS_UDEV_DEVICE(self));
+	g_hash_table_remove_all(priv->sysfs_cache);
+}
+
+/**
+ * fu_udev_device_get_sysfs_cache_hits:
+ * @self: a #FuUdevDevice
+ *
+ * Gets how many sysfs attribute reads were answered from the cache.
+ *
+ * Returns: integer
+ *
+ * Since: 2.0.7
+ **/
+guint
+fu_udev_device_get_sysfs_cache_hits(FuUdevDevice *self)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_UDEV_DEVICE(self), 0);
+	return priv->sysfs_cache_hits;
+}
+
+/**
+ * fu_udev_device_get_sysfs_cache_misses:
+ * @self: a #FuUdevDevice
+ *
+ * Gets how many cacheable sysfs attribute reads had to read the file.
+ *
+ * Returns: integer
+ *
+ * Since: 2.0.7
+ **/
+guint
+fu_udev_device_get_sysfs_cache_misses(FuUdevDevice *self)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(FU_IS_UDEV_DEVICE(self), 0);
+	return priv->sysfs_cache_misses;
+}
+
+/* these never change while the sysfs node exists, apart from uevent when the driver changes */
+static gboolean
+fu_udev_device_sysfs_attr_is_cacheable(const gchar *attr)
+{
+	const gchar *attrs[] = {"class",
+				"device",
+				"modalias",
+				"revision",
+				"subsystem_device",
+				"subsystem_vendor",
+				"uevent",
+				"vendor",
+				NULL};
+	return g_strv_contains(attrs, attr);
+}
+
 static void
 fu_udev_device_invalidate(FuDevice *device)
 {
@@ -644,6 +727,7 @@ fu_udev_device_invalidate(FuDevice *device)
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	priv->properties_valid = FALSE;
 	g_hash_table_remove_all(priv->properties);
+	g_hash_table_remove_all(priv->sysfs_cache);
 }
 
 static void
@@ -1179,11 +1263,13 @@ fu_udev_device_ioctl(FuUdevDevice *self,
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	gint rc_tmp;
 	g_autoptr(GTimer) timer = g_timer_new();
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_UDEV_DEVICE(self), FALSE);
 	g_return_val_if_fail(request != 0x0, FALSE);
 	g_return_val_if_fail(buf != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	span = fu_trace_span_begin("udev", "ioctl", fu_device_get_id(FU_DEVICE(self)));
 
 	/* not open! */
 	if (priv->io_channel == NULL) {
@@ -1266,10 +1352,12 @@ fu_udev_device_pread(FuUdevDevice *self, goffset port, guint8 *buf, gsize bufsz,
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	FuDeviceEvent *event = NULL;
 	g_autofree gchar *event_id = NULL;
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_UDEV_DEVICE(self), FALSE);
 	g_return_val_if_fail(buf != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	span = fu_trace_span_begin("udev", "pread", fu_device_get_id(FU_DEVICE(self)));
 
 	/* emulated */
 	if (fu_device_has_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_EMULATED) ||
@@ -1393,9 +1481,11 @@ fu_udev_device_pwrite(FuUdevDevice *self,
 		      GError **error)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_UDEV_DEVICE(self), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	span = fu_trace_span_begin("udev", "pwrite", fu_device_get_id(FU_DEVICE(self)));
 
 	/* emulated */
 	if (fu_device_has_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_EMULATED))
@@ -1438,6 +1528,71 @@ fu_udev_device_pwrite(FuUdevDevice *self,
 #endif
 }
 
+/**
+ * fu_udev_device_wait:
+ * @self: a #FuUdevDevice
+ * @condition: a #GIOCondition, typically %G_IO_IN
+ * @timeout_ms: timeout in ms
+ * @error: (nullable): optional return location for an error
+ *
+ * Waits for the opened device to signal @condition, returning as soon as the device is ready
+ * rather than sleeping for a fixed delay.
+ *
+ * Returns: %TRUE for success, or %FALSE with %FWUPD_ERROR_TIMED_OUT
+ *
+ * Since: 2.0.7
+ **/
+gboolean
+fu_udev_device_wait(FuUdevDevice *self, GIOCondition condition, guint timeout_ms, GError **error)
+{
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
+	FuDeviceEvent *event = NULL;
+	g_autofree gchar *event_id = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	g_return_val_if_fail(FU_IS_UDEV_DEVICE(self), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* emulated */
+	if (fu_device_has_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_EMULATED) ||
+	    fu_context_has_flag(fu_device_get_context(FU_DEVICE(self)),
+				FU_CONTEXT_FLAG_SAVE_EVENTS)) {
+		event_id = g_strdup_printf("Wait:Condition=0x%x", (guint)condition);
+	}
+
+	/* emulated */
+	if (fu_device_has_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_EMULATED)) {
+		event = fu_device_load_event(FU_DEVICE(self), event_id, error);
+		if (event == NULL)
+			return FALSE;
+		return fu_device_event_check_error(event, error);
+	}
+
+	/* save */
+	if (event_id != NULL)
+		event = fu_device_save_event(FU_DEVICE(self), event_id);
+
+	/* not open! */
+	if (priv->io_channel == NULL) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "%s [%s] has not been opened",
+			    fu_device_get_id(FU_DEVICE(self)),
+			    fu_device_get_name(FU_DEVICE(self)));
+		return FALSE;
+	}
+	if (!fu_io_channel_wait(priv->io_channel, condition, timeout_ms, &error_local)) {
+		if (event != NULL)
+			fu_device_event_set_error(event, error_local);
+		g_propagate_error(error, g_steal_pointer(&error_local));
+		return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+}
+
 /**
  * fu_udev_device_read:
  * @self: a #FuUdevDevice
@@ -1675,6 +1830,7 @@ fu_udev_device_write_bytes(FuUdevDevice *self,
 gchar *
 fu_udev_device_read_sysfs(FuUdevDevice *self, const gchar *attr, guint timeout_ms, GError **error)
 {
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	FuDeviceEvent *event = NULL;
 	g_autofree gchar *event_id = NULL;
 	g_autofree gchar *path = NULL;
@@ -1686,6 +1842,16 @@ fu_udev_device_read_sysfs(FuUdevDevice *self, const gchar *attr, guint timeout_m
 	g_return_val_if_fail(attr != NULL, NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
 
+	/* already read, which also means no duplicate event is saved */
+	if (fu_udev_device_sysfs_attr_is_cacheable(attr)) {
+		const gchar *value_cached = g_hash_table_lookup(priv->sysfs_cache, attr);
+		if (value_cached != NULL) {
+			priv->sysfs_cache_hits++;
+			return g_strdup(value_cached);
+		}
+		priv->sysfs_cache_misses++;
+	}
+
 	/* need event ID */
 	if (fu_device_has_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_EMULATED) ||
 	    fu_context_has_flag(fu_device_get_context(FU_DEVICE(self)),
@@ -1695,10 +1861,16 @@ fu_udev_device_read_sysfs(FuUdevDevice *self, const gchar *attr, guint timeout_m
 
 	/* emulated */
 	if (fu_device_has_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_EMULATED)) {
+		const gchar *tmp;
 		event = fu_device_load_event(FU_DEVICE(self), event_id, error);
 		if (event == NULL)
 			return NULL;
-		return g_strdup(fu_device_event_get_str(event, "Data", error));
+		tmp = fu_device_event_get_str(event, "Data", error);
+		if (tmp == NULL)
+			return NULL;
+		if (fu_udev_device_sysfs_attr_is_cacheable(attr))
+			g_hash_table_insert(priv->sysfs_cache, g_strdup(attr), g_strdup(tmp));
+		return g_strdup(tmp);
 	}
 
 	/* save */
@@ -1742,6 +1914,10 @@ fu_udev_device_read_sysfs(FuUdevDevice *self, const gchar *attr, guint timeout_m
 	if (event != NULL)
 		fu_device_event_set_str(event, "Data", value);
 
+	/* save for next time */
+	if (fu_udev_device_sysfs_attr_is_cacheable(attr))
+		g_hash_table_insert(priv->sysfs_cache, g_strdup(attr), g_strdup(value));
+
 	/* success */
 	return g_steal_pointer(&value);
 }
@@ -1842,6 +2018,7 @@ fu_udev_device_write_sysfs(FuUdevDevice *self,
 			   guint timeout_ms,
 			   GError **error)
 {
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	FuDeviceEvent *event = NULL;
 	g_autofree gchar *event_id = NULL;
 	g_autofree gchar *path = NULL;
@@ -1873,6 +2050,7 @@ fu_udev_device_write_sysfs(FuUdevDevice *self,
 				    "sysfs_path undefined");
 		return FALSE;
 	}
+	g_hash_table_remove(priv->sysfs_cache, attr);
 	path = g_build_filename(fu_udev_device_get_sysfs_path(self), attr, NULL);
 	io_channel = fu_io_channel_new_file(path, FU_IO_CHANNEL_OPEN_FLAG_WRITE, error);
 	if (io_channel == NULL)
@@ -1910,6 +2088,7 @@ fu_udev_device_write_sysfs_byte_array(FuUdevDevice *self,
 				      guint timeout_ms,
 				      GError **error)
 {
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	FuDeviceEvent *event = NULL;
 	g_autofree gchar *event_id = NULL;
 	g_autofree gchar *path = NULL;
@@ -1942,6 +2121,7 @@ fu_udev_device_write_sysfs_byte_array(FuUdevDevice *self,
 				    "sysfs_path undefined");
 		return FALSE;
 	}
+	g_hash_table_remove(priv->sysfs_cache, attr);
 	path = g_build_filename(fu_udev_device_get_sysfs_path(self), attr, NULL);
 	io_channel = fu_io_channel_new_file(path, FU_IO_CHANNEL_OPEN_FLAG_WRITE, error);
 	if (io_channel == NULL)
@@ -1978,6 +2158,7 @@ fu_udev_device_write_sysfs_bytes(FuUdevDevice *self,
 				 guint timeout_ms,
 				 GError **error)
 {
+	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	FuDeviceEvent *event = NULL;
 	g_autofree gchar *event_id = NULL;
 	g_autofree gchar *path = NULL;
@@ -2011,6 +2192,7 @@ fu_udev_device_write_sysfs_bytes(FuUdevDevice *self,
 				    "sysfs_path undefined");
 		return FALSE;
 	}
+	g_hash_table_remove(priv->sysfs_cache, attr);
 	path = g_build_filename(fu_udev_device_get_sysfs_path(self), attr, NULL);
 	io_channel = fu_io_channel_new_file(path, FU_IO_CHANNEL_OPEN_FLAG_WRITE, error);
 	if (io_channel == NULL)
@@ -2331,6 +2513,7 @@ fu_udev_device_finalize(GObject *object)
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 
 	g_hash_table_unref(priv->properties);
+	g_hash_table_unref(priv->sysfs_cache);
 	g_free(priv->subsystem);
 	g_free(priv->devtype);
 	g_free(priv->bind_id);
@@ -2359,6 +2542,7 @@ fu_udev_device_init(FuUdevDevice *self)
 {
 	FuUdevDevicePrivate *priv = GET_PRIVATE(self);
 	priv->properties = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	priv->sysfs_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 	fu_device_set_acquiesce_delay(FU_DEVICE(self), 2500);
 	fu_device_add_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_CAN_EMULATION_TAG);
 	g_signal_connect(FU_DEVICE(self),
@@ -82,6 +82,9 @@ fu_udev_device_write_bytes(FuUdevDevice *self,
 			   FuIOChannelFlags flags,
 			   GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1, 2);
 gboolean
+fu_udev_device_wait(FuUdevDevice *self, GIOCondition condition, guint timeout_ms, GError **error)
+    G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1);
+gboolean
 fu_udev_device_read(FuUdevDevice *self,
 		    guint8 *buf,
 		    gsize bufsz,
@@ -18,6 +18,7 @@
 #include "fu-input-stream.h"
 #include "fu-mem.h"
 #include "fu-string.h"
+#include "fu-trace-private.h"
 #include "fu-usb-bos-descriptor-private.h"
 #include "fu-usb-config-descriptor-private.h"
 #include "fu-usb-device-fw-ds20.h"
@@ -1454,9 +1455,11 @@ fu_usb_device_control_transfer(FuUsbDevice *self,
 	guint8 request_type_raw = 0;
 	FuDeviceEvent *event = NULL;
 	g_autofree gchar *event_id = NULL;
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_USB_DEVICE(self), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	span = fu_trace_span_begin("usb", "control_transfer", fu_device_get_id(FU_DEVICE(self)));
 
 	/* build event key either for load or save */
 	if (fu_device_has_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_EMULATED) ||
@@ -1578,9 +1581,11 @@ fu_usb_device_bulk_transfer(FuUsbDevice *self,
 	gint transferred = 0;
 	FuDeviceEvent *event = NULL;
 	g_autofree gchar *event_id = NULL;
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_USB_DEVICE(self), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	span = fu_trace_span_begin("usb", "bulk_transfer", fu_device_get_id(FU_DEVICE(self)));
 
 	/* build event key either for load or save */
 	if (fu_device_has_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_EMULATED) ||
@@ -1674,9 +1679,11 @@ fu_usb_device_interrupt_transfer(FuUsbDevice *self,
 	gint transferred = 0;
 	FuDeviceEvent *event = NULL;
 	g_autofree gchar *event_id = NULL;
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_USB_DEVICE(self), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	span = fu_trace_span_begin("usb", "interrupt_transfer", fu_device_get_id(FU_DEVICE(self)));
 
 	/* build event key either for load or save */
 	if (fu_device_has_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_EMULATED) ||
@@ -58,6 +58,12 @@ fu_uswid_firmware_validate(FuFirmware *firmware, GInputStream *stream, gsize off
 	return fu_struct_uswid_validate_stream(stream, offset, error);
 }
 
+static gboolean
+fu_uswid_firmware_sniff(FuFirmware *firmware, const guint8 *buf, gsize bufsz, GError **error)
+{
+	return fu_struct_uswid_validate(buf, bufsz, 0x0, error);
+}
+
 static gboolean
 fu_uswid_firmware_parse(FuFirmware *firmware,
 			GInputStream *stream,
@@ -306,6 +312,7 @@ fu_uswid_firmware_class_init(FuUswidFirmwareClass *klass)
 {
 	FuFirmwareClass *firmware_class = FU_FIRMWARE_CLASS(klass);
 	firmware_class->validate = fu_uswid_firmware_validate;
+	firmware_class->sniff = fu_uswid_firmware_sniff;
 	firmware_class->parse = fu_uswid_firmware_parse;
 	firmware_class->write = fu_uswid_firmware_write;
 	firmware_class->build = fu_uswid_firmware_build;
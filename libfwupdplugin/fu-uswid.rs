@@ -13,7 +13,7 @@ enum FuUswidPayloadCompression {
     Lzma = 0x02,
 }
 
-#[derive(New, ValidateStream, ParseStream, Default)]
+#[derive(New, Validate, ValidateStream, ParseStream, Default)]
 #[repr(C, packed)]
 struct FuStructUswid {
     magic: Guid == 0x53424F4DD6BA2EACA3E67A52AAEE3BAF,
@@ -18,6 +18,16 @@
 
 #define FU_COMMON_VERSION_DECODE_BCD(val) ((((val) >> 4) & 0x0f) * 10 + ((val) & 0x0f))
 
+#define FU_VERSION_KEY_SECTIONS_MAX 8
+
+struct FuVersionKey {
+	gchar *version;	     /* as supplied */
+	gchar *version_safe; /* as passed to fu_version_compare_safe() */
+	FwupdVersionFormat fmt;
+	guint8 sections_len; /* or 0 if not just decimal digits and dots */
+	guint32 sections[FU_VERSION_KEY_SECTIONS_MAX];
+};
+
 static gchar *
 fu_version_ensure_semver_internal(const gchar *version);
 
@@ -755,3 +765,177 @@ fu_version_compare(const gchar *version_a, const gchar *version_b, FwupdVersionF
 	}
 	return fu_version_compare_safe(version_a, version_b);
 }
+
+/* only versions made up of decimal sections can use the fast path */
+static void
+fu_version_key_ensure_sections(FuVersionKey *key)
+{
+	guint8 sections_len = 0;
+	guint64 val = 0;
+	gboolean has_digit = FALSE;
+
+	if (key->version_safe == NULL)
+		return;
+	for (gsize i = 0;; i++) {
+		gchar chr = key->version_safe[i];
+		if (g_ascii_isdigit(chr)) {
+			val = val * 10 + (chr - '0');
+			if (val > G_MAXUINT32)
+				return;
+			has_digit = TRUE;
+			continue;
+		}
+		if (chr != '.' && chr != '\0')
+			return;
+		if (!has_digit || sections_len >= FU_VERSION_KEY_SECTIONS_MAX)
+			return;
+		key->sections[sections_len++] = val;
+		if (chr == '\0')
+			break;
+		val = 0;
+		has_digit = FALSE;
+	}
+	key->sections_len = sections_len;
+}
+
+/**
+ * fu_version_key_new:
+ * @version: (nullable): the semver release version, e.g. `1.2.3`
+ * @fmt: a version format, e.g. %FWUPD_VERSION_FORMAT_PLAIN
+ *
+ * Parses the version number so that it can be compared using fu_version_key_compare().
+ *
+ * Returns: (transfer full): a #FuVersionKey
+ *
+ * Since: 2.0.7
+ */
+FuVersionKey *
+fu_version_key_new(const gchar *version, FwupdVersionFormat fmt)
+{
+	FuVersionKey *key = g_new0(FuVersionKey, 1);
+	key->version = g_strdup(version);
+	key->fmt = fmt;
+	if (fmt == FWUPD_VERSION_FORMAT_HEX)
+		key->version_safe = fu_version_parse_from_format(version, fmt);
+	else if (fmt != FWUPD_VERSION_FORMAT_PLAIN)
+		key->version_safe = g_strdup(version);
+	fu_version_key_ensure_sections(key);
+	return key;
+}
+
+/**
+ * fu_version_key_free:
+ * @key: (nullable): a #FuVersionKey
+ *
+ * Frees the version key.
+ *
+ * Since: 2.0.7
+ */
+void
+fu_version_key_free(FuVersionKey *key)
+{
+	if (key == NULL)
+		return;
+	g_free(key->version);
+	g_free(key->version_safe);
+	g_free(key);
+}
+
+/**
+ * fu_version_key_get_version:
+ * @key: a #FuVersionKey
+ *
+ * Gets the version number the key was created from.
+ *
+ * Returns: a version number, or %NULL if unset
+ *
+ * Since: 2.0.7
+ */
+const gchar *
+fu_version_key_get_version(const FuVersionKey *key)
+{
+	g_return_val_if_fail(key != NULL, NULL);
+	return key->version;
+}
+
+/**
+ * fu_version_key_get_format:
+ * @key: a #FuVersionKey
+ *
+ * Gets the version format the key was created with.
+ *
+ * Returns: a version format, e.g. %FWUPD_VERSION_FORMAT_TRIPLET
+ *
+ * Since: 2.0.7
+ */
+FwupdVersionFormat
+fu_version_key_get_format(const FuVersionKey *key)
+{
+	g_return_val_if_fail(key != NULL, FWUPD_VERSION_FORMAT_UNKNOWN);
+	return key->fmt;
+}
+
+/**
+ * fu_version_key_matches:
+ * @key: a #FuVersionKey
+ * @version: (nullable): the semver release version, e.g. `1.2.3`
+ * @fmt: a version format, e.g. %FWUPD_VERSION_FORMAT_PLAIN
+ *
+ * Checks if the key was created from the same version and format, which is useful when
+ * deciding if a cached key is still valid.
+ *
+ * Returns: %TRUE if the key is still valid
+ *
+ * Since: 2.0.7
+ */
+gboolean
+fu_version_key_matches(const FuVersionKey *key, const gchar *version, FwupdVersionFormat fmt)
+{
+	g_return_val_if_fail(key != NULL, FALSE);
+	return key->fmt == fmt && g_strcmp0(key->version, version) == 0;
+}
+
+/**
+ * fu_version_key_compare:
+ * @key_a: a #FuVersionKey
+ * @key_b: a #FuVersionKey
+ *
+ * Compares version numbers for sorting, returning the same result as fu_version_compare() but
+ * without splitting and parsing the strings each time.
+ *
+ * If the keys were created with different version formats, the format of @key_a is used.
+ *
+ * Returns: -1 if a < b, +1 if a > b, 0 if they are equal, and %G_MAXINT on error
+ *
+ * Since: 2.0.7
+ */
+gint
+fu_version_key_compare(const FuVersionKey *key_a, const FuVersionKey *key_b)
+{
+	guint sections_len;
+
+	g_return_val_if_fail(key_a != NULL, G_MAXINT);
+	g_return_val_if_fail(key_b != NULL, G_MAXINT);
+
+	/* slow path */
+	if (key_a->fmt != key_b->fmt)
+		return fu_version_compare(key_a->version, key_b->version, key_a->fmt);
+	if (key_a->fmt == FWUPD_VERSION_FORMAT_PLAIN)
+		return g_strcmp0(key_a->version, key_b->version);
+	if (key_a->sections_len == 0 || key_b->sections_len == 0)
+		return fu_version_compare_safe(key_a->version_safe, key_b->version_safe);
+
+	/* compare each section, and then the one with more sections is newer */
+	sections_len = MIN(key_a->sections_len, key_b->sections_len);
+	for (guint i = 0; i < sections_len; i++) {
+		if (key_a->sections[i] < key_b->sections[i])
+			return -1;
+		if (key_a->sections[i] > key_b->sections[i])
+			return 1;
+	}
+	if (key_a->sections_len < key_b->sections_len)
+		return -1;
+	if (key_a->sections_len > key_b->sections_len)
+		return 1;
+	return 0;
+}
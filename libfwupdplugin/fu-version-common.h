@@ -9,8 +9,29 @@
 #include <fwupd.h>
 #include <gio/gio.h>
 
+/**
+ * FuVersionKey:
+ *
+ * A version number that has been split into sections once, so that it can be compared many
+ * times without parsing the string again.
+ **/
+typedef struct FuVersionKey FuVersionKey;
+
 gint
 fu_version_compare(const gchar *version_a, const gchar *version_b, FwupdVersionFormat fmt);
+FuVersionKey *
+fu_version_key_new(const gchar *version, FwupdVersionFormat fmt);
+void
+fu_version_key_free(FuVersionKey *key);
+const gchar *
+fu_version_key_get_version(const FuVersionKey *key) G_GNUC_NON_NULL(1);
+FwupdVersionFormat
+fu_version_key_get_format(const FuVersionKey *key) G_GNUC_NON_NULL(1);
+gboolean
+fu_version_key_matches(const FuVersionKey *key, const gchar *version, FwupdVersionFormat fmt)
+    G_GNUC_NON_NULL(1);
+gint
+fu_version_key_compare(const FuVersionKey *key_a, const FuVersionKey *key_b) G_GNUC_NON_NULL(1, 2);
 gchar *
 fu_version_from_uint64(guint64 val, FwupdVersionFormat kind);
 gchar *
@@ -33,3 +54,5 @@ gboolean
 fu_version_verify_format(const gchar *version,
 			 FwupdVersionFormat fmt,
 			 GError **error) G_GNUC_WARN_UNUSED_RESULT G_GNUC_NON_NULL(1);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuVersionKey, fu_version_key_free)
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <linux/mmc/ioctl.h>
+
+#include "fu-emmc-common.h"
+
+/* the kernel copies all the data for a multi-cmd ioctl, so do not make this too large */
+#define FU_EMMC_MULTI_CMD_SIZE_MAX (4 * MMC_IOC_MAX_BYTES)
+
+/* one data sector per command unless a quirk opts into larger writes */
+guint32
+fu_emmc_ffu_chunk_size(guint32 sect_size, guint32 write_block_size)
+{
+	if (write_block_size > 0)
+		return write_block_size;
+	return sect_size;
+}
+
+/* each chunk needs SET_BLOCK_COUNT and WRITE_MULTIPLE_BLOCK, and the batch needs two SWITCH */
+guint
+fu_emmc_ffu_batch_count(guint32 chunk_size, guint batch_max)
+{
+	guint batch_count =
+	    MIN((MMC_IOC_MAX_CMDS - 2) / 2, FU_EMMC_MULTI_CMD_SIZE_MAX / MAX(chunk_size, 1));
+	if (batch_max > 0)
+		batch_count = MIN(batch_count, batch_max);
+	return MAX(batch_count, 1);
+}
@@ -0,0 +1,14 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+guint32
+fu_emmc_ffu_chunk_size(guint32 sect_size, guint32 write_block_size);
+guint
+fu_emmc_ffu_batch_count(guint32 chunk_size, guint batch_max);
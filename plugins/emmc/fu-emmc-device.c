@@ -9,6 +9,7 @@
 #include <linux/mmc/ioctl.h>
 #include <sys/ioctl.h>
 
+#include "fu-emmc-common.h"
 #include "fu-emmc-device.h"
 
 /* From kernel linux/major.h */
@@ -70,6 +71,12 @@ struct _FuEmmcDevice {
 	FuUdevDevice parent_instance;
 	guint32 sect_size;
 	guint32 write_block_size;
+	guint ffu_batch_max;
+	guint32 ffu_chunk_size;
+	guint ffu_batch_count;
+	guint ffu_write_duration;   /* ms */
+	guint ffu_verify_duration;  /* ms */
+	guint ffu_install_duration; /* ms */
 };
 
 G_DEFINE_TYPE(FuEmmcDevice, fu_emmc_device, FU_TYPE_UDEV_DEVICE)
@@ -79,6 +86,8 @@ fu_emmc_device_to_string(FuDevice *device, guint idt, GString *str)
 {
 	FuEmmcDevice *self = FU_EMMC_DEVICE(device);
 	fwupd_codec_string_append_int(str, idt, "SectorSize", self->sect_size);
+	fwupd_codec_string_append_hex(str, idt, "WriteBlockSize", self->write_block_size);
+	fwupd_codec_string_append_int(str, idt, "FfuBatchMax", self->ffu_batch_max);
 }
 
 static gboolean
@@ -353,6 +362,116 @@ fu_emmc_device_prepare_firmware(FuDevice *device,
 	return g_steal_pointer(&firmware);
 }
 
+static void
+fu_emmc_device_set_ffu_mode_cmd(struct mmc_ioc_cmd *cmd, guint8 mode)
+{
+	cmd->opcode = MMC_SWITCH;
+	cmd->arg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) | (EXT_CSD_MODE_CONFIG << 16) | (mode << 8) |
+		   EXT_CSD_CMD_SET_NORMAL;
+	cmd->flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
+	cmd->write_flag = 1;
+}
+
+static gboolean
+fu_emmc_device_ffu_multi_cmd(FuEmmcDevice *self,
+			     struct mmc_ioc_multi_cmd *multi_cmd,
+			     GError **error)
+{
+	gsize multi_cmdsz =
+	    sizeof(struct mmc_ioc_multi_cmd) + multi_cmd->num_of_cmds * sizeof(struct mmc_ioc_cmd);
+	g_autoptr(FuIoctl) ioctl = fu_udev_device_ioctl_new(FU_UDEV_DEVICE(self));
+
+	if (!fu_ioctl_execute(ioctl,
+			      MMC_IOC_MULTI_CMD,
+			      (guint8 *)multi_cmd,
+			      multi_cmdsz,
+			      NULL,
+			      FU_EMMC_DEVICE_IOCTL_TIMEOUT,
+			      FU_IOCTL_FLAG_NONE,
+			      error)) {
+		struct mmc_ioc_cmd cmd = {0x0};
+		g_autoptr(GError) error_local = NULL;
+
+		/* multi-cmd ioctl failed before exiting from ffu mode */
+		g_prefix_error(error, "multi-cmd failed: ");
+		fu_emmc_device_set_ffu_mode_cmd(&cmd, EXT_CSD_NORMAL_MODE);
+		if (!fu_ioctl_execute(ioctl,
+				      MMC_IOC_CMD,
+				      (guint8 *)&cmd,
+				      sizeof(cmd),
+				      NULL,
+				      FU_EMMC_DEVICE_IOCTL_TIMEOUT,
+				      FU_IOCTL_FLAG_NONE,
+				      &error_local)) {
+			g_prefix_error(error, "%s: ", error_local->message);
+		}
+		return FALSE;
+	}
+
+	/* success */
+	return TRUE;
+}
+
+/* enter FFU mode, write as many chunks as possible, then return to normal mode */
+static gboolean
+fu_emmc_device_write_chunks(FuEmmcDevice *self,
+			    FuChunkArray *chunks,
+			    guint32 arg,
+			    FuProgress *progress,
+			    GError **error)
+{
+	guint chunks_len = fu_chunk_array_length(chunks);
+
+	for (guint i = 0; i < chunks_len; i += self->ffu_batch_count) {
+		guint batch_len = MIN(self->ffu_batch_count, chunks_len - i);
+		guint32 num_of_cmds = 2 + (2 * batch_len);
+		g_autofree struct mmc_ioc_multi_cmd *multi_cmd = NULL;
+		g_autoptr(GPtrArray) chks = g_ptr_array_new_with_free_func(g_object_unref);
+
+		multi_cmd = g_malloc0(sizeof(struct mmc_ioc_multi_cmd) +
+				      num_of_cmds * sizeof(struct mmc_ioc_cmd));
+		multi_cmd->num_of_cmds = num_of_cmds;
+		fu_emmc_device_set_ffu_mode_cmd(&multi_cmd->cmds[0], EXT_CSD_FFU_MODE);
+		for (guint j = 0; j < batch_len; j++) {
+			struct mmc_ioc_cmd *cmd_cnt = &multi_cmd->cmds[1 + (2 * j)];
+			struct mmc_ioc_cmd *cmd_data = &multi_cmd->cmds[2 + (2 * j)];
+			FuChunk *chk = fu_chunk_array_index(chunks, i + j, error);
+			guint32 blocks;
+
+			if (chk == NULL)
+				return FALSE;
+			g_ptr_array_add(chks, chk);
+			blocks = fu_chunk_get_data_sz(chk) / 512;
+
+			/* send block count */
+			cmd_cnt->opcode = MMC_SET_BLOCK_COUNT;
+			cmd_cnt->arg = blocks;
+			cmd_cnt->flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_ADTC;
+
+			/* send image chunk */
+			cmd_data->opcode = MMC_WRITE_MULTIPLE_BLOCK;
+			cmd_data->blksz = 512;
+			cmd_data->blocks = blocks;
+			cmd_data->arg = arg;
+			cmd_data->flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_ADTC;
+			cmd_data->write_flag = 1;
+			mmc_ioc_cmd_set_data((*cmd_data), fu_chunk_get_data(chk));
+		}
+		fu_emmc_device_set_ffu_mode_cmd(&multi_cmd->cmds[num_of_cmds - 1],
+						EXT_CSD_NORMAL_MODE);
+		if (!fu_emmc_device_ffu_multi_cmd(self, multi_cmd, error)) {
+			g_prefix_error(error, "failed to write chunk 0x%x: ", i);
+			return FALSE;
+		}
+
+		/* update progress */
+		fu_progress_set_percentage_full(progress, (gsize)i + batch_len, (gsize)chunks_len);
+	}
+
+	/* success */
+	return TRUE;
+}
+
 static gboolean
 fu_emmc_device_write_firmware(FuDevice *device,
 			      FuFirmware *firmware,
@@ -363,22 +482,19 @@ fu_emmc_device_write_firmware(FuDevice *device,
 	FuEmmcDevice *self = FU_EMMC_DEVICE(device);
 	guint32 arg;
 	guint32 sect_done = 0;
-	guint32 sector_size;
 	gboolean check_sect_done = FALSE;
-	gsize multi_cmdsz;
 	guint8 ext_csd[512];
 	guint failure_cnt = 0;
-	g_autofree struct mmc_ioc_multi_cmd *multi_cmd = NULL;
 	g_autoptr(GInputStream) stream = NULL;
 	g_autoptr(FuChunkArray) chunks = NULL;
-	g_autoptr(FuIoctl) ioctl = fu_udev_device_ioctl_new(FU_UDEV_DEVICE(self));
+	g_autoptr(GTimer) timer = g_timer_new();
 
 	/* progress */
 	fu_progress_set_id(progress, G_STRLOC);
 	fu_progress_add_flag(progress, FU_PROGRESS_FLAG_GUESSED);
 	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_BUSY, 5, "ffu");
-	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_WRITE, 50, NULL);
-	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_VERIFY, 45, NULL);
+	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_WRITE, 50, "write");
+	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_VERIFY, 45, "install");
 
 	if (!fu_emmc_device_read_extcsd(self, ext_csd, sizeof(ext_csd), error))
 		return FALSE;
@@ -387,8 +503,6 @@ fu_emmc_device_write_firmware(FuDevice *device,
 	if (stream == NULL)
 		return FALSE;
 
-	sector_size = self->write_block_size ?: self->sect_size;
-
 	/*  mode operation codes are supported */
 	check_sect_done = (ext_csd[EXT_CSD_FFU_FEATURES] & 1) > 0;
 
@@ -396,93 +510,47 @@ fu_emmc_device_write_firmware(FuDevice *device,
 	arg = ext_csd[EXT_CSD_FFU_ARG_0] | ext_csd[EXT_CSD_FFU_ARG_1] << 8 |
 	      ext_csd[EXT_CSD_FFU_ARG_2] << 16 | ext_csd[EXT_CSD_FFU_ARG_3] << 24;
 
-	/* prepare multi_cmd to be sent */
-	multi_cmdsz = sizeof(struct mmc_ioc_multi_cmd) + 4 * sizeof(struct mmc_ioc_cmd);
-	multi_cmd = g_malloc0(multi_cmdsz);
-	multi_cmd->num_of_cmds = 4;
-
-	/* put device into ffu mode */
-	multi_cmd->cmds[0].opcode = MMC_SWITCH;
-	multi_cmd->cmds[0].arg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) | (EXT_CSD_MODE_CONFIG << 16) |
-				 (EXT_CSD_FFU_MODE << 8) | EXT_CSD_CMD_SET_NORMAL;
-	multi_cmd->cmds[0].flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
-	multi_cmd->cmds[0].write_flag = 1;
-
-	/* send block count */
-	multi_cmd->cmds[1].opcode = MMC_SET_BLOCK_COUNT;
-	multi_cmd->cmds[1].arg = sector_size / 512;
-	multi_cmd->cmds[1].flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_ADTC;
-
-	/* send image chunk */
-	multi_cmd->cmds[2].opcode = MMC_WRITE_MULTIPLE_BLOCK;
-	multi_cmd->cmds[2].blksz = 512;
-	multi_cmd->cmds[2].blocks = sector_size / 512;
-	multi_cmd->cmds[2].arg = arg;
-	multi_cmd->cmds[2].flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_ADTC;
-	multi_cmd->cmds[2].write_flag = 1;
-
-	/* return device into normal mode */
-	multi_cmd->cmds[3].opcode = MMC_SWITCH;
-	multi_cmd->cmds[3].arg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) | (EXT_CSD_MODE_CONFIG << 16) |
-				 (EXT_CSD_NORMAL_MODE << 8) | EXT_CSD_CMD_SET_NORMAL;
-	multi_cmd->cmds[3].flags = MMC_RSP_SPI_R1B | MMC_RSP_R1B | MMC_CMD_AC;
-	multi_cmd->cmds[3].write_flag = 1;
-	fu_progress_step_done(progress);
-
 	/* build packets */
+	self->ffu_chunk_size = fu_emmc_ffu_chunk_size(self->sect_size, self->write_block_size);
+	if (self->ffu_chunk_size % self->sect_size != 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_SUPPORTED,
+			    "FFU chunk size 0x%x is not a multiple of the sector size 0x%x",
+			    self->ffu_chunk_size,
+			    self->sect_size);
+		return FALSE;
+	}
+	self->ffu_batch_count = fu_emmc_ffu_batch_count(self->ffu_chunk_size, self->ffu_batch_max);
+	g_debug("using FFU chunk size 0x%x with %u chunks per ioctl",
+		self->ffu_chunk_size,
+		self->ffu_batch_count);
 	chunks = fu_chunk_array_new_from_stream(stream,
 						FU_CHUNK_ADDR_OFFSET_NONE,
 						FU_CHUNK_PAGESZ_NONE,
-						sector_size,
+						self->ffu_chunk_size,
 						error);
 	if (chunks == NULL)
 		return FALSE;
-	while (failure_cnt < 3) {
-		for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
-			g_autoptr(FuChunk) chk = NULL;
-
-			/* prepare chunk */
-			chk = fu_chunk_array_index(chunks, i, error);
-			if (chk == NULL)
-				return FALSE;
-
-			mmc_ioc_cmd_set_data(multi_cmd->cmds[2], fu_chunk_get_data(chk));
-
-			if (!fu_ioctl_execute(ioctl,
-					      MMC_IOC_MULTI_CMD,
-					      (guint8 *)multi_cmd,
-					      multi_cmdsz,
-					      NULL,
-					      FU_EMMC_DEVICE_IOCTL_TIMEOUT,
-					      FU_IOCTL_FLAG_NONE,
-					      error)) {
-				g_autoptr(GError) error_local = NULL;
-				g_prefix_error(error, "multi-cmd failed: ");
-				/* multi-cmd ioctl failed before exiting from ffu mode */
-				if (!fu_ioctl_execute(ioctl,
-						      MMC_IOC_CMD,
-						      (guint8 *)&multi_cmd->cmds[3],
-						      sizeof(struct mmc_ioc_cmd),
-						      NULL,
-						      FU_EMMC_DEVICE_IOCTL_TIMEOUT,
-						      FU_IOCTL_FLAG_NONE,
-						      &error_local)) {
-					g_prefix_error(error, "%s: ", error_local->message);
-				}
-				return FALSE;
-			}
+	fu_progress_step_done(progress);
 
-			/* update progress */
-			fu_progress_set_percentage_full(fu_progress_get_child(progress),
-							(gsize)i + 1,
-							(gsize)fu_chunk_array_length(chunks));
-		}
+	g_timer_start(timer);
+	while (failure_cnt < 3) {
+		if (!fu_emmc_device_write_chunks(self,
+						 chunks,
+						 arg,
+						 fu_progress_get_child(progress),
+						 error))
+			return FALSE;
+		self->ffu_write_duration = g_timer_elapsed(timer, NULL) * 1000;
 
 		if (!check_sect_done)
 			break;
 
+		g_timer_start(timer);
 		if (!fu_emmc_device_read_extcsd(self, ext_csd, sizeof(ext_csd), error))
 			return FALSE;
+		self->ffu_verify_duration = g_timer_elapsed(timer, NULL) * 1000;
 
 		sect_done = ext_csd[EXT_CSD_NUM_OF_FW_SEC_PROG_0] |
 			    ext_csd[EXT_CSD_NUM_OF_FW_SEC_PROG_1] << 8 |
@@ -494,7 +562,8 @@ fu_emmc_device_write_firmware(FuDevice *device,
 
 		failure_cnt++;
 		g_debug("programming failed: retrying (%u)", failure_cnt);
-		fu_progress_step_done(progress);
+		fu_progress_reset(fu_progress_get_child(progress));
+		g_timer_start(timer);
 	}
 
 	fu_progress_step_done(progress);
@@ -521,15 +590,17 @@ fu_emmc_device_write_firmware(FuDevice *device,
 	if (!check_sect_done) {
 		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_NEEDS_REBOOT);
 	} else {
+		g_autofree struct mmc_ioc_multi_cmd *multi_cmd = NULL;
+
 		/* re-enter ffu mode and install the firmware */
+		g_timer_start(timer);
+		multi_cmd = g_malloc0(sizeof(struct mmc_ioc_multi_cmd) +
+				      2 * sizeof(struct mmc_ioc_cmd));
 		multi_cmd->num_of_cmds = 2;
-		multi_cmdsz = sizeof(struct mmc_ioc_multi_cmd) +
-			      multi_cmd->num_of_cmds * sizeof(struct mmc_ioc_cmd);
+		fu_emmc_device_set_ffu_mode_cmd(&multi_cmd->cmds[0], EXT_CSD_FFU_MODE);
 
 		/* set ext_csd to install mode */
 		multi_cmd->cmds[1].opcode = MMC_SWITCH;
-		multi_cmd->cmds[1].blksz = 0;
-		multi_cmd->cmds[1].blocks = 0;
 		multi_cmd->cmds[1].arg = (MMC_SWITCH_MODE_WRITE_BYTE << 24) |
 					 (EXT_CSD_MODE_OPERATION_CODES << 16) |
 					 (EXT_CSD_FFU_INSTALL << 8) | EXT_CSD_CMD_SET_NORMAL;
@@ -537,33 +608,15 @@ fu_emmc_device_write_firmware(FuDevice *device,
 		multi_cmd->cmds[1].write_flag = 1;
 
 		/* send ioctl with multi-cmd */
-		if (!fu_ioctl_execute(ioctl,
-				      MMC_IOC_MULTI_CMD,
-				      (guint8 *)multi_cmd,
-				      multi_cmdsz,
-				      NULL,
-				      FU_EMMC_DEVICE_IOCTL_TIMEOUT,
-				      FU_IOCTL_FLAG_NONE,
-				      error)) {
-			g_autoptr(GError) error_local = NULL;
-			/* In case multi-cmd ioctl failed before exiting from ffu mode */
-			g_prefix_error(error, "multi-cmd failed setting install mode: ");
-			if (!fu_ioctl_execute(ioctl,
-					      MMC_IOC_CMD,
-					      (guint8 *)&multi_cmd->cmds[2],
-					      sizeof(struct mmc_ioc_cmd),
-					      NULL,
-					      FU_EMMC_DEVICE_IOCTL_TIMEOUT,
-					      FU_IOCTL_FLAG_NONE,
-					      &error_local)) {
-				g_prefix_error(error, "%s: ", error_local->message);
-			}
+		if (!fu_emmc_device_ffu_multi_cmd(self, multi_cmd, error)) {
+			g_prefix_error(error, "failed setting install mode: ");
 			return FALSE;
 		}
 
 		/* return status */
 		if (!fu_emmc_device_read_extcsd(self, ext_csd, sizeof(ext_csd), error))
 			return FALSE;
+		self->ffu_install_duration = g_timer_elapsed(timer, NULL) * 1000;
 		if (ext_csd[EXT_CSD_FFU_STATUS] != 0) {
 			g_set_error(error,
 				    FWUPD_ERROR,
@@ -578,17 +631,54 @@ fu_emmc_device_write_firmware(FuDevice *device,
 	return TRUE;
 }
 
+static void
+fu_emmc_device_report_metadata_post(FuDevice *device, GHashTable *metadata)
+{
+	FuEmmcDevice *self = FU_EMMC_DEVICE(device);
+
+	/* used to tune EmmcBlockSize and EmmcBatchMax */
+	if (self->ffu_chunk_size == 0)
+		return;
+	g_hash_table_insert(metadata,
+			    g_strdup("EmmcFfuChunkSize"),
+			    g_strdup_printf("0x%x", self->ffu_chunk_size));
+	g_hash_table_insert(metadata,
+			    g_strdup("EmmcFfuBatchCount"),
+			    g_strdup_printf("%u", self->ffu_batch_count));
+	g_hash_table_insert(metadata,
+			    g_strdup("EmmcFfuWriteDuration"),
+			    g_strdup_printf("%u", self->ffu_write_duration));
+	g_hash_table_insert(metadata,
+			    g_strdup("EmmcFfuVerifyDuration"),
+			    g_strdup_printf("%u", self->ffu_verify_duration));
+	g_hash_table_insert(metadata,
+			    g_strdup("EmmcFfuInstallDuration"),
+			    g_strdup_printf("%u", self->ffu_install_duration));
+}
+
 static gboolean
 fu_emmc_device_set_quirk_kv(FuDevice *device, const gchar *key, const gchar *value, GError **error)
 {
 	FuEmmcDevice *self = FU_EMMC_DEVICE(device);
 	if (g_strcmp0(key, "EmmcBlockSize") == 0) {
 		guint64 tmp = 0;
-		if (!fu_strtoull(value, &tmp, 0, G_MAXUINT32, FU_INTEGER_BASE_AUTO, error))
+		if (!fu_strtoull(value, &tmp, 512, MMC_IOC_MAX_BYTES, FU_INTEGER_BASE_AUTO, error))
 			return FALSE;
 		self->write_block_size = tmp;
 		return TRUE;
 	}
+	if (g_strcmp0(key, "EmmcBatchMax") == 0) {
+		guint64 tmp = 0;
+		if (!fu_strtoull(value,
+				 &tmp,
+				 1,
+				 (MMC_IOC_MAX_CMDS - 2) / 2,
+				 FU_INTEGER_BASE_AUTO,
+				 error))
+			return FALSE;
+		self->ffu_batch_max = tmp;
+		return TRUE;
+	}
 
 	g_set_error_literal(error,
 			    FWUPD_ERROR,
@@ -629,5 +719,6 @@ fu_emmc_device_class_init(FuEmmcDeviceClass *klass)
 	device_class->prepare_firmware = fu_emmc_device_prepare_firmware;
 	device_class->probe = fu_emmc_device_probe;
 	device_class->write_firmware = fu_emmc_device_write_firmware;
+	device_class->report_metadata_post = fu_emmc_device_report_metadata_post;
 	device_class->set_progress = fu_emmc_device_set_progress;
 }
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "config.h"
+
+#include <linux/mmc/ioctl.h>
+
+#include "fu-emmc-common.h"
+
+static void
+fu_emmc_ffu_chunk_size_func(void)
+{
+	struct {
+		guint32 sect_size;
+		guint32 write_block_size;
+		guint32 chunk_size;
+	} map[] = {
+	    {512, 0, 512},
+	    {4096, 0, 4096},
+	    {512, 0x1000, 0x1000},
+	    {4096, 0x1000, 0x1000},
+	    {512, MMC_IOC_MAX_BYTES, MMC_IOC_MAX_BYTES},
+	};
+	for (guint i = 0; i < G_N_ELEMENTS(map); i++) {
+		g_assert_cmpint(fu_emmc_ffu_chunk_size(map[i].sect_size, map[i].write_block_size),
+				==,
+				map[i].chunk_size);
+	}
+}
+
+static void
+fu_emmc_ffu_batch_count_func(void)
+{
+	struct {
+		guint32 chunk_size;
+		guint batch_max;
+		guint batch_count;
+	} map[] = {
+	    /* limited by the number of commands */
+	    {512, 0, 126},
+	    {4096, 0, 126},
+	    /* limited by the payload size */
+	    {0x8000, 0, 64},
+	    {MMC_IOC_MAX_BYTES, 0, 4},
+	    /* limited by the quirk */
+	    {512, 8, 8},
+	    {MMC_IOC_MAX_BYTES, 8, 4},
+	    {512, 1, 1},
+	    /* never zero */
+	    {0, 0, 126},
+	};
+	for (guint i = 0; i < G_N_ELEMENTS(map); i++) {
+		g_assert_cmpint(fu_emmc_ffu_batch_count(map[i].chunk_size, map[i].batch_max),
+				==,
+				map[i].batch_count);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	/* only critical and error are fatal */
+	g_log_set_fatal_mask(NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
+
+	/* tests go here */
+	g_test_add_func("/emmc/ffu-chunk-size", fu_emmc_ffu_chunk_size_func);
+	g_test_add_func("/emmc/ffu-batch-count", fu_emmc_ffu_batch_count_func);
+	return g_test_run();
+}
@@ -12,12 +12,20 @@
 #include "fu-nvme-common.h"
 #include "fu-nvme-device.h"
 
-#define FU_NVME_ID_CTRL_SIZE 0x1000
+#define FU_NVME_ID_CTRL_SIZE	  0x1000
+#define FU_NVME_LOG_FW_SLOT_SIZE  0x200
+#define FU_NVME_LOG_ID_FW_SLOT	  0x03
+#define FU_NVME_PAGE_SIZE_MIN	  0x1000
+#define FU_NVME_TRANSFER_SIZE_MAX 0x100000
 
 struct _FuNvmeDevice {
 	FuPciDevice parent_instance;
 	guint pci_depth;
 	guint64 write_block_size;
+	guint8 fwug; /* in units of FU_NVME_PAGE_SIZE_MIN */
+	guint8 mdts; /* as a power of two of FU_NVME_PAGE_SIZE_MIN */
+	guint8 nfws;
+	gboolean s1ro;
 };
 
 #define FU_NVME_COMMIT_ACTION_CA0 0b000 /* replace only */
@@ -25,8 +33,9 @@ struct _FuNvmeDevice {
 #define FU_NVME_COMMIT_ACTION_CA2 0b010 /* activate on next reset */
 #define FU_NVME_COMMIT_ACTION_CA3 0b011 /* replace, and activate immediately */
 
-#define FU_NVME_DEVICE_FLAG_FORCE_ALIGN "force-align"
-#define FU_NVME_DEVICE_FLAG_COMMIT_CA3	"commit-ca3"
+#define FU_NVME_DEVICE_FLAG_FORCE_ALIGN	    "force-align"
+#define FU_NVME_DEVICE_FLAG_COMMIT_CA3	    "commit-ca3"
+#define FU_NVME_DEVICE_FLAG_COMMIT_DEFERRED "commit-deferred"
 
 G_DEFINE_TYPE(FuNvmeDevice, fu_nvme_device, FU_TYPE_PCI_DEVICE)
 
@@ -37,6 +46,11 @@ fu_nvme_device_to_string(FuDevice *device, guint idt, GString *str)
 {
 	FuNvmeDevice *self = FU_NVME_DEVICE(device);
 	fwupd_codec_string_append_int(str, idt, "PciDepth", self->pci_depth);
+	fwupd_codec_string_append_hex(str, idt, "WriteBlockSize", self->write_block_size);
+	fwupd_codec_string_append_hex(str, idt, "Fwug", self->fwug);
+	fwupd_codec_string_append_int(str, idt, "Mdts", self->mdts);
+	fwupd_codec_string_append_int(str, idt, "Nfws", self->nfws);
+	fwupd_codec_string_append_bool(str, idt, "S1ro", self->s1ro);
 }
 
 /* @addr_start and @addr_end are *inclusive* to match the NMVe specification */
@@ -156,6 +170,23 @@ fu_nvme_device_identify_ctrl(FuNvmeDevice *self, guint8 *buf, gsize bufsz, GErro
 	return fu_nvme_device_submit_admin_passthru(self, &cmd, buf, bufsz, error);
 }
 
+static gboolean
+fu_nvme_device_get_log_page(FuNvmeDevice *self,
+			    guint8 lid,
+			    guint8 *buf,
+			    gsize bufsz,
+			    GError **error)
+{
+	struct nvme_admin_cmd cmd = {
+	    .opcode = 0x02,
+	    .nsid = 0xffffffff,
+	    .addr = 0x0, /* memory address of data */
+	    .data_len = bufsz,
+	    .cdw10 = ((((guint32)bufsz >> 2) - 1) << 16) | lid, /* NUMDL in DWORDs */
+	};
+	return fu_nvme_device_submit_admin_passthru(self, &cmd, buf, bufsz, error);
+}
+
 static gboolean
 fu_nvme_device_fw_commit(FuNvmeDevice *self,
 			 guint8 slot,
@@ -222,9 +253,6 @@ static gboolean
 fu_nvme_device_parse_cns(FuNvmeDevice *self, const guint8 *buf, gsize sz, GError **error)
 {
 	guint8 fawr;
-	guint8 fwug;
-	guint8 nfws;
-	guint8 s1ro;
 	g_autofree gchar *gu = NULL;
 	g_autofree gchar *mn = NULL;
 	g_autofree gchar *sn = NULL;
@@ -252,16 +280,15 @@ fu_nvme_device_parse_cns(FuNvmeDevice *self, const guint8 *buf, gsize sz, GError
 	if (sr != NULL)
 		fu_device_set_version(FU_DEVICE(self), sr);
 
-	/* firmware update granularity (FWUG) */
-	fwug = buf[319];
-	if (fwug != 0x00 && fwug != 0xff)
-		self->write_block_size = ((guint64)fwug) * 0x1000;
+	/* maximum data transfer size (MDTS) and firmware update granularity (FWUG) */
+	self->mdts = buf[77];
+	self->fwug = buf[319];
 
 	/* firmware slot information */
 	fawr = (buf[260] & 0x10) >> 4;
-	nfws = (buf[260] & 0x0e) >> 1;
-	s1ro = buf[260] & 0x01;
-	g_debug("fawr: %u, nr fw slots: %u, slot1 r/o: %u", fawr, nfws, s1ro);
+	self->nfws = (buf[260] & 0x0e) >> 1;
+	self->s1ro = buf[260] & 0x01;
+	g_debug("fawr: %u, nr fw slots: %u, slot1 r/o: %u", fawr, self->nfws, self->s1ro);
 
 	/* FRU globally unique identifier (FGUID) */
 	gu = fu_nvme_device_get_guid_safe(buf, 127);
@@ -341,6 +368,7 @@ fu_nvme_device_probe(FuDevice *device, GError **error)
 	/* most devices need at least a warm reset, but some quirked drives
 	 * need a full "cold" shutdown and startup */
 	if (!fu_device_has_private_flag(device, FU_NVME_DEVICE_FLAG_COMMIT_CA3) &&
+	    !fu_device_has_private_flag(device, FU_NVME_DEVICE_FLAG_COMMIT_DEFERRED) &&
 	    !fu_device_has_flag(self, FWUPD_DEVICE_FLAG_EMULATED) &&
 	    !fu_device_has_flag(self, FWUPD_DEVICE_FLAG_NEEDS_SHUTDOWN))
 		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_NEEDS_REBOOT);
@@ -380,6 +408,87 @@ fu_nvme_device_setup(FuDevice *device, GError **error)
 	return TRUE;
 }
 
+/* the largest multiple of the update granularity allowed by the maximum data transfer size */
+gsize
+fu_nvme_device_get_transfer_size(FuNvmeDevice *self)
+{
+	gsize granularity = FU_NVME_PAGE_SIZE_MIN;
+	gsize transfer_max = FU_NVME_TRANSFER_SIZE_MAX;
+
+	g_return_val_if_fail(FU_IS_NVME_DEVICE(self), 0);
+
+	/* set from a quirk */
+	if (self->write_block_size > 0)
+		return self->write_block_size;
+
+	/* 0x00 is no information provided, and 0xFF is no restriction */
+	if (self->fwug == 0x00)
+		return FU_NVME_PAGE_SIZE_MIN;
+	if (self->fwug != 0xff)
+		granularity = (gsize)self->fwug * FU_NVME_PAGE_SIZE_MIN;
+
+	/* the final block has to be padded, so use as little padding as possible */
+	if (fu_device_has_private_flag(FU_DEVICE(self), FU_NVME_DEVICE_FLAG_FORCE_ALIGN))
+		return granularity;
+
+	/* 0x00 is no limit, and CAP.MPSMIN is assumed to be the smallest page size */
+	if (self->mdts != 0x00 && self->mdts < 16)
+		transfer_max = MIN(transfer_max, (gsize)FU_NVME_PAGE_SIZE_MIN << self->mdts);
+	if (granularity >= transfer_max)
+		return granularity;
+	return transfer_max - (transfer_max % granularity);
+}
+
+/* the first writable slot that is not running, so the download does not affect the device */
+static gboolean
+fu_nvme_device_get_stage_slot(FuNvmeDevice *self, guint8 *slot, GError **error)
+{
+	guint8 buf[FU_NVME_LOG_FW_SLOT_SIZE] = {0x0};
+	guint8 slot_active;
+
+	if (!fu_nvme_device_get_log_page(self, FU_NVME_LOG_ID_FW_SLOT, buf, sizeof(buf), error)) {
+		g_prefix_error(error, "failed to get firmware slot information: ");
+		return FALSE;
+	}
+	slot_active = buf[0] & 0x07;
+	for (guint8 i = self->s1ro ? 2 : 1; i <= self->nfws; i++) {
+		if (i != slot_active) {
+			*slot = i;
+			return TRUE;
+		}
+	}
+	g_set_error(error,
+		    FWUPD_ERROR,
+		    FWUPD_ERROR_NOT_SUPPORTED,
+		    "no inactive writable slot, slot %u of %u is active",
+		    slot_active,
+		    self->nfws);
+	return FALSE;
+}
+
+static gboolean
+fu_nvme_device_activate(FuDevice *device, FuProgress *progress, GError **error)
+{
+	FuNvmeDevice *self = FU_NVME_DEVICE(device);
+	guint8 slot = 0;
+
+	/* the active slot has not changed since the download */
+	if (!fu_nvme_device_get_stage_slot(self, &slot, error))
+		return FALSE;
+	if (!fu_nvme_device_fw_commit(self,
+				      slot,
+				      FU_NVME_COMMIT_ACTION_CA2,
+				      0x00, /* boot partition identifier */
+				      error)) {
+		g_prefix_error(error, "failed to activate slot %u: ", slot);
+		return FALSE;
+	}
+
+	/* success */
+	fu_device_add_flag(device, FWUPD_DEVICE_FLAG_NEEDS_REBOOT);
+	return TRUE;
+}
+
 static gboolean
 fu_nvme_device_write_firmware(FuDevice *device,
 			      FuFirmware *firmware,
@@ -391,8 +500,9 @@ fu_nvme_device_write_firmware(FuDevice *device,
 	g_autoptr(GBytes) fw2 = NULL;
 	g_autoptr(GBytes) fw = NULL;
 	g_autoptr(FuChunkArray) chunks = NULL;
-	guint64 block_size = self->write_block_size > 0 ? self->write_block_size : 0x1000;
+	gsize block_size = fu_nvme_device_get_transfer_size(self);
 	guint8 commit_action = FU_NVME_COMMIT_ACTION_CA1;
+	guint8 commit_slot = 0x00; /* let controller choose */
 
 	/* progress */
 	fu_progress_set_id(progress, G_STRLOC);
@@ -404,6 +514,14 @@ fu_nvme_device_write_firmware(FuDevice *device,
 	if (fw == NULL)
 		return FALSE;
 
+	/* replace the image in a slot that is not running, and activate it later */
+	if (fu_device_has_private_flag(device, FU_NVME_DEVICE_FLAG_COMMIT_DEFERRED)) {
+		if (!fu_nvme_device_get_stage_slot(self, &commit_slot, error))
+			return FALSE;
+		commit_action = FU_NVME_COMMIT_ACTION_CA0;
+	}
+	g_debug("using transfer size of 0x%x", (guint)block_size);
+
 	/* some vendors provide firmware files whose sizes are not multiples
 	 * of blksz *and* the device won't accept blocks of different sizes */
 	if (fu_device_has_private_flag(device, FU_NVME_DEVICE_FLAG_FORCE_ALIGN)) {
@@ -439,18 +557,23 @@ fu_nvme_device_write_firmware(FuDevice *device,
 	fu_progress_step_done(progress);
 
 	/* commit */
-	if (fu_device_has_private_flag(device, FU_NVME_DEVICE_FLAG_COMMIT_CA3))
+	if (commit_action == FU_NVME_COMMIT_ACTION_CA1 &&
+	    fu_device_has_private_flag(device, FU_NVME_DEVICE_FLAG_COMMIT_CA3))
 		commit_action = FU_NVME_COMMIT_ACTION_CA3;
 	if (!fu_nvme_device_fw_commit(self,
-				      0x00, /* let controller choose */
+				      commit_slot,
 				      commit_action,
 				      0x00, /* boot partition identifier */
 				      error)) {
-		g_prefix_error(error, "failed to commit to auto slot: ");
+		g_prefix_error(error, "failed to commit to slot %u: ", commit_slot);
 		return FALSE;
 	}
 	fu_progress_step_done(progress);
 
+	/* staged */
+	if (commit_action == FU_NVME_COMMIT_ACTION_CA0)
+		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_NEEDS_ACTIVATION);
+
 	/* success! */
 	return TRUE;
 }
@@ -500,6 +623,7 @@ fu_nvme_device_init(FuNvmeDevice *self)
 	fu_udev_device_add_open_flag(FU_UDEV_DEVICE(self), FU_IO_CHANNEL_OPEN_FLAG_READ);
 	fu_device_register_private_flag(FU_DEVICE(self), FU_NVME_DEVICE_FLAG_FORCE_ALIGN);
 	fu_device_register_private_flag(FU_DEVICE(self), FU_NVME_DEVICE_FLAG_COMMIT_CA3);
+	fu_device_register_private_flag(FU_DEVICE(self), FU_NVME_DEVICE_FLAG_COMMIT_DEFERRED);
 }
 
 static void
@@ -510,6 +634,7 @@ fu_nvme_device_class_init(FuNvmeDeviceClass *klass)
 	device_class->set_quirk_kv = fu_nvme_device_set_quirk_kv;
 	device_class->setup = fu_nvme_device_setup;
 	device_class->write_firmware = fu_nvme_device_write_firmware;
+	device_class->activate = fu_nvme_device_activate;
 	device_class->probe = fu_nvme_device_probe;
 	device_class->set_progress = fu_nvme_device_set_progress;
 }
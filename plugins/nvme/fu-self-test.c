@@ -84,6 +84,37 @@ fu_nvme_cns_all_func(void)
 	}
 }
 
+static void
+fu_nvme_transfer_size_func(void)
+{
+	guint8 buf[0x1000] = {0x0};
+	g_autoptr(FuContext) ctx = fu_context_new();
+	struct {
+		guint8 mdts;
+		guint8 fwug;
+		gsize transfer_size;
+	} map[] = {
+	    {0x00, 0x00, 0x1000},   /* no information */
+	    {0x05, 0x01, 0x20000},  /* 128kB max */
+	    {0x05, 0x03, 0x1e000},  /* multiple of 12kB */
+	    {0x05, 0xff, 0x20000},  /* no granularity restriction */
+	    {0x00, 0xff, 0x100000}, /* no limit, so clamped */
+	    {0x02, 0x08, 0x8000},   /* granularity larger than max */
+	};
+
+	for (guint i = 0; i < G_N_ELEMENTS(map); i++) {
+		g_autoptr(FuNvmeDevice) dev = NULL;
+		g_autoptr(GError) error = NULL;
+
+		buf[77] = map[i].mdts;
+		buf[319] = map[i].fwug;
+		dev = fu_nvme_device_new_from_blob(ctx, buf, sizeof(buf), &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(dev);
+		g_assert_cmpint(fu_nvme_device_get_transfer_size(dev), ==, map[i].transfer_size);
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -100,5 +131,6 @@ main(int argc, char **argv)
 	/* tests go here */
 	g_test_add_func("/fwupd/cns", fu_nvme_cns_func);
 	g_test_add_func("/fwupd/cns{all}", fu_nvme_cns_all_func);
+	g_test_add_func("/fwupd/transfer-size", fu_nvme_transfer_size_func);
 	return g_test_run();
 }
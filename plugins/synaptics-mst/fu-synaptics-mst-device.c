@@ -70,6 +70,7 @@ struct _FuSynapticsMstDevice {
 	FuSynapticsMstFamily family;
 	guint8 active_bank;
 	guint16 board_id;
+	gboolean board_id_cached;
 	guint16 chip_id;
 };
 
@@ -115,6 +116,7 @@ fu_synaptics_mst_device_init(FuSynapticsMstDevice *self)
 	fu_device_register_private_flag(FU_DEVICE(self),
 					FU_SYNAPTICS_MST_DEVICE_FLAG_IS_SOMEWHAT_EMULATED);
 	fu_device_add_flag(FU_DEVICE(self), FWUPD_DEVICE_FLAG_UPDATABLE);
+	fu_device_add_private_flag(FU_DEVICE(self), FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP);
 	fu_device_add_request_flag(FU_DEVICE(self), FWUPD_REQUEST_FLAG_ALLOW_GENERIC_MESSAGE);
 
 	/* this is set from ->incorporate() */
@@ -1368,6 +1370,34 @@ fu_synaptics_mst_device_restart(FuSynapticsMstDevice *self, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_synaptics_mst_device_ensure_board_id(FuSynapticsMstDevice *self, GError **error);
+
+static gboolean
+fu_synaptics_mst_device_check_board_id(FuSynapticsMstDevice *self,
+				       FuFirmware *firmware,
+				       FwupdInstallFlags flags,
+				       GError **error)
+{
+	guint16 board_id;
+
+	if ((flags & FWUPD_INSTALL_FLAG_IGNORE_VID_PID) > 0 ||
+	    fu_device_has_private_flag(FU_DEVICE(self),
+				       FU_SYNAPTICS_MST_DEVICE_FLAG_IGNORE_BOARD_ID))
+		return TRUE;
+	board_id = fu_synaptics_mst_firmware_get_board_id(FU_SYNAPTICS_MST_FIRMWARE(firmware));
+	if (board_id != self->board_id) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INVALID_DATA,
+			    "board ID mismatch, got 0x%04x, expected 0x%04x",
+			    board_id,
+			    self->board_id);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static FuFirmware *
 fu_synaptics_mst_device_prepare_firmware(FuDevice *device,
 					 GInputStream *stream,
@@ -1384,20 +1414,8 @@ fu_synaptics_mst_device_prepare_firmware(FuDevice *device,
 	/* check firmware and board ID match */
 	if (!fu_firmware_parse_stream(firmware, stream, 0x0, flags, error))
 		return NULL;
-	if ((flags & FWUPD_INSTALL_FLAG_IGNORE_VID_PID) == 0 &&
-	    !fu_device_has_private_flag(device, FU_SYNAPTICS_MST_DEVICE_FLAG_IGNORE_BOARD_ID)) {
-		guint16 board_id =
-		    fu_synaptics_mst_firmware_get_board_id(FU_SYNAPTICS_MST_FIRMWARE(firmware));
-		if (board_id != self->board_id) {
-			g_set_error(error,
-				    FWUPD_ERROR,
-				    FWUPD_ERROR_INVALID_DATA,
-				    "board ID mismatch, got 0x%04x, expected 0x%04x",
-				    board_id,
-				    self->board_id);
-			return NULL;
-		}
-	}
+	if (!fu_synaptics_mst_device_check_board_id(self, firmware, flags, error))
+		return NULL;
 	return g_steal_pointer(&firmware);
 }
 
@@ -1441,6 +1459,23 @@ fu_synaptics_mst_device_write_firmware(FuDevice *device,
 	if (fw == NULL)
 		return FALSE;
 
+	/* the board ID may have come from the setup cache, so check it with the hardware */
+	if (self->board_id_cached) {
+		g_autoptr(FuDeviceLocker) locker_rc = NULL;
+		locker_rc =
+		    fu_device_locker_new_full(self,
+					      (FuDeviceLockerFunc)fu_synaptics_mst_device_enable_rc,
+					      (FuDeviceLockerFunc)fu_synaptics_mst_device_disable_rc,
+					      error);
+		if (locker_rc == NULL)
+			return FALSE;
+		if (!fu_synaptics_mst_device_ensure_board_id(self, error))
+			return FALSE;
+		self->board_id_cached = FALSE;
+		if (!fu_synaptics_mst_device_check_board_id(self, firmware, flags, error))
+			return FALSE;
+	}
+
 	/* enable remote control and disable on exit */
 	if (!fu_device_has_private_flag(device, FU_DEVICE_PRIVATE_FLAG_SKIPS_RESTART)) {
 		locker =
@@ -1621,6 +1656,60 @@ fu_synaptics_mst_device_ensure_board_id(FuSynapticsMstDevice *self, GError **err
 	return TRUE;
 }
 
+static gboolean
+fu_synaptics_mst_device_ensure_board_id_cached(FuSynapticsMstDevice *self,
+					       const gchar *version,
+					       GError **error)
+{
+	FuDevice *device = FU_DEVICE(self);
+	const gchar *board_id_str;
+	g_autofree gchar *board_id_new = NULL;
+
+	/* the emulated EEPROM is cheap to read */
+	if (!fu_device_has_private_flag(device,
+					FU_SYNAPTICS_MST_DEVICE_FLAG_IS_SOMEWHAT_EMULATED)) {
+		FuDpauxDevice *dpaux = FU_DPAUX_DEVICE(self);
+		guint32 oui = fu_dpaux_device_get_dpcd_ieee_oui(dpaux);
+		guint8 hw_rev = fu_dpaux_device_get_dpcd_hw_rev(dpaux);
+		g_autofree gchar *chip_id_str = g_strdup_printf("%04x", self->chip_id);
+		g_autofree gchar *oui_str = g_strdup_printf("%06x", oui);
+		g_autofree gchar *hw_rev_str = g_strdup_printf("%02x", hw_rev);
+
+		fu_device_add_setup_cache_identity(device, "DpcdOui", oui_str);
+		fu_device_add_setup_cache_identity(device, "DpcdHwRev", hw_rev_str);
+		fu_device_add_setup_cache_identity(device, "ChipId", chip_id_str);
+		fu_device_add_setup_cache_identity(device, "Version", version);
+		board_id_str = fu_device_get_setup_cache_value(device, "BoardId");
+		if (board_id_str != NULL) {
+			guint64 board_id = 0;
+			if (!fu_strtoull(board_id_str,
+					 &board_id,
+					 0,
+					 G_MAXUINT16,
+					 FU_INTEGER_BASE_AUTO,
+					 error))
+				return FALSE;
+			self->board_id = board_id;
+			self->board_id_cached = TRUE;
+			return TRUE;
+		}
+	}
+
+	/* check the active bank for debugging */
+	if (self->family == FU_SYNAPTICS_MST_FAMILY_PANAMERA) {
+		if (!fu_synaptics_mst_device_get_active_bank_panamera(self, error))
+			return FALSE;
+	}
+
+	/* read board ID */
+	if (!fu_synaptics_mst_device_ensure_board_id(self, error))
+		return FALSE;
+	self->board_id_cached = FALSE;
+	board_id_new = g_strdup_printf("%u", self->board_id);
+	fu_device_set_setup_cache_value(device, "BoardId", board_id_new);
+	return TRUE;
+}
+
 static gboolean
 fu_synaptics_mst_device_setup(FuDevice *device, GError **error)
 {
@@ -1726,14 +1815,8 @@ fu_synaptics_mst_device_setup(FuDevice *device, GError **error)
 		break;
 	}
 
-	/* check the active bank for debugging */
-	if (self->family == FU_SYNAPTICS_MST_FAMILY_PANAMERA) {
-		if (!fu_synaptics_mst_device_get_active_bank_panamera(self, error))
-			return FALSE;
-	}
-
-	/* read board ID */
-	if (!fu_synaptics_mst_device_ensure_board_id(self, error))
+	/* the board ID needs slow RC commands, so reuse it if nothing has changed */
+	if (!fu_synaptics_mst_device_ensure_board_id_cached(self, version, error))
 		return FALSE;
 
 	parent = fu_device_get_parent(FU_DEVICE(self));
@@ -100,6 +100,7 @@ fu_test_plugin_modify_config(FuPlugin *plugin, const gchar *key, const gchar *va
 			       "RegistrationSupported",
 			       "RequestDelay",
 			       "RequestSupported",
+			       "SecurityAttrResult",
 			       "VerifyDelay",
 			       "WriteDelay",
 			       "WriteSupported",
@@ -115,6 +116,23 @@ fu_test_plugin_modify_config(FuPlugin *plugin, const gchar *key, const gchar *va
 	return fu_plugin_set_config_value(plugin, key, value, error);
 }
 
+static void
+fu_test_plugin_add_security_attrs(FuPlugin *plugin, FuSecurityAttrs *attrs)
+{
+	const gchar *result = fu_plugin_get_config_value(plugin, "SecurityAttrResult");
+	g_autoptr(FwupdSecurityAttr) attr = NULL;
+
+	/* not enabled by default, so that the other tests have no HSI attributes */
+	if (g_strcmp0(result, "unknown") == 0)
+		return;
+	attr = fu_plugin_security_attr_new(plugin, FWUPD_SECURITY_ATTR_ID_ENCRYPTED_RAM);
+	fwupd_security_attr_set_result_success(attr, FWUPD_SECURITY_ATTR_RESULT_ENCRYPTED);
+	fwupd_security_attr_set_result(attr, fwupd_security_attr_result_from_string(result));
+	if (fwupd_security_attr_get_result(attr) == FWUPD_SECURITY_ATTR_RESULT_ENCRYPTED)
+		fwupd_security_attr_add_flag(attr, FWUPD_SECURITY_ATTR_FLAG_SUCCESS);
+	fu_security_attrs_append(attrs, attr);
+}
+
 static void
 fu_test_plugin_device_registered(FuPlugin *plugin, FuDevice *device)
 {
@@ -392,6 +410,7 @@ fu_test_plugin_constructed(GObject *obj)
 	fu_plugin_set_config_default(plugin, "RegistrationSupported", "false");
 	fu_plugin_set_config_default(plugin, "RequestDelay", "10"); /* ms */
 	fu_plugin_set_config_default(plugin, "RequestSupported", "false");
+	fu_plugin_set_config_default(plugin, "SecurityAttrResult", "unknown");
 	fu_plugin_set_config_default(plugin, "VerifyDelay", "0");
 	fu_plugin_set_config_default(plugin, "WriteDelay", "0");
 	fu_plugin_set_config_default(plugin, "WriteSupported", "true");
@@ -420,5 +439,6 @@ fu_test_plugin_class_init(FuTestPluginClass *klass)
 	plugin_class->verify = fu_test_plugin_verify;
 	plugin_class->coldplug = fu_test_plugin_coldplug;
 	plugin_class->device_registered = fu_test_plugin_device_registered;
+	plugin_class->add_security_attrs = fu_test_plugin_add_security_attrs;
 	plugin_class->modify_config = fu_test_plugin_modify_config;
 }
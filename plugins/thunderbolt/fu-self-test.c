@@ -20,6 +20,7 @@
 
 #include "fu-context-private.h"
 #include "fu-plugin-private.h"
+#include "fu-thunderbolt-common.h"
 #include "fu-thunderbolt-plugin.h"
 #include "fu-udev-device-private.h"
 
@@ -1187,6 +1188,9 @@ test_update_wd19(ThunderboltTest *tt, gconstpointer user_data)
 	/* simulate a wd19 update which will not disappear / re-appear */
 	fu_device_add_private_flag(tree->fu_device, FU_DEVICE_PRIVATE_FLAG_SKIPS_RESTART);
 	fu_device_add_flag(tree->fu_device, FWUPD_DEVICE_FLAG_USABLE_DURING_UPDATE);
+
+	/* the mock nvmem can be read back */
+	fu_device_add_private_flag(tree->fu_device, FU_THUNDERBOLT_DEVICE_FLAG_VERIFY_NVMEM);
 	version_before = fu_device_get_version(tree->fu_device);
 
 	ret = fu_plugin_runner_write_firmware(plugin,
@@ -10,6 +10,7 @@
 #include <fwupdplugin.h>
 
 #define FU_THUNDERBOLT_DEVICE_FLAG_FORCE_ENUMERATION "force-enumeration"
+#define FU_THUNDERBOLT_DEVICE_FLAG_VERIFY_NVMEM	     "verify-nvmem"
 
 #define FU_THUNDERBOLT_DEVICE_WRITE_TIMEOUT 1500 /* ms */
 
@@ -266,35 +266,117 @@ fu_thunderbolt_device_rescan(FuDevice *device, GError **error)
 	return fu_thunderbolt_device_get_version(self, error);
 }
 
+/* sysfs binary attributes are written at most one page at a time */
+static gsize
+fu_thunderbolt_device_get_nvmem_page_size(void)
+{
+	glong page_size = sysconf(_SC_PAGESIZE);
+	return page_size > 0 ? (gsize)page_size : 0x1000;
+}
+
 static gboolean
-fu_thunderbolt_device_write_stream(GOutputStream *ostream,
-				   GBytes *bytes,
-				   FuProgress *progress,
-				   GError **error)
+fu_thunderbolt_device_nvmem_pwrite(gint fd, FuChunk *chk, GError **error)
 {
-	gsize bufsz = g_bytes_get_size(bytes);
-	gsize total_written = 0;
-
-	do {
-		gssize wrote;
-		g_autoptr(GBytes) fw_data = NULL;
-		fw_data = fu_bytes_new_offset(bytes, total_written, bufsz - total_written, error);
-		if (fw_data == NULL)
+	const guint8 *buf = fu_chunk_get_data(chk);
+	gsize bufsz = fu_chunk_get_data_sz(chk);
+	gsize offset = 0;
+
+	while (offset < bufsz) {
+		gssize wrote = pwrite(fd,
+				      buf + offset,
+				      bufsz - offset,
+				      (off_t)(fu_chunk_get_address(chk) + offset));
+		if (wrote < 0 && errno == EINTR)
+			continue;
+		if (wrote <= 0) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_WRITE,
+				    "failed to write @0x%x: %s",
+				    (guint)(fu_chunk_get_address(chk) + offset),
+				    wrote < 0 ? g_strerror(errno) : "no data written");
 			return FALSE;
-		wrote = g_output_stream_write_bytes(ostream, fw_data, NULL, error);
-		if (wrote < 0)
+		}
+		offset += wrote;
+	}
+
+	/* success */
+	return TRUE;
+}
+
+/* @buf is only one page, so the image is never copied in full */
+static gboolean
+fu_thunderbolt_device_nvmem_pverify(gint fd, FuChunk *chk, guint8 *buf, GError **error)
+{
+	gsize bufsz = fu_chunk_get_data_sz(chk);
+	gsize offset = 0;
+
+	while (offset < bufsz) {
+		gssize len = pread(fd,
+				   buf + offset,
+				   bufsz - offset,
+				   (off_t)(fu_chunk_get_address(chk) + offset));
+		if (len < 0 && errno == EINTR)
+			continue;
+		if (len <= 0) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_READ,
+				    "failed to read @0x%x: %s",
+				    (guint)(fu_chunk_get_address(chk) + offset),
+				    len < 0 ? g_strerror(errno) : "no data read");
 			return FALSE;
-		total_written += wrote;
-		fu_progress_set_percentage_full(progress, total_written, bufsz);
-	} while (total_written < bufsz);
-	if (total_written != bufsz) {
-		g_set_error(error,
-			    FWUPD_ERROR,
-			    FWUPD_ERROR_WRITE,
-			    "only wrote 0x%x of 0x%x",
-			    (guint)total_written,
-			    (guint)bufsz);
-		return FALSE;
+		}
+		offset += len;
+	}
+	return fu_memcmp_safe(buf,
+			      bufsz,
+			      0x0,
+			      fu_chunk_get_data(chk),
+			      bufsz,
+			      0x0,
+			      bufsz,
+			      error);
+}
+
+static gboolean
+fu_thunderbolt_device_nvmem_write_chunks(gint fd,
+					 FuChunkArray *chunks,
+					 FuProgress *progress,
+					 GError **error)
+{
+	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
+		g_autoptr(FuChunk) chk = fu_chunk_array_index(chunks, i, error);
+		if (chk == NULL)
+			return FALSE;
+		if (!fu_thunderbolt_device_nvmem_pwrite(fd, chk, error))
+			return FALSE;
+		fu_progress_set_percentage_full(progress,
+						(gsize)i + 1,
+						(gsize)fu_chunk_array_length(chunks));
+	}
+
+	/* success */
+	return TRUE;
+}
+
+static gboolean
+fu_thunderbolt_device_nvmem_verify_chunks(gint fd,
+					  FuChunkArray *chunks,
+					  FuProgress *progress,
+					  GError **error)
+{
+	g_autofree guint8 *buf = g_malloc0(fu_thunderbolt_device_get_nvmem_page_size());
+
+	for (guint i = 0; i < fu_chunk_array_length(chunks); i++) {
+		g_autoptr(FuChunk) chk = fu_chunk_array_index(chunks, i, error);
+		if (chk == NULL)
+			return FALSE;
+		if (!fu_thunderbolt_device_nvmem_pverify(fd, chk, buf, error))
+			return FALSE;
+		fu_progress_set_percentage_full(progress,
+						(gsize)i + 1,
+						(gsize)fu_chunk_array_length(chunks));
 	}
 
 	/* success */
@@ -303,22 +385,83 @@ fu_thunderbolt_device_write_stream(GOutputStream *ostream,
 
 static gboolean
 fu_thunderbolt_device_write_data(FuThunderboltDevice *self,
-				 GBytes *blob_fw,
+				 GInputStream *stream,
 				 FuProgress *progress,
 				 GError **error)
 {
+	gint fd;
+	g_autofree gchar *fn = NULL;
+	g_autoptr(FuChunkArray) chunks = NULL;
 	g_autoptr(GFile) nvmem = NULL;
-	g_autoptr(GOutputStream) ostream = NULL;
 
+	/* progress */
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_WRITE, 80, NULL);
+	fu_progress_add_step(progress, FWUPD_STATUS_DEVICE_VERIFY, 20, NULL);
+
+	/* each chunk is read from the stream as required */
+	chunks = fu_chunk_array_new_from_stream(stream,
+						FU_CHUNK_ADDR_OFFSET_NONE,
+						FU_CHUNK_PAGESZ_NONE,
+						fu_thunderbolt_device_get_nvmem_page_size(),
+						error);
+	if (chunks == NULL)
+		return FALSE;
+
+	/* write */
 	nvmem = fu_thunderbolt_device_find_nvmem(self, FALSE, error);
 	if (nvmem == NULL)
 		return FALSE;
-	ostream = (GOutputStream *)g_file_append_to(nvmem, G_FILE_CREATE_NONE, NULL, error);
-	if (ostream == NULL)
+	fn = g_file_get_path(nvmem);
+	fd = open(fn, O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_PERMISSION_DENIED,
+			    "failed to open %s: %s",
+			    fn,
+			    g_strerror(errno));
+		return FALSE;
+	}
+	if (!fu_thunderbolt_device_nvmem_write_chunks(fd,
+						      chunks,
+						      fu_progress_get_child(progress),
+						      error)) {
+		g_close(fd, NULL);
+		return FALSE;
+	}
+	if (!g_close(fd, error))
+		return FALSE;
+	fu_progress_step_done(progress);
+
+	/* the kernel does not usually allow reading the non-active NVM */
+	if (!fu_device_has_private_flag(FU_DEVICE(self), FU_THUNDERBOLT_DEVICE_FLAG_VERIFY_NVMEM)) {
+		fu_progress_finished(progress);
+		return TRUE;
+	}
+	fd = open(fn, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_PERMISSION_DENIED,
+			    "failed to open %s: %s",
+			    fn,
+			    g_strerror(errno));
+		return FALSE;
+	}
+	if (!fu_thunderbolt_device_nvmem_verify_chunks(fd,
+						       chunks,
+						       fu_progress_get_child(progress),
+						       error)) {
+		g_close(fd, NULL);
 		return FALSE;
-	if (!fu_thunderbolt_device_write_stream(ostream, blob_fw, progress, error))
+	}
+	if (!g_close(fd, error))
 		return FALSE;
-	return g_output_stream_close(ostream, NULL, error);
+	fu_progress_step_done(progress);
+
+	/* success */
+	return TRUE;
 }
 
 static FuFirmware *
@@ -380,15 +523,14 @@ fu_thunderbolt_device_write_firmware(FuDevice *device,
 				     GError **error)
 {
 	FuThunderboltDevice *self = FU_THUNDERBOLT_DEVICE(device);
-	g_autoptr(GBytes) blob_fw = NULL;
+	g_autoptr(GInputStream) stream = NULL;
 
 	/* get default image */
-	blob_fw = fu_firmware_get_bytes(firmware, error);
-	if (blob_fw == NULL)
+	stream = fu_firmware_get_stream(firmware, error);
+	if (stream == NULL)
 		return FALSE;
 
-	fu_progress_set_status(progress, FWUPD_STATUS_DEVICE_WRITE);
-	if (!fu_thunderbolt_device_write_data(self, blob_fw, progress, error)) {
+	if (!fu_thunderbolt_device_write_data(self, stream, progress, error)) {
 		g_prefix_error(error,
 			       "could not write firmware to thunderbolt device at %s: ",
 			       fu_udev_device_get_sysfs_path(FU_UDEV_DEVICE(self)));
@@ -461,6 +603,7 @@ fu_thunderbolt_device_init(FuThunderboltDevice *self)
 	priv->retries = 50;
 	fu_device_add_icon(FU_DEVICE(self), "thunderbolt");
 	fu_device_add_protocol(FU_DEVICE(self), "com.intel.thunderbolt");
+	fu_device_register_private_flag(FU_DEVICE(self), FU_THUNDERBOLT_DEVICE_FLAG_VERIFY_NVMEM);
 }
 
 static void
@@ -40,29 +40,37 @@ fu_uefi_dbx_get_efi_arch(void)
 	return NULL;
 }
 
-static gchar *
-fu_uefi_dbx_get_authenticode_hash(const gchar *fn, GError **error)
+/* only computed once for each list, rather than once for each file on the ESP */
+static GHashTable *
+fu_uefi_dbx_signature_list_build_checksums(FuEfiSignatureList *siglist, GError **error)
 {
-	g_autoptr(FuFirmware) firmware = fu_pefile_firmware_new();
-	g_autoptr(GFile) file = g_file_new_for_path(fn);
-	if (!fu_firmware_parse_file(firmware, file, FWUPD_INSTALL_FLAG_NONE, error))
-		return NULL;
-	return fu_firmware_get_checksum(firmware, G_CHECKSUM_SHA256, error);
+	g_autoptr(GHashTable) checksums =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_autoptr(GPtrArray) imgs = fu_firmware_get_images(FU_FIRMWARE(siglist));
+
+	for (guint i = 0; i < imgs->len; i++) {
+		FuFirmware *img = g_ptr_array_index(imgs, i);
+		g_autofree gchar *checksum = NULL;
+
+		checksum = fu_firmware_get_checksum(img, G_CHECKSUM_SHA256, error);
+		if (checksum == NULL)
+			return NULL;
+		g_hash_table_add(checksums, g_steal_pointer(&checksum));
+	}
+	return g_steal_pointer(&checksums);
 }
 
 static gboolean
-fu_uefi_dbx_signature_list_validate_filename(FuContext *ctx,
-					     FuEfiSignatureList *siglist,
-					     const gchar *fn,
-					     FwupdInstallFlags flags,
-					     GError **error)
+fu_uefi_dbx_signature_list_validate_file(GHashTable *checksums,
+					 FuFirmware *esp_file,
+					 GError **error)
 {
+	const gchar *fn = fu_firmware_get_filename(esp_file);
 	g_autofree gchar *checksum = NULL;
-	g_autoptr(FuFirmware) img = NULL;
 	g_autoptr(GError) error_local = NULL;
 
-	/* get checksum of file */
-	checksum = fu_uefi_dbx_get_authenticode_hash(fn, &error_local);
+	/* the Authenticode hash was computed when the ESP file was loaded */
+	checksum = fu_firmware_get_checksum(esp_file, G_CHECKSUM_SHA256, &error_local);
 	if (checksum == NULL) {
 		g_debug("failed to get checksum for %s: %s", fn, error_local->message);
 		return TRUE;
@@ -70,8 +78,7 @@ fu_uefi_dbx_signature_list_validate_filename(FuContext *ctx,
 
 	/* Authenticode signature is present in dbx! */
 	g_debug("fn=%s, checksum=%s", fn, checksum);
-	img = fu_firmware_get_image_by_checksum(FU_FIRMWARE(siglist), checksum, NULL);
-	if (img != NULL) {
+	if (g_hash_table_contains(checksums, checksum)) {
 		g_set_error(error,
 			    FWUPD_ERROR,
 			    FWUPD_ERROR_NEEDS_USER_ACTION,
@@ -91,6 +98,7 @@ fu_uefi_dbx_signature_list_validate(FuContext *ctx,
 				    FwupdInstallFlags flags,
 				    GError **error)
 {
+	g_autoptr(GHashTable) checksums = NULL;
 	g_autoptr(GPtrArray) files = NULL;
 	g_autoptr(GError) error_local = NULL;
 
@@ -105,14 +113,14 @@ fu_uefi_dbx_signature_list_validate(FuContext *ctx,
 		g_propagate_error(error, g_steal_pointer(&error_local));
 		return FALSE;
 	}
+	if (files->len == 0)
+		return TRUE;
+	checksums = fu_uefi_dbx_signature_list_build_checksums(siglist, error);
+	if (checksums == NULL)
+		return FALSE;
 	for (guint i = 0; i < files->len; i++) {
-		FuFirmware *firmware = g_ptr_array_index(files, i);
-		if (!fu_uefi_dbx_signature_list_validate_filename(
-			ctx,
-			siglist,
-			fu_firmware_get_filename(firmware),
-			flags,
-			error))
+		FuFirmware *esp_file = g_ptr_array_index(files, i);
+		if (!fu_uefi_dbx_signature_list_validate_file(checksums, esp_file, error))
 			return FALSE;
 	}
 	return TRUE;
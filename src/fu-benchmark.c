@@ -0,0 +1,1152 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#define G_LOG_DOMAIN "FuBenchmark"
+
+#include "config.h"
+
+#include "fu-benchmark.h"
+#include "fu-device-list.h"
+#include "fu-efi-lz77-decompressor.h"
+
+/* all inputs are generated from fixed patterns so that results are comparable between runs */
+#define FU_BENCHMARK_CHECKSUM_BUFSZ   0x10000 /* bytes */
+#define FU_BENCHMARK_QUIRK_LOOKUPS    1000
+#define FU_BENCHMARK_DEVICE_LIST_SIZE 1000
+#define FU_BENCHMARK_SILO_COMPONENTS  1000
+#define FU_BENCHMARK_EMULATION_EVENTS 1000
+#define FU_BENCHMARK_CAB_WRITE_BUFSZ  0x400000 /* bytes */
+#define FU_BENCHMARK_VERSION_SORT     10000
+
+typedef struct {
+	gchar *id;
+	guint64 bytes;	    /* per iteration, or 0 */
+	guint64 operations; /* per iteration */
+	FuBenchmarkFunc func;
+	gpointer user_data;
+	GDestroyNotify user_data_free;
+	GArray *samples; /* of gint64, in µs */
+} FuBenchmarkItem;
+
+struct _FuBenchmark {
+	GObject parent_instance;
+	GPtrArray *items; /* of FuBenchmarkItem */
+	gchar *pattern;
+	guint iterations;
+};
+
+static void
+fu_benchmark_codec_iface_init(FwupdCodecInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(FuBenchmark,
+			fu_benchmark,
+			G_TYPE_OBJECT,
+			G_IMPLEMENT_INTERFACE(FWUPD_TYPE_CODEC, fu_benchmark_codec_iface_init))
+
+static void
+fu_benchmark_item_free(FuBenchmarkItem *item)
+{
+	if (item->user_data_free != NULL)
+		item->user_data_free(item->user_data);
+	g_array_unref(item->samples);
+	g_free(item->id);
+	g_free(item);
+}
+
+static gint
+fu_benchmark_sample_sort_cb(gconstpointer a, gconstpointer b)
+{
+	gint64 val_a = *((const gint64 *)a);
+	gint64 val_b = *((const gint64 *)b);
+	if (val_a < val_b)
+		return -1;
+	if (val_a > val_b)
+		return 1;
+	return 0;
+}
+
+/* samples are sorted after the run completes */
+static gint64
+fu_benchmark_item_get_min(FuBenchmarkItem *item)
+{
+	if (item->samples->len == 0)
+		return 0;
+	return g_array_index(item->samples, gint64, 0);
+}
+
+static gint64
+fu_benchmark_item_get_max(FuBenchmarkItem *item)
+{
+	if (item->samples->len == 0)
+		return 0;
+	return g_array_index(item->samples, gint64, item->samples->len - 1);
+}
+
+/**
+ * fu_benchmark_samples_get_median:
+ * @samples: (element-type gint64): sorted samples
+ *
+ * Gets the median of the samples, averaging the two middle samples for an even count.
+ *
+ * Returns: integer, or 0 if there are no samples
+ **/
+gint64
+fu_benchmark_samples_get_median(GArray *samples)
+{
+	guint idx = samples->len / 2;
+	if (samples->len == 0)
+		return 0;
+	if (samples->len % 2 == 0) {
+		return (g_array_index(samples, gint64, idx - 1) +
+			g_array_index(samples, gint64, idx)) /
+		       2;
+	}
+	return g_array_index(samples, gint64, idx);
+}
+
+static gint64
+fu_benchmark_item_get_median(FuBenchmarkItem *item)
+{
+	return fu_benchmark_samples_get_median(item->samples);
+}
+
+static gint64
+fu_benchmark_item_get_total(FuBenchmarkItem *item)
+{
+	gint64 total = 0;
+	for (guint i = 0; i < item->samples->len; i++)
+		total += g_array_index(item->samples, gint64, i);
+	return total;
+}
+
+static gint64
+fu_benchmark_item_get_mean(FuBenchmarkItem *item)
+{
+	if (item->samples->len == 0)
+		return 0;
+	return fu_benchmark_item_get_total(item) / item->samples->len;
+}
+
+/* per second, using the median so that a single descheduled iteration does not skew it */
+static guint64
+fu_benchmark_item_get_rate(FuBenchmarkItem *item, guint64 value)
+{
+	gint64 median = fu_benchmark_item_get_median(item);
+	if (median <= 0)
+		return 0;
+	return (value * G_USEC_PER_SEC) / (guint64)median;
+}
+
+static void
+fu_benchmark_add_string(FwupdCodec *codec, guint idt, GString *str)
+{
+	FuBenchmark *self = FU_BENCHMARK(codec);
+	fwupd_codec_string_append_int(str, idt, "Iterations", self->iterations);
+	for (guint i = 0; i < self->items->len; i++) {
+		FuBenchmarkItem *item = g_ptr_array_index(self->items, i);
+		fwupd_codec_string_append(str, idt, "Id", item->id);
+		fwupd_codec_string_append_int(str,
+					      idt + 1,
+					      "MedianUsec",
+					      fu_benchmark_item_get_median(item));
+		fwupd_codec_string_append_int(str, idt + 1, "MinUsec", fu_benchmark_item_get_min(item));
+		fwupd_codec_string_append_int(str, idt + 1, "MaxUsec", fu_benchmark_item_get_max(item));
+		fwupd_codec_string_append_int(str,
+					      idt + 1,
+					      "OperationsPerSec",
+					      fu_benchmark_item_get_rate(item, item->operations));
+		if (item->bytes > 0) {
+			fwupd_codec_string_append_size(str,
+						       idt + 1,
+						       "BytesPerSec",
+						       fu_benchmark_item_get_rate(item, item->bytes));
+		}
+	}
+}
+
+static void
+fu_benchmark_add_json(FwupdCodec *codec, JsonBuilder *builder, FwupdCodecFlags flags)
+{
+	FuBenchmark *self = FU_BENCHMARK(codec);
+
+	fwupd_codec_json_append(builder, "FwupdVersion", PACKAGE_VERSION);
+	fwupd_codec_json_append_int(builder, "Iterations", self->iterations);
+	json_builder_set_member_name(builder, "Benchmarks");
+	json_builder_begin_array(builder);
+	for (guint i = 0; i < self->items->len; i++) {
+		FuBenchmarkItem *item = g_ptr_array_index(self->items, i);
+		json_builder_begin_object(builder);
+		fwupd_codec_json_append(builder, "Id", item->id);
+		fwupd_codec_json_append_int(builder, "Iterations", item->samples->len);
+		fwupd_codec_json_append_int(builder, "Operations", item->operations);
+		if (item->bytes > 0)
+			fwupd_codec_json_append_int(builder, "Bytes", item->bytes);
+		fwupd_codec_json_append_int(builder, "MinUsec", fu_benchmark_item_get_min(item));
+		fwupd_codec_json_append_int(builder, "MaxUsec", fu_benchmark_item_get_max(item));
+		fwupd_codec_json_append_int(builder,
+					    "MedianUsec",
+					    fu_benchmark_item_get_median(item));
+		fwupd_codec_json_append_int(builder, "MeanUsec", fu_benchmark_item_get_mean(item));
+		fwupd_codec_json_append_int(builder, "TotalUsec", fu_benchmark_item_get_total(item));
+		fwupd_codec_json_append_int(builder,
+					    "OperationsPerSec",
+					    fu_benchmark_item_get_rate(item, item->operations));
+		if (item->bytes > 0) {
+			fwupd_codec_json_append_int(builder,
+						    "BytesPerSec",
+						    fu_benchmark_item_get_rate(item, item->bytes));
+		}
+		json_builder_end_object(builder);
+	}
+	json_builder_end_array(builder);
+}
+
+static void
+fu_benchmark_codec_iface_init(FwupdCodecInterface *iface)
+{
+	iface->add_string = fu_benchmark_add_string;
+	iface->add_json = fu_benchmark_add_json;
+}
+
+/**
+ * fu_benchmark_set_pattern:
+ * @self: a #FuBenchmark
+ * @pattern: a glob pattern, e.g. `firmware-parse:*`
+ *
+ * Only adds benchmarks with an ID that matches the pattern.
+ **/
+void
+fu_benchmark_set_pattern(FuBenchmark *self, const gchar *pattern)
+{
+	g_return_if_fail(FU_IS_BENCHMARK(self));
+	g_free(self->pattern);
+	self->pattern = g_strdup(pattern);
+}
+
+static gboolean
+fu_benchmark_matches(FuBenchmark *self, const gchar *id)
+{
+	if (self->pattern == NULL)
+		return TRUE;
+	return g_pattern_match_simple(self->pattern, id);
+}
+
+/**
+ * fu_benchmark_add:
+ * @self: a #FuBenchmark
+ * @id: a stable benchmark ID, e.g. `crc32`
+ * @bytes: number of bytes processed per iteration, or 0 if not applicable
+ * @operations: number of operations performed per iteration
+ * @func: the function to run for each iteration
+ * @user_data: data passed to @func
+ * @user_data_free: (nullable): a function to free @user_data
+ *
+ * Adds a benchmark. If the ID does not match the pattern then @user_data is freed immediately.
+ **/
+void
+fu_benchmark_add(FuBenchmark *self,
+		 const gchar *id,
+		 guint64 bytes,
+		 guint64 operations,
+		 FuBenchmarkFunc func,
+		 gpointer user_data,
+		 GDestroyNotify user_data_free)
+{
+	FuBenchmarkItem *item;
+
+	g_return_if_fail(FU_IS_BENCHMARK(self));
+	g_return_if_fail(id != NULL);
+	g_return_if_fail(func != NULL);
+
+	if (!fu_benchmark_matches(self, id)) {
+		if (user_data_free != NULL)
+			user_data_free(user_data);
+		return;
+	}
+	item = g_new0(FuBenchmarkItem, 1);
+	item->id = g_strdup(id);
+	item->bytes = bytes;
+	item->operations = MAX(operations, 1);
+	item->func = func;
+	item->user_data = user_data;
+	item->user_data_free = user_data_free;
+	item->samples = g_array_new(FALSE, FALSE, sizeof(gint64));
+	g_ptr_array_add(self->items, item);
+}
+
+/**
+ * fu_benchmark_get_size:
+ * @self: a #FuBenchmark
+ *
+ * Gets the number of benchmarks that will be run.
+ *
+ * Returns: integer
+ **/
+guint
+fu_benchmark_get_size(FuBenchmark *self)
+{
+	g_return_val_if_fail(FU_IS_BENCHMARK(self), 0);
+	return self->items->len;
+}
+
+static gboolean
+fu_benchmark_item_run(FuBenchmark *self, FuBenchmarkItem *item, GError **error)
+{
+	/* warm up caches and any lazy initialization, not timed */
+	if (!item->func(item->user_data, error)) {
+		g_prefix_error(error, "%s: ", item->id);
+		return FALSE;
+	}
+	for (guint i = 0; i < self->iterations; i++) {
+		gint64 start = g_get_monotonic_time();
+		gint64 duration;
+		if (!item->func(item->user_data, error)) {
+			g_prefix_error(error, "%s: ", item->id);
+			return FALSE;
+		}
+		duration = g_get_monotonic_time() - start;
+		g_array_append_val(item->samples, duration);
+	}
+	g_array_sort(item->samples, fu_benchmark_sample_sort_cb);
+	return TRUE;
+}
+
+/**
+ * fu_benchmark_run:
+ * @self: a #FuBenchmark
+ * @progress: a #FuProgress
+ * @error: (nullable): optional return location for an error
+ *
+ * Runs all the added benchmarks in the order they were added.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_benchmark_run(FuBenchmark *self, FuProgress *progress, GError **error)
+{
+	g_return_val_if_fail(FU_IS_BENCHMARK(self), FALSE);
+	g_return_val_if_fail(FU_IS_PROGRESS(progress), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (self->items->len == 0) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_NOTHING_TO_DO,
+				    "no benchmarks matched");
+		return FALSE;
+	}
+	fu_progress_set_id(progress, G_STRLOC);
+	fu_progress_set_steps(progress, self->items->len);
+	for (guint i = 0; i < self->items->len; i++) {
+		FuBenchmarkItem *item = g_ptr_array_index(self->items, i);
+		g_array_set_size(item->samples, 0);
+		if (!fu_benchmark_item_run(self, item, error))
+			return FALSE;
+		g_debug("%s: median %" G_GINT64_FORMAT "us",
+			item->id,
+			fu_benchmark_item_get_median(item));
+		fu_progress_step_done(progress);
+	}
+	return TRUE;
+}
+
+typedef struct {
+	GType gtype;
+	GBytes *blob;
+} FuBenchmarkFirmwareHelper;
+
+static void
+fu_benchmark_firmware_helper_free(FuBenchmarkFirmwareHelper *helper)
+{
+	g_bytes_unref(helper->blob);
+	g_free(helper);
+}
+
+static gboolean
+fu_benchmark_firmware_parse_cb(gpointer user_data, GError **error)
+{
+	FuBenchmarkFirmwareHelper *helper = (FuBenchmarkFirmwareHelper *)user_data;
+	g_autoptr(FuFirmware) firmware = g_object_new(helper->gtype, NULL);
+	return fu_firmware_parse_bytes(firmware,
+				       helper->blob,
+				       0x0,
+				       FWUPD_INSTALL_FLAG_NO_SEARCH,
+				       error);
+}
+
+/* returns a hash of GType name:XbNode for every builder file in @builder_dir */
+static GHashTable *
+fu_benchmark_load_builder_dir(const gchar *builder_dir, GPtrArray *silos, GError **error)
+{
+	const gchar *fn;
+	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GHashTable) nodes =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_object_unref);
+
+	dir = g_dir_open(builder_dir, 0, error);
+	if (dir == NULL)
+		return NULL;
+	while ((fn = g_dir_read_name(dir)) != NULL) {
+		const gchar *gtype_name;
+		g_autofree gchar *filename = NULL;
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(XbBuilder) builder = xb_builder_new();
+		g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+		g_autoptr(XbNode) n = NULL;
+		g_autoptr(XbSilo) silo = NULL;
+		g_autoptr(GFile) file = NULL;
+
+		if (!g_str_has_suffix(fn, ".builder.xml"))
+			continue;
+		filename = g_build_filename(builder_dir, fn, NULL);
+		file = g_file_new_for_path(filename);
+		if (!xb_builder_source_load_file(source,
+						 file,
+						 XB_BUILDER_SOURCE_FLAG_NONE,
+						 NULL,
+						 &error_local)) {
+			g_debug("ignoring %s: %s", fn, error_local->message);
+			continue;
+		}
+		xb_builder_import_source(builder, source);
+		silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, &error_local);
+		if (silo == NULL) {
+			g_debug("ignoring %s: %s", fn, error_local->message);
+			continue;
+		}
+		n = xb_silo_query_first(silo, "firmware", NULL);
+		if (n == NULL)
+			continue;
+		gtype_name = xb_node_get_attr(n, "gtype");
+		if (gtype_name == NULL || g_hash_table_contains(nodes, gtype_name))
+			continue;
+		g_hash_table_insert(nodes, g_strdup(gtype_name), g_steal_pointer(&n));
+		g_ptr_array_add(silos, g_steal_pointer(&silo));
+	}
+	return g_steal_pointer(&nodes);
+}
+
+/* either built from a builder file, or the default-constructed image written out */
+static GBytes *
+fu_benchmark_firmware_build_blob(GType gtype, XbNode *n, GError **error)
+{
+	g_autoptr(FuFirmware) firmware = g_object_new(gtype, NULL);
+	g_autoptr(FuFirmware) firmware_tmp = g_object_new(gtype, NULL);
+	g_autoptr(GBytes) blob = NULL;
+
+	if (n != NULL) {
+		if (!fu_firmware_build(firmware, n, error))
+			return NULL;
+	}
+	blob = fu_firmware_write(firmware, error);
+	if (blob == NULL)
+		return NULL;
+	if (g_bytes_get_size(blob) == 0) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "empty image");
+		return NULL;
+	}
+
+	/* check it round-trips, otherwise every iteration would fail */
+	if (!fu_firmware_parse_bytes(firmware_tmp, blob, 0x0, FWUPD_INSTALL_FLAG_NO_SEARCH, error))
+		return NULL;
+	return g_steal_pointer(&blob);
+}
+
+static gboolean
+fu_benchmark_add_firmware_parsers(FuBenchmark *self,
+				  FuContext *ctx,
+				  const gchar *builder_dir,
+				  GError **error)
+{
+	g_autoptr(GArray) gtypes = fu_context_get_firmware_gtypes(ctx);
+	g_autoptr(GHashTable) nodes = NULL;
+	g_autoptr(GPtrArray) silos = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+
+	if (builder_dir != NULL) {
+		nodes = fu_benchmark_load_builder_dir(builder_dir, silos, error);
+		if (nodes == NULL)
+			return FALSE;
+	}
+	for (guint i = 0; i < gtypes->len; i++) {
+		GType gtype = g_array_index(gtypes, GType, i);
+		FuBenchmarkFirmwareHelper *helper;
+		XbNode *n = NULL;
+		g_autofree gchar *id = g_strdup_printf("firmware-parse:%s", g_type_name(gtype));
+		g_autoptr(GBytes) blob = NULL;
+		g_autoptr(GError) error_local = NULL;
+
+		if (!fu_benchmark_matches(self, id))
+			continue;
+		if (nodes != NULL)
+			n = g_hash_table_lookup(nodes, g_type_name(gtype));
+		blob = fu_benchmark_firmware_build_blob(gtype, n, &error_local);
+		if (blob == NULL) {
+			g_debug("no benchmark input for %s: %s",
+				g_type_name(gtype),
+				error_local->message);
+			continue;
+		}
+		helper = g_new0(FuBenchmarkFirmwareHelper, 1);
+		helper->gtype = gtype;
+		helper->blob = g_bytes_ref(blob);
+		fu_benchmark_add(self,
+				 id,
+				 g_bytes_get_size(blob),
+				 1,
+				 fu_benchmark_firmware_parse_cb,
+				 helper,
+				 (GDestroyNotify)fu_benchmark_firmware_helper_free);
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_crc32_cb(gpointer user_data, GError **error)
+{
+	GBytes *blob = (GBytes *)user_data;
+	volatile guint32 csum = fu_crc32_bytes(FU_CRC_KIND_B32_STANDARD, blob);
+	(void)csum;
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_crc16_cb(gpointer user_data, GError **error)
+{
+	GBytes *blob = (GBytes *)user_data;
+	volatile guint16 csum = fu_crc16_bytes(FU_CRC_KIND_B16_XMODEM, blob);
+	(void)csum;
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_crc8_cb(gpointer user_data, GError **error)
+{
+	GBytes *blob = (GBytes *)user_data;
+	volatile guint8 csum = fu_crc8_bytes(FU_CRC_KIND_B8_STANDARD, blob);
+	(void)csum;
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_sum8_cb(gpointer user_data, GError **error)
+{
+	GBytes *blob = (GBytes *)user_data;
+	volatile guint8 csum = fu_sum8_bytes(blob);
+	(void)csum;
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_sum16_cb(gpointer user_data, GError **error)
+{
+	GBytes *blob = (GBytes *)user_data;
+	volatile guint16 csum = fu_sum16_bytes(blob);
+	(void)csum;
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_sum32_cb(gpointer user_data, GError **error)
+{
+	GBytes *blob = (GBytes *)user_data;
+	volatile guint32 csum = fu_sum32_bytes(blob);
+	(void)csum;
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_sha1_cb(gpointer user_data, GError **error)
+{
+	GBytes *blob = (GBytes *)user_data;
+	g_autofree gchar *csum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA1, blob);
+	return csum != NULL;
+}
+
+static gboolean
+fu_benchmark_sha256_cb(gpointer user_data, GError **error)
+{
+	GBytes *blob = (GBytes *)user_data;
+	g_autofree gchar *csum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, blob);
+	return csum != NULL;
+}
+
+static void
+fu_benchmark_add_checksums(FuBenchmark *self)
+{
+	struct {
+		const gchar *id;
+		FuBenchmarkFunc func;
+	} map[] = {{"checksum:crc32", fu_benchmark_crc32_cb},
+		   {"checksum:crc16", fu_benchmark_crc16_cb},
+		   {"checksum:crc8", fu_benchmark_crc8_cb},
+		   {"checksum:sum8", fu_benchmark_sum8_cb},
+		   {"checksum:sum16", fu_benchmark_sum16_cb},
+		   {"checksum:sum32", fu_benchmark_sum32_cb},
+		   {"checksum:sha1", fu_benchmark_sha1_cb},
+		   {"checksum:sha256", fu_benchmark_sha256_cb},
+		   {NULL, NULL}};
+	g_autofree guint8 *buf = g_malloc(FU_BENCHMARK_CHECKSUM_BUFSZ);
+	g_autoptr(GBytes) blob = NULL;
+
+	for (gsize i = 0; i < FU_BENCHMARK_CHECKSUM_BUFSZ; i++)
+		buf[i] = (guint8)((i * 31) ^ (i >> 8));
+	blob = g_bytes_new_take(g_steal_pointer(&buf), FU_BENCHMARK_CHECKSUM_BUFSZ);
+	for (guint i = 0; map[i].id != NULL; i++) {
+		fu_benchmark_add(self,
+				 map[i].id,
+				 FU_BENCHMARK_CHECKSUM_BUFSZ,
+				 1,
+				 map[i].func,
+				 g_bytes_ref(blob),
+				 (GDestroyNotify)g_bytes_unref);
+	}
+}
+
+static gboolean
+fu_benchmark_efi_lz77_cb(gpointer user_data, GError **error)
+{
+	GBytes *blob = (GBytes *)user_data;
+	g_autoptr(FuFirmware) firmware = fu_efi_lz77_decompressor_new();
+	return fu_firmware_parse_bytes(firmware, blob, 0x0, FWUPD_INSTALL_FLAG_NONE, error);
+}
+
+/* the compressed test vector is not a builder file, so it is only used if present */
+static void
+fu_benchmark_add_decompressors(FuBenchmark *self, const gchar *builder_dir)
+{
+	g_autofree gchar *fn = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	if (builder_dir == NULL || !fu_benchmark_matches(self, "decompress:efi-lz77"))
+		return;
+	fn = g_build_filename(builder_dir, "efi-lz77-tiano.bin", NULL);
+	blob = fu_bytes_get_contents(fn, &error_local);
+	if (blob == NULL) {
+		g_debug("no benchmark input for EFI LZ77: %s", error_local->message);
+		return;
+	}
+	fu_benchmark_add(self,
+			 "decompress:efi-lz77",
+			 g_bytes_get_size(blob),
+			 1,
+			 fu_benchmark_efi_lz77_cb,
+			 g_bytes_ref(blob),
+			 (GDestroyNotify)g_bytes_unref);
+}
+
+static gboolean
+fu_benchmark_cab_write_cb(gpointer user_data, GError **error)
+{
+	FuCabFirmware *cab = FU_CAB_FIRMWARE(user_data);
+	g_autoptr(GBytes) blob = fu_firmware_write(FU_FIRMWARE(cab), error);
+	return blob != NULL;
+}
+
+/* MSZIP compression, using one thread and then one thread per CPU */
+static gboolean
+fu_benchmark_add_cab_write(FuBenchmark *self, GError **error)
+{
+	struct {
+		const gchar *id;
+		guint max_threads;
+	} map[] = {{"cab-write:serial", 1}, {"cab-write:parallel", 0}, {NULL, 0}};
+	g_autofree guint8 *buf = NULL;
+	g_autoptr(GBytes) blob = NULL;
+
+	if (!fu_benchmark_matches(self, "cab-write:*"))
+		return TRUE;
+
+	/* something that compresses, but not to nothing */
+	buf = g_malloc(FU_BENCHMARK_CAB_WRITE_BUFSZ);
+	for (gsize i = 0; i < FU_BENCHMARK_CAB_WRITE_BUFSZ; i++)
+		buf[i] = (guint8)((i * 31) ^ (i >> 11) ^ (i >> 19));
+	blob = g_bytes_new_take(g_steal_pointer(&buf), FU_BENCHMARK_CAB_WRITE_BUFSZ);
+	for (guint i = 0; map[i].id != NULL; i++) {
+		g_autoptr(FuCabFirmware) cab = fu_cab_firmware_new();
+		g_autoptr(FuCabImage) img = fu_cab_image_new();
+
+		if (!fu_benchmark_matches(self, map[i].id))
+			continue;
+		fu_firmware_set_id(FU_FIRMWARE(img), "firmware.bin");
+		fu_firmware_set_bytes(FU_FIRMWARE(img), blob);
+		if (!fu_firmware_add_image_full(FU_FIRMWARE(cab), FU_FIRMWARE(img), error))
+			return FALSE;
+		fu_cab_firmware_set_compressed(cab, TRUE);
+		fu_cab_firmware_set_max_threads(cab, map[i].max_threads);
+		fu_benchmark_add(self,
+				 map[i].id,
+				 FU_BENCHMARK_CAB_WRITE_BUFSZ,
+				 1,
+				 fu_benchmark_cab_write_cb,
+				 g_steal_pointer(&cab),
+				 (GDestroyNotify)g_object_unref);
+	}
+	return TRUE;
+}
+
+typedef struct {
+	GPtrArray *strs; /* of utf-8 */
+	GPtrArray *keys; /* of FuVersionKey */
+} FuBenchmarkVersionHelper;
+
+static void
+fu_benchmark_version_helper_free(FuBenchmarkVersionHelper *helper)
+{
+	g_ptr_array_unref(helper->strs);
+	g_ptr_array_unref(helper->keys);
+	g_free(helper);
+}
+
+static gint
+fu_benchmark_version_str_sort_cb(gconstpointer a, gconstpointer b)
+{
+	const gchar *str_a = *((const gchar **)a);
+	const gchar *str_b = *((const gchar **)b);
+	return fu_version_compare(str_a, str_b, FWUPD_VERSION_FORMAT_TRIPLET);
+}
+
+static gint
+fu_benchmark_version_key_sort_cb(gconstpointer a, gconstpointer b)
+{
+	const FuVersionKey *key_a = *((const FuVersionKey **)a);
+	const FuVersionKey *key_b = *((const FuVersionKey **)b);
+	return fu_version_key_compare(key_a, key_b);
+}
+
+/* each iteration sorts a shallow copy, as sorting an already sorted array would be quicker */
+static gboolean
+fu_benchmark_version_sort_str_cb(gpointer user_data, GError **error)
+{
+	FuBenchmarkVersionHelper *helper = (FuBenchmarkVersionHelper *)user_data;
+	g_autoptr(GPtrArray) array = g_ptr_array_copy(helper->strs, NULL, NULL);
+	g_ptr_array_set_free_func(array, NULL);
+	g_ptr_array_sort(array, fu_benchmark_version_str_sort_cb);
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_version_sort_key_cb(gpointer user_data, GError **error)
+{
+	FuBenchmarkVersionHelper *helper = (FuBenchmarkVersionHelper *)user_data;
+	g_autoptr(GPtrArray) array = g_ptr_array_copy(helper->keys, NULL, NULL);
+	g_ptr_array_set_free_func(array, NULL);
+	g_ptr_array_sort(array, fu_benchmark_version_key_sort_cb);
+	return TRUE;
+}
+
+static FuBenchmarkVersionHelper *
+fu_benchmark_version_helper_new(void)
+{
+	FuBenchmarkVersionHelper *helper = g_new0(FuBenchmarkVersionHelper, 1);
+	helper->strs = g_ptr_array_new_with_free_func(g_free);
+	helper->keys = g_ptr_array_new_with_free_func((GDestroyNotify)fu_version_key_free);
+	for (guint i = 0; i < FU_BENCHMARK_VERSION_SORT; i++) {
+		g_autofree gchar *str =
+		    g_strdup_printf("%u.%u.%u", (i * 7) % 10, (i * 13) % 100, (i * 31) % 1000);
+		g_ptr_array_add(helper->keys, fu_version_key_new(str, FWUPD_VERSION_FORMAT_TRIPLET));
+		g_ptr_array_add(helper->strs, g_steal_pointer(&str));
+	}
+	return helper;
+}
+
+/* sorting a long release history, either comparing strings or the pre-parsed keys */
+static void
+fu_benchmark_add_version_sort(FuBenchmark *self)
+{
+	if (fu_benchmark_matches(self, "version-sort:string")) {
+		fu_benchmark_add(self,
+				 "version-sort:string",
+				 0,
+				 FU_BENCHMARK_VERSION_SORT,
+				 fu_benchmark_version_sort_str_cb,
+				 fu_benchmark_version_helper_new(),
+				 (GDestroyNotify)fu_benchmark_version_helper_free);
+	}
+	if (fu_benchmark_matches(self, "version-sort:key")) {
+		fu_benchmark_add(self,
+				 "version-sort:key",
+				 0,
+				 FU_BENCHMARK_VERSION_SORT,
+				 fu_benchmark_version_sort_key_cb,
+				 fu_benchmark_version_helper_new(),
+				 (GDestroyNotify)fu_benchmark_version_helper_free);
+	}
+}
+
+typedef struct {
+	FuContext *ctx;
+	GPtrArray *guids; /* of utf-8 */
+} FuBenchmarkQuirkHelper;
+
+static void
+fu_benchmark_quirk_helper_free(FuBenchmarkQuirkHelper *helper)
+{
+	g_object_unref(helper->ctx);
+	g_ptr_array_unref(helper->guids);
+	g_free(helper);
+}
+
+static gboolean
+fu_benchmark_quirk_lookup_cb(gpointer user_data, GError **error)
+{
+	FuBenchmarkQuirkHelper *helper = (FuBenchmarkQuirkHelper *)user_data;
+	for (guint i = 0; i < helper->guids->len; i++) {
+		const gchar *guid = g_ptr_array_index(helper->guids, i);
+		if (fu_context_lookup_quirk_by_id(helper->ctx, guid, "Plugin") != NULL) {
+			g_set_error(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INTERNAL,
+				    "unexpected quirk match for %s",
+				    guid);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static void
+fu_benchmark_add_quirks(FuBenchmark *self, FuContext *ctx)
+{
+	FuBenchmarkQuirkHelper *helper = g_new0(FuBenchmarkQuirkHelper, 1);
+
+	/* all misses, as that is the common case when probing devices */
+	helper->ctx = g_object_ref(ctx);
+	helper->guids = g_ptr_array_new_with_free_func(g_free);
+	for (guint i = 0; i < FU_BENCHMARK_QUIRK_LOOKUPS; i++) {
+		g_autofree gchar *instance_id =
+		    g_strdup_printf("USB\\VID_%04X&PID_%04X", 0x0000, 0x1000 + i);
+		g_ptr_array_add(helper->guids, fwupd_guid_hash_string(instance_id));
+	}
+	fu_benchmark_add(self,
+			 "quirk-lookup",
+			 0,
+			 FU_BENCHMARK_QUIRK_LOOKUPS,
+			 fu_benchmark_quirk_lookup_cb,
+			 helper,
+			 (GDestroyNotify)fu_benchmark_quirk_helper_free);
+}
+
+typedef struct {
+	FuDeviceList *device_list;
+	GPtrArray *device_ids; /* of utf-8 */
+	GPtrArray *guids;      /* of utf-8 */
+} FuBenchmarkDeviceListHelper;
+
+static void
+fu_benchmark_device_list_helper_free(FuBenchmarkDeviceListHelper *helper)
+{
+	g_object_unref(helper->device_list);
+	g_ptr_array_unref(helper->device_ids);
+	g_ptr_array_unref(helper->guids);
+	g_free(helper);
+}
+
+static gboolean
+fu_benchmark_device_list_by_id_cb(gpointer user_data, GError **error)
+{
+	FuBenchmarkDeviceListHelper *helper = (FuBenchmarkDeviceListHelper *)user_data;
+	for (guint i = 0; i < helper->device_ids->len; i++) {
+		const gchar *device_id = g_ptr_array_index(helper->device_ids, i);
+		g_autoptr(FuDevice) device =
+		    fu_device_list_get_by_id(helper->device_list, device_id, error);
+		if (device == NULL)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_benchmark_device_list_by_guid_cb(gpointer user_data, GError **error)
+{
+	FuBenchmarkDeviceListHelper *helper = (FuBenchmarkDeviceListHelper *)user_data;
+	for (guint i = 0; i < helper->guids->len; i++) {
+		const gchar *guid = g_ptr_array_index(helper->guids, i);
+		g_autoptr(FuDevice) device =
+		    fu_device_list_get_by_guid(helper->device_list, guid, error);
+		if (device == NULL)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static FuBenchmarkDeviceListHelper *
+fu_benchmark_device_list_helper_new(FuContext *ctx)
+{
+	FuBenchmarkDeviceListHelper *helper = g_new0(FuBenchmarkDeviceListHelper, 1);
+
+	helper->device_list = fu_device_list_new();
+	helper->device_ids = g_ptr_array_new_with_free_func(g_free);
+	helper->guids = g_ptr_array_new_with_free_func(g_free);
+	for (guint i = 0; i < FU_BENCHMARK_DEVICE_LIST_SIZE; i++) {
+		g_autofree gchar *id = g_strdup_printf("benchmark-%04u", i);
+		g_autofree gchar *instance_id = g_strdup_printf("BENCHMARK\\ID_%04u", i);
+		g_autoptr(FuDevice) device = fu_device_new(ctx);
+		fu_device_set_id(device, id);
+		fu_device_add_instance_id(device, instance_id);
+		fu_device_list_add(helper->device_list, device);
+		g_ptr_array_add(helper->device_ids, g_strdup(fu_device_get_id(device)));
+		g_ptr_array_add(helper->guids, fwupd_guid_hash_string(instance_id));
+	}
+	return helper;
+}
+
+static void
+fu_benchmark_add_device_list(FuBenchmark *self, FuContext *ctx)
+{
+	if (fu_benchmark_matches(self, "device-list:by-id")) {
+		fu_benchmark_add(self,
+				 "device-list:by-id",
+				 0,
+				 FU_BENCHMARK_DEVICE_LIST_SIZE,
+				 fu_benchmark_device_list_by_id_cb,
+				 fu_benchmark_device_list_helper_new(ctx),
+				 (GDestroyNotify)fu_benchmark_device_list_helper_free);
+	}
+	if (fu_benchmark_matches(self, "device-list:by-guid")) {
+		fu_benchmark_add(self,
+				 "device-list:by-guid",
+				 0,
+				 FU_BENCHMARK_DEVICE_LIST_SIZE,
+				 fu_benchmark_device_list_by_guid_cb,
+				 fu_benchmark_device_list_helper_new(ctx),
+				 (GDestroyNotify)fu_benchmark_device_list_helper_free);
+	}
+}
+
+typedef struct {
+	XbSilo *silo;
+	XbQuery *query;
+	GPtrArray *guids; /* of utf-8 */
+} FuBenchmarkSiloHelper;
+
+static void
+fu_benchmark_silo_helper_free(FuBenchmarkSiloHelper *helper)
+{
+	if (helper->query != NULL)
+		g_object_unref(helper->query);
+	if (helper->silo != NULL)
+		g_object_unref(helper->silo);
+	g_ptr_array_unref(helper->guids);
+	g_free(helper);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuBenchmarkSiloHelper, fu_benchmark_silo_helper_free)
+
+static gboolean
+fu_benchmark_silo_query_cb(gpointer user_data, GError **error)
+{
+	FuBenchmarkSiloHelper *helper = (FuBenchmarkSiloHelper *)user_data;
+	for (guint i = 0; i < helper->guids->len; i++) {
+		const gchar *guid = g_ptr_array_index(helper->guids, i);
+		g_autoptr(GPtrArray) components = NULL;
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+
+		xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
+		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
+		components = xb_silo_query_with_context(helper->silo, helper->query, &context, error);
+		if (components == NULL)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* same shape and indexes as the metadata silo built by the engine */
+static gboolean
+fu_benchmark_add_silo(FuBenchmark *self, GError **error)
+{
+	g_autoptr(FuBenchmarkSiloHelper) helper = NULL;
+	g_autoptr(GString) xml = g_string_new("<components>");
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+
+	if (!fu_benchmark_matches(self, "silo-query"))
+		return TRUE;
+
+	helper = g_new0(FuBenchmarkSiloHelper, 1);
+	helper->guids = g_ptr_array_new_with_free_func(g_free);
+	for (guint i = 0; i < FU_BENCHMARK_SILO_COMPONENTS; i++) {
+		g_autofree gchar *instance_id = g_strdup_printf("BENCHMARK\\ID_%04u", i);
+		g_autofree gchar *guid = fwupd_guid_hash_string(instance_id);
+		g_string_append_printf(xml,
+				       "<component type=\"firmware\">"
+				       "<id>org.fwupd.benchmark.id%04u</id>"
+				       "<provides><firmware type=\"flashed\">%s</firmware></provides>"
+				       "<releases><release version=\"1.2.%u\">"
+				       "<checksum type=\"sha1\" target=\"container\">%040x</checksum>"
+				       "</release></releases>"
+				       "</component>",
+				       i,
+				       guid,
+				       i,
+				       i);
+		g_ptr_array_add(helper->guids, g_steal_pointer(&guid));
+	}
+	g_string_append(xml, "</components>");
+	if (!xb_builder_source_load_xml(source, xml->str, XB_BUILDER_SOURCE_FLAG_NONE, error))
+		return FALSE;
+	xb_builder_import_source(builder, source);
+	helper->silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, error);
+	if (helper->silo == NULL)
+		return FALSE;
+	if (!xb_silo_query_build_index(helper->silo,
+				       "components/component/provides/firmware",
+				       NULL,
+				       error))
+		return FALSE;
+	helper->query =
+	    xb_query_new_full(helper->silo,
+			      "components/component/provides/firmware[@type=$'flashed'][text()=?]/"
+			      "../..",
+			      XB_QUERY_FLAG_OPTIMIZE,
+			      error);
+	if (helper->query == NULL)
+		return FALSE;
+	fu_benchmark_add(self,
+			 "silo-query",
+			 0,
+			 FU_BENCHMARK_SILO_COMPONENTS,
+			 fu_benchmark_silo_query_cb,
+			 g_steal_pointer(&helper),
+			 (GDestroyNotify)fu_benchmark_silo_helper_free);
+	return TRUE;
+}
+
+typedef struct {
+	FuDevice *device;
+	GPtrArray *event_ids; /* of utf-8 */
+} FuBenchmarkEmulationHelper;
+
+static void
+fu_benchmark_emulation_helper_free(FuBenchmarkEmulationHelper *helper)
+{
+	g_object_unref(helper->device);
+	g_ptr_array_unref(helper->event_ids);
+	g_free(helper);
+}
+
+/* replays the recorded transactions in order, as an emulated device would */
+static gboolean
+fu_benchmark_emulation_replay_cb(gpointer user_data, GError **error)
+{
+	FuBenchmarkEmulationHelper *helper = (FuBenchmarkEmulationHelper *)user_data;
+	for (guint i = 0; i < helper->event_ids->len; i++) {
+		const gchar *event_id = g_ptr_array_index(helper->event_ids, i);
+		FuDeviceEvent *event;
+		g_autoptr(GBytes) blob = NULL;
+
+		event = fu_device_load_event(helper->device, event_id, error);
+		if (event == NULL)
+			return FALSE;
+		blob = fu_device_event_get_bytes(event, "Data", error);
+		if (blob == NULL)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+fu_benchmark_add_emulation(FuBenchmark *self, FuContext *ctx)
+{
+	FuBenchmarkEmulationHelper *helper;
+	guint8 buf[64] = {0x0};
+
+	if (!fu_benchmark_matches(self, "emulation-replay"))
+		return;
+
+	helper = g_new0(FuBenchmarkEmulationHelper, 1);
+	helper->device = fu_device_new(ctx);
+	helper->event_ids = g_ptr_array_new_with_free_func(g_free);
+	for (guint i = 0; i < FU_BENCHMARK_EMULATION_EVENTS; i++) {
+		FuDeviceEvent *event;
+		g_autofree gchar *event_id =
+		    g_strdup_printf("Ioctl:Request=0x%04x,Data=0x%08x", 0x1234, i);
+		for (guint j = 0; j < sizeof(buf); j++)
+			buf[j] = (guint8)(i + j);
+		event = fu_device_save_event(helper->device, event_id);
+		fu_device_event_set_data(event, "Data", buf, sizeof(buf));
+		g_ptr_array_add(helper->event_ids, g_steal_pointer(&event_id));
+	}
+	fu_benchmark_add(self,
+			 "emulation-replay",
+			 0,
+			 FU_BENCHMARK_EMULATION_EVENTS,
+			 fu_benchmark_emulation_replay_cb,
+			 helper,
+			 (GDestroyNotify)fu_benchmark_emulation_helper_free);
+}
+
+/**
+ * fu_benchmark_add_defaults:
+ * @self: a #FuBenchmark
+ * @ctx: a #FuContext with the firmware types and quirks already loaded
+ * @builder_dir: (nullable): a directory of `.builder.xml` files to use as firmware inputs
+ * @error: (nullable): optional return location for an error
+ *
+ * Adds the default set of benchmarks for the daemon hot paths.
+ *
+ * Returns: %TRUE for success
+ **/
+gboolean
+fu_benchmark_add_defaults(FuBenchmark *self,
+			  FuContext *ctx,
+			  const gchar *builder_dir,
+			  GError **error)
+{
+	g_return_val_if_fail(FU_IS_BENCHMARK(self), FALSE);
+	g_return_val_if_fail(FU_IS_CONTEXT(ctx), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (!fu_benchmark_add_firmware_parsers(self, ctx, builder_dir, error))
+		return FALSE;
+	fu_benchmark_add_checksums(self);
+	fu_benchmark_add_decompressors(self, builder_dir);
+	if (!fu_benchmark_add_cab_write(self, error))
+		return FALSE;
+	fu_benchmark_add_version_sort(self);
+	fu_benchmark_add_quirks(self, ctx);
+	fu_benchmark_add_device_list(self, ctx);
+	if (!fu_benchmark_add_silo(self, error))
+		return FALSE;
+	fu_benchmark_add_emulation(self, ctx);
+	return TRUE;
+}
+
+static void
+fu_benchmark_init(FuBenchmark *self)
+{
+	self->items = g_ptr_array_new_with_free_func((GDestroyNotify)fu_benchmark_item_free);
+}
+
+static void
+fu_benchmark_finalize(GObject *obj)
+{
+	FuBenchmark *self = FU_BENCHMARK(obj);
+	g_ptr_array_unref(self->items);
+	g_free(self->pattern);
+	G_OBJECT_CLASS(fu_benchmark_parent_class)->finalize(obj);
+}
+
+static void
+fu_benchmark_class_init(FuBenchmarkClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = fu_benchmark_finalize;
+}
+
+/**
+ * fu_benchmark_new:
+ * @iterations: number of timed iterations for each benchmark
+ *
+ * Returns: (transfer full): a new #FuBenchmark
+ **/
+FuBenchmark *
+fu_benchmark_new(guint iterations)
+{
+	FuBenchmark *self = g_object_new(FU_TYPE_BENCHMARK, NULL);
+	self->iterations = MAX(iterations, 1);
+	return self;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <fwupdplugin.h>
+
+#define FU_TYPE_BENCHMARK (fu_benchmark_get_type())
+G_DECLARE_FINAL_TYPE(FuBenchmark, fu_benchmark, FU, BENCHMARK, GObject)
+
+#define FU_BENCHMARK_ITERATIONS_DEFAULT 100
+
+typedef gboolean (*FuBenchmarkFunc)(gpointer user_data, GError **error);
+
+FuBenchmark *
+fu_benchmark_new(guint iterations);
+void
+fu_benchmark_set_pattern(FuBenchmark *self, const gchar *pattern) G_GNUC_NON_NULL(1);
+void
+fu_benchmark_add(FuBenchmark *self,
+		 const gchar *id,
+		 guint64 bytes,
+		 guint64 operations,
+		 FuBenchmarkFunc func,
+		 gpointer user_data,
+		 GDestroyNotify user_data_free) G_GNUC_NON_NULL(1, 2, 5);
+gboolean
+fu_benchmark_add_defaults(FuBenchmark *self,
+			  FuContext *ctx,
+			  const gchar *builder_dir,
+			  GError **error) G_GNUC_NON_NULL(1, 2);
+guint
+fu_benchmark_get_size(FuBenchmark *self) G_GNUC_NON_NULL(1);
+gint64
+fu_benchmark_samples_get_median(GArray *samples) G_GNUC_NON_NULL(1);
+gboolean
+fu_benchmark_run(FuBenchmark *self, FuProgress *progress, GError **error) G_GNUC_NON_NULL(1, 2);
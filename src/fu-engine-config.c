@@ -236,6 +236,12 @@ fu_engine_config_get_idle_timeout(FuEngineConfig *self)
 	return fu_config_get_value_u64(FU_CONFIG(self), "fwupd", "IdleTimeout");
 }
 
+guint
+fu_engine_config_get_udev_events_delay(FuEngineConfig *self)
+{
+	return fu_config_get_value_u64(FU_CONFIG(self), "fwupd", "UdevEventsDelay");
+}
+
 GPtrArray *
 fu_engine_config_get_disabled_devices(FuEngineConfig *self)
 {
@@ -423,6 +429,7 @@ fu_engine_config_init(FuEngineConfig *self)
 	fu_engine_config_set_default(self, "TestDevices", "false");
 	fu_engine_config_set_default(self, "TrustedReports", "VendorId=$OEM");
 	fu_engine_config_set_default(self, "TrustedUids", NULL);
+	fu_engine_config_set_default(self, "UdevEventsDelay", "0"); /* ms */
 	fu_engine_config_set_default(self, "UpdateMotd", "true");
 	fu_engine_config_set_default(self, "UriSchemes", "file;https;http;ipfs");
 	fu_engine_config_set_default(self, "VerboseDomains", NULL);
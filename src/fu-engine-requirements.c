@@ -8,36 +8,45 @@
 
 #include "config.h"
 
+#include "fu-device-private.h"
 #include "fu-engine-requirements.h"
 
+static gint
+fu_engine_requirements_vercmp(const FuVersionKey *version_key, const gchar *version_req)
+{
+	g_autoptr(FuVersionKey) version_key_req =
+	    fu_version_key_new(version_req, fu_version_key_get_format(version_key));
+	return fu_version_key_compare(version_key, version_key_req);
+}
+
 static gboolean
 fu_engine_requirements_require_vercmp(XbNode *req,
-				      const gchar *version,
-				      FwupdVersionFormat fmt,
+				      const FuVersionKey *version_key,
 				      GError **error)
 {
+	const gchar *version = fu_version_key_get_version(version_key);
 	gboolean ret = FALSE;
 	gint rc = 0;
 	const gchar *tmp = xb_node_get_attr(req, "compare");
 	const gchar *version_req = xb_node_get_attr(req, "version");
 
 	if (g_strcmp0(tmp, "eq") == 0) {
-		rc = fu_version_compare(version, version_req, fmt);
+		rc = fu_engine_requirements_vercmp(version_key, version_req);
 		ret = rc == 0;
 	} else if (g_strcmp0(tmp, "ne") == 0) {
-		rc = fu_version_compare(version, version_req, fmt);
+		rc = fu_engine_requirements_vercmp(version_key, version_req);
 		ret = rc != 0;
 	} else if (g_strcmp0(tmp, "lt") == 0) {
-		rc = fu_version_compare(version, version_req, fmt);
+		rc = fu_engine_requirements_vercmp(version_key, version_req);
 		ret = rc < 0;
 	} else if (g_strcmp0(tmp, "gt") == 0) {
-		rc = fu_version_compare(version, version_req, fmt);
+		rc = fu_engine_requirements_vercmp(version_key, version_req);
 		ret = rc > 0;
 	} else if (g_strcmp0(tmp, "le") == 0) {
-		rc = fu_version_compare(version, version_req, fmt);
+		rc = fu_engine_requirements_vercmp(version_key, version_req);
 		ret = rc <= 0;
 	} else if (g_strcmp0(tmp, "ge") == 0) {
-		rc = fu_version_compare(version, version_req, fmt);
+		rc = fu_engine_requirements_vercmp(version_key, version_req);
 		ret = rc >= 0;
 	} else if (g_strcmp0(tmp, "glob") == 0) {
 		ret = g_pattern_match_simple(version_req, version);
@@ -98,8 +107,7 @@ fu_engine_requirements_check_not_child(FuEngine *self,
 			return FALSE;
 		}
 		if (fu_engine_requirements_require_vercmp(req,
-							  version,
-							  fu_device_get_version_format(child),
+							  fu_device_get_version_key(child),
 							  NULL)) {
 			g_set_error(error,
 				    FWUPD_ERROR,
@@ -241,11 +249,9 @@ fu_engine_requirements_check_firmware(FuEngine *self,
 	/* old firmware version */
 	if (xb_node_get_text(req) == NULL) {
 		version = fu_device_get_version(device_actual);
-		if (!fu_engine_requirements_require_vercmp(
-			req,
-			version,
-			fu_device_get_version_format(device_actual),
-			&error_local)) {
+		if (!fu_engine_requirements_require_vercmp(req,
+							   fu_device_get_version_key(device_actual),
+							   &error_local)) {
 			if (g_strcmp0(xb_node_get_attr(req, "compare"), "ge") == 0) {
 				g_set_error(
 				    error,
@@ -268,12 +274,11 @@ fu_engine_requirements_check_firmware(FuEngine *self,
 
 	/* bootloader version */
 	if (g_strcmp0(xb_node_get_text(req), "bootloader") == 0) {
+		g_autoptr(FuVersionKey) version_key = NULL;
 		version = fu_device_get_version_bootloader(device_actual);
-		if (!fu_engine_requirements_require_vercmp(
-			req,
-			version,
-			fu_device_get_version_format(device_actual),
-			&error_local)) {
+		version_key =
+		    fu_version_key_new(version, fu_device_get_version_format(device_actual));
+		if (!fu_engine_requirements_require_vercmp(req, version_key, &error_local)) {
 			if (g_strcmp0(xb_node_get_attr(req, "compare"), "ge") == 0) {
 				g_set_error(
 				    error,
@@ -437,8 +442,7 @@ fu_engine_requirements_check_firmware(FuEngine *self,
 	version = fu_device_get_version(device_actual);
 	if (version != NULL && xb_node_get_attr(req, "compare") != NULL &&
 	    !fu_engine_requirements_require_vercmp(req,
-						   version,
-						   fu_device_get_version_format(device_actual),
+						   fu_device_get_version_key(device_actual),
 						   &error_local)) {
 		if (g_strcmp0(xb_node_get_attr(req, "compare"), "ge") == 0) {
 			g_set_error(error,
@@ -467,6 +471,7 @@ static gboolean
 fu_engine_requirements_check_id(FuEngine *self, XbNode *req, GError **error)
 {
 	FuContext *ctx = fu_engine_get_context(self);
+	g_autoptr(FuVersionKey) version_key = NULL;
 	g_autoptr(GError) error_local = NULL;
 	const gchar *version;
 
@@ -487,10 +492,8 @@ fu_engine_requirements_check_id(FuEngine *self, XbNode *req, GError **error)
 			    xb_node_get_text(req));
 		return FALSE;
 	}
-	if (!fu_engine_requirements_require_vercmp(req,
-						   version,
-						   FWUPD_VERSION_FORMAT_UNKNOWN,
-						   &error_local)) {
+	version_key = fu_version_key_new(version, FWUPD_VERSION_FORMAT_UNKNOWN);
+	if (!fu_engine_requirements_require_vercmp(req, version_key, &error_local)) {
 		if (g_strcmp0(xb_node_get_attr(req, "compare"), "ge") == 0) {
 			g_set_error(error,
 				    FWUPD_ERROR,
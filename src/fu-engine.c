@@ -66,6 +66,7 @@
 #include "fu-remote.h"
 #include "fu-security-attr-common.h"
 #include "fu-security-attrs-private.h"
+#include "fu-trace-private.h"
 #include "fu-udev-device-private.h"
 #include "fu-uefi-backend.h"
 #include "fu-usb-backend.h"
@@ -130,11 +131,14 @@ struct _FuEngine {
 	GHashTable *blocked_firmware;	      /* (nullable) */
 	FuEngineEmulator *emulation;
 	GHashTable *device_changed_allowlist; /* (element-type str int) */
+	GHashTable *release_candidates;	      /* (element-type str FuEngineReleaseCandidates) */
 	gchar *host_machine_id;
 	JcatContext *jcat_context;
 	gboolean loaded;
 	gchar *host_security_id;
 	FuSecurityAttrs *host_security_attrs;
+	GHashTable *plugin_security_attrs; /* (element-type str FuEngineSecurityAttrsEntry) */
+	GHashTable *device_security_attrs; /* (element-type str FuEngineSecurityAttrsEntry) */
 	GPtrArray *local_monitors; /* (element-type GFileMonitor) */
 	GMainLoop *acquiesce_loop;
 	guint acquiesce_id;
@@ -148,6 +152,29 @@ struct _FuEngine {
 
 enum { PROP_0, PROP_CONTEXT, PROP_LAST };
 
+/* a release node that has not been loaded into a FuRelease yet */
+typedef struct {
+	XbNode *component;
+	XbNode *rel;
+	FuVersionKey *version_key;  /* (nullable) */
+	const gchar *branch;	    /* (nullable) */
+	gboolean has_update_values; /* copied to the device when loaded */
+} FuEngineReleaseCandidate;
+
+/* the security attrs after a producer was called, and what they were before */
+typedef struct {
+	gchar *fingerprint_in;
+	gchar *fingerprint_out;
+	FuSecurityAttrs *attrs;
+} FuEngineSecurityAttrsEntry;
+
+/* all the release nodes for a device, valid until the device or the silo changes */
+typedef struct {
+	FwupdVersionFormat fmt;
+	guint guids_len;
+	GPtrArray *items; /* (element-type FuEngineReleaseCandidate) */
+} FuEngineReleaseCandidates;
+
 enum {
 	SIGNAL_CHANGED,
 	SIGNAL_DEVICE_ADDED,
@@ -217,6 +244,64 @@ fu_engine_emit_changed(FuEngine *self)
 		g_info("failed to update list of devices: %s", error->message);
 }
 
+static void
+fu_engine_security_attrs_entry_free(FuEngineSecurityAttrsEntry *entry)
+{
+	g_free(entry->fingerprint_in);
+	g_free(entry->fingerprint_out);
+	g_object_unref(entry->attrs);
+	g_free(entry);
+}
+
+static gboolean
+fu_engine_security_attrs_entry_has_guid(FuEngineSecurityAttrsEntry *entry,
+					const gchar *plugin_name,
+					GPtrArray *guids)
+{
+	g_autoptr(GPtrArray) attrs = fu_security_attrs_get_all(entry->attrs);
+	for (guint i = 0; i < attrs->len; i++) {
+		FwupdSecurityAttr *attr = g_ptr_array_index(attrs, i);
+		if (g_strcmp0(fwupd_security_attr_get_plugin(attr), plugin_name) != 0)
+			continue;
+		for (guint j = 0; j < guids->len; j++) {
+			const gchar *guid = g_ptr_array_index(guids, j);
+			if (fwupd_security_attr_has_guid(attr, guid))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* the producers that could be affected by anything, e.g. the BIOS settings or metadata */
+static void
+fu_engine_invalidate_security_attrs(FuEngine *self)
+{
+	g_hash_table_remove_all(self->device_security_attrs);
+	g_hash_table_remove_all(self->plugin_security_attrs);
+	g_clear_pointer(&self->host_security_id, g_free);
+}
+
+static void
+fu_engine_invalidate_security_attrs_for_device(FuEngine *self, FuDevice *device)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	GPtrArray *guids = fu_device_get_guids(device);
+
+	if (fu_device_get_id(device) != NULL)
+		g_hash_table_remove(self->device_security_attrs, fu_device_get_id(device));
+	if (fu_device_get_plugin(device) != NULL)
+		g_hash_table_remove(self->plugin_security_attrs, fu_device_get_plugin(device));
+	g_hash_table_iter_init(&iter, self->plugin_security_attrs);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		if (fu_engine_security_attrs_entry_has_guid(value, key, guids)) {
+			g_debug("invalidating security attrs from %s", (const gchar *)key);
+			g_hash_table_iter_remove(&iter);
+		}
+	}
+}
+
 static void
 fu_engine_emit_device_changed_safe(FuEngine *self, FuDevice *device)
 {
@@ -225,6 +310,7 @@ fu_engine_emit_device_changed_safe(FuEngine *self, FuDevice *device)
 		return;
 
 	/* invalidate host security attributes */
+	fu_engine_invalidate_security_attrs_for_device(self, device);
 	g_clear_pointer(&self->host_security_id, g_free);
 	g_signal_emit(self, signals[SIGNAL_DEVICE_CHANGED], 0, device);
 }
@@ -507,9 +593,40 @@ fu_engine_ensure_context_flag_save_events(FuEngine *self)
 	fu_context_add_flag(self->ctx, FU_CONTEXT_FLAG_SAVE_EVENTS);
 }
 
+static void
+fu_engine_release_candidate_free(FuEngineReleaseCandidate *item)
+{
+	g_object_unref(item->component);
+	g_object_unref(item->rel);
+	fu_version_key_free(item->version_key);
+	g_free(item);
+}
+
+static void
+fu_engine_release_candidates_free(FuEngineReleaseCandidates *candidates)
+{
+	g_ptr_array_unref(candidates->items);
+	g_free(candidates);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuEngineReleaseCandidates, fu_engine_release_candidates_free)
+
+static void
+fu_engine_invalidate_release_candidates(FuEngine *self, FuDevice *device)
+{
+	if (device == NULL) {
+		g_hash_table_remove_all(self->release_candidates);
+		return;
+	}
+	if (fu_device_get_id(device) != NULL)
+		g_hash_table_remove(self->release_candidates, fu_device_get_id(device));
+}
+
 static void
 fu_engine_device_added_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
+	fu_engine_invalidate_release_candidates(self, device);
+	fu_engine_invalidate_security_attrs_for_device(self, device);
 	fu_engine_watch_device(self, device);
 	fu_engine_ensure_device_problem_priority(self, device);
 	fu_engine_ensure_device_power_inhibit(self, device);
@@ -533,6 +650,8 @@ fu_engine_device_runner_device_removed(FuEngine *self, FuDevice *device)
 static void
 fu_engine_device_removed_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
+	fu_engine_invalidate_release_candidates(self, device);
+	fu_engine_invalidate_security_attrs_for_device(self, device);
 	fu_engine_device_runner_device_removed(self, device);
 	fu_engine_acquiesce_reset(self);
 	g_signal_handlers_disconnect_by_data(device, self);
@@ -542,6 +661,7 @@ fu_engine_device_removed_cb(FuDeviceList *device_list, FuDevice *device, FuEngin
 static void
 fu_engine_device_changed_cb(FuDeviceList *device_list, FuDevice *device, FuEngine *self)
 {
+	fu_engine_invalidate_release_candidates(self, device);
 	fu_engine_watch_device(self, device);
 	fu_engine_emit_device_changed(self, fu_device_get_id(device));
 	fu_engine_acquiesce_reset(self);
@@ -1033,6 +1153,7 @@ fu_engine_modify_bios_settings(FuEngine *self,
 				    "no BIOS settings needed to be changed");
 		return FALSE;
 	}
+	fu_engine_invalidate_security_attrs(self);
 	if (fu_bios_settings_get_attr(bios_settings, FWUPD_BIOS_SETTING_PENDING_REBOOT) != NULL) {
 		if (!fu_bios_settings_get_pending_reboot(bios_settings, &changed, error))
 			return FALSE;
@@ -1370,6 +1491,7 @@ fu_engine_get_component_by_guid(FuEngine *self, const gchar *guid)
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(XbNode) component = NULL;
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	g_auto(FuTraceSpan) span = fu_trace_span_begin("silo", "component_by_guid", guid);
 
 	/* no components in silo */
 	if (self->query_component_by_guid == NULL)
@@ -1517,10 +1639,12 @@ fu_engine_verify(FuEngine *self, const gchar *device_id, FuProgress *progress, G
 	g_autoptr(GString) xpath_csum = g_string_new(NULL);
 	g_autoptr(XbNode) csum = NULL;
 	g_autoptr(XbNode) release = NULL;
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_ENGINE(self), FALSE);
 	g_return_val_if_fail(device_id != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	span = fu_trace_span_begin("engine", "verify", device_id);
 
 	/* check the id exists */
 	device = fu_device_list_get_by_id(self->device_list, device_id, error);
@@ -2229,6 +2353,7 @@ fu_engine_install_releases(FuEngine *self,
 	g_autoptr(FuIdleLocker) locker = NULL;
 	g_autoptr(GPtrArray) devices = NULL;
 	g_autoptr(GPtrArray) devices_new = NULL;
+	g_auto(FuTraceSpan) span = fu_trace_span_begin("engine", "install_releases", NULL);
 
 	/* do not allow auto-shutdown during this time */
 	locker = fu_idle_locker_new(self->idle,
@@ -2476,6 +2601,83 @@ fu_engine_save_into_backup_remote(FuEngine *self, GBytes *fw, GError **error)
 	return fu_remote_save_to_filename(remote, remotes_fn, NULL, error);
 }
 
+static gboolean
+fu_engine_install_blob_full(FuEngine *self,
+			    FuDevice *device,
+			    GInputStream *stream_fw,
+			    FuProgress *progress,
+			    FwupdInstallFlags flags,
+			    FwupdFeatureFlags feature_flags,
+			    GHashTable *durations,
+			    GError **error);
+
+static void
+fu_engine_invalidate_device_setup_cache(FuEngine *self, FuDevice *device)
+{
+	const gchar *cache_id = fu_device_get_setup_cache_id(device);
+	g_autoptr(GError) error_local = NULL;
+
+	if (cache_id == NULL)
+		return;
+	if (!fu_history_remove_setup_cache(self->history, cache_id, &error_local)) {
+		if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED))
+			g_debug("failed to remove setup cache: %s", error_local->message);
+		else
+			g_warning("failed to remove setup cache: %s", error_local->message);
+	}
+	fu_device_invalidate_setup_cache(device);
+}
+
+/* how much of the install was spent waiting rather than transferring */
+static void
+fu_engine_add_release_delay_metadata(FuEngine *self,
+				     FuRelease *release,
+				     FuDevice *device_orig,
+				     FuDevice *device,
+				     guint sleep_cnt_old,
+				     guint64 sleep_total_old,
+				     guint retry_cnt_old,
+				     FwupdInstallFlags flags)
+{
+	guint sleep_cnt = fu_device_get_sleep_count(device_orig) - sleep_cnt_old;
+	guint64 sleep_total = fu_device_get_sleep_duration(device_orig) - sleep_total_old;
+	guint retry_cnt = fu_device_get_retry_count(device_orig) - retry_cnt_old;
+	g_autofree gchar *sleep_cnt_str = NULL;
+	g_autofree gchar *sleep_total_str = NULL;
+	g_autofree gchar *retry_cnt_str = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	/* the device was replugged */
+	if (device != device_orig) {
+		sleep_cnt += fu_device_get_sleep_count(device);
+		sleep_total += fu_device_get_sleep_duration(device);
+		retry_cnt += fu_device_get_retry_count(device);
+	}
+	sleep_cnt_str = g_strdup_printf("%u", sleep_cnt);
+	sleep_total_str = g_strdup_printf("%" G_GUINT64_FORMAT, sleep_total);
+	retry_cnt_str = g_strdup_printf("%u", retry_cnt);
+	fu_release_add_metadata_item(release, "SleepCount", sleep_cnt_str);
+	fu_release_add_metadata_item(release, "SleepDuration", sleep_total_str);
+	fu_release_add_metadata_item(release, "RetryCount", retry_cnt_str);
+	if ((flags & FWUPD_INSTALL_FLAG_NO_HISTORY) > 0)
+		return;
+	if (!fu_history_modify_device_release(self->history, device, release, &error_local)) {
+		g_warning("failed to save delays: %s", error_local->message);
+		return;
+	}
+
+	/* remember how long the retries usually take for next time */
+	if (fu_device_has_private_flag(device, FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE) &&
+	    fu_device_get_retry_latency(device) > 0 && fu_device_get_guid_default(device) != NULL) {
+		if (!fu_history_set_retry_latency(self->history,
+						  fu_device_get_guid_default(device),
+						  fu_device_get_retry_latency(device),
+						  &error_local)) {
+			g_warning("failed to save retry latency: %s", error_local->message);
+		}
+	}
+}
+
 /**
  * fu_engine_install_release:
  * @self: a #FuEngine
@@ -2507,15 +2709,23 @@ fu_engine_install_release(FuEngine *self,
 	FwupdFeatureFlags feature_flags = FWUPD_FEATURE_FLAG_NONE;
 	GInputStream *stream_fw;
 	const gchar *tmp;
+	gboolean ret;
+	guint sleep_cnt_old;
+	guint64 sleep_total_old;
+	guint retry_cnt_old;
 	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(FuDevice) device_tmp = NULL;
 	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GHashTable) durations =
+	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_ENGINE(self), FALSE);
 	g_return_val_if_fail(FU_IS_RELEASE(release), FALSE);
 	g_return_val_if_fail(FU_IS_PROGRESS(progress), FALSE);
 	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	span = fu_trace_span_begin("engine", "install_release", NULL);
 
 	/* optional for tests */
 	if (request != NULL)
@@ -2585,13 +2795,19 @@ fu_engine_install_release(FuEngine *self,
 	}
 
 	/* install firmware blob */
-	if (!fu_engine_install_blob(self,
-				    device,
-				    stream_fw,
-				    progress,
-				    flags,
-				    feature_flags,
-				    &error_local)) {
+	sleep_cnt_old = fu_device_get_sleep_count(device_orig);
+	sleep_total_old = fu_device_get_sleep_duration(device_orig);
+	retry_cnt_old = fu_device_get_retry_count(device_orig);
+	ret = fu_engine_install_blob_full(self,
+					  device,
+					  stream_fw,
+					  progress,
+					  flags,
+					  feature_flags,
+					  durations,
+					  &error_local);
+	fu_release_add_metadata(release, durations);
+	if (!ret) {
 		FwupdUpdateState state = fu_device_get_update_state(device);
 		if (state != FWUPD_UPDATE_STATE_FAILED &&
 		    state != FWUPD_UPDATE_STATE_FAILED_TRANSIENT)
@@ -2599,6 +2815,14 @@ fu_engine_install_release(FuEngine *self,
 		else
 			fu_device_set_update_state(device_orig, state);
 		fu_device_set_update_error(device_orig, error_local->message);
+		fu_engine_add_release_delay_metadata(self,
+						     release,
+						     device_orig,
+						     device_orig,
+						     sleep_cnt_old,
+						     sleep_total_old,
+						     retry_cnt_old,
+						     flags);
 		g_propagate_error(error, g_steal_pointer(&error_local));
 		return FALSE;
 	}
@@ -2610,6 +2834,14 @@ fu_engine_install_release(FuEngine *self,
 		return FALSE;
 	}
 	g_set_object(&device, device_tmp);
+	fu_engine_add_release_delay_metadata(self,
+					     release,
+					     device_orig,
+					     device,
+					     sleep_cnt_old,
+					     sleep_total_old,
+					     retry_cnt_old,
+					     flags);
 
 	/* update state (which updates the database if required) */
 	if (fu_device_has_flag(device, FWUPD_DEVICE_FLAG_NEEDS_REBOOT) ||
@@ -3294,20 +3526,41 @@ fu_engine_firmware_read(FuEngine *self,
 	return fu_device_read_firmware(device, progress, error);
 }
 
-gboolean
-fu_engine_install_blob(FuEngine *self,
-		       FuDevice *device,
-		       GInputStream *stream_fw,
-		       FuProgress *progress,
-		       FwupdInstallFlags flags,
-		       FwupdFeatureFlags feature_flags,
-		       GError **error)
+/* accumulated as the write may be done more than once */
+static void
+fu_engine_install_blob_add_duration(GHashTable *durations, const gchar *key, GTimer *timer)
+{
+	guint64 total = (guint64)(g_timer_elapsed(timer, NULL) * 1000.f);
+	const gchar *tmp;
+
+	if (durations != NULL) {
+		tmp = g_hash_table_lookup(durations, key);
+		if (tmp != NULL)
+			total += g_ascii_strtoull(tmp, NULL, 10);
+		g_hash_table_insert(durations,
+				    g_strdup(key),
+				    g_strdup_printf("%" G_GUINT64_FORMAT, total));
+	}
+	g_timer_start(timer);
+}
+
+static gboolean
+fu_engine_install_blob_full(FuEngine *self,
+			    FuDevice *device,
+			    GInputStream *stream_fw,
+			    FuProgress *progress,
+			    FwupdInstallFlags flags,
+			    FwupdFeatureFlags feature_flags,
+			    GHashTable *durations,
+			    GError **error)
 {
 	guint retries = 0;
 	gsize streamsz = 0;
 	g_autofree gchar *device_id = NULL;
 	g_autoptr(GTimer) timer = g_timer_new();
+	g_autoptr(GTimer) timer_phase = g_timer_new();
 	g_autoptr(FuDeviceProgress) device_progress = fu_device_progress_new(device, progress);
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(device_progress != NULL, FALSE);
 
@@ -3332,11 +3585,17 @@ fu_engine_install_blob(FuEngine *self,
 	/* mark this as modified even if we actually fail to do the update */
 	fu_device_set_modified_usec(device, g_get_real_time());
 
+	/* anything read from the hardware before the update is now stale */
+	fu_engine_invalidate_device_setup_cache(self, device);
+
 	/* signal to all the plugins the update is about to happen */
 	device_id = g_strdup(fu_device_get_id(device));
+	span = fu_trace_span_begin("engine", "install_blob", device_id);
 	fu_engine_set_emulator_phase(self, FU_ENGINE_EMULATOR_PHASE_PREPARE);
+	g_timer_start(timer_phase);
 	if (!fu_engine_prepare(self, device_id, fu_progress_get_child(progress), flags, error))
 		return FALSE;
+	fu_engine_install_blob_add_duration(durations, "PrepareDuration", timer_phase);
 	fu_progress_step_done(progress);
 
 	/* plugins can set FWUPD_DEVICE_FLAG_ANOTHER_WRITE_REQUIRED to run again, but they
@@ -3389,6 +3648,9 @@ fu_engine_install_blob(FuEngine *self,
 				g_prefix_error(error, "failed to detach: ");
 				return FALSE;
 			}
+			fu_engine_install_blob_add_duration(durations,
+							    "DetachDuration",
+							    timer_phase);
 			fu_progress_step_done(progress_local);
 
 			/* parse firmware */
@@ -3401,6 +3663,9 @@ fu_engine_install_blob(FuEngine *self,
 							      error);
 			if (firmware == NULL)
 				return FALSE;
+			fu_engine_install_blob_add_duration(durations,
+							    "PrepareFirmwareDuration",
+							    timer_phase);
 			fu_progress_step_done(progress_local);
 
 			/* install */
@@ -3413,6 +3678,9 @@ fu_engine_install_blob(FuEngine *self,
 				g_prefix_error(error, "failed to write-firmware: ");
 				return FALSE;
 			}
+			fu_engine_install_blob_add_duration(durations,
+							    "WriteDuration",
+							    timer_phase);
 			fu_progress_step_done(progress_local);
 		} else {
 			/* parse firmware */
@@ -3424,6 +3692,9 @@ fu_engine_install_blob(FuEngine *self,
 							      error);
 			if (firmware == NULL)
 				return FALSE;
+			fu_engine_install_blob_add_duration(durations,
+							    "PrepareFirmwareDuration",
+							    timer_phase);
 			fu_progress_step_done(progress_local);
 
 			/* detach to bootloader mode */
@@ -3436,6 +3707,9 @@ fu_engine_install_blob(FuEngine *self,
 				g_prefix_error(error, "failed to detach: ");
 				return FALSE;
 			}
+			fu_engine_install_blob_add_duration(durations,
+							    "DetachDuration",
+							    timer_phase);
 			fu_progress_step_done(progress_local);
 
 			/* install */
@@ -3449,6 +3723,9 @@ fu_engine_install_blob(FuEngine *self,
 				g_prefix_error(error, "failed to write-firmware: ");
 				return FALSE;
 			}
+			fu_engine_install_blob_add_duration(durations,
+							    "WriteDuration",
+							    timer_phase);
 			fu_progress_step_done(progress_local);
 		}
 
@@ -3461,6 +3738,7 @@ fu_engine_install_blob(FuEngine *self,
 			g_prefix_error(error, "failed to attach: ");
 			return FALSE;
 		}
+		fu_engine_install_blob_add_duration(durations, "AttachDuration", timer_phase);
 		fu_progress_step_done(progress_local);
 
 		/* get the new version number */
@@ -3469,6 +3747,7 @@ fu_engine_install_blob(FuEngine *self,
 			g_prefix_error(error, "failed to reload: ");
 			return FALSE;
 		}
+		fu_engine_install_blob_add_duration(durations, "ReloadDuration", timer_phase);
 		fu_progress_step_done(progress_local);
 
 		/* the device and plugin both may have changed */
@@ -3499,8 +3778,10 @@ fu_engine_install_blob(FuEngine *self,
 
 	/* signal to all the plugins the update has happened */
 	fu_engine_set_emulator_phase(self, FU_ENGINE_EMULATOR_PHASE_CLEANUP);
+	g_timer_start(timer_phase);
 	if (!fu_engine_cleanup(self, device_id, fu_progress_get_child(progress), flags, error))
 		return FALSE;
+	fu_engine_install_blob_add_duration(durations, "CleanupDuration", timer_phase);
 	fu_progress_step_done(progress);
 
 	/* make the UI update */
@@ -3511,6 +3792,25 @@ fu_engine_install_blob(FuEngine *self,
 	return TRUE;
 }
 
+gboolean
+fu_engine_install_blob(FuEngine *self,
+		       FuDevice *device,
+		       GInputStream *stream_fw,
+		       FuProgress *progress,
+		       FwupdInstallFlags flags,
+		       FwupdFeatureFlags feature_flags,
+		       GError **error)
+{
+	return fu_engine_install_blob_full(self,
+					   device,
+					   stream_fw,
+					   progress,
+					   flags,
+					   feature_flags,
+					   NULL,
+					   error);
+}
+
 static FuDevice *
 fu_engine_get_item_by_id_fallback_history(FuEngine *self, const gchar *id, GError **error)
 {
@@ -3575,6 +3875,9 @@ fu_engine_create_silo_index(FuEngine *self, GError **error)
 	g_autoptr(GError) error_container_checksum2 = NULL;
 	g_autoptr(GError) error_tag_by_guid_version = NULL;
 
+	/* any cached release nodes refer to the old silo */
+	fu_engine_invalidate_release_candidates(self, NULL);
+
 	/* print what we've got */
 	components = xb_silo_query(self->silo, "components/component[@type='firmware']", 0, NULL);
 	if (components == NULL)
@@ -3911,6 +4214,7 @@ fu_engine_load_metadata_store(FuEngine *self, FuEngineLoadFlags flags, GError **
 	XbBuilderCompileFlags compile_flags = XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID;
 	g_autoptr(GFile) xmlb = NULL;
 	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_auto(FuTraceSpan) span = fu_trace_span_begin("engine", "load_metadata_store", NULL);
 
 	/* clear existing silo */
 	g_clear_object(&self->silo);
@@ -4046,12 +4350,25 @@ fu_engine_remote_list_ensure_p2p_policy_remote(FuEngine *self, FwupdRemote *remo
 	}
 }
 
+static void
+fu_engine_ensure_udev_events_delay(FuEngine *self)
+{
+#ifdef HAVE_UDEV
+	g_autoptr(FuBackend) backend = fu_context_get_backend_by_name(self->ctx, "udev", NULL);
+	if (backend == NULL)
+		return;
+	fu_udev_backend_set_events_delay(FU_UDEV_BACKEND(backend),
+					 fu_engine_config_get_udev_events_delay(self->config));
+#endif
+}
+
 static void
 fu_engine_config_changed_cb(FuEngineConfig *config, FuEngine *self)
 {
 	GPtrArray *remotes = fu_remote_list_get_all(self->remote_list);
 
 	fu_idle_set_timeout(self->idle, fu_engine_config_get_idle_timeout(config));
+	fu_engine_ensure_udev_events_delay(self);
 
 	/* allow changing the hardcoded ESP location */
 	if (fu_engine_config_get_esp_location(config) != NULL)
@@ -4075,7 +4392,7 @@ fu_engine_metadata_changed(FuEngine *self)
 	fu_engine_md_refresh_devices(self);
 
 	/* invalidate host security attributes */
-	g_clear_pointer(&self->host_security_id, g_free);
+	fu_engine_invalidate_security_attrs(self);
 
 	/* make the UI update */
 	fu_engine_emit_changed(self);
@@ -4343,7 +4660,7 @@ fu_engine_update_metadata_bytes(FuEngine *self,
 	fu_engine_md_refresh_devices(self);
 
 	/* invalidate host security attributes */
-	g_clear_pointer(&self->host_security_id, g_free);
+	fu_engine_invalidate_security_attrs(self);
 
 	/* make the UI update */
 	fu_engine_emit_changed(self);
@@ -4586,10 +4903,12 @@ fu_engine_get_details(FuEngine *self,
 	g_autoptr(GPtrArray) checksums = g_ptr_array_new_with_free_func(g_free);
 	g_autoptr(FuCabinet) cabinet = NULL;
 	g_autoptr(XbNode) rel_by_csum = NULL;
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_ENGINE(self), NULL);
 	g_return_val_if_fail(G_IS_INPUT_STREAM(stream), NULL);
 	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+	span = fu_trace_span_begin("engine", "get_details", NULL);
 
 	cabinet = fu_engine_build_cabinet_from_stream(self, stream, error);
 	if (cabinet == NULL) {
@@ -4959,6 +5278,7 @@ fu_engine_sort_releases_cb(gconstpointer a, gconstpointer b, gpointer user_data)
 	FuDevice *device = FU_DEVICE(user_data);
 	FuRelease *rel_a = FU_RELEASE(*((FuRelease **)a));
 	FuRelease *rel_b = FU_RELEASE(*((FuRelease **)b));
+	FwupdVersionFormat fmt = fu_device_get_version_format(device);
 	gint rc;
 
 	/* first by branch */
@@ -4967,9 +5287,8 @@ fu_engine_sort_releases_cb(gconstpointer a, gconstpointer b, gpointer user_data)
 		return rc;
 
 	/* then by version */
-	rc = fu_version_compare(fu_release_get_version(rel_b),
-				fu_release_get_version(rel_a),
-				fu_device_get_version_format(device));
+	rc = fu_version_key_compare(fu_release_get_version_key(rel_b, fmt),
+				    fu_release_get_version_key(rel_a, fmt));
 	if (rc != 0)
 		return rc;
 
@@ -5006,21 +5325,30 @@ fu_engine_check_release_is_blocked(FuEngine *self, FuRelease *release)
 	return FALSE;
 }
 
+/* the values that fu_engine_add_release_for_device_candidate() copies to the device */
 static gboolean
-fu_engine_add_releases_for_device_component(FuEngine *self,
-					    FuEngineRequest *request,
-					    FuDevice *device,
-					    XbNode *component,
-					    GPtrArray *releases,
-					    GError **error)
-{
-	FwupdFeatureFlags feature_flags;
-	FwupdVersionFormat fmt = fu_device_get_version_format(device);
+fu_engine_component_has_update_values(XbNode *component)
+{
+	const gchar *xpaths[] = {"custom/value[@key='LVFS::UpdateMessage']",
+				 "custom/value[@key='LVFS::UpdateImage']",
+				 "custom/value[@key='LVFS::UpdateRequestId']",
+				 NULL};
+	for (guint i = 0; xpaths[i] != NULL; i++) {
+		if (xb_node_query_text(component, xpaths[i], NULL) != NULL)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static gboolean
+fu_engine_add_release_candidates_for_component(XbNode *component,
+					       FuEngineReleaseCandidates *candidates,
+					       GError **error)
+{
+	const gchar *branch = xb_node_query_text(component, "branch", NULL);
+	gboolean has_update_values = fu_engine_component_has_update_values(component);
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(GPtrArray) releases_tmp = NULL;
-	FwupdInstallFlags install_flags =
-	    FWUPD_INSTALL_FLAG_IGNORE_VID_PID | FWUPD_INSTALL_FLAG_ALLOW_BRANCH_SWITCH |
-	    FWUPD_INSTALL_FLAG_ALLOW_REINSTALL | FWUPD_INSTALL_FLAG_ALLOW_OLDER;
 
 	/* get all releases */
 	releases_tmp = xb_node_query(component, "releases/release", 0, &error_local);
@@ -5032,123 +5360,254 @@ fu_engine_add_releases_for_device_component(FuEngine *self,
 		g_propagate_error(error, g_steal_pointer(&error_local));
 		return FALSE;
 	}
-	feature_flags = fu_engine_request_get_feature_flags(request);
 	for (guint i = 0; i < releases_tmp->len; i++) {
 		XbNode *rel = g_ptr_array_index(releases_tmp, i);
-		const gchar *remote_id;
-		const gchar *update_message;
-		const gchar *update_image;
-		const gchar *update_request_id;
-		gint vercmp;
-		GPtrArray *checksums;
-		GPtrArray *locations;
-		g_autoptr(FuRelease) release = fu_release_new();
-		g_autoptr(GError) error_loop = NULL;
-
-		/* create new FwupdRelease for the XbNode */
-		fu_release_set_request(release, request);
-		fu_release_set_device(release, device);
-		if (!fu_engine_load_release(self,
-					    release,
-					    NULL, /* cabinet */
-					    component,
-					    rel,
-					    install_flags,
-					    &error_loop)) {
-			g_debug("failed to set release for component: %s", error_loop->message);
-			continue;
+		const gchar *version = xb_node_get_attr(rel, "version");
+		FuEngineReleaseCandidate *item = g_new0(FuEngineReleaseCandidate, 1);
+
+		/* only the version is parsed now, everything else is done in fu_release_load() */
+		item->component = g_object_ref(component);
+		item->rel = g_object_ref(rel);
+		item->branch = branch;
+		item->has_update_values = has_update_values;
+		if (version != NULL) {
+			g_autofree gchar *version_rel = NULL;
+			g_autoptr(GError) error_version = NULL;
+
+			/* not filtered, so that fu_release_load() shows the warning */
+			version_rel =
+			    fu_release_convert_version(version, candidates->fmt, &error_version);
+			if (version_rel == NULL)
+				g_debug("not pre-filtering: %s", error_version->message);
+			else
+				item->version_key = fu_version_key_new(version_rel, candidates->fmt);
 		}
+		g_ptr_array_add(candidates->items, item);
+	}
 
-		/* fall back to quirk-provided value */
-		if (fwupd_release_get_install_duration(FWUPD_RELEASE(release)) == 0) {
-			fwupd_release_set_install_duration(FWUPD_RELEASE(release),
-							   fu_device_get_install_duration(device));
-		}
+	/* success */
+	return TRUE;
+}
 
-		/* invalid */
-		locations = fwupd_release_get_locations(FWUPD_RELEASE(release));
-		if (locations->len == 0) {
-			g_autofree gchar *str = fwupd_codec_to_string(FWUPD_CODEC(release));
-			g_debug("no locations for %s", str);
-			continue;
-		}
-		checksums = fu_release_get_checksums(release);
-		if (checksums->len == 0) {
-			g_autofree gchar *str = fwupd_codec_to_string(FWUPD_CODEC(release));
-			g_debug("no locations for %s", str);
+static FuEngineReleaseCandidates *
+fu_engine_release_candidates_new(FuEngine *self, FuDevice *device)
+{
+	GPtrArray *device_guids = fu_device_get_guids(device);
+	FuEngineReleaseCandidates *candidates = g_new0(FuEngineReleaseCandidates, 1);
+	g_auto(FuTraceSpan) span = fu_trace_span_begin("silo", "release_candidates", NULL);
+
+	candidates->fmt = fu_device_get_version_format(device);
+	candidates->guids_len = device_guids->len;
+	candidates->items =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)fu_engine_release_candidate_free);
+
+	/* get all the components that provide any of these GUIDs */
+	for (guint j = 0; j < device_guids->len; j++) {
+		const gchar *guid = g_ptr_array_index(device_guids, j);
+		g_autoptr(GError) error_local = NULL;
+		g_autoptr(GPtrArray) components = NULL;
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+
+		xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
+		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
+		components = xb_silo_query_with_context(self->silo,
+							self->query_component_by_guid,
+							&context,
+							&error_local);
+		if (components == NULL) {
+			g_debug("%s was not found: %s", guid, error_local->message);
 			continue;
 		}
-
-		/* different branch */
-		if (g_strcmp0(fu_release_get_branch(release), fu_device_get_branch(device)) != 0) {
-			if ((feature_flags & FWUPD_FEATURE_FLAG_SWITCH_BRANCH) == 0) {
-				g_info("client does not understand branches, skipping %s:%s",
-				       fu_release_get_branch(release),
-				       fu_release_get_version(release));
+		g_debug("%s matched %u components", guid, components->len);
+		for (guint i = 0; i < components->len; i++) {
+			XbNode *component = XB_NODE(g_ptr_array_index(components, i));
+			g_autoptr(GError) error_tmp = NULL;
+			if (!fu_engine_add_release_candidates_for_component(component,
+									    candidates,
+									    &error_tmp)) {
+				g_debug("%s", error_tmp->message);
 				continue;
 			}
-			fu_release_add_flag(release, FWUPD_RELEASE_FLAG_IS_ALTERNATE_BRANCH);
 		}
+	}
+	return candidates;
+}
 
-		/* test for upgrade or downgrade */
-		vercmp = fu_version_compare(fu_release_get_version(release),
-					    fu_device_get_version(device),
-					    fmt);
-		if (vercmp > 0)
-			fu_release_add_flag(release, FWUPD_RELEASE_FLAG_IS_UPGRADE);
-		else if (vercmp < 0)
-			fu_release_add_flag(release, FWUPD_RELEASE_FLAG_IS_DOWNGRADE);
+/* the release nodes only depend on the device GUIDs, version format and the silo */
+static FuEngineReleaseCandidates *
+fu_engine_get_release_candidates(FuEngine *self, FuDevice *device)
+{
+	const gchar *device_id = fu_device_get_id(device);
+	FuEngineReleaseCandidates *candidates;
 
-		/* lower than allowed to downgrade to */
-		if (fu_device_get_version_lowest(device) != NULL &&
-		    fu_version_compare(fu_release_get_version(release),
-				       fu_device_get_version_lowest(device),
-				       fmt) < 0) {
-			fu_release_add_flag(release, FWUPD_RELEASE_FLAG_BLOCKED_VERSION);
-		}
+	if (device_id == NULL)
+		return NULL;
+	candidates = g_hash_table_lookup(self->release_candidates, device_id);
+	if (candidates != NULL &&
+	    candidates->fmt == fu_device_get_version_format(device) &&
+	    candidates->guids_len == fu_device_get_guids(device)->len)
+		return candidates;
+	candidates = fu_engine_release_candidates_new(self, device);
+	g_hash_table_insert(self->release_candidates, g_strdup(device_id), candidates);
+	return candidates;
+}
 
-		/* manually blocked */
-		if (fu_engine_check_release_is_blocked(self, release))
-			fu_release_add_flag(release, FWUPD_RELEASE_FLAG_BLOCKED_APPROVAL);
+/* returns %TRUE if the release cannot possibly be returned with this filter */
+static gboolean
+fu_engine_release_candidate_is_filtered(FuEngineReleaseCandidate *item,
+					FuDevice *device,
+					FuEngineReleaseFilter filter,
+					GString *error_str)
+{
+	gint vercmp;
 
-		/* check if remote is filtering firmware */
-		remote_id = fwupd_release_get_remote_id(FWUPD_RELEASE(release));
-		if (remote_id != NULL) {
-			FwupdRemote *remote = fu_engine_get_remote_by_id(self, remote_id, NULL);
-			if (remote != NULL &&
-			    fwupd_remote_has_flag(remote, FWUPD_REMOTE_FLAG_APPROVAL_REQUIRED) &&
-			    !fu_engine_check_release_is_approved(self, FWUPD_RELEASE(release))) {
-				fu_release_add_flag(release, FWUPD_RELEASE_FLAG_BLOCKED_APPROVAL);
-			}
+	if (filter == FU_ENGINE_RELEASE_FILTER_NONE || item->version_key == NULL)
+		return FALSE;
+	if (fu_device_get_version(device) == NULL)
+		return FALSE;
+	vercmp = fu_version_key_compare(item->version_key, fu_device_get_version_key(device));
+	if (vercmp == 0) {
+		if (error_str != NULL) {
+			g_string_append_printf(error_str,
+					       "%s=same, ",
+					       fu_version_key_get_version(item->version_key));
 		}
-
-		/* add update message if exists but device doesn't already have one */
-		update_message = fwupd_release_get_update_message(FWUPD_RELEASE(release));
-		if (fu_device_get_update_message(device) == NULL && update_message != NULL) {
-			fu_device_set_update_message(device, update_message);
+		return TRUE;
+	}
+	if (filter == FU_ENGINE_RELEASE_FILTER_UPGRADES && vercmp < 0) {
+		if (error_str != NULL) {
+			g_string_append_printf(error_str,
+					       "%s=older, ",
+					       fu_version_key_get_version(item->version_key));
 		}
-		update_image = fwupd_release_get_update_image(FWUPD_RELEASE(release));
-		if (fu_device_get_update_image(device) == NULL && update_image != NULL) {
-			fu_device_set_update_image(device, update_image);
+		return TRUE;
+	}
+	if (filter == FU_ENGINE_RELEASE_FILTER_DOWNGRADES && vercmp > 0) {
+		if (error_str != NULL) {
+			g_string_append_printf(error_str,
+					       "%s=newer, ",
+					       fu_version_key_get_version(item->version_key));
 		}
-		update_request_id = fu_release_get_update_request_id(release);
-		if (fu_device_get_update_request_id(device) == NULL && update_request_id != NULL) {
-			fu_device_add_request_flag(device,
-						   FWUPD_REQUEST_FLAG_ALLOW_GENERIC_MESSAGE);
-			fu_device_set_update_request_id(device, update_request_id);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+fu_engine_add_release_for_device_candidate(FuEngine *self,
+					   FuEngineRequest *request,
+					   FuDevice *device,
+					   FuEngineReleaseCandidate *item,
+					   GPtrArray *releases)
+{
+	FwupdFeatureFlags feature_flags = fu_engine_request_get_feature_flags(request);
+	FwupdVersionFormat fmt = fu_device_get_version_format(device);
+	FwupdInstallFlags install_flags =
+	    FWUPD_INSTALL_FLAG_IGNORE_VID_PID | FWUPD_INSTALL_FLAG_ALLOW_BRANCH_SWITCH |
+	    FWUPD_INSTALL_FLAG_ALLOW_REINSTALL | FWUPD_INSTALL_FLAG_ALLOW_OLDER;
+	const gchar *remote_id;
+	const gchar *update_message;
+	const gchar *update_image;
+	const gchar *update_request_id;
+	gint vercmp;
+	GPtrArray *checksums;
+	GPtrArray *locations;
+	g_autoptr(FuRelease) release = fu_release_new();
+	g_autoptr(GError) error_loop = NULL;
+
+	/* create new FwupdRelease for the XbNode */
+	fu_release_set_request(release, request);
+	fu_release_set_device(release, device);
+	if (!fu_engine_load_release(self,
+				    release,
+				    NULL, /* cabinet */
+				    item->component,
+				    item->rel,
+				    install_flags,
+				    &error_loop)) {
+		g_debug("failed to set release for component: %s", error_loop->message);
+		return;
+	}
+
+	/* fall back to quirk-provided value */
+	if (fwupd_release_get_install_duration(FWUPD_RELEASE(release)) == 0) {
+		fwupd_release_set_install_duration(FWUPD_RELEASE(release),
+						   fu_device_get_install_duration(device));
+	}
+
+	/* invalid */
+	locations = fwupd_release_get_locations(FWUPD_RELEASE(release));
+	if (locations->len == 0) {
+		g_autofree gchar *str = fwupd_codec_to_string(FWUPD_CODEC(release));
+		g_debug("no locations for %s", str);
+		return;
+	}
+	checksums = fu_release_get_checksums(release);
+	if (checksums->len == 0) {
+		g_autofree gchar *str = fwupd_codec_to_string(FWUPD_CODEC(release));
+		g_debug("no locations for %s", str);
+		return;
+	}
+
+	/* different branch */
+	if (g_strcmp0(fu_release_get_branch(release), fu_device_get_branch(device)) != 0) {
+		if ((feature_flags & FWUPD_FEATURE_FLAG_SWITCH_BRANCH) == 0) {
+			g_info("client does not understand branches, skipping %s:%s",
+			       fu_release_get_branch(release),
+			       fu_release_get_version(release));
+			return;
 		}
+		fu_release_add_flag(release, FWUPD_RELEASE_FLAG_IS_ALTERNATE_BRANCH);
+	}
 
-		/* success */
-		g_ptr_array_add(releases, g_steal_pointer(&release));
+	/* test for upgrade or downgrade */
+	vercmp = fu_version_key_compare(fu_release_get_version_key(release, fmt),
+					fu_device_get_version_key(device));
+	if (vercmp > 0)
+		fu_release_add_flag(release, FWUPD_RELEASE_FLAG_IS_UPGRADE);
+	else if (vercmp < 0)
+		fu_release_add_flag(release, FWUPD_RELEASE_FLAG_IS_DOWNGRADE);
 
-		/* if we're only checking for SUPPORTED then *any* release is good enough */
-		if (fu_engine_request_has_flag(request, FU_ENGINE_REQUEST_FLAG_ANY_RELEASE) &&
-		    releases->len > 0)
-			break;
+	/* lower than allowed to downgrade to */
+	if (fu_device_get_version_lowest(device) != NULL &&
+	    fu_version_compare(fu_release_get_version(release),
+			       fu_device_get_version_lowest(device),
+			       fmt) < 0) {
+		fu_release_add_flag(release, FWUPD_RELEASE_FLAG_BLOCKED_VERSION);
+	}
+
+	/* manually blocked */
+	if (fu_engine_check_release_is_blocked(self, release))
+		fu_release_add_flag(release, FWUPD_RELEASE_FLAG_BLOCKED_APPROVAL);
+
+	/* check if remote is filtering firmware */
+	remote_id = fwupd_release_get_remote_id(FWUPD_RELEASE(release));
+	if (remote_id != NULL) {
+		FwupdRemote *remote = fu_engine_get_remote_by_id(self, remote_id, NULL);
+		if (remote != NULL &&
+		    fwupd_remote_has_flag(remote, FWUPD_REMOTE_FLAG_APPROVAL_REQUIRED) &&
+		    !fu_engine_check_release_is_approved(self, FWUPD_RELEASE(release))) {
+			fu_release_add_flag(release, FWUPD_RELEASE_FLAG_BLOCKED_APPROVAL);
+		}
+	}
+
+	/* add update message if exists but device doesn't already have one */
+	update_message = fwupd_release_get_update_message(FWUPD_RELEASE(release));
+	if (fu_device_get_update_message(device) == NULL && update_message != NULL) {
+		fu_device_set_update_message(device, update_message);
+	}
+	update_image = fwupd_release_get_update_image(FWUPD_RELEASE(release));
+	if (fu_device_get_update_image(device) == NULL && update_image != NULL) {
+		fu_device_set_update_image(device, update_image);
+	}
+	update_request_id = fu_release_get_update_request_id(release);
+	if (fu_device_get_update_request_id(device) == NULL && update_request_id != NULL) {
+		fu_device_add_request_flag(device, FWUPD_REQUEST_FLAG_ALLOW_GENERIC_MESSAGE);
+		fu_device_set_update_request_id(device, update_request_id);
 	}
 
 	/* success */
-	return TRUE;
+	g_ptr_array_add(releases, g_steal_pointer(&release));
 }
 
 static const gchar *
@@ -5159,15 +5618,47 @@ fu_engine_get_branch_fallback(const gchar *nullable_branch)
 	return nullable_branch;
 }
 
-GPtrArray *
-fu_engine_get_releases_for_device(FuEngine *self,
-				  FuEngineRequest *request,
-				  FuDevice *device,
-				  GError **error)
+/* returns %TRUE if loading the release could change the device, even if it is filtered */
+static gboolean
+fu_engine_release_candidate_has_side_effects(FuEngineReleaseCandidate *item, FuDevice *device)
 {
-	GPtrArray *device_guids;
+	if (!fu_device_has_flag(device, FWUPD_DEVICE_FLAG_HAS_MULTIPLE_BRANCHES) &&
+	    g_strcmp0(fu_engine_get_branch_fallback(item->branch),
+		      fu_engine_get_branch_fallback(fu_device_get_branch(device))) != 0)
+		return TRUE;
+	if (!item->has_update_values)
+		return FALSE;
+	return fu_device_get_update_message(device) == NULL ||
+	       fu_device_get_update_image(device) == NULL ||
+	       fu_device_get_update_request_id(device) == NULL;
+}
+
+static void
+fu_engine_add_release_branches(GPtrArray *branches, GPtrArray *releases)
+{
+	for (guint i = 0; i < releases->len; i++) {
+		FwupdRelease *rel_tmp = FWUPD_RELEASE(g_ptr_array_index(releases, i));
+		const gchar *branch_tmp =
+		    fu_engine_get_branch_fallback(fwupd_release_get_branch(rel_tmp));
+		if (g_ptr_array_find_with_equal_func(branches, branch_tmp, g_str_equal, NULL))
+			continue;
+		g_ptr_array_add(branches, g_strdup(branch_tmp));
+	}
+}
+
+static GPtrArray *
+fu_engine_get_releases_for_device_filtered(FuEngine *self,
+					   FuEngineRequest *request,
+					   FuDevice *device,
+					   FuEngineReleaseFilter filter,
+					   GString *error_str,
+					   GError **error)
+{
+	FuEngineReleaseCandidates *candidates;
+	g_autoptr(FuEngineReleaseCandidates) candidates_tmp = NULL;
 	g_autoptr(GPtrArray) branches = NULL;
 	g_autoptr(GPtrArray) releases = NULL;
+	g_autoptr(GPtrArray) releases_filtered = NULL;
 
 	/* no components in silo */
 	if (self->query_component_by_guid == NULL) {
@@ -5208,72 +5699,70 @@ fu_engine_get_releases_for_device(FuEngine *self,
 		return NULL;
 	}
 
-	/* get all the components that provide any of these GUIDs */
-	device_guids = fu_device_get_guids(device);
-	releases = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
-	for (guint j = 0; j < device_guids->len; j++) {
-		const gchar *guid = g_ptr_array_index(device_guids, j);
-		g_autoptr(GError) error_local = NULL;
-		g_autoptr(GPtrArray) components = NULL;
-		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
-
-		xb_query_context_set_flags(&context, XB_QUERY_FLAG_USE_INDEXES);
-		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, guid, NULL);
-		components = xb_silo_query_with_context(self->silo,
-							self->query_component_by_guid,
-							&context,
-							&error_local);
-		if (components == NULL) {
-			g_debug("%s was not found: %s", guid, error_local->message);
-			continue;
-		}
+	/* the release nodes are cached, but the FuRelease objects depend on the request */
+	candidates = fu_engine_get_release_candidates(self, device);
+	if (candidates == NULL) {
+		candidates_tmp = fu_engine_release_candidates_new(self, device);
+		candidates = candidates_tmp;
+	}
 
-		/* find all the releases that pass all the requirements */
-		g_debug("%s matched %u components", guid, components->len);
-		for (guint i = 0; i < components->len; i++) {
-			XbNode *component = XB_NODE(g_ptr_array_index(components, i));
-			g_autoptr(GError) error_tmp = NULL;
-			if (!fu_engine_add_releases_for_device_component(self,
-									 request,
-									 device,
-									 component,
-									 releases,
-									 &error_tmp)) {
-				g_debug("%s", error_tmp->message);
-				continue;
+	/* find all the releases that pass all the requirements */
+	releases = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	releases_filtered = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	for (guint i = 0; i < candidates->items->len; i++) {
+		FuEngineReleaseCandidate *item = g_ptr_array_index(candidates->items, i);
+
+		/* only load the releases that can possibly be used, or that set device properties */
+		if (fu_engine_release_candidate_is_filtered(item, device, filter, error_str)) {
+			if (fu_engine_release_candidate_has_side_effects(item, device)) {
+				fu_engine_add_release_for_device_candidate(self,
+									   request,
+									   device,
+									   item,
+									   releases_filtered);
 			}
+			continue;
 		}
-		g_debug("%s matched %u releases", guid, releases->len);
+		fu_engine_add_release_for_device_candidate(self, request, device, item, releases);
 
 		/* if we're only checking for SUPPORTED then *any* release is good enough */
 		if (fu_engine_request_has_flag(request, FU_ENGINE_REQUEST_FLAG_ANY_RELEASE) &&
 		    releases->len > 0)
 			break;
 	}
+	g_debug("%u candidates matched %u releases", candidates->items->len, releases->len);
 
 	/* are there multiple branches available */
 	branches = g_ptr_array_new_with_free_func(g_free);
 	g_ptr_array_add(branches,
 			g_strdup(fu_engine_get_branch_fallback(fu_device_get_branch(device))));
-	for (guint i = 0; i < releases->len; i++) {
-		FwupdRelease *rel_tmp = FWUPD_RELEASE(g_ptr_array_index(releases, i));
-		const gchar *branch_tmp =
-		    fu_engine_get_branch_fallback(fwupd_release_get_branch(rel_tmp));
-		if (g_ptr_array_find_with_equal_func(branches, branch_tmp, g_str_equal, NULL))
-			continue;
-		g_ptr_array_add(branches, g_strdup(branch_tmp));
-	}
+	fu_engine_add_release_branches(branches, releases);
+	fu_engine_add_release_branches(branches, releases_filtered);
 	if (branches->len > 1)
 		fu_device_add_flag(device, FWUPD_DEVICE_FLAG_HAS_MULTIPLE_BRANCHES);
 
-	/* return the compound error */
-	if (releases->len == 0) {
+	/* return the compound error, unless the caller is going to build a better one */
+	if (releases->len == 0 && (error_str == NULL || error_str->len == 0)) {
 		g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO, "No releases found");
 		return NULL;
 	}
 	return g_steal_pointer(&releases);
 }
 
+GPtrArray *
+fu_engine_get_releases_for_device(FuEngine *self,
+				  FuEngineRequest *request,
+				  FuDevice *device,
+				  GError **error)
+{
+	return fu_engine_get_releases_for_device_filtered(self,
+							  request,
+							  device,
+							  FU_ENGINE_RELEASE_FILTER_NONE,
+							  NULL,
+							  error);
+}
+
 /**
  * fu_engine_get_releases:
  * @self: a #FuEngine
@@ -5386,7 +5875,13 @@ fu_engine_get_downgrades(FuEngine *self,
 		return NULL;
 
 	/* get all the releases for the device */
-	releases_tmp = fu_engine_get_releases_for_device(self, request, device, error);
+	releases_tmp =
+	    fu_engine_get_releases_for_device_filtered(self,
+						       request,
+						       device,
+						       FU_ENGINE_RELEASE_FILTER_DOWNGRADES,
+						       error_str,
+						       error);
 	if (releases_tmp == NULL)
 		return NULL;
 	releases = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
@@ -5618,7 +6113,13 @@ fu_engine_get_upgrades(FuEngine *self,
 	}
 
 	/* get all the releases for the device */
-	releases_tmp = fu_engine_get_releases_for_device(self, request, device, error);
+	releases_tmp =
+	    fu_engine_get_releases_for_device_filtered(self,
+						       request,
+						       device,
+						       FU_ENGINE_RELEASE_FILTER_UPGRADES,
+						       error_str,
+						       error);
 	if (releases_tmp == NULL)
 		return NULL;
 	releases = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
@@ -5844,6 +6345,7 @@ fu_engine_plugins_coldplug(FuEngine *self, FuProgress *progress)
 {
 	GPtrArray *plugins;
 	g_autoptr(GString) str = g_string_new(NULL);
+	g_auto(FuTraceSpan) span = fu_trace_span_begin("engine", "plugins_coldplug", NULL);
 
 	/* exec */
 	plugins = fu_plugin_list_get_all(self->plugin_list);
@@ -6162,6 +6664,52 @@ fu_engine_ensure_device_emulation_tag(FuEngine *self, FuDevice *device)
 	fu_device_add_flag(device, FWUPD_DEVICE_FLAG_EMULATION_TAG);
 }
 
+/* so the slow hardware reads can be skipped when the daemon next starts */
+static void
+fu_engine_save_device_setup_cache(FuEngine *self, FuDevice *device)
+{
+	const gchar *cache_id = fu_device_get_setup_cache_id(device);
+	GHashTable *values = fu_device_get_setup_cache(device);
+	g_autoptr(GError) error_local = NULL;
+
+	if (cache_id == NULL || values == NULL)
+		return;
+	if (fu_context_get_setup_cache(self->ctx, cache_id) == values)
+		return;
+	if (!fu_history_set_setup_cache(self->history, cache_id, values, &error_local)) {
+		if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+			g_debug("failed to save setup cache: %s", error_local->message);
+			return;
+		}
+		g_warning("failed to save setup cache: %s", error_local->message);
+		return;
+	}
+	fu_context_add_setup_cache(self->ctx, cache_id, values);
+}
+
+static void
+fu_engine_ensure_device_retry_latency(FuEngine *self, FuDevice *device)
+{
+	guint latency = 0;
+
+	/* already done */
+	if (!fu_device_has_private_flag(device, FU_DEVICE_PRIVATE_FLAG_RETRY_ADAPTIVE))
+		return;
+	if (fu_device_get_retry_latency(device) > 0)
+		return;
+	if (fu_device_get_guid_default(device) == NULL)
+		return;
+	if (!fu_history_get_retry_latency(self->history,
+					  fu_device_get_guid_default(device),
+					  &latency,
+					  NULL))
+		return;
+
+	/* success */
+	g_debug("using retry latency of %ums for %s", latency, fu_device_get_id(device));
+	fu_device_set_retry_latency(device, latency);
+}
+
 void
 fu_engine_add_device(FuEngine *self, FuDevice *device)
 {
@@ -6236,6 +6784,12 @@ fu_engine_add_device(FuEngine *self, FuDevice *device)
 	/* check if the device needs emulation-tag */
 	fu_engine_ensure_device_emulation_tag(self, device);
 
+	/* learned from previous updates */
+	fu_engine_ensure_device_retry_latency(self, device);
+
+	/* values read from the hardware in ->setup() */
+	fu_engine_save_device_setup_cache(self, device);
+
 	/* set or clear the SUPPORTED flag */
 	fu_engine_ensure_device_supported(self, device);
 
@@ -6317,8 +6871,8 @@ fu_engine_context_security_changed_cb(FuContext *ctx, gpointer user_data)
 {
 	FuEngine *self = FU_ENGINE(user_data);
 
-	/* invalidate host security attributes */
-	g_clear_pointer(&self->host_security_id, g_free);
+	/* invalidate host security attributes, the plugin that changed is not known */
+	fu_engine_invalidate_security_attrs(self);
 
 	/* make UI refresh */
 	fu_engine_emit_changed(self);
@@ -6743,6 +7297,7 @@ fu_engine_fix_host_security_attr(FuEngine *self, const gchar *appstream_id, GErr
 		g_debug("ignoring %s", error_local->message);
 	} else {
 		g_info("fixed %s", fwupd_security_attr_get_appstream_id(hsi_attr));
+		fu_engine_invalidate_security_attrs(self);
 		return TRUE;
 	}
 
@@ -6764,10 +7319,13 @@ fu_engine_fix_host_security_attr(FuEngine *self, const gchar *appstream_id, GErr
 			    fwupd_security_attr_get_bios_setting_id(hsi_attr));
 		return FALSE;
 	}
-	return fwupd_bios_setting_write_value(
-	    bios_attr,
-	    fwupd_security_attr_get_bios_setting_target_value(hsi_attr),
-	    error);
+	if (!fwupd_bios_setting_write_value(
+		bios_attr,
+		fwupd_security_attr_get_bios_setting_target_value(hsi_attr),
+		error))
+		return FALSE;
+	fu_engine_invalidate_security_attrs(self);
+	return TRUE;
 }
 
 /**
@@ -6849,10 +7407,13 @@ fu_engine_undo_host_security_attr(FuEngine *self, const gchar *appstream_id, GEr
 	    error);
 	if (hsi_attr_old == NULL)
 		return FALSE;
-	return fwupd_bios_setting_write_value(
-	    bios_attr,
-	    fwupd_security_attr_get_bios_setting_current_value(hsi_attr_old),
-	    error);
+	if (!fwupd_bios_setting_write_value(
+		bios_attr,
+		fwupd_security_attr_get_bios_setting_current_value(hsi_attr_old),
+		error))
+		return FALSE;
+	fu_engine_invalidate_security_attrs(self);
+	return TRUE;
 }
 
 static gboolean
@@ -6964,6 +7525,145 @@ fu_engine_load_host_emulation(FuEngine *self, const gchar *fn, GError **error)
 	return TRUE;
 }
 
+#ifdef HAVE_HSI
+/* passing NULL to %s is undefined behavior */
+static const gchar *
+fu_engine_security_attrs_fingerprint_str(const gchar *str)
+{
+	return str != NULL ? str : "(null)";
+}
+
+/* everything a later producer could read, but not the created timestamp */
+static gchar *
+fu_engine_security_attrs_fingerprint(FuSecurityAttrs *attrs)
+{
+	g_autoptr(GPtrArray) items = fu_security_attrs_get_all(attrs);
+	g_autoptr(GString) str = g_string_new(NULL);
+
+	for (guint i = 0; i < items->len; i++) {
+		FwupdSecurityAttr *attr = g_ptr_array_index(items, i);
+		GPtrArray *guids = fwupd_security_attr_get_guids(attr);
+		GPtrArray *obsoletes = fwupd_security_attr_get_obsoletes(attr);
+		g_string_append_printf(str,
+				       "%s|%s|%u|%u|%u|%u|%" G_GUINT64_FORMAT "|%s|%s|%s|%s|%s",
+				       fu_engine_security_attrs_fingerprint_str(
+					   fwupd_security_attr_get_appstream_id(attr)),
+				       fu_engine_security_attrs_fingerprint_str(
+					   fwupd_security_attr_get_plugin(attr)),
+				       fwupd_security_attr_get_level(attr),
+				       fwupd_security_attr_get_result(attr),
+				       fwupd_security_attr_get_result_fallback(attr),
+				       fwupd_security_attr_get_result_success(attr),
+				       fwupd_security_attr_get_flags(attr),
+				       fu_engine_security_attrs_fingerprint_str(
+					   fwupd_security_attr_get_bios_setting_id(attr)),
+				       fu_engine_security_attrs_fingerprint_str(
+					   fwupd_security_attr_get_bios_setting_target_value(attr)),
+				       fu_engine_security_attrs_fingerprint_str(
+					   fwupd_security_attr_get_bios_setting_current_value(attr)),
+				       fu_engine_security_attrs_fingerprint_str(
+					   fwupd_security_attr_get_kernel_current_value(attr)),
+				       fu_engine_security_attrs_fingerprint_str(
+					   fwupd_security_attr_get_kernel_target_value(attr)));
+		for (guint j = 0; j < guids->len; j++) {
+			g_string_append_printf(str,
+					       "|%s",
+					       (const gchar *)g_ptr_array_index(guids, j));
+		}
+		for (guint j = 0; j < obsoletes->len; j++) {
+			g_string_append_printf(str,
+					       "|%s",
+					       (const gchar *)g_ptr_array_index(obsoletes, j));
+		}
+		g_string_append_c(str, '\n');
+	}
+	return g_string_free(g_steal_pointer(&str), FALSE);
+}
+
+static void
+fu_engine_security_attrs_copy_into(FuSecurityAttrs *attrs_src, FuSecurityAttrs *attrs_dst)
+{
+	g_autoptr(GPtrArray) items = fu_security_attrs_get_all(attrs_src);
+	fu_security_attrs_remove_all(attrs_dst);
+	for (guint i = 0; i < items->len; i++) {
+		FwupdSecurityAttr *attr = g_ptr_array_index(items, i);
+		g_autoptr(FwupdSecurityAttr) attr_copy = fwupd_security_attr_copy(attr);
+		fu_security_attrs_append_internal(attrs_dst, attr_copy);
+	}
+}
+
+typedef struct {
+	FuEngine *self;
+	const gchar *fingerprint;	  /* of the attrs when the producer is called */
+	gchar *fingerprint_tmp;		  /* (nullable) */
+	FuSecurityAttrs *attrs_snapshot;  /* (nullable): not yet copied into the host attrs */
+	guint producers_replayed;
+} FuEngineSecurityAttrsHelper;
+
+/*
+ * Producers are called in the same order each time, and can read and modify the attrs added
+ * by earlier producers. If the producer has not been invalidated, and the attrs it would be
+ * given are the same as last time, then the attrs it returned last time are used instead.
+ */
+static void
+fu_engine_ensure_security_attrs_for_producer(FuEngineSecurityAttrsHelper *helper,
+					     GHashTable *cache,
+					     const gchar *key,
+					     FuPlugin *plugin,
+					     FuDevice *device)
+{
+	FuEngine *self = helper->self;
+	FuEngineSecurityAttrsEntry *entry = NULL;
+
+	if (key != NULL)
+		entry = g_hash_table_lookup(cache, key);
+	if (entry != NULL && g_strcmp0(entry->fingerprint_in, helper->fingerprint) == 0) {
+		helper->fingerprint = entry->fingerprint_out;
+		helper->attrs_snapshot = entry->attrs;
+		helper->producers_replayed++;
+		return;
+	}
+
+	/* the producer needs the real attrs from the earlier producers */
+	if (helper->attrs_snapshot != NULL) {
+		fu_engine_security_attrs_copy_into(helper->attrs_snapshot,
+						   self->host_security_attrs);
+		helper->attrs_snapshot = NULL;
+	}
+	if (plugin != NULL)
+		fu_plugin_runner_add_security_attrs(plugin, self->host_security_attrs);
+	if (device != NULL)
+		fu_device_add_security_attrs(device, self->host_security_attrs);
+	if (key == NULL) {
+		g_free(helper->fingerprint_tmp);
+		helper->fingerprint_tmp =
+		    fu_engine_security_attrs_fingerprint(self->host_security_attrs);
+		helper->fingerprint = helper->fingerprint_tmp;
+		return;
+	}
+
+	/* save for next time */
+	entry = g_new0(FuEngineSecurityAttrsEntry, 1);
+	entry->fingerprint_in = g_strdup(helper->fingerprint);
+	entry->fingerprint_out = fu_engine_security_attrs_fingerprint(self->host_security_attrs);
+	entry->attrs = fu_security_attrs_new();
+	fu_engine_security_attrs_copy_into(self->host_security_attrs, entry->attrs);
+	g_hash_table_insert(cache, g_strdup(key), entry);
+	helper->fingerprint = entry->fingerprint_out;
+}
+#endif
+
+/*
+ * The security attrs are cached for each producer, and are invalidated when:
+ *
+ *  - the device that added them changes, or is added or removed
+ *  - a device owned by the plugin that added them changes, or is added or removed
+ *  - a device changes that has a GUID the plugin added to one of its attrs
+ *  - the context emits ::security-changed, the metadata changes, a BIOS setting is modified,
+ *    or an attribute is fixed or reverted, which invalidates all the producers
+ *
+ * Producers that come later are also called again if the attrs they are given have changed.
+ */
 static void
 fu_engine_ensure_security_attrs(FuEngine *self)
 {
@@ -6972,6 +7672,8 @@ fu_engine_ensure_security_attrs(FuEngine *self)
 	g_autoptr(GPtrArray) devices = fu_device_list_get_active(self->device_list);
 	g_autoptr(GPtrArray) vals = NULL;
 	g_autoptr(GError) error = NULL;
+	g_autofree gchar *fingerprint = NULL;
+	FuEngineSecurityAttrsHelper helper = {.self = self};
 
 	/* already valid */
 	if (self->host_security_id != NULL || self->host_emulation)
@@ -6983,18 +7685,36 @@ fu_engine_ensure_security_attrs(FuEngine *self)
 	/* built in */
 	fu_engine_ensure_security_attrs_supported_cpu(self);
 	fu_engine_ensure_security_attrs_tainted(self);
+	fingerprint = fu_engine_security_attrs_fingerprint(self->host_security_attrs);
+	helper.fingerprint = fingerprint;
 
-	/* call into devices */
+	/* call into devices, unless the cached values are still valid */
 	for (guint i = 0; i < devices->len; i++) {
 		FuDevice *device = g_ptr_array_index(devices, i);
-		fu_device_add_security_attrs(device, self->host_security_attrs);
+		fu_engine_ensure_security_attrs_for_producer(&helper,
+							     self->device_security_attrs,
+							     fu_device_get_id(device),
+							     NULL,
+							     device);
 	}
 
-	/* call into plugins */
+	/* call into plugins, unless the cached values are still valid */
 	for (guint j = 0; j < plugins->len; j++) {
 		FuPlugin *plugin_tmp = g_ptr_array_index(plugins, j);
-		fu_plugin_runner_add_security_attrs(plugin_tmp, self->host_security_attrs);
+		fu_engine_ensure_security_attrs_for_producer(&helper,
+							     self->plugin_security_attrs,
+							     fu_plugin_get_name(plugin_tmp),
+							     plugin_tmp,
+							     NULL);
+	}
+	if (helper.attrs_snapshot != NULL) {
+		fu_engine_security_attrs_copy_into(helper.attrs_snapshot,
+						   self->host_security_attrs);
 	}
+	g_debug("reused security attrs from %u of %u producers",
+		helper.producers_replayed,
+		devices->len + plugins->len);
+	g_free(helper.fingerprint_tmp);
 
 	/* sanity check */
 	vals = fu_security_attrs_get_all(self->host_security_attrs);
@@ -8006,6 +8726,30 @@ fu_engine_backends_coldplug(FuEngine *self, FuProgress *progress)
 	}
 }
 
+static void
+fu_engine_load_setup_caches(FuEngine *self)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	g_autoptr(GHashTable) caches = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	caches = fu_history_get_setup_caches(self->history, &error_local);
+	if (caches == NULL) {
+		if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+			g_debug("failed to load setup caches: %s", error_local->message);
+			return;
+		}
+		g_warning("failed to load setup caches: %s", error_local->message);
+		return;
+	}
+	g_hash_table_iter_init(&iter, caches);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		fu_context_add_setup_cache(self->ctx, key, value);
+	g_debug("loaded %u setup caches", g_hash_table_size(caches));
+}
+
 /**
  * fu_engine_load:
  * @self: a #FuEngine
@@ -8030,10 +8774,12 @@ fu_engine_load(FuEngine *self, FuEngineLoadFlags flags, FuProgress *progress, GE
 	g_autoptr(GError) error_quirks = NULL;
 	g_autoptr(GError) error_json_devices = NULL;
 	g_autoptr(GError) error_local = NULL;
+	g_auto(FuTraceSpan) span = FU_TRACE_SPAN_INIT();
 
 	g_return_val_if_fail(FU_IS_ENGINE(self), FALSE);
 	g_return_val_if_fail(FU_IS_PROGRESS(progress), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	span = fu_trace_span_begin("engine", "load", NULL);
 
 	/* avoid re-loading a second time if fu-tool or fu-util request to */
 	if (self->loaded)
@@ -8149,6 +8895,9 @@ fu_engine_load(FuEngine *self, FuEngineLoadFlags flags, FuProgress *progress, GE
 		const gchar *csum = g_ptr_array_index(checksums_blocked, i);
 		fu_engine_add_blocked_firmware(self, csum);
 	}
+
+	/* get the results of previous device setup, before any devices are added */
+	fu_engine_load_setup_caches(self);
 	fu_progress_step_done(progress);
 
 	/* load plugins early, as we have to call ->load() *before* building quirk silo */
@@ -8178,6 +8927,9 @@ fu_engine_load(FuEngine *self, FuEngineLoadFlags flags, FuProgress *progress, GE
 	if ((flags & FU_ENGINE_LOAD_FLAG_NO_IDLE_SOURCES) == 0)
 		fu_idle_set_timeout(self->idle, fu_engine_config_get_idle_timeout(self->config));
 
+	/* coalesce hotplug storms */
+	fu_engine_ensure_udev_events_delay(self);
+
 	/* on a read-only filesystem don't care about the cache GUID */
 	if (flags & FU_ENGINE_LOAD_FLAG_READONLY)
 		quirks_flags |= FU_QUIRKS_LOAD_FLAG_READONLY_FS;
@@ -8804,10 +9556,25 @@ fu_engine_init(FuEngine *self)
 	self->plugin_list = fu_plugin_list_new();
 	self->plugin_filter = g_ptr_array_new_with_free_func(g_free);
 	self->host_security_attrs = fu_security_attrs_new();
+	self->plugin_security_attrs =
+	    g_hash_table_new_full(g_str_hash,
+				  g_str_equal,
+				  g_free,
+				  (GDestroyNotify)fu_engine_security_attrs_entry_free);
+	self->device_security_attrs =
+	    g_hash_table_new_full(g_str_hash,
+				  g_str_equal,
+				  g_free,
+				  (GDestroyNotify)fu_engine_security_attrs_entry_free);
 	self->local_monitors = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 	self->acquiesce_loop = g_main_loop_new(NULL, FALSE);
 	self->device_changed_allowlist =
 	    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	self->release_candidates =
+	    g_hash_table_new_full(g_str_hash,
+				  g_str_equal,
+				  g_free,
+				  (GDestroyNotify)fu_engine_release_candidates_free);
 #ifdef HAVE_PASSIM
 	self->passim_client = passim_client_new();
 #endif
@@ -8857,6 +9624,8 @@ fu_engine_finalize(GObject *obj)
 	g_free(self->host_machine_id);
 	g_free(self->host_security_id);
 	g_object_unref(self->host_security_attrs);
+	g_hash_table_unref(self->plugin_security_attrs);
+	g_hash_table_unref(self->device_security_attrs);
 	g_object_unref(self->idle);
 	g_object_unref(self->config);
 	g_object_unref(self->remote_list);
@@ -8866,6 +9635,7 @@ fu_engine_finalize(GObject *obj)
 	g_ptr_array_unref(self->plugin_filter);
 	g_ptr_array_unref(self->local_monitors);
 	g_hash_table_unref(self->device_changed_allowlist);
+	g_hash_table_unref(self->release_candidates);
 	g_object_unref(self->plugin_list);
 
 	G_OBJECT_CLASS(fu_engine_parent_class)->finalize(obj);
@@ -35,6 +35,12 @@ enum FuEngineRequestFlag {
     AnyRelease = 1 << 1,
 }
 
+enum FuEngineReleaseFilter {
+    None,
+    Upgrades,
+    Downgrades,
+}
+
 #[derive(ToBitString)]
 enum FuIdleInhibit {
     None = 0,
@@ -67,7 +73,7 @@ enum FuUdevMonitorNetlinkGroup {
     Udev,
 }
 
-#[derive(FromString)]
+#[derive(FromString, ToString)]
 enum FuUdevAction {
     Unknown,
     Add,
@@ -37,8 +37,10 @@
  * v12	add install_duration to history
  * v13	add release_flags to history
  * v14	create table emulation_tag
+ * v15	create table retry_latency
+ * v16	create table setup_cache
  */
-#define FU_HISTORY_CURRENT_SCHEMA_VERSION 14
+#define FU_HISTORY_CURRENT_SCHEMA_VERSION 16
 
 static void
 fu_history_finalize(GObject *object);
@@ -237,6 +239,13 @@ fu_history_create_database(FuHistory *self, GError **error)
 			  "hsi_score TEXT DEFAULT NULL);"
 			  "CREATE TABLE emulation_tag (device_id TEXT);"
 			  "CREATE UNIQUE INDEX idx_device_id ON emulation_tag (device_id);"
+			  "CREATE TABLE IF NOT EXISTS retry_latency ("
+			  "guid TEXT PRIMARY KEY,"
+			  "latency INTEGER DEFAULT 0);" /* ms */
+			  "CREATE TABLE IF NOT EXISTS setup_cache ("
+			  "cache_id TEXT PRIMARY KEY,"
+			  "fwupd_version TEXT,"
+			  "data TEXT DEFAULT NULL);"
 			  "COMMIT;",
 			  NULL,
 			  NULL,
@@ -478,6 +487,51 @@ fu_history_migrate_database_v12(FuHistory *self, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_history_migrate_database_v13(FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec(self->db,
+			  "CREATE TABLE IF NOT EXISTS retry_latency ("
+			  "guid TEXT PRIMARY KEY,"
+			  "latency INTEGER DEFAULT 0);",
+			  NULL,
+			  NULL,
+			  NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "Failed to create table: %s",
+			    sqlite3_errmsg(self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static gboolean
+fu_history_migrate_database_v14(FuHistory *self, GError **error)
+{
+	gint rc;
+	rc = sqlite3_exec(self->db,
+			  "CREATE TABLE IF NOT EXISTS setup_cache ("
+			  "cache_id TEXT PRIMARY KEY,"
+			  "fwupd_version TEXT,"
+			  "data TEXT DEFAULT NULL);",
+			  NULL,
+			  NULL,
+			  NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "Failed to create table: %s",
+			    sqlite3_errmsg(self->db));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 /* returns 0 if database is not initialized */
 static guint
 fu_history_get_schema_version(FuHistory *self)
@@ -563,6 +617,14 @@ fu_history_create_or_migrate(FuHistory *self, guint schema_ver, GError **error)
 	case 13:
 		if (!fu_history_migrate_database_v12(self, error))
 			return FALSE;
+	/* fall through */
+	case 14:
+		if (!fu_history_migrate_database_v13(self, error))
+			return FALSE;
+	/* fall through */
+	case 15:
+		if (!fu_history_migrate_database_v14(self, error))
+			return FALSE;
 		/* no longer fall through */
 		break;
 	default:
@@ -1817,6 +1879,322 @@ fu_history_remove_emulation_tag(FuHistory *self, const gchar *device_id, GError
 #endif
 }
 
+/**
+ * fu_history_set_retry_latency:
+ * @self: a #FuHistory
+ * @guid: a device GUID
+ * @latency: delay in ms
+ * @error: (nullable): optional return location for an error
+ *
+ * Saves the delay that device retries usually need before succeeding.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 2.0.7
+ **/
+gboolean
+fu_history_set_retry_latency(FuHistory *self, const gchar *guid, guint latency, GError **error)
+{
+#ifdef HAVE_SQLITE
+	gint rc;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+
+	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
+	g_return_val_if_fail(guid != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load(self, error))
+		return FALSE;
+
+	/* add or replace */
+	rc = sqlite3_prepare_v2(self->db,
+				"INSERT OR REPLACE INTO retry_latency (guid, latency) "
+				"VALUES (?1, ?2)",
+				-1,
+				&stmt,
+				NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "failed to prepare SQL to insert retry latency: %s",
+			    sqlite3_errmsg(self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
+	sqlite3_bind_int64(stmt, 2, latency);
+	return fu_history_stmt_exec(self, stmt, NULL, error);
+#else
+	g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "no sqlite support");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_history_get_retry_latency:
+ * @self: a #FuHistory
+ * @guid: a device GUID
+ * @latency: (out): delay in ms
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets the delay that device retries usually need before succeeding.
+ *
+ * Returns: #TRUE for success, #FALSE if never saved or on failure
+ *
+ * Since: 2.0.7
+ **/
+gboolean
+fu_history_get_retry_latency(FuHistory *self, const gchar *guid, guint *latency, GError **error)
+{
+#ifdef HAVE_SQLITE
+	gint rc;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+
+	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
+	g_return_val_if_fail(guid != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load(self, error))
+		return FALSE;
+
+	/* get */
+	rc = sqlite3_prepare_v2(self->db,
+				"SELECT latency FROM retry_latency WHERE guid = ?1 LIMIT 1;",
+				-1,
+				&stmt,
+				NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "failed to prepare SQL to get retry latency: %s",
+			    sqlite3_errmsg(self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text(stmt, 1, guid, -1, SQLITE_STATIC);
+	rc = sqlite3_step(stmt);
+	if (rc == SQLITE_DONE) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_NOT_FOUND,
+			    "no retry latency for %s",
+			    guid);
+		return FALSE;
+	}
+	if (rc != SQLITE_ROW) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_READ,
+			    "failed to execute prepared statement: %s",
+			    sqlite3_errmsg(self->db));
+		return FALSE;
+	}
+	if (latency != NULL)
+		*latency = (guint)sqlite3_column_int64(stmt, 0);
+	return TRUE;
+#else
+	g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "no sqlite support");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_history_set_setup_cache:
+ * @self: a #FuHistory
+ * @cache_id: a device setup cache ID
+ * @values: (element-type utf8 utf8): the values saved by the device
+ * @error: (nullable): optional return location for an error
+ *
+ * Saves the results of `FuDevice->setup()` so they can be reused when the daemon restarts.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 2.0.7
+ **/
+gboolean
+fu_history_set_setup_cache(FuHistory *self,
+			   const gchar *cache_id,
+			   GHashTable *values,
+			   GError **error)
+{
+#ifdef HAVE_SQLITE
+	gint rc;
+	g_autofree gchar *data = NULL;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+
+	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
+	g_return_val_if_fail(cache_id != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load(self, error))
+		return FALSE;
+
+	/* add or replace */
+	data = fu_history_convert_hash_to_string(values);
+	rc = sqlite3_prepare_v2(self->db,
+				"INSERT OR REPLACE INTO setup_cache "
+				"(cache_id, fwupd_version, data) VALUES (?1, ?2, ?3)",
+				-1,
+				&stmt,
+				NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "failed to prepare SQL to insert setup cache: %s",
+			    sqlite3_errmsg(self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text(stmt, 1, cache_id, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, PACKAGE_VERSION, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 3, data, -1, SQLITE_STATIC);
+	return fu_history_stmt_exec(self, stmt, NULL, error);
+#else
+	g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "no sqlite support");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_history_remove_setup_cache:
+ * @self: a #FuHistory
+ * @cache_id: a device setup cache ID
+ * @error: (nullable): optional return location for an error
+ *
+ * Removes the saved results of `FuDevice->setup()`, typically as the firmware is being written.
+ *
+ * Returns: #TRUE for success, #FALSE for failure
+ *
+ * Since: 2.0.7
+ **/
+gboolean
+fu_history_remove_setup_cache(FuHistory *self, const gchar *cache_id, GError **error)
+{
+#ifdef HAVE_SQLITE
+	gint rc;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+
+	g_return_val_if_fail(FU_IS_HISTORY(self), FALSE);
+	g_return_val_if_fail(cache_id != NULL, FALSE);
+
+	/* lazy load */
+	if (!fu_history_load(self, error))
+		return FALSE;
+
+	rc = sqlite3_prepare_v2(self->db,
+				"DELETE FROM setup_cache WHERE cache_id = ?1;",
+				-1,
+				&stmt,
+				NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "failed to prepare SQL to delete setup cache: %s",
+			    sqlite3_errmsg(self->db));
+		return FALSE;
+	}
+	sqlite3_bind_text(stmt, 1, cache_id, -1, SQLITE_STATIC);
+	return fu_history_stmt_exec(self, stmt, NULL, error);
+#else
+	g_set_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED, "no sqlite support");
+	return FALSE;
+#endif
+}
+
+/**
+ * fu_history_get_setup_caches:
+ * @self: a #FuHistory
+ * @error: (nullable): optional return location for an error
+ *
+ * Gets all the saved results of `FuDevice->setup()`. Any results saved by a different version
+ * of fwupd are deleted, as the plugin may now read different values.
+ *
+ * Returns: (transfer container) (element-type utf8 GHashTable): cache IDs to values
+ *
+ * Since: 2.0.7
+ **/
+GHashTable *
+fu_history_get_setup_caches(FuHistory *self, GError **error)
+{
+	g_autoptr(GHashTable) caches = g_hash_table_new_full(g_str_hash,
+							     g_str_equal,
+							     g_free,
+							     (GDestroyNotify)g_hash_table_unref);
+#ifdef HAVE_SQLITE
+	gint rc;
+	g_autoptr(sqlite3_stmt) stmt_delete = NULL;
+	g_autoptr(sqlite3_stmt) stmt = NULL;
+
+	g_return_val_if_fail(FU_IS_HISTORY(self), NULL);
+
+	/* lazy load */
+	if (!fu_history_load(self, error))
+		return NULL;
+
+	/* remove stale entries */
+	rc = sqlite3_prepare_v2(self->db,
+				"DELETE FROM setup_cache WHERE fwupd_version != ?1;",
+				-1,
+				&stmt_delete,
+				NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "failed to prepare SQL to delete setup cache: %s",
+			    sqlite3_errmsg(self->db));
+		return NULL;
+	}
+	sqlite3_bind_text(stmt_delete, 1, PACKAGE_VERSION, -1, SQLITE_STATIC);
+	if (!fu_history_stmt_exec(self, stmt_delete, NULL, error))
+		return NULL;
+
+	/* get all */
+	rc = sqlite3_prepare_v2(self->db,
+				"SELECT cache_id, data FROM setup_cache;",
+				-1,
+				&stmt,
+				NULL);
+	if (rc != SQLITE_OK) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_INTERNAL,
+			    "failed to prepare SQL to get setup cache: %s",
+			    sqlite3_errmsg(self->db));
+		return NULL;
+	}
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+		const gchar *cache_id = (const gchar *)sqlite3_column_text(stmt, 0);
+		const gchar *data = (const gchar *)sqlite3_column_text(stmt, 1);
+		g_autoptr(GHashTable) values = NULL;
+		g_auto(GStrv) split = NULL;
+
+		if (cache_id == NULL || data == NULL)
+			continue;
+		values = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		split = g_strsplit(data, ";", -1);
+		for (guint i = 0; split[i] != NULL; i++) {
+			g_auto(GStrv) kv = g_strsplit(split[i], "=", 2);
+			if (g_strv_length(kv) != 2)
+				continue;
+			g_hash_table_insert(values, g_strdup(kv[0]), g_strdup(kv[1]));
+		}
+		g_hash_table_insert(caches, g_strdup(cache_id), g_steal_pointer(&values));
+	}
+	if (rc != SQLITE_DONE) {
+		g_set_error(error,
+			    FWUPD_ERROR,
+			    FWUPD_ERROR_WRITE,
+			    "failed to execute prepared statement: %s",
+			    sqlite3_errmsg(self->db));
+		return NULL;
+	}
+#endif
+	return g_steal_pointer(&caches);
+}
+
 static void
 fu_history_housekeeping_cb(FuContext *ctx, FuHistory *self)
 {
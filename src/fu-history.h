@@ -67,3 +67,19 @@ fu_history_remove_emulation_tag(FuHistory *self, const gchar *device_id, GError
 gboolean
 fu_history_has_emulation_tag(FuHistory *self, const gchar *device_id, GError **error)
     G_GNUC_NON_NULL(1);
+gboolean
+fu_history_set_retry_latency(FuHistory *self, const gchar *guid, guint latency, GError **error)
+    G_GNUC_NON_NULL(1, 2);
+gboolean
+fu_history_get_retry_latency(FuHistory *self, const gchar *guid, guint *latency, GError **error)
+    G_GNUC_NON_NULL(1, 2);
+gboolean
+fu_history_set_setup_cache(FuHistory *self,
+			   const gchar *cache_id,
+			   GHashTable *values,
+			   GError **error) G_GNUC_NON_NULL(1, 2, 3);
+gboolean
+fu_history_remove_setup_cache(FuHistory *self, const gchar *cache_id, GError **error)
+    G_GNUC_NON_NULL(1, 2);
+GHashTable *
+fu_history_get_setup_caches(FuHistory *self, GError **error) G_GNUC_NON_NULL(1);
@@ -31,6 +31,7 @@ struct _FuRelease {
 	gchar *device_version_old;
 	GPtrArray *soft_reqs; /* nullable, element-type XbNode */
 	GPtrArray *hard_reqs; /* nullable, element-type XbNode */
+	FuVersionKey *version_key; /* nullable */
 	guint64 priority;
 };
 
@@ -98,6 +99,28 @@ fu_release_get_request(FuRelease *self)
 	return self->request;
 }
 
+/**
+ * fu_release_get_version_key:
+ * @self: a #FuRelease
+ * @fmt: a version format, e.g. %FWUPD_VERSION_FORMAT_TRIPLET
+ *
+ * Gets the release version as a pre-parsed key, which is rebuilt only if the version or the
+ * version format changes.
+ *
+ * Returns: a #FuVersionKey
+ **/
+const FuVersionKey *
+fu_release_get_version_key(FuRelease *self, FwupdVersionFormat fmt)
+{
+	const gchar *version = fu_release_get_version(self);
+	g_return_val_if_fail(FU_IS_RELEASE(self), NULL);
+	if (self->version_key == NULL || !fu_version_key_matches(self->version_key, version, fmt)) {
+		fu_version_key_free(self->version_key);
+		self->version_key = fu_version_key_new(version, fmt);
+	}
+	return self->version_key;
+}
+
 /**
  * fu_release_get_device_version_old:
  * @self: a #FuRelease
@@ -283,13 +306,21 @@ fu_release_get_localized_xpath(FuRelease *self, const gchar *element)
 	return g_string_free(xpath, FALSE);
 }
 
-/* convert hex and decimal versions to dotted style */
-static gchar *
-fu_release_get_release_version(FuRelease *self, const gchar *version, GError **error)
+/**
+ * fu_release_convert_version:
+ * @version: a release version from the metadata, e.g. `0x123`
+ * @fmt: the device version format, e.g. %FWUPD_VERSION_FORMAT_TRIPLET
+ * @error: (nullable): optional return location for an error
+ *
+ * Converts hex and decimal release versions into the dotted format used by the device, which is
+ * what fu_release_load() does to the `version` attribute of the release node.
+ *
+ * Returns: the version string, or %NULL if the version is not a valid integer
+ **/
+gchar *
+fu_release_convert_version(const gchar *version, FwupdVersionFormat fmt, GError **error)
 {
-	FwupdVersionFormat fmt = fu_device_get_version_format(self->device);
 	guint64 ver_uint32;
-	g_autoptr(GError) error_local = NULL;
 
 	/* already dotted notation */
 	if (g_strstr_len(version, -1, ".") != NULL)
@@ -300,14 +331,9 @@ fu_release_get_release_version(FuRelease *self, const gchar *version, GError **e
 		return g_strdup(version);
 
 	/* parse as integer */
-	if (!fu_strtoull(version,
-			 &ver_uint32,
-			 1,
-			 G_MAXUINT32,
-			 FU_INTEGER_BASE_AUTO,
-			 &error_local)) {
-		g_warning("invalid release version %s: %s", version, error_local->message);
-		return g_strdup(version);
+	if (!fu_strtoull(version, &ver_uint32, 1, G_MAXUINT32, FU_INTEGER_BASE_AUTO, error)) {
+		g_prefix_error(error, "invalid release version %s: ", version);
+		return NULL;
 	}
 
 	/* convert to dotted decimal */
@@ -718,9 +744,9 @@ fu_release_check_requirements(FuRelease *self,
 	}
 
 	/* is this a downgrade or re-install */
-	vercmp = fu_version_compare(version,
-				    fu_release_get_version(self),
-				    fu_device_get_version_format(self->device));
+	vercmp = fu_version_key_compare(
+	    fu_device_get_version_key(self->device),
+	    fu_release_get_version_key(self, fu_device_get_version_format(self->device)));
 	if (fu_device_has_flag(self->device, FWUPD_DEVICE_FLAG_ONLY_VERSION_UPGRADE) &&
 	    vercmp > 0) {
 		g_set_error(error,
@@ -893,9 +919,14 @@ fu_release_load(FuRelease *self,
 	}
 	if (self->device != NULL) {
 		g_autofree gchar *version_rel = NULL;
-		version_rel = fu_release_get_release_version(self, tmp, error);
-		if (version_rel == NULL)
-			return FALSE;
+		g_autoptr(GError) error_local = NULL;
+		version_rel = fu_release_convert_version(tmp,
+							 fu_device_get_version_format(self->device),
+							 &error_local);
+		if (version_rel == NULL) {
+			g_warning("%s", error_local->message);
+			version_rel = g_strdup(tmp);
+		}
 		fwupd_release_set_version(FWUPD_RELEASE(self), version_rel);
 	} else {
 		fwupd_release_set_version(FWUPD_RELEASE(self), tmp);
@@ -1253,9 +1284,9 @@ fu_release_compare(FuRelease *release1, FuRelease *release2)
 	}
 
 	/* FWUPD_DEVICE_FLAG_INSTALL_ALL_RELEASES has to be from oldest to newest */
-	return fu_version_compare(fu_release_get_version(release1),
-				  fu_release_get_version(release2),
-				  fu_device_get_version_format(device1));
+	return fu_version_key_compare(
+	    fu_release_get_version_key(release1, fu_device_get_version_format(device1)),
+	    fu_release_get_version_key(release2, fu_device_get_version_format(device1)));
 }
 
 static void
@@ -1271,6 +1302,7 @@ fu_release_finalize(GObject *obj)
 
 	g_free(self->update_request_id);
 	g_free(self->device_version_old);
+	fu_version_key_free(self->version_key);
 	if (self->request != NULL)
 		g_object_unref(self->request);
 	if (self->device != NULL)
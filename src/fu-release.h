@@ -64,6 +64,11 @@ const gchar *
 fu_release_get_update_request_id(FuRelease *self) G_GNUC_NON_NULL(1);
 const gchar *
 fu_release_get_device_version_old(FuRelease *self) G_GNUC_NON_NULL(1);
+const FuVersionKey *
+fu_release_get_version_key(FuRelease *self, FwupdVersionFormat fmt) G_GNUC_NON_NULL(1);
+gchar *
+fu_release_convert_version(const gchar *version, FwupdVersionFormat fmt, GError **error)
+    G_GNUC_NON_NULL(1);
 
 void
 fu_release_set_request(FuRelease *self, FuEngineRequest *request) G_GNUC_NON_NULL(1);
@@ -17,6 +17,7 @@
 #include "fwupd-security-attr-private.h"
 
 #include "../plugins/test/fu-test-plugin.h"
+#include "fu-benchmark.h"
 #include "fu-bios-settings-private.h"
 #include "fu-cabinet.h"
 #include "fu-client-list.h"
@@ -38,8 +39,12 @@
 #include "fu-remote.h"
 #include "fu-security-attr-common.h"
 #include "fu-smbios-private.h"
+#include "fu-udev-device-private.h"
 #include "fu-usb-backend.h"
 
+#ifdef HAVE_UDEV
+#include "fu-udev-backend.h"
+#endif
 #ifdef HAVE_GIO_UNIX
 #include "fu-unix-seekable-input-stream.h"
 #endif
@@ -2320,6 +2325,92 @@ fu_engine_get_details_missing_func(gconstpointer user_data)
 	g_assert_cmpstr(fwupd_release_get_version(release), ==, "1.2.3");
 }
 
+static void
+fu_engine_security_attrs_invalidate_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuPlugin) plugin = fu_plugin_new_from_gtype(fu_test_plugin_get_type(), self->ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(FuSecurityAttrs) attrs1 = NULL;
+	g_autoptr(FuSecurityAttrs) attrs2 = NULL;
+	g_autoptr(FuSecurityAttrs) attrs3 = NULL;
+	g_autoptr(FwupdSecurityAttr) attr1 = NULL;
+	g_autoptr(FwupdSecurityAttr) attr2 = NULL;
+	g_autoptr(FwupdSecurityAttr) attr3 = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) settings = g_hash_table_new(g_str_hash, g_str_equal);
+	g_autoptr(XbSilo) silo_empty = xb_silo_new();
+
+#ifndef HAVE_HSI
+	g_test_skip("no HSI support");
+	return;
+#endif
+
+	/* no metadata in daemon */
+	fu_engine_set_silo(engine, silo_empty);
+
+	/* set up dummy plugin */
+	ret = fu_plugin_reset_config_values(plugin, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_plugin_set_config_value(plugin, "SecurityAttrResult", "encrypted", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_engine_add_plugin(engine, plugin);
+	ret = fu_engine_load(engine, FU_ENGINE_LOAD_FLAG_NO_CACHE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	attrs1 = fu_engine_get_host_security_attrs(engine);
+	attr1 = fu_security_attrs_get_by_appstream_id(attrs1,
+						      FWUPD_SECURITY_ATTR_ID_ENCRYPTED_RAM,
+						      &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(attr1);
+	g_assert_cmpint(fwupd_security_attr_get_result(attr1),
+			==,
+			FWUPD_SECURITY_ATTR_RESULT_ENCRYPTED);
+
+	/* the plugin is called again when a BIOS setting is modified */
+	ret = fu_plugin_set_config_value(plugin, "SecurityAttrResult", "not-encrypted", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_hash_table_insert(settings, (gpointer)FWUPD_BIOS_SETTING_SELF_TEST, (gpointer) "1");
+	ret = fu_engine_modify_bios_settings(engine, settings, FALSE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	attrs2 = fu_engine_get_host_security_attrs(engine);
+	attr2 = fu_security_attrs_get_by_appstream_id(attrs2,
+						      FWUPD_SECURITY_ATTR_ID_ENCRYPTED_RAM,
+						      &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(attr2);
+	g_assert_cmpint(fwupd_security_attr_get_result(attr2),
+			==,
+			FWUPD_SECURITY_ATTR_RESULT_NOT_ENCRYPTED);
+
+	/* and when the context says something changed */
+	ret = fu_plugin_set_config_value(plugin, "SecurityAttrResult", "encrypted", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_context_security_changed(self->ctx);
+	attrs3 = fu_engine_get_host_security_attrs(engine);
+	attr3 = fu_security_attrs_get_by_appstream_id(attrs3,
+						      FWUPD_SECURITY_ATTR_ID_ENCRYPTED_RAM,
+						      &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(attr3);
+	g_assert_cmpint(fwupd_security_attr_get_result(attr3),
+			==,
+			FWUPD_SECURITY_ATTR_RESULT_ENCRYPTED);
+
+	/* do not affect the other tests */
+	ret = fu_plugin_reset_config_values(plugin, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+}
+
 static void
 fu_engine_downgrade_func(gconstpointer user_data)
 {
@@ -2336,7 +2427,10 @@ fu_engine_downgrade_func(gconstpointer user_data)
 	g_autoptr(GPtrArray) releases_dg = NULL;
 	g_autoptr(GPtrArray) releases = NULL;
 	g_autoptr(GPtrArray) releases_up = NULL;
+	g_autoptr(GPtrArray) releases_dg0 = NULL;
+	g_autoptr(GPtrArray) releases_dg2 = NULL;
 	g_autoptr(GPtrArray) releases_up2 = NULL;
+	g_autoptr(GPtrArray) releases_up3 = NULL;
 	g_autoptr(GPtrArray) remotes = NULL;
 	g_autoptr(XbSilo) silo_empty = xb_silo_new();
 
@@ -2401,6 +2495,9 @@ fu_engine_downgrade_func(gconstpointer user_data)
 	    "    <provides>"
 	    "      <firmware type=\"flashed\">aaaaaaaa-bbbb-cccc-dddd-eeeeeeeeeeee</firmware>"
 	    "    </provides>"
+	    "    <custom>"
+	    "      <value key=\"LVFS::UpdateMessage\">Unplug the dock</value>"
+	    "    </custom>"
 	    "    <releases>"
 	    "      <release version=\"1.2.5\" date=\"2017-09-16\">"
 	    "        <size type=\"installed\">123</size>"
@@ -2466,6 +2563,13 @@ fu_engine_downgrade_func(gconstpointer user_data)
 	g_assert_true(fu_device_has_flag(device, FWUPD_DEVICE_FLAG_SUPPORTED));
 	g_assert_true(fu_device_has_private_flag(device, FU_DEVICE_PRIVATE_FLAG_REGISTERED));
 
+	/* the newer releases are not returned, but still set the update message */
+	releases_dg0 = fu_engine_get_downgrades(engine, request, fu_device_get_id(device), &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(releases_dg0);
+	g_assert_cmpint(releases_dg0->len, ==, 1);
+	g_assert_cmpstr(fu_device_get_update_message(device), ==, "Unplug the dock");
+
 	/* get the releases for one device */
 	releases = fu_engine_get_releases(engine, request, fu_device_get_id(device), &error);
 	g_assert_no_error(error);
@@ -2510,6 +2614,20 @@ fu_engine_downgrade_func(gconstpointer user_data)
 	releases_up2 = fu_engine_get_upgrades(engine, request, fu_device_get_id(device), &error);
 	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO);
 	g_assert_null(releases_up2);
+	g_clear_error(&error);
+
+	/* the cached release nodes are filtered using the new device version */
+	fu_device_remove_flag(device, FWUPD_DEVICE_FLAG_ONLY_EXPLICIT_UPDATES);
+	fu_device_set_version(device, "1.2.5");
+	releases_up3 = fu_engine_get_upgrades(engine, request, fu_device_get_id(device), &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO);
+	g_assert_nonnull(g_strstr_len(error->message, -1, "1.2.5=same"));
+	g_assert_null(releases_up3);
+	g_clear_error(&error);
+	releases_dg2 = fu_engine_get_downgrades(engine, request, fu_device_get_id(device), &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(releases_dg2);
+	g_assert_cmpint(releases_dg2->len, ==, 3);
 }
 
 static void
@@ -2931,6 +3049,10 @@ fu_engine_history_func(gconstpointer user_data)
 	g_assert_cmpint(fu_device_get_update_state(device2), ==, FWUPD_UPDATE_STATE_SUCCESS);
 	g_assert_cmpstr(fu_device_get_update_error(device2), ==, NULL);
 	fu_device_set_modified_usec(device2, 1514338000ull * G_USEC_PER_SEC);
+	g_assert_nonnull(fwupd_release_get_metadata_item(fu_device_get_release_default(device2),
+							 "WriteDuration"));
+	g_assert_nonnull(fwupd_release_get_metadata_item(fu_device_get_release_default(device2),
+							 "PrepareFirmwareDuration"));
 	g_hash_table_remove_all(fwupd_release_get_metadata(fu_device_get_release_default(device2)));
 	device_str = fu_device_to_string(device2);
 	checksum = fu_input_stream_compute_checksum(stream, G_CHECKSUM_SHA1, &error);
@@ -2978,6 +3100,106 @@ fu_engine_history_func(gconstpointer user_data)
 	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOTHING_TO_DO);
 }
 
+static void
+fu_engine_history_setup_cache_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	g_autofree gchar *cache_id = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(FuCabinet) cabinet = NULL;
+	g_autoptr(FuDevice) device = fu_device_new(self->ctx);
+	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
+	g_autoptr(FuHistory) history = NULL;
+	g_autoptr(FuRelease) release = fu_release_new();
+	g_autoptr(FuPlugin) plugin = fu_plugin_new_from_gtype(fu_test_plugin_get_type(), self->ctx);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) setup_caches = NULL;
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(XbNode) component = NULL;
+	g_autoptr(XbSilo) silo_empty = xb_silo_new();
+
+	/* ensure empty tree */
+	fu_self_test_mkroot();
+
+	/* no metadata in daemon */
+	fu_engine_set_silo(engine, silo_empty);
+
+	/* set up dummy plugin */
+	ret = fu_plugin_reset_config_values(plugin, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	fu_engine_add_plugin(engine, plugin);
+
+	ret = fu_engine_load(engine, FU_ENGINE_LOAD_FLAG_NO_CACHE, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* add a device that read something slow from the hardware */
+	fu_device_set_version_format(device, FWUPD_VERSION_FORMAT_TRIPLET);
+	fu_device_set_version(device, "1.2.2");
+	fu_device_set_id(device, "test_device");
+	fu_device_build_vendor_id_u16(device, "USB", 0xFFFF);
+	fu_device_add_protocol(device, "com.acme");
+	fu_device_set_name(device, "Test Device");
+	fu_device_set_plugin(device, "test");
+	fu_device_add_instance_id(device, "12345678-1234-1234-1234-123456789012");
+	fu_device_add_flag(device, FWUPD_DEVICE_FLAG_UPDATABLE);
+	fu_device_add_flag(device, FWUPD_DEVICE_FLAG_UNSIGNED_PAYLOAD);
+	fu_device_add_private_flag(device, FU_DEVICE_PRIVATE_FLAG_CACHE_SETUP);
+	fu_device_add_setup_cache_identity(device, "HwRev", "2");
+	fu_device_set_setup_cache_value(device, "BoardId", "1234");
+	fu_engine_add_device(engine, device);
+	cache_id = g_strdup(fu_device_get_setup_cache_id(device));
+	g_assert_nonnull(cache_id);
+
+	/* the engine saved the value */
+	history = fu_history_new(self->ctx);
+	setup_caches = fu_history_get_setup_caches(history, &error);
+	if (g_error_matches(error, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+		g_test_skip("no sqlite support");
+		return;
+	}
+	g_assert_no_error(error);
+	g_assert_nonnull(setup_caches);
+	g_assert_nonnull(g_hash_table_lookup(setup_caches, cache_id));
+	g_clear_pointer(&setup_caches, g_hash_table_unref);
+
+	filename =
+	    g_test_build_filename(G_TEST_BUILT, "tests", "missing-hwid", "noreqs-1.2.3.cab", NULL);
+	stream = fu_input_stream_from_path(filename, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(stream);
+	cabinet = fu_engine_build_cabinet_from_stream(engine, stream, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(cabinet);
+	component = fu_cabinet_get_component(cabinet, "com.hughski.test.firmware", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(component);
+
+	/* install it */
+	fu_release_set_device(release, device);
+	ret = fu_release_load(release, cabinet, component, NULL, FWUPD_INSTALL_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	ret = fu_engine_install_release(engine,
+					release,
+					stream,
+					progress,
+					FWUPD_INSTALL_FLAG_NONE,
+					&error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	/* the saved value is now stale */
+	setup_caches = fu_history_get_setup_caches(history, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(setup_caches);
+	g_assert_null(g_hash_table_lookup(setup_caches, cache_id));
+	g_assert_null(fu_device_get_setup_cache(device));
+}
+
 static void
 fu_engine_history_verfmt_func(gconstpointer user_data)
 {
@@ -4664,6 +4886,194 @@ fu_backend_usb_invalid_func(gconstpointer user_data)
 	g_assert_false(fu_device_has_icon(device_tmp, "computer"));
 }
 
+static gboolean
+fu_benchmark_test_cb(gpointer user_data, GError **error)
+{
+	guint *cnt = (guint *)user_data;
+	(*cnt)++;
+	return TRUE;
+}
+
+static void
+fu_benchmark_func(void)
+{
+	gboolean ret;
+	guint cnt = 0;
+	gint64 samples_odd[] = {1, 2, 30};
+	gint64 samples_even[] = {1, 2, 4, 30};
+	JsonObject *json_obj;
+	JsonObject *json_item;
+	g_autoptr(FuBenchmark) benchmark = fu_benchmark_new(5);
+	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
+	g_autoptr(GArray) samples = g_array_new(FALSE, FALSE, sizeof(gint64));
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JsonBuilder) builder = json_builder_new();
+	g_autoptr(JsonNode) json_node = NULL;
+
+	/* median */
+	g_assert_cmpint(fu_benchmark_samples_get_median(samples), ==, 0);
+	g_array_append_vals(samples, samples_odd, G_N_ELEMENTS(samples_odd));
+	g_assert_cmpint(fu_benchmark_samples_get_median(samples), ==, 2);
+	g_array_set_size(samples, 0);
+	g_array_append_vals(samples, samples_even, G_N_ELEMENTS(samples_even));
+	g_assert_cmpint(fu_benchmark_samples_get_median(samples), ==, 3);
+
+	/* only the matching benchmark is added */
+	fu_benchmark_set_pattern(benchmark, "test:*");
+	fu_benchmark_add(benchmark, "test:counter", 0x1000, 10, fu_benchmark_test_cb, &cnt, NULL);
+	fu_benchmark_add(benchmark, "other", 0, 1, fu_benchmark_test_cb, &cnt, NULL);
+	g_assert_cmpint(fu_benchmark_get_size(benchmark), ==, 1);
+
+	/* the first run is not timed */
+	ret = fu_benchmark_run(benchmark, progress, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	g_assert_cmpint(cnt, ==, 6);
+
+	/* check the statistics are consistent */
+	json_builder_begin_object(builder);
+	fwupd_codec_to_json(FWUPD_CODEC(benchmark), builder, FWUPD_CODEC_FLAG_NONE);
+	json_builder_end_object(builder);
+	json_node = json_builder_get_root(builder);
+	json_obj = json_node_get_object(json_node);
+	g_assert_cmpint(json_object_get_int_member(json_obj, "Iterations"), ==, 5);
+	json_item = json_array_get_object_element(json_object_get_array_member(json_obj,
+										"Benchmarks"),
+						  0);
+	g_assert_cmpstr(json_object_get_string_member(json_item, "Id"), ==, "test:counter");
+	g_assert_cmpint(json_object_get_int_member(json_item, "Iterations"), ==, 5);
+	g_assert_cmpint(json_object_get_int_member(json_item, "Operations"), ==, 10);
+	g_assert_cmpint(json_object_get_int_member(json_item, "Bytes"), ==, 0x1000);
+	g_assert_cmpint(json_object_get_int_member(json_item, "MinUsec"),
+			<=,
+			json_object_get_int_member(json_item, "MedianUsec"));
+	g_assert_cmpint(json_object_get_int_member(json_item, "MedianUsec"),
+			<=,
+			json_object_get_int_member(json_item, "MaxUsec"));
+	g_assert_cmpint(json_object_get_int_member(json_item, "MeanUsec"),
+			<=,
+			json_object_get_int_member(json_item, "MaxUsec"));
+	g_assert_cmpint(json_object_get_int_member(json_item, "TotalUsec"),
+			>=,
+			json_object_get_int_member(json_item, "MaxUsec"));
+}
+
+#ifdef HAVE_UDEV
+static GBytes *
+fu_backend_udev_netlink_blob_new(const gchar *action, const gchar *devpath, const gchar *devtype)
+{
+	g_autoptr(GByteArray) buf = g_byte_array_new();
+	g_autofree gchar *action_str = g_strdup_printf("ACTION=%s", action);
+	g_autofree gchar *devpath_str = g_strdup_printf("DEVPATH=%s", devpath);
+	g_autofree gchar *devtype_str = NULL;
+	gsize propsz = strlen(action_str) + 1 + strlen(devpath_str) + 1;
+
+	if (devtype != NULL) {
+		devtype_str = g_strdup_printf("DEVTYPE=%s", devtype);
+		propsz += strlen(devtype_str) + 1;
+	}
+
+	/* FuStructUdevMonitorNetlinkHeader */
+	g_byte_array_append(buf, (const guint8 *)"libudev", 8);
+	fu_byte_array_append_uint32(buf, 0xFEEDCAFE, G_BIG_ENDIAN);
+	fu_byte_array_append_uint32(buf, 40, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32(buf, 40, G_LITTLE_ENDIAN);
+	fu_byte_array_append_uint32(buf, propsz, G_LITTLE_ENDIAN);
+	for (guint i = 0; i < 4; i++)
+		fu_byte_array_append_uint32(buf, 0x0, G_LITTLE_ENDIAN);
+
+	/* NUL-separated properties */
+	g_byte_array_append(buf, (const guint8 *)action_str, strlen(action_str) + 1);
+	g_byte_array_append(buf, (const guint8 *)devpath_str, strlen(devpath_str) + 1);
+	if (devtype_str != NULL)
+		g_byte_array_append(buf, (const guint8 *)devtype_str, strlen(devtype_str) + 1);
+	return g_bytes_new(buf->data, buf->len);
+}
+
+static void
+fu_backend_udev_netlink_add_full(FuBackend *backend,
+				 const gchar *action,
+				 const gchar *devpath,
+				 const gchar *devtype)
+{
+	gboolean ret;
+	g_autoptr(GBytes) blob = fu_backend_udev_netlink_blob_new(action, devpath, devtype);
+	g_autoptr(GError) error = NULL;
+
+	ret = fu_udev_backend_netlink_add_blob(FU_UDEV_BACKEND(backend), blob, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+}
+
+static void
+fu_backend_udev_netlink_add(FuBackend *backend, const gchar *action, const gchar *devpath)
+{
+	fu_backend_udev_netlink_add_full(backend, action, devpath, NULL);
+}
+
+static void
+fu_backend_udev_events_func(gconstpointer user_data)
+{
+	FuTest *self = (FuTest *)user_data;
+	gboolean ret;
+	g_autoptr(FuBackend) backend = fu_udev_backend_new(self->ctx);
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) events = NULL;
+
+	/* long enough that the queue is never flushed during the test */
+	fu_udev_backend_set_events_delay(FU_UDEV_BACKEND(backend), 60000);
+
+	/* children are added before parents, and parents removed before children */
+	fu_backend_udev_netlink_add(backend, "add", "/devices/usb1/1-1");
+	fu_backend_udev_netlink_add(backend, "add", "/devices/usb1");
+	fu_backend_udev_netlink_add(backend, "remove", "/devices/hid0");
+	fu_backend_udev_netlink_add(backend, "remove", "/devices/hid0/0001/hidraw0");
+
+	/* a change after an add, and a duplicate change where the newest properties are kept */
+	fu_backend_udev_netlink_add_full(backend, "change", "/devices/usb1/1-1", "usb_device");
+	fu_backend_udev_netlink_add_full(backend, "change", "/devices/pci0", "old");
+	fu_backend_udev_netlink_add_full(backend, "change", "/devices/pci0", "new");
+
+	/* a device that came and went within the window */
+	fu_backend_udev_netlink_add(backend, "add", "/devices/usb1/1-1/1-1.2");
+	fu_backend_udev_netlink_add(backend, "change", "/devices/usb1/1-1/1-1.2");
+	fu_backend_udev_netlink_add(backend, "remove", "/devices/usb1/1-1/1-1.2");
+
+	/* a device that went and came back */
+	fu_backend_udev_netlink_add(backend, "remove", "/devices/usb2");
+	fu_backend_udev_netlink_add(backend, "add", "/devices/usb2");
+
+	/* not interesting */
+	fu_backend_udev_netlink_add(backend, "bind", "/devices/usb1");
+
+	events = fu_udev_backend_get_events_pending(FU_UDEV_BACKEND(backend));
+	for (guint i = 0; i < events->len; i++)
+		g_debug("%s", (const gchar *)g_ptr_array_index(events, i));
+	g_assert_cmpint(events->len, ==, 7);
+	g_assert_true(g_str_has_prefix(g_ptr_array_index(events, 0), "remove:"));
+	g_assert_true(g_str_has_suffix(g_ptr_array_index(events, 0), "/devices/hid0/0001/hidraw0"));
+	g_assert_true(g_str_has_prefix(g_ptr_array_index(events, 1), "remove:"));
+	g_assert_true(g_str_has_suffix(g_ptr_array_index(events, 1), "/devices/hid0"));
+	g_assert_true(g_str_has_prefix(g_ptr_array_index(events, 2), "remove:"));
+	g_assert_true(g_str_has_suffix(g_ptr_array_index(events, 2), "/devices/usb2"));
+	g_assert_true(g_str_has_prefix(g_ptr_array_index(events, 3), "change:"));
+	g_assert_true(g_str_has_suffix(g_ptr_array_index(events, 3), "/devices/pci0:new"));
+	g_assert_true(g_str_has_prefix(g_ptr_array_index(events, 4), "add:"));
+	g_assert_true(g_str_has_suffix(g_ptr_array_index(events, 4), "/devices/usb1"));
+	g_assert_true(g_str_has_prefix(g_ptr_array_index(events, 5), "add:"));
+	g_assert_true(g_str_has_suffix(g_ptr_array_index(events, 5), "/devices/usb2"));
+	g_assert_true(g_str_has_prefix(g_ptr_array_index(events, 6), "add:"));
+	g_assert_true(g_str_has_suffix(g_ptr_array_index(events, 6), "/devices/usb1/1-1:usb_device"));
+
+	/* invalid action */
+	blob = fu_backend_udev_netlink_blob_new("dance", "/devices/usb1", NULL);
+	ret = fu_udev_backend_netlink_add_blob(FU_UDEV_BACKEND(backend), blob, &error);
+	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA);
+	g_assert_false(ret);
+}
+#endif
+
 static void
 fu_plugin_module_func(gconstpointer user_data)
 {
@@ -4722,7 +5132,10 @@ fu_history_func(gconstpointer user_data)
 	g_autoptr(FuDevice) device_found = NULL;
 	g_autoptr(FuHistory) history = NULL;
 	g_autoptr(GError) error = NULL;
+	GHashTable *setup_cache_tmp;
 	g_autoptr(GPtrArray) approved_firmware = NULL;
+	g_autoptr(GHashTable) setup_cache = NULL;
+	g_autoptr(GHashTable) setup_caches = NULL;
 	g_autofree gchar *dirname = NULL;
 	g_autofree gchar *filename = NULL;
 
@@ -4865,6 +5278,28 @@ fu_history_func(gconstpointer user_data)
 	ret = fu_history_has_emulation_tag(history, "id", &error);
 	g_assert_error(error, FWUPD_ERROR, FWUPD_ERROR_NOT_FOUND);
 	g_assert_false(ret);
+	g_clear_error(&error);
+
+	/* setup cache */
+	setup_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	g_hash_table_insert(setup_cache, g_strdup("BoardId"), g_strdup("1234"));
+	ret = fu_history_set_setup_cache(history, "cache-id", setup_cache, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	setup_caches = fu_history_get_setup_caches(history, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(setup_caches);
+	setup_cache_tmp = g_hash_table_lookup(setup_caches, "cache-id");
+	g_assert_nonnull(setup_cache_tmp);
+	g_assert_cmpstr(g_hash_table_lookup(setup_cache_tmp, "BoardId"), ==, "1234");
+	g_clear_pointer(&setup_caches, g_hash_table_unref);
+	ret = fu_history_remove_setup_cache(history, "cache-id", &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	setup_caches = fu_history_get_setup_caches(history, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(setup_caches);
+	g_assert_null(g_hash_table_lookup(setup_caches, "cache-id"));
 }
 
 static GBytes *
@@ -6945,12 +7380,16 @@ fu_test_engine_fake_hidraw(gconstpointer user_data)
 {
 	FuTest *self = (FuTest *)user_data;
 	gboolean ret;
+	guint cache_hits;
 	g_autofree gchar *value2 = NULL;
+	g_autofree gchar *value3 = NULL;
+	g_autofree gchar *value4 = NULL;
 	g_autoptr(FuDevice) device = NULL;
 	g_autoptr(FuEngine) engine = fu_engine_new(self->ctx);
 	g_autoptr(FuProgress) progress = fu_progress_new(G_STRLOC);
 	g_autoptr(FuUdevDevice) udev_device2 = NULL;
 	g_autoptr(FuUdevDevice) udev_device3 = NULL;
+	g_autoptr(FuUdevDevice) udev_device4 = NULL;
 	g_autoptr(GError) error = NULL;
 
 	/* non-linux */
@@ -6991,6 +7430,21 @@ fu_test_engine_fake_hidraw(gconstpointer user_data)
 	g_assert_no_error(error);
 	g_assert_cmpstr(value2, ==, "241:1");
 
+	/* identity attributes are only read from the filesystem once */
+	cache_hits = fu_udev_device_get_sysfs_cache_hits(FU_UDEV_DEVICE(device));
+	value3 = fu_udev_device_read_sysfs(FU_UDEV_DEVICE(device),
+					   "uevent",
+					   FU_UDEV_DEVICE_ATTR_READ_TIMEOUT_DEFAULT,
+					   &error);
+	g_assert_no_error(error);
+	value4 = fu_udev_device_read_sysfs(FU_UDEV_DEVICE(device),
+					   "uevent",
+					   FU_UDEV_DEVICE_ATTR_READ_TIMEOUT_DEFAULT,
+					   &error);
+	g_assert_no_error(error);
+	g_assert_cmpstr(value3, ==, value4);
+	g_assert_cmpint(fu_udev_device_get_sysfs_cache_hits(FU_UDEV_DEVICE(device)), >, cache_hits);
+
 	/* get child, both specified */
 	udev_device2 = FU_UDEV_DEVICE(
 	    fu_device_get_backend_parent_with_subsystem(device, "usb:usb_interface", &error));
@@ -7005,6 +7459,14 @@ fu_test_engine_fake_hidraw(gconstpointer user_data)
 	g_assert_nonnull(udev_device3);
 	g_assert_cmpstr(fu_udev_device_get_subsystem(udev_device3), ==, "usb");
 	g_assert_cmpstr(fu_udev_device_get_driver(udev_device3), ==, "usb");
+
+	/* the same parent is not probed again */
+	udev_device4 =
+	    FU_UDEV_DEVICE(fu_device_get_backend_parent_with_subsystem(device, "usb", &error));
+	g_assert_no_error(error);
+	g_assert_nonnull(udev_device4);
+	if (!fu_context_has_flag(self->ctx, FU_CONTEXT_FLAG_SAVE_EVENTS))
+		g_assert_true(udev_device4 == udev_device3);
 }
 
 static void
@@ -7440,6 +7902,10 @@ main(int argc, char **argv)
 	g_test_add_func("/fwupd/unix-seekable-input-stream", fu_unix_seekable_input_stream_func);
 	g_test_add_data_func("/fwupd/backend{usb}", self, fu_backend_usb_func);
 	g_test_add_data_func("/fwupd/backend{usb-invalid}", self, fu_backend_usb_invalid_func);
+#ifdef HAVE_UDEV
+	g_test_add_data_func("/fwupd/backend{udev-events}", self, fu_backend_udev_events_func);
+#endif
+	g_test_add_func("/fwupd/benchmark", fu_benchmark_func);
 	g_test_add_data_func("/fwupd/plugin{module}", self, fu_plugin_module_func);
 	g_test_add_data_func("/fwupd/memcpy", self, fu_memcpy_func);
 	g_test_add_func("/fwupd/cabinet", fu_common_cabinet_func);
@@ -7511,6 +7977,9 @@ main(int argc, char **argv)
 			     fu_engine_multiple_rels_func);
 	g_test_add_data_func("/fwupd/engine{install-request}", self, fu_engine_install_request);
 	g_test_add_data_func("/fwupd/engine{history-success}", self, fu_engine_history_func);
+	g_test_add_data_func("/fwupd/engine{history-setup-cache}",
+			     self,
+			     fu_engine_history_setup_cache_func);
 	g_test_add_data_func("/fwupd/engine{history-verfmt}", self, fu_engine_history_verfmt_func);
 	g_test_add_data_func("/fwupd/engine{history-modify}", self, fu_engine_history_modify_func);
 	g_test_add_data_func("/fwupd/engine{history-error}", self, fu_engine_history_error_func);
@@ -7539,6 +8008,9 @@ main(int argc, char **argv)
 	g_test_add_data_func("/fwupd/engine{history-inherit}", self, fu_engine_history_inherit);
 	g_test_add_data_func("/fwupd/engine{partial-hash}", self, fu_engine_partial_hash_func);
 	g_test_add_data_func("/fwupd/engine{downgrade}", self, fu_engine_downgrade_func);
+	g_test_add_data_func("/fwupd/engine{security-attrs-invalidate}",
+			     self,
+			     fu_engine_security_attrs_invalidate_func);
 	g_test_add_data_func("/fwupd/engine{md-verfmt}", self, fu_engine_md_verfmt_func);
 	g_test_add_data_func("/fwupd/engine{requirements-success}",
 			     self,
@@ -27,6 +27,7 @@
 #include "fwupd-enums-private.h"
 #include "fwupd-remote-private.h"
 
+#include "fu-benchmark.h"
 #include "fu-bios-settings-private.h"
 #include "fu-cabinet.h"
 #include "fu-console.h"
@@ -41,6 +42,7 @@
 #include "fu-security-attr-common.h"
 #include "fu-security-attrs-private.h"
 #include "fu-smbios-private.h"
+#include "fu-trace-private.h"
 #include "fu-util-bios-setting.h"
 #include "fu-util-common.h"
 
@@ -2725,6 +2727,65 @@ fu_util_get_firmware_gtypes(FuUtilPrivate *priv, gchar **values, GError **error)
 	return TRUE;
 }
 
+static gboolean
+fu_util_benchmark(FuUtilPrivate *priv, gchar **values, GError **error)
+{
+	g_autofree gchar *str = NULL;
+	g_autoptr(FuBenchmark) benchmark = fu_benchmark_new(FU_BENCHMARK_ITERATIONS_DEFAULT);
+
+	/* check args */
+	if (g_strv_length(values) > 2) {
+		g_set_error_literal(error,
+				    FWUPD_ERROR,
+				    FWUPD_ERROR_INVALID_ARGS,
+				    "Invalid arguments, expected [PATTERN] [BUILDER-DIR]");
+		return FALSE;
+	}
+	if (g_strv_length(values) >= 1)
+		fu_benchmark_set_pattern(benchmark, values[0]);
+
+	/* progress */
+	fu_progress_set_id(priv->progress, G_STRLOC);
+	fu_progress_add_flag(priv->progress, FU_PROGRESS_FLAG_NO_PROFILE);
+	fu_progress_add_step(priv->progress, FWUPD_STATUS_LOADING, 5, "load-engine");
+	fu_progress_add_step(priv->progress, FWUPD_STATUS_LOADING, 5, "setup");
+	fu_progress_add_step(priv->progress, FWUPD_STATUS_DEVICE_BUSY, 90, "run");
+
+	/* load engine */
+	if (!fu_engine_load(priv->engine,
+			    FU_ENGINE_LOAD_FLAG_READONLY | FU_ENGINE_LOAD_FLAG_EXTERNAL_PLUGINS |
+				FU_ENGINE_LOAD_FLAG_BUILTIN_PLUGINS,
+			    fu_progress_get_child(priv->progress),
+			    error))
+		return FALSE;
+	fu_progress_step_done(priv->progress);
+
+	/* generate all the inputs up front so they are not included in the timing */
+	if (!fu_benchmark_add_defaults(benchmark,
+				       fu_engine_get_context(priv->engine),
+				       g_strv_length(values) >= 2 ? values[1] : NULL,
+				       error))
+		return FALSE;
+	fu_progress_step_done(priv->progress);
+
+	/* run */
+	if (!fu_benchmark_run(benchmark, fu_progress_get_child(priv->progress), error))
+		return FALSE;
+	fu_progress_step_done(priv->progress);
+
+	/* print */
+	if (priv->as_json) {
+		g_autoptr(JsonBuilder) builder = json_builder_new();
+		json_builder_begin_object(builder);
+		fwupd_codec_to_json(FWUPD_CODEC(benchmark), builder, FWUPD_CODEC_FLAG_NONE);
+		json_builder_end_object(builder);
+		return fu_util_print_builder(priv->console, builder, error);
+	}
+	str = fwupd_codec_to_string(FWUPD_CODEC(benchmark));
+	fu_console_print_literal(priv->console, str);
+	return TRUE;
+}
+
 static gchar *
 fu_util_prompt_for_firmware_type(FuUtilPrivate *priv, GPtrArray *firmware_types, GError **error)
 {
@@ -2803,8 +2864,21 @@ fu_util_firmware_parse(FuUtilPrivate *priv, gchar **values, GError **error)
 		if (firmware_type == NULL)
 			return FALSE;
 	} else if (g_strcmp0(values[1], "auto") == 0) {
+		gsize streamsz = 0;
+		g_autoptr(GBytes) blob_sniff = NULL;
 		g_autoptr(GPtrArray) gtype_ids = fu_context_get_firmware_gtype_ids(ctx);
 		g_autoptr(GPtrArray) firmware_auto_types = g_ptr_array_new_with_free_func(g_free);
+
+		/* read the start of the file once to quickly skip unlikely types */
+		if (!fu_input_stream_size(stream, &streamsz, error))
+			return FALSE;
+		blob_sniff = fu_input_stream_read_bytes(stream,
+							0x0,
+							MIN(streamsz, FU_FIRMWARE_SNIFF_BUFSZ),
+							NULL,
+							error);
+		if (blob_sniff == NULL)
+			return FALSE;
 		for (guint i = 0; i < gtype_ids->len; i++) {
 			const gchar *gtype_id = g_ptr_array_index(gtype_ids, i);
 			GType gtype_tmp;
@@ -2827,6 +2901,15 @@ fu_util_firmware_parse(FuUtilPrivate *priv, gchar **values, GError **error)
 			firmware_tmp = g_object_new(gtype_tmp, NULL);
 			if (fu_firmware_has_flag(firmware_tmp, FU_FIRMWARE_FLAG_NO_AUTO_DETECTION))
 				continue;
+			if (!fu_firmware_sniff(firmware_tmp,
+					       g_bytes_get_data(blob_sniff, NULL),
+					       g_bytes_get_size(blob_sniff),
+					       streamsz,
+					       FWUPD_INSTALL_FLAG_NO_SEARCH,
+					       &error_local)) {
+				g_debug("skipping %s: %s", gtype_id, error_local->message);
+				continue;
+			}
 			if (!fu_firmware_parse_stream(firmware_tmp,
 						      stream,
 						      0x0,
@@ -4781,6 +4864,7 @@ main(int argc, char *argv[])
 	g_autofree gchar *cmd_descriptions = NULL;
 	g_autofree gchar *filter_device = NULL;
 	g_autofree gchar *filter_release = NULL;
+	g_autofree gchar *trace_filename = NULL;
 	const GOptionEntry options[] = {
 	    {"version",
 	     '\0',
@@ -4960,6 +5044,14 @@ main(int argc, char *argv[])
 	     /* TRANSLATORS: command line option */
 	     N_("Output in JSON format"),
 	     NULL},
+	    {"trace",
+	     '\0',
+	     0,
+	     G_OPTION_ARG_FILENAME,
+	     &trace_filename,
+	     /* TRANSLATORS: command line option, Perfetto is a trace viewer */
+	     N_("Write timing spans to a file that can be opened with Perfetto"),
+	     NULL},
 	    {NULL}};
 
 #ifdef _WIN32
@@ -5235,6 +5327,13 @@ main(int argc, char *argv[])
 			      /* TRANSLATORS: command description */
 			      _("List the available firmware types"),
 			      fu_util_get_firmware_types);
+	fu_util_cmd_array_add(cmd_array,
+			      "benchmark",
+			      /* TRANSLATORS: command argument: uppercase, spaces->dashes */
+			      _("[PATTERN] [BUILDER-DIR]"),
+			      /* TRANSLATORS: command description */
+			      _("Measure the performance of common operations"),
+			      fu_util_benchmark);
 	fu_util_cmd_array_add(cmd_array,
 			      "get-firmware-gtypes",
 			      NULL,
@@ -5585,6 +5684,10 @@ main(int argc, char *argv[])
 	if (ignore_requirements)
 		priv->flags |= FWUPD_INSTALL_FLAG_IGNORE_REQUIREMENTS;
 
+	/* record spans for the whole run */
+	if (trace_filename != NULL)
+		fu_trace_start();
+
 	/* load engine */
 	priv->ctx = fu_context_new();
 	priv->engine = fu_engine_new(priv->ctx);
@@ -5620,6 +5723,13 @@ main(int argc, char *argv[])
 
 	/* run the specified command */
 	ret = fu_util_cmd_array_run(cmd_array, priv, argv[1], (gchar **)&argv[2], &error);
+
+	/* save even on failure, as that is when the trace is most useful */
+	if (trace_filename != NULL) {
+		g_autoptr(GError) error_trace = NULL;
+		if (!fu_trace_save(trace_filename, &error_trace))
+			g_warning("failed to save trace: %s", error_trace->message);
+	}
 	if (!ret) {
 #ifdef SUPPORTED_BUILD
 		/* sanity check */
@@ -28,8 +28,25 @@ struct _FuUdevBackend {
 	GPtrArray *dpaux_devices; /* of FuDpauxDevice */
 	guint dpaux_devices_rescan_id;
 	gboolean done_coldplug;
+	GHashTable *parents;	     /* (element-type utf8 GWeakRef) */
+	GPtrArray *parents_coldplug; /* (element-type FuUdevDevice) */
+	guint parents_hits;
+	guint parents_misses;
+	GPtrArray *events; /* (element-type FuUdevBackendEvent) */
+	guint events_id;
+	guint events_delay; /* ms */
+	guint events_coalesced;
 };
 
+typedef struct {
+	FuUdevAction action;
+	gchar *sysfs_path;
+	guint depth;
+	gchar *subsystem;
+	gchar *devtype;
+	GPtrArray *properties; /* (element-type GStrv) */
+} FuUdevBackendEvent;
+
 G_DEFINE_TYPE(FuUdevBackend, fu_udev_backend, FU_TYPE_BACKEND)
 
 #define FU_UDEV_BACKEND_DPAUX_RESCAN_DELAY 5 /* s */
@@ -39,6 +56,64 @@ fu_udev_backend_to_string(FuBackend *backend, guint idt, GString *str)
 {
 	FuUdevBackend *self = FU_UDEV_BACKEND(backend);
 	fwupd_codec_string_append_bool(str, idt, "DoneColdplug", self->done_coldplug);
+	fwupd_codec_string_append_int(str, idt, "ParentCacheHits", self->parents_hits);
+	fwupd_codec_string_append_int(str, idt, "ParentCacheMisses", self->parents_misses);
+	fwupd_codec_string_append_int(str, idt, "EventsDelay", self->events_delay);
+	fwupd_codec_string_append_int(str, idt, "EventsCoalesced", self->events_coalesced);
+}
+
+static void
+fu_udev_backend_parent_weak_ref_free(GWeakRef *weak_ref)
+{
+	g_weak_ref_clear(weak_ref);
+	g_free(weak_ref);
+}
+
+/* parents are shared between all the children, but only while somebody is using them */
+static FuUdevDevice *
+fu_udev_backend_get_parent_cached(FuUdevBackend *self, const gchar *sysfs_path)
+{
+	GWeakRef *weak_ref = g_hash_table_lookup(self->parents, sysfs_path);
+	FuUdevDevice *device;
+
+	if (weak_ref == NULL)
+		return NULL;
+	device = g_weak_ref_get(weak_ref);
+	if (device == NULL) {
+		g_hash_table_remove(self->parents, sysfs_path);
+		return NULL;
+	}
+	return device;
+}
+
+static void
+fu_udev_backend_add_parent_cached(FuUdevBackend *self,
+				  const gchar *sysfs_path,
+				  FuUdevDevice *device)
+{
+	GWeakRef *weak_ref = g_new0(GWeakRef, 1);
+	g_weak_ref_init(weak_ref, device);
+	g_hash_table_insert(self->parents, g_strdup(sysfs_path), weak_ref);
+
+	/* keep alive until all the siblings have been added */
+	if (!self->done_coldplug)
+		g_ptr_array_add(self->parents_coldplug, g_object_ref(device));
+}
+
+static void
+fu_udev_backend_invalidate_parent_cached(FuUdevBackend *self, const gchar *sysfs_path)
+{
+	GHashTableIter iter;
+	const gchar *key;
+	gsize sysfs_path_len = strlen(sysfs_path);
+
+	/* the device and anything below it, but not siblings such as usb1 and usb10 */
+	g_hash_table_iter_init(&iter, self->parents);
+	while (g_hash_table_iter_next(&iter, (gpointer *)&key, NULL)) {
+		if (g_str_has_prefix(key, sysfs_path) &&
+		    (key[sysfs_path_len] == '\0' || key[sysfs_path_len] == '/'))
+			g_hash_table_iter_remove(&iter);
+	}
 }
 
 static void
@@ -358,29 +433,40 @@ fu_udev_backend_coldplug_subsystem(FuUdevBackend *self, const gchar *fn)
 	}
 }
 
-static gboolean
-fu_udev_backend_netlink_parse_blob(FuUdevBackend *self, GBytes *blob, GError **error)
+static void
+fu_udev_backend_event_free(FuUdevBackendEvent *event)
+{
+	g_free(event->sysfs_path);
+	g_free(event->subsystem);
+	g_free(event->devtype);
+	if (event->properties != NULL)
+		g_ptr_array_unref(event->properties);
+	g_free(event);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(FuUdevBackendEvent, fu_udev_backend_event_free)
+
+static FuUdevBackendEvent *
+fu_udev_backend_event_new(GBytes *blob, GError **error)
 {
-	FuContext *ctx = fu_backend_get_context(FU_BACKEND(self));
-	FuUdevAction action = FU_UDEV_ACTION_UNKNOWN;
 	const guint8 *buf;
 	gsize bufsz = 0;
-	g_autofree gchar *sysfsdir = fu_path_from_kind(FU_PATH_KIND_SYSFSDIR);
 	g_autoptr(FuStructUdevMonitorNetlinkHeader) st_hdr = NULL;
-	g_autoptr(FuUdevDevice) device_donor = NULL;
+	g_autoptr(FuUdevBackendEvent) event = g_new0(FuUdevBackendEvent, 1);
 	g_autoptr(GBytes) blob_payload = NULL;
 
 	/* parse the buffer */
 	st_hdr = fu_struct_udev_monitor_netlink_header_parse_bytes(blob, 0x0, error);
 	if (st_hdr == NULL)
-		return FALSE;
+		return NULL;
 	blob_payload =
 	    fu_bytes_new_offset(blob,
 				fu_struct_udev_monitor_netlink_header_get_properties_off(st_hdr),
 				fu_struct_udev_monitor_netlink_header_get_properties_len(st_hdr),
 				error);
 	if (blob_payload == NULL)
-		return FALSE;
+		return NULL;
+	event->properties = g_ptr_array_new_with_free_func((GDestroyNotify)g_strfreev);
 
 	/* split into lines */
 	buf = g_bytes_get_data(blob_payload, &bufsz);
@@ -393,103 +479,271 @@ fu_udev_backend_netlink_parse_blob(FuUdevBackend *self, GBytes *blob, GError **e
 			g_set_error_literal(error,
 					    FWUPD_ERROR,
 					    FWUPD_ERROR_INTERNAL,
-					    "invalid ACSII buffer");
-			return FALSE;
+					    "invalid ASCII buffer");
+			return NULL;
 		}
 		kv = g_strsplit(kvstr, "=", 2);
 		if (g_strcmp0(kv[0], "ACTION") == 0) {
-			action = fu_udev_action_from_string(kv[1]);
-			if (action == FU_UDEV_ACTION_UNKNOWN) {
+			event->action = fu_udev_action_from_string(kv[1]);
+			if (event->action == FU_UDEV_ACTION_UNKNOWN) {
 				g_set_error(error,
 					    FWUPD_ERROR,
 					    FWUPD_ERROR_INVALID_DATA,
 					    "unknown action %s",
 					    kv[1]);
-				return FALSE;
+				return NULL;
 			}
-
-			/* we do not care about these */
-			if (action == FU_UDEV_ACTION_BIND || action == FU_UDEV_ACTION_UNBIND)
-				return TRUE;
 		} else if (g_strcmp0(kv[0], "DEVPATH") == 0) {
-			g_autofree gchar *sysfspath = g_build_filename(sysfsdir, kv[1], NULL);
-
-			/* something changed */
-			if (action == FU_UDEV_ACTION_CHANGE) {
-				FuDevice *device_tmp =
-				    fu_backend_lookup_by_id(FU_BACKEND(self), sysfspath);
-				if (device_tmp == NULL)
-					return TRUE;
-				if (g_strcmp0(
-					fu_udev_device_get_subsystem(FU_UDEV_DEVICE(device_tmp)),
-					"drm") != 0)
-					fu_udev_backend_rescan_dpaux_devices(self);
-				g_set_object(&device_donor, FU_UDEV_DEVICE(device_tmp));
+			g_autofree gchar *sysfsdir = fu_path_from_kind(FU_PATH_KIND_SYSFSDIR);
+			g_free(event->sysfs_path);
+			event->sysfs_path = g_build_filename(sysfsdir, kv[1], NULL);
+			event->depth = 0;
+			for (guint j = 0; event->sysfs_path[j] != '\0'; j++) {
+				if (event->sysfs_path[j] == '/')
+					event->depth++;
 			}
-
-			/* something got removed */
-			if (action == FU_UDEV_ACTION_REMOVE) {
-				fu_udev_backend_device_remove(self, sysfspath);
-				return TRUE;
-			}
-
-			/* something got added */
-			if (action == FU_UDEV_ACTION_ADD) {
-				if (device_donor != NULL) {
-					g_set_error_literal(error,
-							    FWUPD_ERROR,
-							    FWUPD_ERROR_INVALID_DATA,
-							    "already have a donor device");
-					return FALSE;
-				}
-				device_donor = fu_udev_device_new(ctx, sysfspath);
-			}
-		} else if (g_strcmp0(kv[0], "SUBSYSTEM") == 0 && device_donor != NULL) {
-			fu_udev_device_set_subsystem(device_donor, kv[1]);
-		} else if (g_strcmp0(kv[0], "DEVTYPE") == 0 && device_donor != NULL) {
-			fu_udev_device_set_devtype(device_donor, kv[1]);
-		} else if (device_donor != NULL) {
-			fu_udev_device_add_property(device_donor, kv[0], kv[1]);
+		} else if (g_strcmp0(kv[0], "SUBSYSTEM") == 0) {
+			g_free(event->subsystem);
+			event->subsystem = g_strdup(kv[1]);
+		} else if (g_strcmp0(kv[0], "DEVTYPE") == 0) {
+			g_free(event->devtype);
+			event->devtype = g_strdup(kv[1]);
+		} else {
+			g_ptr_array_add(event->properties, g_steal_pointer(&kv));
 		}
 
 		/* next! */
 		i += strlen(kvstr);
 	}
+	if (event->action == FU_UDEV_ACTION_UNKNOWN) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA, "no ACTION");
+		return NULL;
+	}
+	if (event->sysfs_path == NULL) {
+		g_set_error_literal(error, FWUPD_ERROR, FWUPD_ERROR_INVALID_DATA, "no DEVPATH");
+		return NULL;
+	}
+
+	/* success */
+	return g_steal_pointer(&event);
+}
+
+static gboolean
+fu_udev_backend_event_process(FuUdevBackend *self, FuUdevBackendEvent *event, GError **error)
+{
+	FuContext *ctx = fu_backend_get_context(FU_BACKEND(self));
+	g_autoptr(FuUdevDevice) device_donor = NULL;
+	g_autoptr(FuUdevDevice) device_actual = NULL;
+
+	/* a cached parent may no longer be valid */
+	if (event->action == FU_UDEV_ACTION_CHANGE || event->action == FU_UDEV_ACTION_REMOVE)
+		fu_udev_backend_invalidate_parent_cached(self, event->sysfs_path);
+
+	/* something got removed */
+	if (event->action == FU_UDEV_ACTION_REMOVE) {
+		fu_udev_backend_device_remove(self, event->sysfs_path);
+		return TRUE;
+	}
+
+	/* something changed */
+	if (event->action == FU_UDEV_ACTION_CHANGE) {
+		FuDevice *device_tmp = fu_backend_lookup_by_id(FU_BACKEND(self), event->sysfs_path);
+		if (device_tmp == NULL)
+			return TRUE;
+		fu_udev_device_invalidate_sysfs_cache(FU_UDEV_DEVICE(device_tmp));
+		if (g_strcmp0(fu_udev_device_get_subsystem(FU_UDEV_DEVICE(device_tmp)), "drm") != 0)
+			fu_udev_backend_rescan_dpaux_devices(self);
+		device_donor = g_object_ref(FU_UDEV_DEVICE(device_tmp));
+	} else if (event->action == FU_UDEV_ACTION_ADD) {
+		device_donor = fu_udev_device_new(ctx, event->sysfs_path);
+	} else {
+		return TRUE;
+	}
+	if (event->subsystem != NULL)
+		fu_udev_device_set_subsystem(device_donor, event->subsystem);
+	if (event->devtype != NULL)
+		fu_udev_device_set_devtype(device_donor, event->devtype);
+	for (guint i = 0; i < event->properties->len; i++) {
+		gchar **kv = g_ptr_array_index(event->properties, i);
+		fu_udev_device_add_property(device_donor, kv[0], kv[1]);
+	}
 
 	/* notify the engine */
-	if (action == FU_UDEV_ACTION_CHANGE) {
-		if (device_donor == NULL) {
-			g_set_error_literal(error,
-					    FWUPD_ERROR,
-					    FWUPD_ERROR_INVALID_DATA,
-					    "no device to change");
-			return FALSE;
-		}
+	if (event->action == FU_UDEV_ACTION_CHANGE) {
 		fu_backend_device_changed(FU_BACKEND(self), FU_DEVICE(device_donor));
+		return TRUE;
 	}
 
 	/* now create the actual device from the donor */
-	if (action == FU_UDEV_ACTION_ADD) {
-		g_autoptr(FuUdevDevice) device_actual = NULL;
-		if (device_donor == NULL) {
-			g_set_error_literal(error,
-					    FWUPD_ERROR,
-					    FWUPD_ERROR_INVALID_DATA,
-					    "no new device to add");
-			return FALSE;
+	device_actual =
+	    FU_UDEV_DEVICE(fu_udev_backend_create_device_for_donor(FU_BACKEND(self),
+								   FU_DEVICE(device_donor),
+								   error));
+	if (device_actual == NULL)
+		return FALSE;
+
+	/* success */
+	fu_udev_backend_device_add_from_device(self, device_actual);
+	return TRUE;
+}
+
+static void
+fu_udev_backend_event_handle(FuUdevBackend *self, FuUdevBackendEvent *event)
+{
+	g_autoptr(GError) error_local = NULL;
+
+	if (!fu_udev_backend_event_process(self, event, &error_local)) {
+		if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
+			g_debug("ignoring netlink message: %s", error_local->message);
+			return;
 		}
-		device_actual =
-		    FU_UDEV_DEVICE(fu_udev_backend_create_device_for_donor(FU_BACKEND(self),
-									   FU_DEVICE(device_donor),
-									   error));
-		if (device_actual == NULL)
-			return FALSE;
+		g_warning("ignoring netlink message: %s", error_local->message);
+	}
+}
+
+static guint
+fu_udev_backend_event_get_rank(FuUdevBackendEvent *event)
+{
+	if (event->action == FU_UDEV_ACTION_REMOVE)
+		return 0;
+	if (event->action == FU_UDEV_ACTION_CHANGE)
+		return 1;
+	return 2;
+}
+
+/* removals deepest-first, then changes, then additions parent-first */
+static gint
+fu_udev_backend_event_sort_cb(gconstpointer a, gconstpointer b)
+{
+	FuUdevBackendEvent *event1 = *((FuUdevBackendEvent **)a);
+	FuUdevBackendEvent *event2 = *((FuUdevBackendEvent **)b);
+	guint rank1 = fu_udev_backend_event_get_rank(event1);
+	guint rank2 = fu_udev_backend_event_get_rank(event2);
+
+	if (rank1 != rank2)
+		return (gint)rank1 - (gint)rank2;
+	if (event1->action == FU_UDEV_ACTION_REMOVE)
+		return (gint)event2->depth - (gint)event1->depth;
+	if (event1->action == FU_UDEV_ACTION_ADD)
+		return (gint)event1->depth - (gint)event2->depth;
+	return 0;
+}
 
-		/* success */
-		fu_udev_backend_device_add_from_device(self, device_actual);
+static gboolean
+fu_udev_backend_events_flush_cb(gpointer user_data)
+{
+	FuUdevBackend *self = FU_UDEV_BACKEND(user_data);
+	g_autoptr(GPtrArray) events = g_steal_pointer(&self->events);
+
+	/* handling an event can cause the netlink source to recurse */
+	self->events_id = 0;
+	self->events = g_ptr_array_new_with_free_func((GDestroyNotify)fu_udev_backend_event_free);
+
+	/* this is stable, so events for the same path stay in order */
+	g_ptr_array_sort(events, fu_udev_backend_event_sort_cb);
+	g_debug("processing batch of %u netlink events", events->len);
+	for (guint i = 0; i < events->len; i++) {
+		FuUdevBackendEvent *event = g_ptr_array_index(events, i);
+		fu_udev_backend_event_handle(self, event);
 	}
+	return FALSE;
+}
 
-	/* success */
+/* for the self tests, in the order they will be processed */
+GPtrArray *
+fu_udev_backend_get_events_pending(FuUdevBackend *self)
+{
+	GPtrArray *strs;
+	g_autoptr(GPtrArray) events = NULL;
+
+	g_return_val_if_fail(FU_IS_UDEV_BACKEND(self), NULL);
+
+	strs = g_ptr_array_new_with_free_func(g_free);
+	events = g_ptr_array_copy(self->events, NULL, NULL);
+	g_ptr_array_set_free_func(events, NULL);
+	g_ptr_array_sort(events, fu_udev_backend_event_sort_cb);
+	for (guint i = 0; i < events->len; i++) {
+		FuUdevBackendEvent *event = g_ptr_array_index(events, i);
+		GString *str = g_string_new(fu_udev_action_to_string(event->action));
+		g_string_append_printf(str, ":%s", event->sysfs_path);
+		if (event->devtype != NULL)
+			g_string_append_printf(str, ":%s", event->devtype);
+		g_ptr_array_add(strs, g_string_free(str, FALSE));
+	}
+	return strs;
+}
+
+static void
+fu_udev_backend_events_queue(FuUdevBackend *self, FuUdevBackendEvent *event)
+{
+	g_autoptr(FuUdevBackendEvent) event_new = event;
+
+	/* look at what is pending for this path since the last removal */
+	for (guint i = self->events->len; i > 0; i--) {
+		FuUdevBackendEvent *event_tmp = g_ptr_array_index(self->events, i - 1);
+		gboolean was_added;
+
+		if (g_strcmp0(event_tmp->sysfs_path, event_new->sysfs_path) != 0)
+			continue;
+		if (event_tmp->action == FU_UDEV_ACTION_REMOVE)
+			break;
+
+		/* the newest properties replace a pending change or add in the same position */
+		if (event_new->action == FU_UDEV_ACTION_CHANGE) {
+			g_debug("coalescing change of %s", event_new->sysfs_path);
+			event_new->action = event_tmp->action;
+			g_ptr_array_remove_index(self->events, i - 1);
+			g_ptr_array_insert(self->events, i - 1, g_steal_pointer(&event_new));
+			self->events_coalesced++;
+			return;
+		}
+
+		/* nothing pending matters if the device is going away */
+		if (event_new->action == FU_UDEV_ACTION_REMOVE) {
+			was_added = event_tmp->action == FU_UDEV_ACTION_ADD;
+			g_ptr_array_remove_index(self->events, i - 1);
+			self->events_coalesced++;
+			if (was_added) {
+				g_debug("coalescing add and remove of %s", event_new->sysfs_path);
+				self->events_coalesced++;
+				return;
+			}
+		}
+	}
+	g_ptr_array_add(self->events, g_steal_pointer(&event_new));
+
+	/* the window is not extended, so a busy bus cannot starve the queue */
+	if (self->events_id == 0) {
+		self->events_id =
+		    g_timeout_add(self->events_delay, fu_udev_backend_events_flush_cb, self);
+	}
+}
+
+gboolean
+fu_udev_backend_netlink_add_blob(FuUdevBackend *self, GBytes *blob, GError **error)
+{
+	g_autoptr(FuUdevBackendEvent) event = NULL;
+
+	g_return_val_if_fail(FU_IS_UDEV_BACKEND(self), FALSE);
+	g_return_val_if_fail(blob != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	event = fu_udev_backend_event_new(blob, error);
+	if (event == NULL)
+		return FALSE;
+
+	/* we do not care about these */
+	if (event->action == FU_UDEV_ACTION_BIND || event->action == FU_UDEV_ACTION_UNBIND)
+		return TRUE;
+
+	/* process now */
+	if (self->events_delay == 0) {
+		fu_udev_backend_event_handle(self, event);
+		return TRUE;
+	}
+
+	/* coalesce with anything else for the same device in the window */
+	fu_udev_backend_events_queue(self, g_steal_pointer(&event));
 	return TRUE;
 }
 
@@ -506,17 +760,18 @@ fu_udev_backend_netlink_cb(gint fd, GIOCondition condition, gpointer user_data)
 	if (len < 0)
 		return TRUE;
 	blob = g_bytes_new(buf, len);
-	if (!fu_udev_backend_netlink_parse_blob(self, blob, &error_local)) {
-		if (g_error_matches(error_local, FWUPD_ERROR, FWUPD_ERROR_NOT_SUPPORTED)) {
-			g_debug("ignoring netlink message: %s", error_local->message);
-			return TRUE;
-		}
+	if (!fu_udev_backend_netlink_add_blob(self, blob, &error_local))
 		g_warning("ignoring netlink message: %s", error_local->message);
-		return TRUE;
-	}
 	return TRUE;
 }
 
+void
+fu_udev_backend_set_events_delay(FuUdevBackend *self, guint events_delay)
+{
+	g_return_if_fail(FU_IS_UDEV_BACKEND(self));
+	self->events_delay = events_delay;
+}
+
 static gboolean
 fu_udev_backend_netlink_setup(FuUdevBackend *self, GError **error)
 {
@@ -563,6 +818,26 @@ fu_udev_backend_netlink_setup(FuUdevBackend *self, GError **error)
 	return TRUE;
 }
 
+static void
+fu_udev_backend_show_sysfs_cache_ratio(FuUdevBackend *self)
+{
+	guint hits = 0;
+	guint misses = 0;
+	g_autoptr(GPtrArray) devices = fu_backend_get_devices(FU_BACKEND(self));
+
+	for (guint i = 0; i < devices->len; i++) {
+		FuUdevDevice *device = g_ptr_array_index(devices, i);
+		hits += fu_udev_device_get_sysfs_cache_hits(device);
+		misses += fu_udev_device_get_sysfs_cache_misses(device);
+	}
+	if (hits + misses == 0)
+		return;
+	g_info("sysfs cache hit ratio %.1f%% (%u hits, %u misses)",
+	       (gdouble)hits * 100.f / (gdouble)(hits + misses),
+	       hits,
+	       misses);
+}
+
 static gboolean
 fu_udev_backend_coldplug(FuBackend *backend, FuProgress *progress, GError **error)
 {
@@ -600,8 +875,16 @@ fu_udev_backend_coldplug(FuBackend *backend, FuProgress *progress, GError **erro
 		fu_progress_step_done(progress);
 	}
 
+	/* how many sysfs reads and parent probes were avoided */
+	fu_udev_backend_show_sysfs_cache_ratio(self);
+	if (self->parents_hits > 0)
+		g_info("reused %u of %u parent devices",
+		       self->parents_hits,
+		       self->parents_hits + self->parents_misses);
+
 	/* success */
 	self->done_coldplug = TRUE;
+	g_ptr_array_set_size(self->parents_coldplug, 0);
 	return TRUE;
 }
 
@@ -632,6 +915,7 @@ fu_udev_backend_get_device_parent(FuBackend *backend,
 				  GError **error)
 {
 	FuUdevBackend *self = FU_UDEV_BACKEND(backend);
+	gboolean use_cache;
 	g_autofree gchar *devtype_new = NULL;
 	g_autofree gchar *sysfs_path = NULL;
 	g_autoptr(FuUdevDevice) device_new = NULL;
@@ -682,6 +966,10 @@ fu_udev_backend_get_device_parent(FuBackend *backend,
 		return NULL;
 	}
 
+	/* the parent target is used to redirect events, so each child needs its own object */
+	use_cache = !fu_context_has_flag(fu_backend_get_context(backend),
+					 FU_CONTEXT_FLAG_SAVE_EVENTS);
+
 	/* lets just walk up the directories */
 	while (1) {
 		g_autofree gchar *dirname = NULL;
@@ -693,7 +981,18 @@ fu_udev_backend_get_device_parent(FuBackend *backend,
 			break;
 
 		/* check has matching subsystem and devtype */
-		device_new = fu_udev_backend_create_device(self, dirname, &error_local);
+		g_clear_object(&device_new);
+		if (use_cache)
+			device_new = fu_udev_backend_get_parent_cached(self, dirname);
+		if (device_new != NULL) {
+			self->parents_hits++;
+		} else {
+			device_new = fu_udev_backend_create_device(self, dirname, &error_local);
+			if (device_new != NULL && use_cache) {
+				self->parents_misses++;
+				fu_udev_backend_add_parent_cached(self, dirname, device_new);
+			}
+		}
 		if (device_new != NULL) {
 			if (fu_udev_device_match_subsystem(device_new, subsystem)) {
 				if (subsystem != NULL) {
@@ -734,9 +1033,14 @@ fu_udev_backend_finalize(GObject *object)
 	FuUdevBackend *self = FU_UDEV_BACKEND(object);
 	if (self->dpaux_devices_rescan_id != 0)
 		g_source_remove(self->dpaux_devices_rescan_id);
+	if (self->events_id != 0)
+		g_source_remove(self->events_id);
 	if (self->netlink_fd > 0)
 		g_close(self->netlink_fd, NULL);
 	g_hash_table_unref(self->map_paths);
+	g_hash_table_unref(self->parents);
+	g_ptr_array_unref(self->parents_coldplug);
+	g_ptr_array_unref(self->events);
 	g_ptr_array_unref(self->dpaux_devices);
 	G_OBJECT_CLASS(fu_udev_backend_parent_class)->finalize(object);
 }
@@ -745,7 +1049,14 @@ static void
 fu_udev_backend_init(FuUdevBackend *self)
 {
 	self->map_paths = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	self->parents =
+	    g_hash_table_new_full(g_str_hash,
+				  g_str_equal,
+				  g_free,
+				  (GDestroyNotify)fu_udev_backend_parent_weak_ref_free);
+	self->parents_coldplug = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 	self->dpaux_devices = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	self->events = g_ptr_array_new_with_free_func((GDestroyNotify)fu_udev_backend_event_free);
 }
 
 static void
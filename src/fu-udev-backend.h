@@ -13,3 +13,10 @@ G_DECLARE_FINAL_TYPE(FuUdevBackend, fu_udev_backend, FU, UDEV_BACKEND, FuBackend
 
 FuBackend *
 fu_udev_backend_new(FuContext *ctx) G_GNUC_NON_NULL(1);
+void
+fu_udev_backend_set_events_delay(FuUdevBackend *self, guint events_delay) G_GNUC_NON_NULL(1);
+gboolean
+fu_udev_backend_netlink_add_blob(FuUdevBackend *self, GBytes *blob, GError **error)
+    G_GNUC_NON_NULL(1, 2);
+GPtrArray *
+fu_udev_backend_get_events_pending(FuUdevBackend *self) G_GNUC_NON_NULL(1);
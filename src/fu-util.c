@@ -2937,6 +2937,8 @@ fu_util_update_device_with_release(FuUtilPrivate *priv,
 				   FwupdRelease *rel,
 				   GError **error)
 {
+	FwupdClientDownloadFlags download_flags;
+
 	if (!fwupd_device_has_flag(dev, FWUPD_DEVICE_FLAG_UPDATABLE)) {
 		const gchar *name = fwupd_device_get_name(dev);
 		g_autofree gchar *str = NULL;
@@ -2962,11 +2964,16 @@ fu_util_update_device_with_release(FuUtilPrivate *priv,
 		if (!fu_util_prompt_warning_bkc(priv, dev, rel, error))
 			return FALSE;
 	}
+
+	/* large archives do not have to fit in memory, and an interrupted download is resumed */
+	download_flags = priv->download_flags;
+	if ((download_flags & FWUPD_CLIENT_DOWNLOAD_FLAG_ONLY_P2P) == 0)
+		download_flags |= FWUPD_CLIENT_DOWNLOAD_FLAG_STREAM_TO_CACHE;
 	return fwupd_client_install_release(priv->client,
 					    dev,
 					    rel,
 					    priv->flags,
-					    priv->download_flags,
+					    download_flags,
 					    priv->cancellable,
 					    error);
 }